@@ -0,0 +1,333 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: AsyncRequester.cpp
+ *
+ * Description: This file contains the AsyncRequester, which completes
+ *				requests through callbacks, and the ResponseFuture.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#include "AsyncRequester.h"
+#include "ElementUtil.h"
+
+#include <blpapi_element.h>
+#include <blpapi_highresolutionclock.h>
+#include <blpapi_name.h>
+
+namespace {
+	const BloombergLP::blpapi::Name RESPONSE_ERROR("responseError");
+	const BloombergLP::blpapi::Name REQUEST_FAILURE("RequestFailure");
+	const BloombergLP::blpapi::Name REASON("reason");
+	const BloombergLP::blpapi::Name MESSAGE("message");
+	const BloombergLP::blpapi::Name DESCRIPTION("description");
+	const BloombergLP::blpapi::Name SESSION_TERMINATED("SessionTerminated");
+}
+
+/*----------------------------------------------------------------
+ * Name			: ResponseFuture constructor
+ * Description	: Constructs a future of a request not completed
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+BloombergLP::ResponseFuture::ResponseFuture()
+	: failed_(false)
+	, done_(false)
+{
+}
+
+/*----------------------------------------------------------------
+ * Name			: wait
+ * Description	: Waits until the request completes
+ * Arguments	: timeoutMs is the longest wait
+ * Returns		: true if the request completed
+ *---------------------------------------------------------------*/
+bool BloombergLP::ResponseFuture::wait(unsigned int timeoutMs)
+{
+	blpapi::TimePoint start = blpapi::HighResolutionClock::now();
+	Guard guard(lock_);
+	while (!done_)
+	{
+		long long elapsedMs = blpapi::TimePointUtil::nanosecondsBetween(start,
+			blpapi::HighResolutionClock::now()) / 1000000;
+		if (elapsedMs >= timeoutMs)
+		{
+			break;
+		}
+		lock_.wait(static_cast<unsigned int>(timeoutMs - elapsedMs));
+	}
+	return done_;
+}
+
+/*----------------------------------------------------------------
+ * Name			: processResponse
+ * Description	: Keeps the messages and wakes the waiting threads
+ * Arguments	: see AsyncRequester.h
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::ResponseFuture::processResponse(const blpapi::CorrelationId&,
+	const std::vector<blpapi::Message>& messages)
+{
+	messages_ = messages;
+	complete();
+}
+
+/*----------------------------------------------------------------
+ * Name			: processFailure
+ * Description	: Keeps the error and wakes the waiting threads
+ * Arguments	: see AsyncRequester.h
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::ResponseFuture::processFailure(const blpapi::CorrelationId&,
+	const std::string& error)
+{
+	error_ = error;
+	failed_ = true;
+	complete();
+}
+
+/*----------------------------------------------------------------
+ * Name			: complete
+ * Description	: Wakes the waiting threads, the results are written
+ *				  before
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::ResponseFuture::complete()
+{
+	Guard guard(lock_);
+	done_ = true;
+	lock_.broadcast();
+}
+
+/*----------------------------------------------------------------
+ * Name			: AsyncRequester constructor
+ * Description	: Constructs a requester without requests
+ * Arguments	: see AsyncRequester.h
+ * Returns		: none
+ *---------------------------------------------------------------*/
+BloombergLP::AsyncRequester::AsyncRequester(blpapi::Session& session,
+	const blpapi::Identity *identity)
+	: session_(session)
+	, identity_(identity)
+	, nextId_(1)
+{
+}
+
+/*----------------------------------------------------------------
+ * Name			: sendRequest
+ * Description	: Sends a request completed through handler
+ * Arguments	: see AsyncRequester.h
+ * Returns		: correlation id of the request
+ *---------------------------------------------------------------*/
+BloombergLP::blpapi::CorrelationId BloombergLP::AsyncRequester::sendRequest(
+	const blpapi::Request& request, ResponseHandler& handler)
+{
+	long long id;
+	{
+		//registered first, the response may arrive before sendRequest
+		//returns
+		Guard guard(lock_);
+		id = nextId_++;
+		outstanding_[id].handler_ = &handler;
+	}
+
+	blpapi::CorrelationId cid(id, CLASS_ID);
+	try {
+		if (identity_)
+		{
+			session_.sendRequest(request, *identity_, cid);
+		}
+		else
+		{
+			session_.sendRequest(request, cid);
+		}
+	}
+	catch (...) {
+		Guard guard(lock_);
+		outstanding_.erase(id);
+		throw;
+	}
+	return cid;
+}
+
+/*----------------------------------------------------------------
+ * Name			: processEvent
+ * Description	: Completes the requests answered in event
+ * Arguments	: event is the event
+ * Returns		: true if event had a requester message
+ *---------------------------------------------------------------*/
+bool BloombergLP::AsyncRequester::processEvent(const blpapi::Event& event)
+{
+	int eventType = event.eventType();
+	if (eventType != blpapi::Event::PARTIAL_RESPONSE
+		&& eventType != blpapi::Event::RESPONSE
+		&& eventType != blpapi::Event::REQUEST_STATUS
+		&& eventType != blpapi::Event::SESSION_STATUS)
+	{
+		return false;
+	}
+
+	bool found = false;
+	std::vector<Completion> completions;
+	{
+		Guard guard(lock_);
+		blpapi::MessageIterator msgIter(event);
+		while (msgIter.next())
+		{
+			blpapi::Message msg = msgIter.message();
+			if (eventType == blpapi::Event::SESSION_STATUS)
+			{
+				if (msg.messageType() != SESSION_TERMINATED)
+				{
+					continue;
+				}
+				//no response will come
+				for (std::map<long long, Outstanding>::iterator it = outstanding_.begin();
+					it != outstanding_.end(); ++it)
+				{
+					Completion completion;
+					completion.id_ = it->first;
+					completion.handler_ = it->second.handler_;
+					completion.error_ = "SessionTerminated";
+					completion.failed_ = true;
+					completions.push_back(completion);
+				}
+				outstanding_.clear();
+				continue;
+			}
+
+			long long id;
+			if (!requestId(msg, CLASS_ID, &id))
+			{
+				continue;
+			}
+			found = true;
+
+			std::map<long long, Outstanding>::iterator it = outstanding_.find(id);
+			if (it == outstanding_.end())
+			{
+				continue;
+			}
+
+			Completion completion;
+			completion.id_ = it->first;
+			completion.handler_ = it->second.handler_;
+			completion.failed_ = true;
+			if (!requestError(msg, &completion.error_))
+			{
+				it->second.messages_.push_back(msg);
+				if (eventType != blpapi::Event::RESPONSE)
+				{
+					continue;
+				}
+				completion.messages_.swap(it->second.messages_);
+				completion.failed_ = false;
+			}
+			completions.push_back(completion);
+			outstanding_.erase(it);
+		}
+	}
+
+	//outside the lock, a handler may send the next request
+	for (size_t i = 0; i < completions.size(); ++i)
+	{
+		Completion& completion = completions[i];
+		blpapi::CorrelationId cid(completion.id_, CLASS_ID);
+		if (completion.failed_)
+		{
+			completion.handler_->processFailure(cid, completion.error_);
+		}
+		else
+		{
+			completion.handler_->processResponse(cid, completion.messages_);
+		}
+	}
+	return found;
+}
+
+/*----------------------------------------------------------------
+ * Name			: numOutstanding
+ * Description	: Returns the number of requests not completed
+ * Arguments	: none
+ * Returns		: number of outstanding requests
+ *---------------------------------------------------------------*/
+size_t BloombergLP::AsyncRequester::numOutstanding()
+{
+	Guard guard(lock_);
+	return outstanding_.size();
+}
+
+/*----------------------------------------------------------------
+ * Name			: requestId
+ * Description	: Finds the request of a message by correlation id
+ * Arguments	: see AsyncRequester.h
+ * Returns		: true if msg answers a request of classId
+ *---------------------------------------------------------------*/
+bool BloombergLP::AsyncRequester::requestId(const blpapi::Message& msg, int classId,
+	long long *id)
+{
+	blpapi::CorrelationId cid = msg.correlationId();
+	if (cid.valueType() != blpapi::CorrelationId::INT_VALUE
+		|| cid.classId() != classId)
+	{
+		return false;
+	}
+	*id = cid.asInteger();
+	return true;
+}
+
+/*----------------------------------------------------------------
+ * Name			: requestError
+ * Description	: Tells if a message of a request fails it
+ * Arguments	: see AsyncRequester.h
+ * Returns		: true if msg is a RequestFailure or has a
+ *				  responseError
+ *---------------------------------------------------------------*/
+bool BloombergLP::AsyncRequester::requestError(const blpapi::Message& msg,
+	std::string *error)
+{
+	blpapi::Element element;
+	if (msg.messageType() == REQUEST_FAILURE)
+	{
+		const char *description = "RequestFailure";
+		if (msg.asElement().getElement(&element, REASON) == 0)
+		{
+			tryGetElementAs(element, DESCRIPTION, &description);
+		}
+		*error = description;
+		return true;
+	}
+	if (msg.asElement().getElement(&element, RESPONSE_ERROR) == 0)
+	{
+		const char *message = "responseError";
+		tryGetElementAs(element, MESSAGE, &message);
+		*error = message;
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,260 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: AsyncRequester.h
+ *
+ * Description: This file contains the AsyncRequester class, which
+ *				completes requests sent on a Session with an
+ *				EventHandler through a callback or a ResponseFuture.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef __AsyncRequester_h__
+#define __AsyncRequester_h__
+
+#include <blpapi_correlationid.h>
+#include <blpapi_event.h>
+#include <blpapi_identity.h>
+#include <blpapi_message.h>
+#include <blpapi_request.h>
+#include <blpapi_session.h>
+
+#include <stddef.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "SyncIO.h"
+
+namespace BloombergLP
+{
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : ResponseHandler
+	 * Description  : Receives the completion of a request sent by an
+	 *				  AsyncRequester. It is called on the thread that
+	 *				  passed the response to processEvent(), usually
+	 *				  the event dispatcher thread, without the requester
+	 *				  lock held, so it may send more requests.
+	 * --------------------------------------------------------------------*/
+	class ResponseHandler
+	{
+		public:
+			virtual ~ResponseHandler() {}
+
+			/*----------------------------------------------------------------
+			 * Name			: processResponse
+			 * Description	: Receives the messages of a completed request
+			 * Arguments	: cid is the correlation id of the request
+			 *				  messages are the partial responses and the
+			 *				  response, in order
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			virtual void processResponse(const blpapi::CorrelationId& cid,
+				const std::vector<blpapi::Message>& messages) = 0;
+
+			/*----------------------------------------------------------------
+			 * Name			: processFailure
+			 * Description	: Receives the failure of a request
+			 * Arguments	: cid is the correlation id of the request
+			 *				  error is the RequestFailure reason, the
+			 *				  responseError message or SessionTerminated
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			virtual void processFailure(const blpapi::CorrelationId& cid,
+				const std::string& error) = 0;
+	};
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : ResponseFuture
+	 * Description  : ResponseHandler a thread can wait on. It holds the
+	 *				  messages or the error of one request; it must stay
+	 *				  alive until the request completes.
+	 * --------------------------------------------------------------------*/
+	class ResponseFuture : public ResponseHandler
+	{
+		public:
+			ResponseFuture();
+
+			/*----------------------------------------------------------------
+			 * Name			: wait
+			 * Description	: Waits until the request completes
+			 * Arguments	: timeoutMs is the longest wait
+			 * Returns		: true if the request completed
+			 *---------------------------------------------------------------*/
+			bool wait(unsigned int timeoutMs);
+
+			//the members below are valid once wait() returned true
+
+			//true if the request failed
+			bool failed() const { return failed_; }
+
+			//messages of a request that did not fail
+			const std::vector<blpapi::Message>& messages() const { return messages_; }
+
+			//reason of a failed request
+			const std::string& error() const { return error_; }
+
+			void processResponse(const blpapi::CorrelationId& cid,
+				const std::vector<blpapi::Message>& messages);
+			void processFailure(const blpapi::CorrelationId& cid,
+				const std::string& error);
+
+		private:
+			//wakes the waiting threads
+			void complete();
+
+			std::vector<blpapi::Message> messages_;
+			std::string error_;
+			bool failed_;
+
+			SyncCondition lock_;
+			bool done_;
+
+			// Unimplemented
+			ResponseFuture(const ResponseFuture&);
+			ResponseFuture& operator=(const ResponseFuture&);
+	};
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : AsyncRequester
+	 * Description  : Sends requests on a session created with an
+	 *				  EventHandler and completes each through its
+	 *				  ResponseHandler, so one dispatcher thread serves any
+	 *				  number of outstanding requests without a thread
+	 *				  blocked in nextEvent() per request.
+	 *				  Requests are found by correlation id, partial
+	 *				  responses are kept until the response arrives.
+	 *				  The EventHandler passes every event to
+	 *				  processEvent(). Any thread may call any method.
+	 * --------------------------------------------------------------------*/
+	class AsyncRequester
+	{
+		public:
+			//classId of the correlation ids of the requester requests
+			enum { CLASS_ID = 0x4152 };
+
+			/*----------------------------------------------------------------
+			 * Name			: AsyncRequester constructor
+			 * Description	: Constructs a requester without requests
+			 * Arguments	: session sends the requests
+			 *				  identity is the identity of the requests,
+			 *				  0 for none
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			AsyncRequester(blpapi::Session& session,
+				const blpapi::Identity *identity = 0);
+
+			/*----------------------------------------------------------------
+			 * Name			: sendRequest
+			 * Description	: Sends a request, handler is called once when
+			 *				  it completes. Throws what
+			 *				  Session::sendRequest throws, handler is then
+			 *				  not called.
+			 * Arguments	: request is the request
+			 *				  handler receives the completion, it must stay
+			 *				  alive until then
+			 * Returns		: correlation id of the request
+			 *---------------------------------------------------------------*/
+			blpapi::CorrelationId sendRequest(const blpapi::Request& request,
+				ResponseHandler& handler);
+
+			/*----------------------------------------------------------------
+			 * Name			: processEvent
+			 * Description	: Completes the requests answered in event, and
+			 *				  fails every outstanding request when the
+			 *				  session terminates
+			 * Arguments	: event is any event
+			 * Returns		: true if event had a requester message
+			 *---------------------------------------------------------------*/
+			bool processEvent(const blpapi::Event& event);
+
+			/*----------------------------------------------------------------
+			 * Name			: numOutstanding
+			 * Description	: Returns the number of requests not completed
+			 * Arguments	: none
+			 * Returns		: number of outstanding requests
+			 *---------------------------------------------------------------*/
+			size_t numOutstanding();
+
+			/*----------------------------------------------------------------
+			 * Name			: requestId
+			 * Description	: Finds the request of a message by the
+			 *				  integer correlation ids of one classId,
+			 *				  for the classes that route their own
+			 *				  requests, e.g. RequestPlanner
+			 * Arguments	: msg is the message
+			 *				  classId is the classId of the requests
+			 *				  id receives the integer of the correlation
+			 *				  id
+			 * Returns		: true if msg answers a request of classId
+			 *---------------------------------------------------------------*/
+			static bool requestId(const blpapi::Message& msg, int classId,
+				long long *id);
+
+			/*----------------------------------------------------------------
+			 * Name			: requestError
+			 * Description	: Tells if a message of a request fails it
+			 * Arguments	: msg is the message
+			 *				  error receives the RequestFailure reason or
+			 *				  the responseError message
+			 * Returns		: true if msg is a RequestFailure or has a
+			 *				  responseError
+			 *---------------------------------------------------------------*/
+			static bool requestError(const blpapi::Message& msg, std::string *error);
+
+		private:
+			struct Outstanding
+			{
+				ResponseHandler *handler_;
+				std::vector<blpapi::Message> messages_;
+			};
+
+			//a request completed while the lock was held
+			struct Completion
+			{
+				long long id_;
+				ResponseHandler *handler_;
+				std::vector<blpapi::Message> messages_;
+				std::string error_;
+				bool failed_;
+			};
+
+			blpapi::Session& session_;
+			const blpapi::Identity *identity_;
+
+			SyncIO lock_;
+			std::map<long long, Outstanding> outstanding_;
+			long long nextId_;
+
+			// Unimplemented
+			AsyncRequester(const AsyncRequester&);
+			AsyncRequester& operator=(const AsyncRequester&);
+	};
+}
+
+#endif
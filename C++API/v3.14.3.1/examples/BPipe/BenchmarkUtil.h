@@ -0,0 +1,178 @@
+/* --------------------------------------------------------------------
+ *                          DISCLAIMER OF WARRANTY
+ *
+ * THE CODE SAMPLES PROVIDED IN THIS SDK (IN SOURCE CODE AND BINARY FORM) ARE
+ * PROVIDED "AS IS," WITHOUT A WARRANTY OF ANY KIND. ALL EXPRESS OR IMPLIED
+ * CONDITIONS, REPRESENTATIONS AND WARRANTIES, INCLUDING ANY IMPLIED WARRANTY
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE OR NON-INFRINGEMENT,
+ * ARE HEREBY EXCLUDED. BLOOMBERG AND ITS LICENSORS SHALL NOT BE LIABLE FOR
+ * ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR
+ * DISTRIBUTING THE SOFTWARE OR ITS DERIVATIVES. IN NO EVENT WILL BLOOMBERG
+ * OR ITS LICENSORS BE LIABLE FOR ANY LOST REVENUE, PROFIT OR DATA, OR FOR
+ * DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL, INCIDENTAL OR PUNITIVE DAMAGES,
+ * HOWEVER CAUSED AND REGARDLESS OF THE THEORY OF LIABILITY, ARISING OUT OF
+ * THE USE OF OR INABILITY TO USE SOFTWARE, EVEN IF BLOOMBERG HAS BEEN ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGES.
+ * THE CODE SAMPLES PROVIDED WITH THE B-PIPE SDK ARE NOT INTENDED FOR
+ * PRODUCTION USE, AND IF PUT TO SUCH USE THEY MAY RESULT IN SLOWNESS OR LOSS
+ * OF DATA.
+ * ----------------------------------------------------------------- */
+
+/* --------------------------------------------------------------------
+ * File: BenchmarkUtil.h
+ *
+ * Description: This source code holds the pieces the book benchmarks
+ *				share: a repeatable random number generator and the
+ *				parsing and usage text of their numeric options.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef _BENCHMARKUTIL_H_
+#define  _BENCHMARKUTIL_H_
+
+#include <stddef.h>  // size_t
+#include <stdlib.h>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/* --------------------------------------------------------------------
+ * Class/Struct : BenchmarkRandom
+ * Description  : Linear congruential generator, so that runs with the
+ *				  same seed generate the same commands
+ * --------------------------------------------------------------------*/
+class BenchmarkRandom
+{
+    public:
+		/*-------------------------------------------------
+		 * Name			: BenchmarkRandom
+		 * Description	: Constructor
+		 * Arguments	: seed is the first state
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        explicit BenchmarkRandom(unsigned int seed = 1)
+        : seed_(seed)
+        {
+        }
+
+		/*-------------------------------------------------
+		 * Name			: next
+		 * Description	: Advances the generator
+		 * Arguments	: none
+		 * Returns		: pseudo random number from 0 to 0x7fff
+		 *-------------------------------------------------*/
+        unsigned int next()
+        {
+            seed_ = seed_ * 1103515245 + 12345;
+            return (seed_ >> 16) & 0x7fff;
+        }
+
+    private:
+        unsigned int seed_;
+};
+
+/* --------------------------------------------------------------------
+ * Class/Struct : BenchmarkOption
+ * Description  : One numeric command line option. A flag sets value_
+ *				  or, if value_ is 0, appends to values_ each time it
+ *				  is given.
+ * --------------------------------------------------------------------*/
+struct BenchmarkOption
+{
+    //flag, e.g. "-n"
+    const char *name_;
+
+    //text shown after the flag by printBenchmarkUsage(),
+    //e.g. "updates = 1000000"
+    const char *usage_;
+
+    unsigned int *value_;
+    std::vector<unsigned int> *values_;
+
+    //least value accepted
+    unsigned int minimum_;
+};
+
+/*-------------------------------------------------
+ * Name			: parseBenchmarkOptions
+ * Description	: Sets the options from the command line
+ * Arguments	: argc, argv are the arguments of main()
+ *				  options are the options accepted
+ *				  count is the number of options
+ * Returns		: false for an unknown flag, a flag without
+ *				  a value or a value below the minimum
+ *-------------------------------------------------*/
+inline bool parseBenchmarkOptions(int argc, char **argv,
+    const BenchmarkOption *options, size_t count)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const BenchmarkOption *option = 0;
+        for (size_t j = 0; j < count && option == 0; ++j)
+        {
+            if (!std::strcmp(argv[i], options[j].name_))
+            {
+                option = &options[j];
+            }
+        }
+        if (option == 0 || i + 1 >= argc)
+        {
+            return false;
+        }
+        int value = std::atoi(argv[++i]);
+        if (value < 0 || (unsigned int)value < option->minimum_)
+        {
+            return false;
+        }
+        if (option->value_ != 0)
+        {
+            *option->value_ = (unsigned int)value;
+        }
+        else
+        {
+            option->values_->push_back((unsigned int)value);
+        }
+    }
+    return true;
+}
+
+/*-------------------------------------------------
+ * Name			: printBenchmarkUsage
+ * Description	: Prints the usage of a benchmark
+ * Arguments	: purpose is the one line description
+ *				  options are the options accepted
+ *				  count is the number of options
+ *				  notes are printed after the options, one
+ *				  per line, 0 for none
+ * Returns		: none
+ *-------------------------------------------------*/
+inline void printBenchmarkUsage(const char *purpose,
+    const BenchmarkOption *options, size_t count, const char *notes)
+{
+    std::cout << "Usage:" << std::endl
+        << "    " << purpose << std::endl;
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::string name(options[i].name_);
+        if (name.size() < 9)
+        {
+            name.resize(9, ' ');
+        }
+        std::cout << "      [" << name << "<" << options[i].usage_ << ">" << std::endl;
+    }
+    if (notes != 0)
+    {
+        std::cout << "notes:" << std::endl << notes;
+    }
+}
+
+#endif
@@ -0,0 +1,326 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: BookSnapshotBenchmark.cpp
+ *
+ * Description: Measures the cost of reading a market depth book while
+ *				the book is being updated. One thread applies table
+ *				commands to a book (the event handler thread in
+ *				MarketDepthSubscriptionSnapshotExample) while reader
+ *				threads read the top of the book either with getEntry(),
+ *				which locks the book, or with getSnapshot(), which reads
+ *				the seqlock published snapshot.
+ *				No B-Pipe connection is needed.
+ * ----------------------------------------------------------------- */
+
+#include <blpapi_highresolutionclock.h>
+#include <blpapi_timepoint.h>
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include "OrderBook.h"
+#include "LevelBook.h"
+#include "BenchmarkUtil.h"
+
+#if defined(WIN32) || defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+using namespace std;
+using namespace BloombergLP;
+using namespace blpapi;
+
+namespace {
+	const int MUTEX_READ = 0;
+	const int SNAPSHOT_READ = 1;
+	const char *READ_MODE_NAMES[] = { "getEntry (mutex)", "getSnapshot (seqlock)" };
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: ReaderContext
+	 * Description	: state shared between the writer and one reader thread
+	 *------------------------------------------------------------------------------------*/
+	template <typename BOOK>
+	struct ReaderContext
+	{
+		BOOK *book;
+		int readMode;
+		unsigned int depth;
+		volatile int *stop;
+		unsigned long long reads;
+	};
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: makeEntry
+	 * Description	: create a book entry for the benchmark
+	 * Arguments	: book is the book the entry is for
+	 *              : entry receives the new entry
+	 *              : price, time, size are the entry fields
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	void makeEntry(ByLevelBook &book, ByLevelBookEntry *entry, double price, unsigned int time, unsigned int size)
+	{
+		*entry = ByLevelBookEntry(book.priceScale().fromDouble(price), time, 1, size);
+	}
+
+	void makeEntry(ByOrderBook &book, ByOrderBookEntry *entry, double price, unsigned int time, unsigned int size)
+	{
+		*entry = ByOrderBookEntry(book.internBroker("BRKR"), book.priceScale().fromDouble(price), time, size);
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: setWindow
+	 * Description	: set the book window size
+	 * Arguments	: book is the book
+	 *              : size is the window size
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	void setWindow(ByLevelBook *book, unsigned int size)
+	{
+		book->setWindowSize(size);
+	}
+
+	void setWindow(ByOrderBook *book, unsigned int size)
+	{
+		book->window_size = size;
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: readerLoop
+	 * Description	: reads the top of book until stop is set
+	 * Arguments	: context is the reader state
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	template <typename BOOK, typename ENTRY>
+	void readerLoop(ReaderContext<BOOK> *context)
+	{
+		std::vector<ENTRY> entries(context->depth);
+		while (!*context->stop) {
+			if (context->readMode == SNAPSHOT_READ) {
+				context->book->getSnapshot(&entries[0], context->depth);
+			} else {
+				// same access pattern as the original ShowBy*Book()
+				unsigned int size = context->book->size();
+				for (unsigned int i = 0; i < size && i < context->depth; ++i) {
+					context->book->getEntry(i, entries[i]);
+				}
+			}
+			++context->reads;
+		}
+	}
+
+#if defined(WIN32) || defined(_WIN32)
+	typedef HANDLE ThreadHandle;
+
+	template <typename BOOK, typename ENTRY>
+	DWORD WINAPI readerThread(LPVOID arg)
+	{
+		readerLoop<BOOK, ENTRY>(static_cast<ReaderContext<BOOK> *>(arg));
+		return 0;
+	}
+
+	template <typename BOOK, typename ENTRY>
+	ThreadHandle startReader(ReaderContext<BOOK> *context)
+	{
+		return CreateThread(NULL, 0, readerThread<BOOK, ENTRY>, context, 0, NULL);
+	}
+
+	void joinThread(ThreadHandle handle)
+	{
+		WaitForSingleObject(handle, INFINITE);
+		CloseHandle(handle);
+	}
+#else
+	typedef pthread_t ThreadHandle;
+
+	template <typename BOOK, typename ENTRY>
+	void *readerThread(void *arg)
+	{
+		readerLoop<BOOK, ENTRY>(static_cast<ReaderContext<BOOK> *>(arg));
+		return 0;
+	}
+
+	template <typename BOOK, typename ENTRY>
+	ThreadHandle startReader(ReaderContext<BOOK> *context)
+	{
+		ThreadHandle handle;
+		pthread_create(&handle, NULL, readerThread<BOOK, ENTRY>, context);
+		return handle;
+	}
+
+	void joinThread(ThreadHandle handle)
+	{
+		pthread_join(handle, NULL);
+	}
+#endif
+}
+
+class BookSnapshotBenchmark
+{
+	unsigned int d_windowSize;
+	unsigned int d_depth;
+	unsigned int d_numReaders;
+	unsigned int d_numUpdates;
+	BenchmarkRandom d_random;
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: runOne
+	 * Description	: apply d_numUpdates table commands to a book while the
+	 *				  readers run, and print the result
+	 * Arguments	: bookName is the name printed
+	 *              : readMode is MUTEX_READ or SNAPSHOT_READ
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	template <typename BOOK, typename ENTRY>
+	void runOne(const char *bookName, int readMode)
+	{
+		BOOK book;
+		setWindow(&book, d_windowSize);
+		book.setSnapshotDepth(readMode == SNAPSHOT_READ ? d_depth : 0);
+
+		ENTRY entry;
+		for (unsigned int i = 0; i < d_windowSize; ++i) {
+			makeEntry(book, &entry, 100.0 + i, i, 100);
+			book.doAdd(i, entry);
+		}
+
+		volatile int stop = 0;
+		std::vector<ReaderContext<BOOK> > contexts(d_numReaders);
+		std::vector<ThreadHandle> threads(d_numReaders);
+		for (unsigned int i = 0; i < d_numReaders; ++i) {
+			contexts[i].book = &book;
+			contexts[i].readMode = readMode;
+			contexts[i].depth = d_depth;
+			contexts[i].stop = &stop;
+			contexts[i].reads = 0;
+			threads[i] = startReader<BOOK, ENTRY>(&contexts[i]);
+		}
+
+		d_random = BenchmarkRandom();
+		TimePoint start = HighResolutionClock::now();
+		for (unsigned int n = 0; n < d_numUpdates; ++n) {
+			unsigned int pos = d_random.next() % d_windowSize;
+			makeEntry(book, &entry, 100.0 + pos, n, d_random.next() % 1000);
+			// mostly MOD with ADD/DEL pairs to keep the book full
+			switch (d_random.next() % 4) {
+				case 0:
+					book.doAdd(pos, entry);
+					break;
+				case 1:
+					book.doDel(pos);
+					book.doAdd(pos, entry);
+					break;
+				default:
+					book.doMod(pos < book.size() ? pos : 0, entry);
+					break;
+			}
+		}
+		TimePoint end = HighResolutionClock::now();
+
+		stop = 1;
+		unsigned long long reads = 0;
+		for (unsigned int i = 0; i < d_numReaders; ++i) {
+			joinThread(threads[i]);
+			reads += contexts[i].reads;
+		}
+
+		long long elapsed = TimePointUtil::nanosecondsBetween(start, end);
+		std::cout << setw(12) << bookName << "  " << setw(22) << READ_MODE_NAMES[readMode]
+			<< "  " << setw(10) << std::fixed << std::setprecision(1)
+			<< (double)elapsed / d_numUpdates << " ns/update"
+			<< "  " << setw(12) << std::setprecision(0)
+			<< (elapsed > 0 ? reads * 1e9 / elapsed : 0.0) << " reads/s" << std::endl;
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: parseCommandLine
+	 * Description	: process command line parameters
+	 * Arguments	: none
+	 * Returns		: true - successful, false - failed
+	 *------------------------------------------------------------------------------------*/
+	bool parseCommandLine(int argc, char **argv)
+	{
+		BenchmarkOption options[] = {
+			{ "-w", "window size = 10", &d_windowSize, 0, 1 },
+			{ "-depth", "levels read = 10", &d_depth, 0, 1 },
+			{ "-r", "reader threads = 1", &d_numReaders, 0, 0 },
+			{ "-n", "updates = 1000000", &d_numUpdates, 0, 1 }
+		};
+		const size_t numOptions = sizeof(options) / sizeof(options[0]);
+		if (!parseBenchmarkOptions(argc, argv, options, numOptions)) {
+			printBenchmarkUsage("Compare locked and snapshot reads of the market depth books",
+				options, numOptions, 0);
+			return false;
+		}
+		return true;
+	}
+
+public:
+	/*------------------------------------------------------------------------------------
+	 * Name			: BookSnapshotBenchmark
+	 * Description	: constructor
+	 * Arguments	: none
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	BookSnapshotBenchmark()
+	: d_windowSize(10)
+	, d_depth(10)
+	, d_numReaders(1)
+	, d_numUpdates(1000000)
+	{
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: run
+	 * Description	: run every book and read mode combination
+	 * Arguments	: argc is number arguments
+	 *              : argv are the argument values
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	void run(int argc, char **argv)
+	{
+		if (!parseCommandLine(argc, argv)) return;
+
+		std::cout << "window " << d_windowSize << ", depth " << d_depth
+			<< ", " << d_numReaders << " reader(s), " << d_numUpdates
+			<< " updates" << std::endl;
+		for (int mode = MUTEX_READ; mode <= SNAPSHOT_READ; ++mode) {
+			runOne<ByLevelBook, ByLevelBookEntry>("ByLevelBook", mode);
+			runOne<ByOrderBook, ByOrderBookEntry>("ByOrderBook", mode);
+		}
+	}
+};
+
+/*------------------------------------------------------------------------------------
+ * Name			: main
+ * Description	: main function
+ * Arguments	: argc is number arguments
+ *              : argv are the argument values
+ * Returns		: none
+ *------------------------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+	std::cout << "BookSnapshotBenchmark" << std::endl;
+	BookSnapshotBenchmark benchmark;
+	benchmark.run(argc, argv);
+	return 0;
+}
@@ -0,0 +1,346 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: DepthBookBenchmark.cpp
+ *
+ * Description: Measures the update cost of the market depth books.
+ *				A repeatable stream of MBO or MBL table commands is
+ *				generated for each depth, then applied to both sides
+ *				of a book through applyRow(), the path the event
+ *				handler of MarketDepthSubscriptionSnapshotExample
+ *				uses. One pass gives the throughput, a second pass
+ *				times every update for the latency percentiles.
+ *				No B-Pipe connection is needed.
+ * ----------------------------------------------------------------- */
+
+#include <blpapi_highresolutionclock.h>
+#include <blpapi_timepoint.h>
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include "OrderBook.h"
+#include "LevelBook.h"
+#include "DepthCommand.h"
+#include "BenchmarkUtil.h"
+
+using namespace std;
+using namespace BloombergLP;
+using namespace blpapi;
+
+namespace {
+	//broker codes of the generated MBO commands
+	const char *BROKERS[] = {
+		"BARC", "CITI", "CSFB", "DBKL", "GSIL", "HSBC", "JPMS", "MLIL",
+		"MSIL", "NOMU", "RBSE", "SGEN", "UBSW", "WINS", "CNVX", "INST"
+	};
+	const unsigned int NUM_BROKERS = sizeof(BROKERS) / sizeof(BROKERS[0]);
+
+	//depths run when none is given on the command line
+	const unsigned int DEFAULT_DEPTHS[] = { 10, 50, 500 };
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: Command
+	 * Description	: one generated table command and the side it applies to
+	 *------------------------------------------------------------------------------------*/
+	struct Command
+	{
+		int side;
+		DepthRow row;
+	};
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: percentile
+	 * Description	: returns a percentile of sorted latencies
+	 * Arguments	: latencies are sorted in increasing order
+	 *              : fraction is the percentile, 0.99 for p99
+	 * Returns		: latency in nanoseconds
+	 *------------------------------------------------------------------------------------*/
+	long long percentile(const std::vector<long long> &latencies, double fraction)
+	{
+		if (latencies.empty()) {
+			return 0;
+		}
+		size_t index = (size_t)(fraction * (latencies.size() - 1) + 0.5);
+		return latencies[index];
+	}
+}
+
+class DepthBookBenchmark
+{
+	std::vector<unsigned int> d_depths;
+	unsigned int d_numUpdates;
+	BenchmarkRandom d_random;
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: nextPosition
+	 * Description	: picks a position, most activity is near the top of book
+	 * Arguments	: range is the number of positions to pick from
+	 * Returns		: position from 0 to range - 1
+	 *------------------------------------------------------------------------------------*/
+	unsigned int nextPosition(unsigned int range)
+	{
+		unsigned int a = d_random.next() % range;
+		unsigned int b = d_random.next() % range;
+		return a < b ? a : b;
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: makeRow
+	 * Description	: fills a row with the price and size of a position
+	 * Arguments	: row receives the command
+	 *              : side is 0 for bid, 1 for ask
+	 *              : command is the TableCommand
+	 *              : pos is the position
+	 *              : n is the command number, used as the tick time
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	void makeRow(DepthRow *row, int side, int command, unsigned int pos, unsigned int n)
+	{
+		// levels one tick apart, away from a 100.00 mid
+		double tick = 0.01;
+		row->command = command;
+		row->position = (int)pos;
+		row->price = side == 0 ? 100.0 - tick * (pos + 1) : 100.0 + tick * (pos + 1);
+		row->size = 100 * (1 + d_random.next() % 50);
+		row->numOrders = 1 + d_random.next() % 20;
+		row->broker = BROKERS[d_random.next() % NUM_BROKERS];
+		row->time = n % 86400000;
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: generate
+	 * Description	: generates a repeatable command stream for a depth.
+	 *				  The size of each side is tracked so every command
+	 *				  addresses an existing position.
+	 *				  MBO is mostly ADD and DEL of orders with some MOD and
+	 *				  EXEC at the top, MBL is mostly MOD of levels with some
+	 *				  ADD, DEL, REPLACE and EXEC.
+	 * Arguments	: byOrder is true for MBO, false for MBL
+	 *              : depth is the window size
+	 *              : commands receives the stream
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	void generate(bool byOrder, unsigned int depth, std::vector<Command> *commands)
+	{
+		// percentages of ADD, DEL, MOD, REPLACE, EXEC
+		static const unsigned int MBO_MIX[] = { 40, 35, 20, 0, 5 };
+		static const unsigned int MBL_MIX[] = { 15, 15, 60, 5, 5 };
+		static const int MIX_COMMANDS[] = { CMD_ADD, CMD_DEL, CMD_MOD, CMD_REPLACE, CMD_EXEC };
+		const unsigned int *mix = byOrder ? MBO_MIX : MBL_MIX;
+
+		d_random = BenchmarkRandom();
+		unsigned int size[2] = { depth, depth };
+		commands->resize(d_numUpdates);
+		for (unsigned int n = 0; n < d_numUpdates; ++n) {
+			Command &command = (*commands)[n];
+			command.side = d_random.next() % 2;
+			unsigned int &sideSize = size[command.side];
+
+			unsigned int pick = d_random.next() % 100;
+			int cmd = CMD_ADD;
+			for (int i = 0; i < 5; ++i) {
+				if (pick < mix[i]) {
+					cmd = MIX_COMMANDS[i];
+					break;
+				}
+				pick -= mix[i];
+			}
+			if (sideSize == 0) {
+				cmd = CMD_ADD;
+			}
+
+			unsigned int pos = 0;
+			switch (cmd) {
+				case CMD_ADD:
+					pos = nextPosition(sideSize + 1);
+					if (sideSize < depth) ++sideSize;
+					break;
+				case CMD_DEL:
+					pos = nextPosition(sideSize);
+					--sideSize;
+					break;
+				case CMD_EXEC:
+					// trades hit the top of book
+					pos = 0;
+					break;
+				default:
+					pos = nextPosition(sideSize);
+					break;
+			}
+			makeRow(&command.row, command.side, cmd, pos, n);
+		}
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: fill
+	 * Description	: fills both sides of a book to its depth
+	 * Arguments	: books are the bid and ask sides
+	 *              : depth is the window size
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	template <typename BOOK>
+	void fill(BOOK *books, unsigned int depth)
+	{
+		for (int side = 0; side < 2; ++side) {
+			books[side].doClearAll();
+			setWindow(books[side], depth);
+			for (unsigned int pos = 0; pos < depth; ++pos) {
+				DepthRow row;
+				makeRow(&row, side, CMD_ADD, pos, pos);
+				applyRow(books[side], row);
+			}
+		}
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: runOne
+	 * Description	: apply the command stream of a depth to a book, once
+	 *				  for the throughput and once timing each update, and
+	 *				  print the result
+	 * Arguments	: bookName is the name printed
+	 *              : byOrder is true for MBO, false for MBL
+	 *              : depth is the window size
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	template <typename BOOK>
+	void runOne(const char *bookName, bool byOrder, unsigned int depth)
+	{
+		std::vector<Command> commands;
+		generate(byOrder, depth, &commands);
+
+		BOOK books[2];
+		fill(books, depth);
+		TimePoint start = HighResolutionClock::now();
+		for (unsigned int n = 0; n < d_numUpdates; ++n) {
+			applyRow(books[commands[n].side], commands[n].row);
+		}
+		long long elapsed = TimePointUtil::nanosecondsBetween(start, HighResolutionClock::now());
+
+		// same commands from the same starting book, timed one by one
+		std::vector<long long> latencies(d_numUpdates);
+		fill(books, depth);
+		for (unsigned int n = 0; n < d_numUpdates; ++n) {
+			TimePoint before = HighResolutionClock::now();
+			applyRow(books[commands[n].side], commands[n].row);
+			latencies[n] = TimePointUtil::nanosecondsBetween(before, HighResolutionClock::now());
+		}
+		std::sort(latencies.begin(), latencies.end());
+
+		std::cout << setw(12) << bookName << "  depth " << setw(4) << depth
+			<< "  " << setw(8) << std::fixed << std::setprecision(1)
+			<< (double)elapsed / d_numUpdates << " ns/update"
+			<< "  p50 " << setw(6) << percentile(latencies, 0.5)
+			<< "  p99 " << setw(6) << percentile(latencies, 0.99)
+			<< "  p99.9 " << setw(7) << percentile(latencies, 0.999)
+			<< "  max " << setw(8) << latencies.back() << std::endl;
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: clockOverhead
+	 * Description	: measures the cost of the two clock reads around each
+	 *				  timed update, included in the percentiles
+	 * Arguments	: none
+	 * Returns		: median nanoseconds between two consecutive clock reads
+	 *------------------------------------------------------------------------------------*/
+	long long clockOverhead()
+	{
+		std::vector<long long> samples(10000);
+		for (size_t i = 0; i < samples.size(); ++i) {
+			TimePoint before = HighResolutionClock::now();
+			samples[i] = TimePointUtil::nanosecondsBetween(before, HighResolutionClock::now());
+		}
+		std::sort(samples.begin(), samples.end());
+		return percentile(samples, 0.5);
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: parseCommandLine
+	 * Description	: process command line parameters
+	 * Arguments	: none
+	 * Returns		: true - successful, false - failed
+	 *------------------------------------------------------------------------------------*/
+	bool parseCommandLine(int argc, char **argv)
+	{
+		BenchmarkOption options[] = {
+			{ "-d", "depth = 10, 50 and 500", 0, &d_depths, 1 },
+			{ "-n", "updates per run = 1000000", &d_numUpdates, 0, 1 }
+		};
+		const size_t numOptions = sizeof(options) / sizeof(options[0]);
+		if (!parseBenchmarkOptions(argc, argv, options, numOptions)) {
+			printBenchmarkUsage("Measure the update cost of the market depth books",
+				options, numOptions,
+				" -Repeat -d to run several depths.\n"
+				" -Latencies are in nanoseconds and include one clock read.\n");
+			return false;
+		}
+		if (d_depths.empty()) {
+			d_depths.assign(DEFAULT_DEPTHS,
+				DEFAULT_DEPTHS + sizeof(DEFAULT_DEPTHS) / sizeof(DEFAULT_DEPTHS[0]));
+		}
+		return true;
+	}
+
+public:
+	/*------------------------------------------------------------------------------------
+	 * Name			: DepthBookBenchmark
+	 * Description	: constructor
+	 * Arguments	: none
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	DepthBookBenchmark()
+	: d_numUpdates(1000000)
+	{
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: run
+	 * Description	: run both books at every depth
+	 * Arguments	: argc is number arguments
+	 *              : argv are the argument values
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	void run(int argc, char **argv)
+	{
+		if (!parseCommandLine(argc, argv)) return;
+
+		std::cout << d_numUpdates << " updates per run, clock read "
+			<< clockOverhead() << " ns" << std::endl;
+		for (size_t i = 0; i < d_depths.size(); ++i) {
+			runOne<ByOrderBook>("ByOrderBook", true, d_depths[i]);
+			runOne<ByLevelBook>("ByLevelBook", false, d_depths[i]);
+		}
+	}
+};
+
+/*------------------------------------------------------------------------------------
+ * Name			: main
+ * Description	: main function
+ * Arguments	: argc is number arguments
+ *              : argv are the argument values
+ * Returns		: none
+ *------------------------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+	std::cout << "DepthBookBenchmark" << std::endl;
+	DepthBookBenchmark benchmark;
+	benchmark.run(argc, argv);
+	return 0;
+}
@@ -0,0 +1,255 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: DepthBookRegistry.cpp
+ *
+ * Description: This file contains the registry of market depth books,
+ *				one per subscription.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#include "DepthBookRegistry.h"
+
+/* --------------------------------------------------------------------
+ * Class/Struct : DepthBook
+ * Description  : Books and sequence state of one subscription
+ * --------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------
+ * Name			: DepthBook constructor
+ * Description	: Constructs empty books of unknown type
+ * Arguments	: id is the subscription correlation id value
+ *				  topic is the subscription string
+ * Returns		: none
+ *---------------------------------------------------------------*/
+BloombergLP::DepthBook::DepthBook(long long id, const std::string& topic)
+	: id(id)
+	, topic(topic)
+	, marketDepthBook(UNKNOWN)
+	, sequenceNumber(0)
+	, gapDetected(0)
+	, askRetran(0)
+	, bidRetran(0)
+	, resubscribed(0)
+{
+	top.bookId_ = id;
+}
+
+
+/*----------------------------------------------------------------
+ * Class		 : DepthBookRegistry
+ * Description   : Owns the DepthBook of every subscription
+ *---------------------------------------------------------------*/
+
+/*----------------------------------------------------------------
+ * Name			: Shard constructor
+ * Description	: Constructs an empty shard
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+BloombergLP::DepthBookRegistry::Shard::Shard()
+	: slots_(16, (DepthBook *)0)
+	, count_(0)
+{
+}
+
+/*----------------------------------------------------------------
+ * Name			: DepthBookRegistry constructor
+ * Description	: Constructs an empty registry
+ * Arguments	: numShards is the number of shards, rounded up
+ *				  to a power of two
+ * Returns		: none
+ *---------------------------------------------------------------*/
+BloombergLP::DepthBookRegistry::DepthBookRegistry(unsigned int numShards)
+	: numShards_(1)
+{
+	while (numShards_ < numShards)
+	{
+		numShards_ *= 2;
+	}
+	shards_ = new Shard[numShards_];
+}
+
+/*----------------------------------------------------------------
+ * Name			: DepthBookRegistry destructor
+ * Description	: Deletes all the books
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+BloombergLP::DepthBookRegistry::~DepthBookRegistry()
+{
+	for (unsigned int i = 0; i < numShards_; ++i)
+	{
+		std::vector<DepthBook *>& slots = shards_[i].slots_;
+		for (unsigned int slot = 0; slot < slots.size(); ++slot)
+		{
+			delete slots[slot];
+		}
+	}
+	delete [] shards_;
+}
+
+/*----------------------------------------------------------------
+ * Name			: add
+ * Description	: Adds the book of a subscription
+ * Arguments	: id is the subscription correlation id value
+ *				  topic is the subscription string
+ * Returns		: the new book, or the book already added for id
+ *---------------------------------------------------------------*/
+BloombergLP::DepthBook *BloombergLP::DepthBookRegistry::add(long long id, const std::string& topic)
+{
+	unsigned long long hash = hashOf(id);
+	Shard& shard = shards_[(hash >> 32) & (numShards_ - 1)];
+	Guard guard(shard.lock_);
+
+	unsigned int slot = slotOf(shard, id, hash);
+	if (shard.slots_[slot] != 0)
+	{
+		return shard.slots_[slot];
+	}
+
+	DepthBook *book = new DepthBook(id, topic);
+	shard.slots_[slot] = book;
+	++shard.count_;
+
+	//keep the load factor under one half
+	if (shard.count_ * 2 > shard.slots_.size())
+	{
+		grow(shard);
+	}
+	return book;
+}
+
+/*----------------------------------------------------------------
+ * Name			: find
+ * Description	: Looks up the book of a subscription
+ * Arguments	: id is the subscription correlation id value
+ * Returns		: the book, 0 if there is no book for id
+ *---------------------------------------------------------------*/
+BloombergLP::DepthBook *BloombergLP::DepthBookRegistry::find(long long id)
+{
+	unsigned long long hash = hashOf(id);
+	Shard& shard = shards_[(hash >> 32) & (numShards_ - 1)];
+	Guard guard(shard.lock_);
+	return shard.slots_[slotOf(shard, id, hash)];
+}
+
+/*----------------------------------------------------------------
+ * Name			: size
+ * Description	: Returns the number of books
+ * Arguments	: none
+ * Returns		: number of books
+ *---------------------------------------------------------------*/
+unsigned int BloombergLP::DepthBookRegistry::size()
+{
+	unsigned int count = 0;
+	for (unsigned int i = 0; i < numShards_; ++i)
+	{
+		Guard guard(shards_[i].lock_);
+		count += shards_[i].count_;
+	}
+	return count;
+}
+
+/*----------------------------------------------------------------
+ * Name			: getBooks
+ * Description	: Lists all the books, in no particular order
+ * Arguments	: books receives the books
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::DepthBookRegistry::getBooks(std::vector<DepthBook *>& books)
+{
+	books.clear();
+	for (unsigned int i = 0; i < numShards_; ++i)
+	{
+		Guard guard(shards_[i].lock_);
+		const std::vector<DepthBook *>& slots = shards_[i].slots_;
+		for (unsigned int slot = 0; slot < slots.size(); ++slot)
+		{
+			if (slots[slot] != 0)
+			{
+				books.push_back(slots[slot]);
+			}
+		}
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: hashOf
+ * Description	: Mixes the bits of an id (splitmix64 finalizer).
+ *				  The high half picks the shard, the low half the
+ *				  slot within the shard.
+ * Arguments	: id is the book id
+ * Returns		: hash of id
+ *---------------------------------------------------------------*/
+unsigned long long BloombergLP::DepthBookRegistry::hashOf(long long id)
+{
+	unsigned long long hash = (unsigned long long)id;
+	hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+	return hash ^ (hash >> 31);
+}
+
+/*----------------------------------------------------------------
+ * Name			: slotOf
+ * Description	: Finds the slot holding id, or the empty slot
+ *				  where it should be added
+ * Arguments	: shard is the shard of id
+ *				  id is the book id
+ *				  hash is hashOf(id)
+ * Returns		: slot index
+ *---------------------------------------------------------------*/
+unsigned int BloombergLP::DepthBookRegistry::slotOf(const Shard& shard, long long id, unsigned long long hash)
+{
+	unsigned int mask = (unsigned int)shard.slots_.size() - 1;
+	unsigned int slot = (unsigned int)hash & mask;
+	while (shard.slots_[slot] != 0 && shard.slots_[slot]->id != id)
+	{
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+/*----------------------------------------------------------------
+ * Name			: grow
+ * Description	: Doubles the shard table and rehashes its books
+ * Arguments	: shard is the shard to grow
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::DepthBookRegistry::grow(Shard& shard)
+{
+	std::vector<DepthBook *> books;
+	books.swap(shard.slots_);
+	shard.slots_.assign(books.size() * 2, (DepthBook *)0);
+	for (unsigned int i = 0; i < books.size(); ++i)
+	{
+		if (books[i] != 0)
+		{
+			shard.slots_[slotOf(shard, books[i]->id, hashOf(books[i]->id))] = books[i];
+		}
+	}
+}
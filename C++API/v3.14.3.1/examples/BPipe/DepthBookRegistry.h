@@ -0,0 +1,232 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: DepthBookRegistry.h
+ *
+ * Description: This file contains the registry of market depth books,
+ *				one per subscription, indexed by the integer value of
+ *				the subscription correlation id.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef __DepthBookRegistry_h__
+#define __DepthBookRegistry_h__
+
+#include <vector>
+#include <string>
+
+#include "OrderBook.h"
+#include "LevelBook.h"
+#include "SyncIO.h"
+#include "TopOfBook.h"
+
+namespace BloombergLP
+{
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : DepthBook
+	 * Description  : The bid and ask books of one market depth subscription
+	 *				  with its sequence number, gap and retran state.
+	 *				  The event handler holds lock while it applies a
+	 *				  message, so messages for the same subscription are
+	 *				  applied in turn even with several dispatcher threads.
+	 * --------------------------------------------------------------------*/
+	struct DepthBook
+	{
+		//book type of the subscription
+		enum BookType { UNKNOWN = -1, BYORDER = 0, BYLEVEL = 1 };
+
+		/*----------------------------------------------------------------
+		 * Name			: DepthBook constructor
+		 * Description	: Constructs empty books of unknown type
+		 * Arguments	: id is the subscription correlation id value
+		 *				  topic is the subscription string
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		DepthBook(long long id, const std::string& topic);
+
+		//subscription correlation id value
+		long long id;
+
+		//subscription string
+		std::string topic;
+
+		//by order books, indexed by side
+		ByOrderBook orderBooks[2];
+
+		//by level books, indexed by side
+		ByLevelBook levelBooks[2];
+
+		//BookType, set by the first market depth message
+		int marketDepthBook;
+
+		//last sequence number received, 0 to take the next one
+		long sequenceNumber;
+
+		//Bloomberg reported a gap, waiting for the retran
+		int gapDetected;
+
+		//ask/bid retran in progress
+		int askRetran;
+		int bidRetran;
+
+		//resubscribe queued after a sequence gap, cleared by the recap
+		int resubscribed;
+
+		//last top of book published
+		TopOfBook top;
+
+		//serializes the processing of this subscription's messages
+		SyncIO lock;
+
+	private:
+		// Unimplemented
+		DepthBook(const DepthBook&);
+		DepthBook& operator=(const DepthBook&);
+	};
+
+
+	/*----------------------------------------------------------------
+	 * Class		 : DepthBookRegistry
+	 * Description   : Owns the DepthBook of every subscription. Books are
+	 *				   spread over shards by a hash of their id and each
+	 *				   shard has its own lock, held only for the lookup,
+	 *				   so dispatcher threads updating different books do
+	 *				   not contend on one lock. A book never moves once
+	 *				   added and lives as long as the registry.
+	 *---------------------------------------------------------------*/
+	class DepthBookRegistry
+	{
+	public:
+		/*----------------------------------------------------------------
+		 * Name			: DepthBookRegistry constructor
+		 * Description	: Constructs an empty registry
+		 * Arguments	: numShards is the number of shards, rounded up
+		 *				  to a power of two
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		explicit DepthBookRegistry(unsigned int numShards = 16);
+
+		/*----------------------------------------------------------------
+		 * Name			: DepthBookRegistry destructor
+		 * Description	: Deletes all the books
+		 * Arguments	: none
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		~DepthBookRegistry();
+
+		/*----------------------------------------------------------------
+		 * Name			: add
+		 * Description	: Adds the book of a subscription
+		 * Arguments	: id is the subscription correlation id value
+		 *				  topic is the subscription string
+		 * Returns		: the new book, or the book already added for id
+		 *---------------------------------------------------------------*/
+		DepthBook *add(long long id, const std::string& topic);
+
+		/*----------------------------------------------------------------
+		 * Name			: find
+		 * Description	: Looks up the book of a subscription
+		 * Arguments	: id is the subscription correlation id value
+		 * Returns		: the book, 0 if there is no book for id
+		 *---------------------------------------------------------------*/
+		DepthBook *find(long long id);
+
+		/*----------------------------------------------------------------
+		 * Name			: size
+		 * Description	: Returns the number of books
+		 * Arguments	: none
+		 * Returns		: number of books
+		 *---------------------------------------------------------------*/
+		unsigned int size();
+
+		/*----------------------------------------------------------------
+		 * Name			: getBooks
+		 * Description	: Lists all the books, in no particular order
+		 * Arguments	: books receives the books
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		void getBooks(std::vector<DepthBook *>& books);
+
+	private:
+		/* --------------------------------------------------------------------
+		 * Class/Struct : Shard
+		 * Description  : Open addressing table of books, keyed by book id
+		 * --------------------------------------------------------------------*/
+		struct Shard
+		{
+			Shard();
+
+			SyncIO lock_;
+
+			//books by hash slot, 0 for an empty slot
+			std::vector<DepthBook *> slots_;
+
+			//number of books in slots_
+			unsigned int count_;
+		};
+
+		/*----------------------------------------------------------------
+		 * Name			: hashOf
+		 * Description	: Mixes the bits of an id, correlation ids are
+		 *				  often small consecutive integers
+		 * Arguments	: id is the book id
+		 * Returns		: hash of id
+		 *---------------------------------------------------------------*/
+		static unsigned long long hashOf(long long id);
+
+		/*----------------------------------------------------------------
+		 * Name			: slotOf
+		 * Description	: Finds the slot holding id, or the empty slot
+		 *				  where it should be added. Called with the
+		 *				  shard lock held.
+		 * Arguments	: shard is the shard of id
+		 *				  id is the book id
+		 *				  hash is hashOf(id)
+		 * Returns		: slot index
+		 *---------------------------------------------------------------*/
+		static unsigned int slotOf(const Shard& shard, long long id, unsigned long long hash);
+
+		/*----------------------------------------------------------------
+		 * Name			: grow
+		 * Description	: Doubles the shard table and rehashes its books.
+		 *				  Called with the shard lock held.
+		 * Arguments	: shard is the shard to grow
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		static void grow(Shard& shard);
+
+		Shard *shards_;
+		unsigned int numShards_;
+
+		// Unimplemented
+		DepthBookRegistry(const DepthBookRegistry&);
+		DepthBookRegistry& operator=(const DepthBookRegistry&);
+	};
+}
+
+#endif
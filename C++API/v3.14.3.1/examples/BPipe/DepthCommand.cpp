@@ -0,0 +1,228 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: DepthCommand.cpp
+ *
+ * Description: This file contains the code applying decoded market
+ *				depth table commands to a book.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#include "DepthCommand.h"
+
+namespace {
+	/*----------------------------------------------------------------
+	 * Name			: fitBookPrice
+	 * Description	: Widens the price scale of both sides of a book
+	 *				  to the decimals a row's price needs
+	 * Arguments	: books are the bid and ask sides
+	 *				  row is the decoded command
+	 * Returns		: none
+	 *---------------------------------------------------------------*/
+	template <typename BOOK>
+	void fitBookPrice(BOOK *books, const BloombergLP::DepthRow &row)
+	{
+		switch (row.command)
+		{
+			case BloombergLP::CMD_ADD:
+			case BloombergLP::CMD_MOD:
+			case BloombergLP::CMD_REPLACE:
+			case BloombergLP::CMD_REPLACE_BY_BROKER:
+			case BloombergLP::CMD_EXEC:
+				break;
+			default:
+				return;
+		}
+		//the sides are widened together so they keep one scale
+		unsigned int decimals = books[0].priceScale().decimalsFor(row.price);
+		if (decimals > books[0].priceScale().decimals()
+			|| decimals > books[1].priceScale().decimals())
+		{
+			books[0].widenPriceScale(decimals);
+			books[1].widenPriceScale(decimals);
+		}
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: applyRow
+ * Description	: Applies a decoded table command to one side of
+ *				  a by order book
+ * Arguments	: book is the book side
+ *				  row is the decoded command
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::applyRow(ByOrderBook &book, const DepthRow &row)
+{
+	switch (row.command)
+	{
+		case CMD_CLEARALL:
+			book.doClearAll();
+			break;
+		case CMD_DEL:
+			book.doDel(row.position);
+			break;
+		case CMD_DELALL:
+			book.doDelAll();
+			break;
+		case CMD_DELBETTER:
+			book.doDelBetter(row.position);
+			break;
+		case CMD_DELSIDE:
+			book.doDelSide();
+			break;
+		case CMD_REPLACE_CLEAR:
+			book.doReplaceClear(row.position);
+			break;
+		case CMD_ADD:
+		case CMD_MOD:
+		case CMD_REPLACE:
+		case CMD_REPLACE_BY_BROKER:
+		case CMD_EXEC:
+		{
+			ByOrderBookEntry entry(book.internBroker(row.broker),
+				book.priceScale().fromDouble(row.price), row.time, row.size);
+			if (row.command == CMD_ADD)
+				book.doAdd(row.position, entry);
+			else if (row.command == CMD_MOD)
+				book.doMod(row.position, entry);
+			else if (row.command == CMD_REPLACE)
+				book.doReplace(row.position, entry);
+			else if (row.command == CMD_REPLACE_BY_BROKER)
+				book.doReplaceByBroker(entry);
+			else
+				book.doExec(row.position, entry);
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: applyRow
+ * Description	: Applies a decoded table command to one side of
+ *				  a by level book
+ * Arguments	: book is the book side
+ *				  row is the decoded command
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::applyRow(ByLevelBook &book, const DepthRow &row)
+{
+	switch (row.command)
+	{
+		case CMD_CLEARALL:
+			book.doClearAll();
+			break;
+		case CMD_DEL:
+			if (row.position != -1)
+				book.doDel(row.position);
+			break;
+		case CMD_DELALL:
+			book.doDelAll();
+			break;
+		case CMD_DELBETTER:
+			book.doDelBetter(row.position);
+			break;
+		case CMD_DELSIDE:
+			book.doDelSide();
+			break;
+		case CMD_REPLACE_CLEAR:
+			book.doReplaceClear(row.position);
+			break;
+		case CMD_ADD:
+		case CMD_MOD:
+		case CMD_REPLACE:
+		case CMD_EXEC:
+		{
+			ByLevelBookEntry entry(book.priceScale().fromDouble(row.price),
+				row.time, row.numOrders, row.size);
+			if (row.command == CMD_ADD)
+				book.doAdd(row.position, entry);
+			else if (row.command == CMD_MOD)
+				book.doMod(row.position, entry);
+			else if (row.command == CMD_REPLACE)
+				book.doReplace(row.position, entry);
+			else
+				book.doExec(row.position, entry);
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: setWindow
+ * Description	: Sets the window size of one side of a by order book
+ * Arguments	: book is the book side
+ *				  size is the window size
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::setWindow(ByOrderBook &book, unsigned int size)
+{
+	book.window_size = size;
+}
+
+/*----------------------------------------------------------------
+ * Name			: setWindow
+ * Description	: Sets the window size of one side of a by level book
+ *				  and sizes its level array to it
+ * Arguments	: book is the book side
+ *				  size is the window size
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::setWindow(ByLevelBook &book, unsigned int size)
+{
+	book.setWindowSize(size);
+}
+
+/*----------------------------------------------------------------
+ * Name			: fitPrice
+ * Description	: Widens the price scale of both sides of a by order
+ *				  book when the price of a row needs more decimals
+ * Arguments	: books are the bid and ask sides
+ *				  row is the decoded command
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::fitPrice(ByOrderBook *books, const DepthRow &row)
+{
+	fitBookPrice(books, row);
+}
+
+/*----------------------------------------------------------------
+ * Name			: fitPrice
+ * Description	: Widens the price scale of both sides of a by level
+ *				  book when the price of a row needs more decimals
+ * Arguments	: books are the bid and ask sides
+ *				  row is the decoded command
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::fitPrice(ByLevelBook *books, const DepthRow &row)
+{
+	fitBookPrice(books, row);
+}
@@ -0,0 +1,120 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: DepthCommand.h
+ *
+ * Description: This file contains the decoded form of a market depth
+ *				table command and the code applying it to a book, shared
+ *				by the subscription example and the journal replay.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef __DepthCommand_h__
+#define __DepthCommand_h__
+
+#include "OrderBook.h"
+#include "LevelBook.h"
+
+namespace BloombergLP
+{
+
+	//MD_TABLE_CMD_RT values
+	enum TableCommand {
+		CMD_ADD, CMD_CLEARALL, CMD_DEL, CMD_DELALL, CMD_DELBETTER, CMD_DELSIDE,
+		CMD_EXEC, CMD_MOD, CMD_REPLACE, CMD_REPLACE_BY_BROKER, CMD_REPLACE_CLEAR,
+		CMD_REPLACE_BY_PRICE,
+		//command not known to this code, ignored
+		CMD_UNKNOWN = -1
+	};
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : DepthRow
+	 * Description  : Table command decoded from a market depth message
+	 *				  or table row
+	 * --------------------------------------------------------------------*/
+	struct DepthRow
+	{
+		//TableCommand
+		int command;
+
+		//0 based position, -1 if not sent
+		int position;
+
+		//price of the bid/ask as received, applyRow() converts it
+		//to the book's PriceScale
+		double price;
+
+		//bid or ask size
+		unsigned int size;
+
+		//number of orders (by level only)
+		unsigned int numOrders;
+
+		//broker code (by order only), "" if not sent. Not owned.
+		const char *broker;
+
+		//tick time in milliseconds since midnight
+		unsigned int time;
+	};
+
+	/*----------------------------------------------------------------
+	 * Name			: applyRow
+	 * Description	: Applies a decoded table command to one side of
+	 *				  a book. Unknown commands are ignored.
+	 * Arguments	: book is the book side
+	 *				  row is the decoded command
+	 * Returns		: none
+	 *---------------------------------------------------------------*/
+	void applyRow(ByOrderBook &book, const DepthRow &row);
+	void applyRow(ByLevelBook &book, const DepthRow &row);
+
+	/*----------------------------------------------------------------
+	 * Name			: fitPrice
+	 * Description	: Widens the price scale of both sides of a book
+	 *				  when the price of a row needs more decimals than
+	 *				  the book has, before applyRow() converts it. The
+	 *				  scale of each book is set by its own prices.
+	 * Arguments	: books are the bid and ask sides
+	 *				  row is the decoded command
+	 * Returns		: none
+	 *---------------------------------------------------------------*/
+	void fitPrice(ByOrderBook *books, const DepthRow &row);
+	void fitPrice(ByLevelBook *books, const DepthRow &row);
+
+	/*----------------------------------------------------------------
+	 * Name			: setWindow
+	 * Description	: Sets the window size of one side of a book from
+	 *				  the init paint
+	 * Arguments	: book is the book side
+	 *				  size is the window size
+	 * Returns		: none
+	 *---------------------------------------------------------------*/
+	void setWindow(ByOrderBook &book, unsigned int size);
+	void setWindow(ByLevelBook &book, unsigned int size);
+}
+
+#endif
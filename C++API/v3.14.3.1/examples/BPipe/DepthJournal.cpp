@@ -0,0 +1,552 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: DepthJournal.cpp
+ *
+ * Description: This file contains the binary journal of decoded market
+ *				depth table commands.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#include <blpapi_highresolutionclock.h>
+
+#include <string.h>
+#include "DepthJournal.h"
+
+#if !defined(WIN32) && !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace BloombergLP;
+using namespace blpapi;
+
+namespace {
+	//file header, followed by count records
+	struct JournalHeader
+	{
+		char magic_[8];
+		unsigned int version_;
+		unsigned int recordSize_;
+		unsigned long long count_;
+		//decimals the books started with, they widen them
+		//again as the recorded prices are applied
+		unsigned int priceDecimals_;
+		char reserved_[36];
+	};
+
+	const char JOURNAL_MAGIC[8] = { 'B', 'D', 'E', 'P', 'T', 'H', 'J', '1' };
+	const unsigned int JOURNAL_VERSION = 2;
+
+	//records the file is first sized for
+	const unsigned long long INITIAL_RECORDS = 65536;
+
+	//compile time checks of the file layout
+	typedef char HeaderSizeCheck[sizeof(JournalHeader) == 64 ? 1 : -1];
+	typedef char RecordSizeCheck[sizeof(DepthJournalRecord) == 72 ? 1 : -1];
+
+	size_t fileSize(unsigned long long records)
+	{
+		return (size_t)(sizeof(JournalHeader) + records * sizeof(DepthJournalRecord));
+	}
+}
+
+/* --------------------------------------------------------------------
+ * Class/Struct : DepthJournalRecord
+ * Description  : One journal record
+ * --------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------
+ * Name			: getRow
+ * Description	: Returns the table command of the record
+ * Arguments	: row receives the command, its broker points
+ *				  into this record
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void DepthJournalRecord::getRow(DepthRow *row) const
+{
+	row->command = command_;
+	row->position = position_;
+	row->price = price_;
+	row->size = size_;
+	row->numOrders = numOrders_;
+	row->broker = broker_;
+	row->time = time_;
+}
+
+
+/* --------------------------------------------------------------------
+ * Class/Struct : MappedFile
+ * Description  : File mapped into memory
+ * --------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------
+ * Name			: MappedFile constructor
+ * Description	: Constructs a closed file
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+MappedFile::MappedFile()
+#if defined(WIN32) || defined(_WIN32)
+: file_(INVALID_HANDLE_VALUE)
+, mapping_(0)
+#else
+: file_(-1)
+#endif
+, data_(0)
+, size_(0)
+, writable_(false)
+{
+}
+
+/*----------------------------------------------------------------
+ * Name			: MappedFile destructor
+ * Description	: Unmaps and closes the file
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+/*----------------------------------------------------------------
+ * Name			: create
+ * Description	: Creates or truncates a file and maps it read write
+ * Arguments	: path is the file name
+ *				  size is the initial size of the file
+ * Returns		: true if the file is mapped
+ *---------------------------------------------------------------*/
+bool MappedFile::create(const char *path, size_t size)
+{
+	close();
+	writable_ = true;
+#if defined(WIN32) || defined(_WIN32)
+	file_ = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, 0,
+		CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file_ == INVALID_HANDLE_VALUE) return false;
+#else
+	file_ = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (file_ == -1) return false;
+#endif
+	size_ = size;
+	if (!map()) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+/*----------------------------------------------------------------
+ * Name			: openReadOnly
+ * Description	: Maps a whole existing file read only
+ * Arguments	: path is the file name
+ * Returns		: true if the file is mapped
+ *---------------------------------------------------------------*/
+bool MappedFile::openReadOnly(const char *path)
+{
+	close();
+	writable_ = false;
+#if defined(WIN32) || defined(_WIN32)
+	file_ = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, 0,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file_ == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER length;
+	if (!GetFileSizeEx(file_, &length)) {
+		close();
+		return false;
+	}
+	size_ = (size_t)length.QuadPart;
+#else
+	file_ = ::open(path, O_RDONLY);
+	if (file_ == -1) return false;
+	struct stat info;
+	if (fstat(file_, &info) != 0) {
+		close();
+		return false;
+	}
+	size_ = (size_t)info.st_size;
+#endif
+	if (size_ == 0 || !map()) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+/*----------------------------------------------------------------
+ * Name			: resize
+ * Description	: Changes the size of a writable file and maps it again
+ * Arguments	: size is the new size
+ * Returns		: true if the file is mapped
+ *---------------------------------------------------------------*/
+bool MappedFile::resize(size_t size)
+{
+	if (!writable_ || data_ == 0) return false;
+	unmap();
+	size_ = size;
+	return map();
+}
+
+/*----------------------------------------------------------------
+ * Name			: close
+ * Description	: Unmaps and closes the file
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void MappedFile::close()
+{
+	unmap();
+#if defined(WIN32) || defined(_WIN32)
+	if (file_ != INVALID_HANDLE_VALUE) {
+		CloseHandle(file_);
+		file_ = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (file_ != -1) {
+		::close(file_);
+		file_ = -1;
+	}
+#endif
+	size_ = 0;
+}
+
+/*----------------------------------------------------------------
+ * Name			: data
+ * Description	: Returns the start of the mapping
+ * Arguments	: none
+ * Returns		: mapping, 0 if the file is not mapped
+ *---------------------------------------------------------------*/
+char *MappedFile::data() const
+{
+	return data_;
+}
+
+/*----------------------------------------------------------------
+ * Name			: size
+ * Description	: Returns the size of the mapping
+ * Arguments	: none
+ * Returns		: size in bytes
+ *---------------------------------------------------------------*/
+size_t MappedFile::size() const
+{
+	return size_;
+}
+
+/*----------------------------------------------------------------
+ * Name			: map
+ * Description	: Sizes the open file to size_ and maps it
+ * Arguments	: none
+ * Returns		: true if the file is mapped
+ *---------------------------------------------------------------*/
+bool MappedFile::map()
+{
+#if defined(WIN32) || defined(_WIN32)
+	unsigned long long length = size_;
+	//a mapping object larger than the file extends the file
+	mapping_ = CreateFileMappingA(file_, 0, writable_ ? PAGE_READWRITE : PAGE_READONLY,
+		(DWORD)(length >> 32), (DWORD)(length & 0xFFFFFFFF), 0);
+	if (mapping_ == 0) return false;
+	data_ = (char *)MapViewOfFile(mapping_, writable_ ? FILE_MAP_WRITE : FILE_MAP_READ,
+		0, 0, size_);
+	if (data_ == 0) {
+		CloseHandle(mapping_);
+		mapping_ = 0;
+		return false;
+	}
+#else
+	if (writable_ && ftruncate(file_, (off_t)size_) != 0) return false;
+	void *p = mmap(0, size_, writable_ ? PROT_READ | PROT_WRITE : PROT_READ,
+		MAP_SHARED, file_, 0);
+	if (p == MAP_FAILED) return false;
+	data_ = (char *)p;
+#endif
+	return true;
+}
+
+/*----------------------------------------------------------------
+ * Name			: unmap
+ * Description	: Removes the mapping, the file stays open
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void MappedFile::unmap()
+{
+#if defined(WIN32) || defined(_WIN32)
+	if (data_ != 0) UnmapViewOfFile(data_);
+	if (mapping_ != 0) CloseHandle(mapping_);
+	mapping_ = 0;
+#else
+	if (data_ != 0) munmap(data_, size_);
+#endif
+	data_ = 0;
+}
+
+
+/*----------------------------------------------------------------
+ * Class		 : DepthJournalWriter
+ * Description   : Appends records to a journal file
+ *---------------------------------------------------------------*/
+
+/*----------------------------------------------------------------
+ * Name			: DepthJournalWriter constructor
+ * Description	: Constructs a closed writer
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+DepthJournalWriter::DepthJournalWriter()
+: count_(0)
+, capacity_(0)
+{
+}
+
+/*----------------------------------------------------------------
+ * Name			: DepthJournalWriter destructor
+ * Description	: Closes the journal
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+DepthJournalWriter::~DepthJournalWriter()
+{
+	close();
+}
+
+/*----------------------------------------------------------------
+ * Name			: open
+ * Description	: Creates the journal file
+ * Arguments	: path is the file name
+ *				  priceDecimals is the number of decimals the
+ *				  books start with
+ * Returns		: true if the journal was created
+ *---------------------------------------------------------------*/
+bool DepthJournalWriter::open(const char *path, unsigned int priceDecimals)
+{
+	Guard guard(lock_);
+	count_ = 0;
+	capacity_ = 0;
+	if (!file_.create(path, fileSize(INITIAL_RECORDS))) return false;
+	capacity_ = INITIAL_RECORDS;
+
+	JournalHeader *header = (JournalHeader *)file_.data();
+	memset(header, 0, sizeof(JournalHeader));
+	memcpy(header->magic_, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+	header->version_ = JOURNAL_VERSION;
+	header->recordSize_ = sizeof(DepthJournalRecord);
+	header->count_ = 0;
+	header->priceDecimals_ = priceDecimals;
+	start_ = HighResolutionClock::now();
+	return true;
+}
+
+/*----------------------------------------------------------------
+ * Name			: close
+ * Description	: Truncates the file to the records written and
+ *				  closes it
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void DepthJournalWriter::close()
+{
+	Guard guard(lock_);
+	if (file_.data() != 0) file_.resize(fileSize(count_));
+	file_.close();
+	capacity_ = 0;
+}
+
+/*----------------------------------------------------------------
+ * Name			: writeCommand
+ * Description	: Appends a table command
+ * Arguments	: bookId is the subscription correlation id value
+ *				  bookType is the DepthBook::BookType
+ *				  side is 0 for bid, 1 for ask
+ *				  sequence is the sequence number, 0 if none
+ *				  row is the command
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void DepthJournalWriter::writeCommand(long long bookId, int bookType, int side,
+	long long sequence, const DepthRow &row)
+{
+	DepthJournalRecord record;
+	memset(&record, 0, sizeof(record));
+	record.kind_ = DepthJournalRecord::COMMAND;
+	record.bookId_ = bookId;
+	record.bookType_ = (signed char)bookType;
+	record.side_ = (unsigned char)side;
+	record.sequence_ = sequence;
+	record.command_ = (signed char)row.command;
+	record.position_ = row.position;
+	record.price_ = row.price;
+	record.size_ = row.size;
+	record.numOrders_ = row.numOrders;
+	record.time_ = row.time;
+	if (row.broker != 0) {
+		strncpy(record.broker_, row.broker, sizeof(record.broker_) - 1);
+	}
+	append(record);
+}
+
+/*----------------------------------------------------------------
+ * Name			: writeInitPaint
+ * Description	: Appends the start of an init paint
+ * Arguments	: bookId is the subscription correlation id value
+ *				  bookType is the DepthBook::BookType
+ *				  windowSize is the window size, 0 if not sent
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void DepthJournalWriter::writeInitPaint(long long bookId, int bookType, unsigned int windowSize)
+{
+	DepthJournalRecord record;
+	memset(&record, 0, sizeof(record));
+	record.kind_ = DepthJournalRecord::INITPAINT;
+	record.bookId_ = bookId;
+	record.bookType_ = (signed char)bookType;
+	record.command_ = CMD_UNKNOWN;
+	record.position_ = -1;
+	record.size_ = windowSize;
+	append(record);
+}
+
+/*----------------------------------------------------------------
+ * Name			: count
+ * Description	: Returns the number of records written
+ * Arguments	: none
+ * Returns		: number of records
+ *---------------------------------------------------------------*/
+unsigned long long DepthJournalWriter::count()
+{
+	Guard guard(lock_);
+	return count_;
+}
+
+/*----------------------------------------------------------------
+ * Name			: append
+ * Description	: Stamps the receive time and appends a record
+ * Arguments	: record is the record to append
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void DepthJournalWriter::append(DepthJournalRecord &record)
+{
+	Guard guard(lock_);
+	if (file_.data() == 0) return;
+	if (count_ == capacity_) {
+		if (!file_.resize(fileSize(capacity_ * 2))) {
+			//mapping lost, the records written stay in the file
+			capacity_ = 0;
+			return;
+		}
+		capacity_ *= 2;
+	}
+	record.receiveTime_ = TimePointUtil::nanosecondsBetween(start_,
+		HighResolutionClock::now());
+
+	DepthJournalRecord *records = (DepthJournalRecord *)(file_.data() + sizeof(JournalHeader));
+	records[count_] = record;
+	++count_;
+	((JournalHeader *)file_.data())->count_ = count_;
+}
+
+
+/*----------------------------------------------------------------
+ * Class		 : DepthJournalReader
+ * Description   : Maps a journal file read only
+ *---------------------------------------------------------------*/
+
+/*----------------------------------------------------------------
+ * Name			: DepthJournalReader constructor
+ * Description	: Constructs a closed reader
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+DepthJournalReader::DepthJournalReader()
+: count_(0)
+, priceDecimals_(0)
+{
+}
+
+/*----------------------------------------------------------------
+ * Name			: open
+ * Description	: Maps a journal and checks its header
+ * Arguments	: path is the file name
+ * Returns		: true if the file is a journal written with this
+ *				  record layout
+ *---------------------------------------------------------------*/
+bool DepthJournalReader::open(const char *path)
+{
+	count_ = 0;
+	if (!file_.openReadOnly(path)) return false;
+	if (file_.size() < sizeof(JournalHeader)) {
+		file_.close();
+		return false;
+	}
+	const JournalHeader *header = (const JournalHeader *)file_.data();
+	if (memcmp(header->magic_, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0
+		|| header->version_ != JOURNAL_VERSION
+		|| header->recordSize_ != sizeof(DepthJournalRecord)) {
+		file_.close();
+		return false;
+	}
+	//a journal still being written is larger than its records
+	unsigned long long available = (file_.size() - sizeof(JournalHeader)) / sizeof(DepthJournalRecord);
+	count_ = header->count_ < available ? header->count_ : available;
+	priceDecimals_ = header->priceDecimals_;
+	return true;
+}
+
+/*----------------------------------------------------------------
+ * Name			: count
+ * Description	: Returns the number of records
+ * Arguments	: none
+ * Returns		: number of records
+ *---------------------------------------------------------------*/
+unsigned long long DepthJournalReader::count() const
+{
+	return count_;
+}
+
+/*----------------------------------------------------------------
+ * Name			: priceDecimals
+ * Description	: Returns the decimals the books started with
+ * Arguments	: none
+ * Returns		: number of decimals
+ *---------------------------------------------------------------*/
+unsigned int DepthJournalReader::priceDecimals() const
+{
+	return priceDecimals_;
+}
+
+/*----------------------------------------------------------------
+ * Name			: records
+ * Description	: Returns the records
+ * Arguments	: none
+ * Returns		: first record
+ *---------------------------------------------------------------*/
+const DepthJournalRecord *DepthJournalReader::records() const
+{
+	return (const DepthJournalRecord *)(file_.data() + sizeof(JournalHeader));
+}
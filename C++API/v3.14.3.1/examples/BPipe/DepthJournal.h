@@ -0,0 +1,390 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: DepthJournal.h
+ *
+ * Description: This file contains the binary journal of decoded market
+ *				depth table commands. The subscription example writes it
+ *				and DepthJournalReplay feeds it back into the books
+ *				without a B-Pipe connection.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef __DepthJournal_h__
+#define __DepthJournal_h__
+
+#include <stddef.h>  // size_t
+#if defined(WIN32) || defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include <blpapi_timepoint.h>
+
+#include "DepthCommand.h"
+#include "SyncIO.h"
+
+namespace BloombergLP
+{
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : DepthJournalRecord
+	 * Description  : One journal record. Records have a fixed size and
+	 *				  are written in host byte order, a journal is meant
+	 *				  to be replayed on the kind of machine that wrote it.
+	 * --------------------------------------------------------------------*/
+	struct DepthJournalRecord
+	{
+		//record kinds
+		enum Kind {
+			//table command, applied to one side
+			COMMAND = 0,
+			//start of an init paint, size_ holds the window size or 0
+			//if none was sent. Both sides are cleared.
+			INITPAINT = 1
+		};
+
+		//nanoseconds from the opening of the journal to the receipt
+		//of the message
+		long long receiveTime_;
+
+		//subscription correlation id value
+		long long bookId_;
+
+		//MBO_SEQNUM_RT/MBL_SEQNUM_RT, 0 if not sent
+		long long sequence_;
+
+		//DepthRow fields
+		double price_;
+		unsigned int size_;
+		unsigned int numOrders_;
+		unsigned int time_;
+		int position_;
+
+		//Kind
+		unsigned char kind_;
+
+		//DepthBook::BookType
+		signed char bookType_;
+
+		//side index into the DepthBook books, 0 bid 1 ask
+		unsigned char side_;
+
+		//TableCommand
+		signed char command_;
+
+		//broker code, null terminated
+		char broker_[ByOrderBookEntry::BROKER_SIZE];
+
+		//zero
+		char reserved_[4];
+
+		/*----------------------------------------------------------------
+		 * Name			: getRow
+		 * Description	: Returns the table command of the record
+		 * Arguments	: row receives the command, its broker points
+		 *				  into this record
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		void getRow(DepthRow *row) const;
+	};
+
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : MappedFile
+	 * Description  : File mapped into memory, read only or read write.
+	 *				  Windows uses file mapping objects
+	 *				  Unix uses mmap
+	 * --------------------------------------------------------------------*/
+	class MappedFile
+	{
+	public:
+		/*----------------------------------------------------------------
+		 * Name			: MappedFile constructor
+		 * Description	: Constructs a closed file
+		 * Arguments	: none
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		MappedFile();
+
+		/*----------------------------------------------------------------
+		 * Name			: MappedFile destructor
+		 * Description	: Unmaps and closes the file, keeping its size
+		 * Arguments	: none
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		~MappedFile();
+
+		/*----------------------------------------------------------------
+		 * Name			: create
+		 * Description	: Creates or truncates a file and maps it read
+		 *				  write
+		 * Arguments	: path is the file name
+		 *				  size is the initial size of the file
+		 * Returns		: true if the file is mapped
+		 *---------------------------------------------------------------*/
+		bool create(const char *path, size_t size);
+
+		/*----------------------------------------------------------------
+		 * Name			: openReadOnly
+		 * Description	: Maps a whole existing file read only
+		 * Arguments	: path is the file name
+		 * Returns		: true if the file is mapped
+		 *---------------------------------------------------------------*/
+		bool openReadOnly(const char *path);
+
+		/*----------------------------------------------------------------
+		 * Name			: resize
+		 * Description	: Changes the size of a file opened with create()
+		 *				  and maps it again. data() may move.
+		 * Arguments	: size is the new size
+		 * Returns		: true if the file is mapped
+		 *---------------------------------------------------------------*/
+		bool resize(size_t size);
+
+		/*----------------------------------------------------------------
+		 * Name			: close
+		 * Description	: Unmaps and closes the file
+		 * Arguments	: none
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		void close();
+
+		/*----------------------------------------------------------------
+		 * Name			: data
+		 * Description	: Returns the start of the mapping
+		 * Arguments	: none
+		 * Returns		: mapping, 0 if the file is not mapped
+		 *---------------------------------------------------------------*/
+		char *data() const;
+
+		/*----------------------------------------------------------------
+		 * Name			: size
+		 * Description	: Returns the size of the mapping
+		 * Arguments	: none
+		 * Returns		: size in bytes
+		 *---------------------------------------------------------------*/
+		size_t size() const;
+
+	private:
+		/*----------------------------------------------------------------
+		 * Name			: map
+		 * Description	: Sizes the open file to size_ and maps it
+		 * Arguments	: none
+		 * Returns		: true if the file is mapped
+		 *---------------------------------------------------------------*/
+		bool map();
+
+		/*----------------------------------------------------------------
+		 * Name			: unmap
+		 * Description	: Removes the mapping, the file stays open
+		 * Arguments	: none
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		void unmap();
+
+#if defined(WIN32) || defined(_WIN32)
+		HANDLE file_;
+		HANDLE mapping_;
+#else
+		int file_;
+#endif
+		char *data_;
+		size_t size_;
+		bool writable_;
+
+		// Unimplemented
+		MappedFile(const MappedFile&);
+		MappedFile& operator=(const MappedFile&);
+	};
+
+
+	/*----------------------------------------------------------------
+	 * Class		 : DepthJournalWriter
+	 * Description   : Appends records to a journal file. The file is
+	 *				   mapped and grown by doubling, the record count in
+	 *				   the file header is updated with every record so
+	 *				   the journal is readable up to the last record
+	 *				   written. Any thread may append.
+	 *---------------------------------------------------------------*/
+	class DepthJournalWriter
+	{
+	public:
+		/*----------------------------------------------------------------
+		 * Name			: DepthJournalWriter constructor
+		 * Description	: Constructs a closed writer
+		 * Arguments	: none
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		DepthJournalWriter();
+
+		/*----------------------------------------------------------------
+		 * Name			: DepthJournalWriter destructor
+		 * Description	: Closes the journal
+		 * Arguments	: none
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		~DepthJournalWriter();
+
+		/*----------------------------------------------------------------
+		 * Name			: open
+		 * Description	: Creates the journal file, replacing any file
+		 *				  of that name. Receive times are measured from
+		 *				  this call.
+		 * Arguments	: path is the file name
+		 *				  priceDecimals is the number of decimals the
+		 *				  books start with, recorded in the header so
+		 *				  a replay scales prices as the books did
+		 * Returns		: true if the journal was created
+		 *---------------------------------------------------------------*/
+		bool open(const char *path, unsigned int priceDecimals);
+
+		/*----------------------------------------------------------------
+		 * Name			: close
+		 * Description	: Truncates the file to the records written and
+		 *				  closes it
+		 * Arguments	: none
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		void close();
+
+		/*----------------------------------------------------------------
+		 * Name			: writeCommand
+		 * Description	: Appends a table command
+		 * Arguments	: bookId is the subscription correlation id value
+		 *				  bookType is the DepthBook::BookType
+		 *				  side is 0 for bid, 1 for ask
+		 *				  sequence is the sequence number, 0 if none
+		 *				  row is the command
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		void writeCommand(long long bookId, int bookType, int side,
+			long long sequence, const DepthRow &row);
+
+		/*----------------------------------------------------------------
+		 * Name			: writeInitPaint
+		 * Description	: Appends the start of an init paint
+		 * Arguments	: bookId is the subscription correlation id value
+		 *				  bookType is the DepthBook::BookType
+		 *				  windowSize is the window size, 0 if not sent
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		void writeInitPaint(long long bookId, int bookType, unsigned int windowSize);
+
+		/*----------------------------------------------------------------
+		 * Name			: count
+		 * Description	: Returns the number of records written
+		 * Arguments	: none
+		 * Returns		: number of records
+		 *---------------------------------------------------------------*/
+		unsigned long long count();
+
+	private:
+		/*----------------------------------------------------------------
+		 * Name			: append
+		 * Description	: Stamps the receive time and appends a record.
+		 *				  Drops the record if the file can not grow.
+		 * Arguments	: record is the record to append
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		void append(DepthJournalRecord &record);
+
+		MappedFile file_;
+		unsigned long long count_;
+		unsigned long long capacity_;
+		blpapi::TimePoint start_;
+		SyncIO lock_;
+
+		// Unimplemented
+		DepthJournalWriter(const DepthJournalWriter&);
+		DepthJournalWriter& operator=(const DepthJournalWriter&);
+	};
+
+
+	/*----------------------------------------------------------------
+	 * Class		 : DepthJournalReader
+	 * Description   : Maps a journal file read only and gives direct
+	 *				   access to its records
+	 *---------------------------------------------------------------*/
+	class DepthJournalReader
+	{
+	public:
+		/*----------------------------------------------------------------
+		 * Name			: DepthJournalReader constructor
+		 * Description	: Constructs a closed reader
+		 * Arguments	: none
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		DepthJournalReader();
+
+		/*----------------------------------------------------------------
+		 * Name			: open
+		 * Description	: Maps a journal and checks its header
+		 * Arguments	: path is the file name
+		 * Returns		: true if the file is a journal written with
+		 *				  this record layout
+		 *---------------------------------------------------------------*/
+		bool open(const char *path);
+
+		/*----------------------------------------------------------------
+		 * Name			: count
+		 * Description	: Returns the number of records
+		 * Arguments	: none
+		 * Returns		: number of records
+		 *---------------------------------------------------------------*/
+		unsigned long long count() const;
+
+		/*----------------------------------------------------------------
+		 * Name			: priceDecimals
+		 * Description	: Returns the decimals the books started with.
+		 *				  Books replayed from them widen their scale
+		 *				  on the same prices the recorded books did.
+		 * Arguments	: none
+		 * Returns		: number of decimals
+		 *---------------------------------------------------------------*/
+		unsigned int priceDecimals() const;
+
+		/*----------------------------------------------------------------
+		 * Name			: records
+		 * Description	: Returns the records, valid until the reader
+		 *				  is destroyed
+		 * Arguments	: none
+		 * Returns		: first record
+		 *---------------------------------------------------------------*/
+		const DepthJournalRecord *records() const;
+
+	private:
+		MappedFile file_;
+		unsigned long long count_;
+		unsigned int priceDecimals_;
+
+		// Unimplemented
+		DepthJournalReader(const DepthJournalReader&);
+		DepthJournalReader& operator=(const DepthJournalReader&);
+	};
+}
+
+#endif
@@ -0,0 +1,315 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: DepthJournalReplay.cpp
+ *
+ * Description: Replays a journal written by
+ *				MarketDepthSubscriptionSnapshotExample -journal into
+ *				fresh market depth books. The journal is mapped into
+ *				memory and applied either as fast as possible or at the
+ *				pace it was received. The final books can be printed
+ *				to compare two builds of the book code on the same
+ *				input. No B-Pipe connection is needed.
+ * ----------------------------------------------------------------- */
+
+#include <blpapi_highresolutionclock.h>
+#include <blpapi_timepoint.h>
+
+#include <vector>
+#include <string>
+#include <stdlib.h>
+#include <stdio.h>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include "DepthBookRegistry.h"
+#include "DepthCommand.h"
+#include "DepthJournal.h"
+
+using namespace std;
+using namespace BloombergLP;
+using namespace blpapi;
+
+class DepthJournalReplay
+{
+	std::string			d_file;
+	int					d_pace;			// wait for the recorded receive times
+	unsigned int		d_loops;
+	int					d_printBooks;
+	unsigned int		d_depth;		// levels printed
+	unsigned int		d_priceDecimals;	// decimals the recorded books started with
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: applyRecord
+	 * Description	: apply one journal record to its book
+	 * Arguments	: books is the registry the book is added to
+	 *              : record is the journal record
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	void applyRecord(DepthBookRegistry &books, const DepthJournalRecord &record)
+	{
+		if (record.bookType_ != DepthBook::BYORDER && record.bookType_ != DepthBook::BYLEVEL) {
+			return;
+		}
+		DepthBook *book = books.add(record.bookId_, "");
+		if (book->marketDepthBook == DepthBook::UNKNOWN) {
+			for (int side = 0; side < 2; ++side) {
+				book->orderBooks[side].setPriceDecimals(d_priceDecimals);
+				book->levelBooks[side].setPriceDecimals(d_priceDecimals);
+			}
+		}
+		book->marketDepthBook = record.bookType_;
+
+		if (record.kind_ == DepthJournalRecord::INITPAINT) {
+			for (int side = 0; side < 2; ++side) {
+				if (book->marketDepthBook == DepthBook::BYORDER) {
+					if (record.size_ != 0) setWindow(book->orderBooks[side], record.size_);
+					book->orderBooks[side].doClearAll();
+				} else {
+					if (record.size_ != 0) setWindow(book->levelBooks[side], record.size_);
+					book->levelBooks[side].doClearAll();
+				}
+			}
+		} else if (record.side_ < 2) {
+			DepthRow row;
+			record.getRow(&row);
+			if (book->marketDepthBook == DepthBook::BYORDER) {
+				fitPrice(book->orderBooks, row);
+				applyRow(book->orderBooks[record.side_], row);
+			} else {
+				fitPrice(book->levelBooks, row);
+				applyRow(book->levelBooks[record.side_], row);
+			}
+		}
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: replay
+	 * Description	: apply every record of the journal
+	 * Arguments	: books receives the books
+	 *              : records are the journal records
+	 *              : count is the number of records
+	 * Returns		: nanoseconds taken
+	 *------------------------------------------------------------------------------------*/
+	long long replay(DepthBookRegistry &books, const DepthJournalRecord *records,
+		unsigned long long count)
+	{
+		TimePoint start = HighResolutionClock::now();
+		long long first = count > 0 ? records[0].receiveTime_ : 0;
+		for (unsigned long long i = 0; i < count; ++i) {
+			if (d_pace) {
+				// spin until the record is due
+				long long due = records[i].receiveTime_ - first;
+				while (TimePointUtil::nanosecondsBetween(start, HighResolutionClock::now()) < due) {
+				}
+			}
+			applyRecord(books, records[i]);
+		}
+		return TimePointUtil::nanosecondsBetween(start, HighResolutionClock::now());
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: printSide
+	 * Description	: print the top levels of one side of a book
+	 * Arguments	: book is the book side
+	 *              : sideName is the side printed
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	void printSide(ByOrderBook &book, const char *sideName)
+	{
+		ByOrderBookEntry entry;
+		unsigned int size = book.size();
+		for (unsigned int i = 0; i < size && i < d_depth; ++i) {
+			if (book.getEntry(i, entry)) {
+				std::cout << "  " << sideName << " " << i << " " << book.brokerCode(entry.brokerId()) << " "
+					<< std::fixed << std::setprecision(book.priceScale().decimals())
+					<< book.priceScale().toDouble(entry.price()) << " "
+					<< entry.size_ << std::endl;
+			}
+		}
+	}
+
+	void printSide(ByLevelBook &book, const char *sideName)
+	{
+		ByLevelBookEntry entry;
+		unsigned int size = book.size();
+		for (unsigned int i = 0; i < size && i < d_depth; ++i) {
+			if (book.getEntry(i, entry)) {
+				std::cout << "  " << sideName << " " << i << " "
+					<< std::fixed << std::setprecision(book.priceScale().decimals())
+					<< book.priceScale().toDouble(entry.price()) << " "
+					<< entry.size_ << " " << entry.numOrders() << std::endl;
+			}
+		}
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: printBooks
+	 * Description	: print the top of every book, ordered by id so the
+	 *				  output of two runs can be compared
+	 * Arguments	: books are the replayed books
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	void printBooks(DepthBookRegistry &books)
+	{
+		std::vector<DepthBook *> list;
+		books.getBooks(list);
+		// few books, insertion sort by id
+		for (size_t i = 1; i < list.size(); ++i) {
+			DepthBook *book = list[i];
+			size_t j = i;
+			for (; j > 0 && list[j - 1]->id > book->id; --j) {
+				list[j] = list[j - 1];
+			}
+			list[j] = book;
+		}
+		for (size_t i = 0; i < list.size(); ++i) {
+			DepthBook &book = *list[i];
+			std::cout << "BOOK " << book.id
+				<< (book.marketDepthBook == DepthBook::BYORDER ? " BYORDER" : " BYLEVEL")
+				<< std::endl;
+			if (book.marketDepthBook == DepthBook::BYORDER) {
+				printSide(book.orderBooks[0], "BID");
+				printSide(book.orderBooks[1], "ASK");
+			} else {
+				printSide(book.levelBooks[0], "BID");
+				printSide(book.levelBooks[1], "ASK");
+			}
+		}
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: printUsage
+	 * Description	: prints the usage of the program on command line
+	 * Arguments	: none
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	void printUsage()
+	{
+		std::cout << "Usage:" << std::endl
+			<< "    Replay a market depth journal into the books" << std::endl
+			<< "      -f        <journal file>" << std::endl
+			<< "      [-pace    <replay at the recorded pace>" << std::endl
+			<< "      [-loops   <replays = 1>" << std::endl
+			<< "      [-print   <print the final books>" << std::endl
+			<< "      [-depth   <levels printed = 10>" << std::endl
+			<< "Notes:" << std::endl
+			<< " -Record a journal with MarketDepthSubscriptionSnapshotExample -journal <file>." << std::endl
+			<< " -Without -pace the records are applied as fast as possible." << std::endl;
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: parseCommandLine
+	 * Description	: process command line parameters
+	 * Arguments	: none
+	 * Returns		: true - successful, false - failed
+	 *------------------------------------------------------------------------------------*/
+	bool parseCommandLine(int argc, char **argv)
+	{
+		for (int i = 1; i < argc; ++i) {
+			if (!std::strcmp(argv[i],"-f") && i + 1 < argc) {
+				d_file = argv[++i];
+			} else if (!std::strcmp(argv[i],"-pace")) {
+				d_pace = 1;
+			} else if (!std::strcmp(argv[i],"-loops") && i + 1 < argc) {
+				d_loops = std::atoi(argv[++i]);
+			} else if (!std::strcmp(argv[i],"-print")) {
+				d_printBooks = 1;
+			} else if (!std::strcmp(argv[i],"-depth") && i + 1 < argc) {
+				d_depth = std::atoi(argv[++i]);
+			} else {
+				printUsage();
+				return false;
+			}
+		}
+		if (d_file.empty() || d_loops == 0) {
+			printUsage();
+			return false;
+		}
+		return true;
+	}
+
+public:
+	/*------------------------------------------------------------------------------------
+	 * Name			: DepthJournalReplay
+	 * Description	: constructor
+	 * Arguments	: none
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	DepthJournalReplay()
+	: d_pace(0)
+	, d_loops(1)
+	, d_printBooks(0)
+	, d_depth(10)
+	, d_priceDecimals(0)
+	{
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: run
+	 * Description	: replay the journal d_loops times into fresh books
+	 * Arguments	: argc is number arguments
+	 *              : argv are the argument values
+	 * Returns		: 0 - successful, 1 - failed
+	 *------------------------------------------------------------------------------------*/
+	int run(int argc, char **argv)
+	{
+		if (!parseCommandLine(argc, argv)) return 1;
+
+		DepthJournalReader reader;
+		if (!reader.open(d_file.c_str())) {
+			std::cerr << "Failed to open journal " << d_file << std::endl;
+			return 1;
+		}
+		unsigned long long count = reader.count();
+		// books start at the scale the recorded books had and widen
+		// it on the same prices
+		d_priceDecimals = reader.priceDecimals();
+		std::cerr << count << " records" << (d_pace ? ", recorded pace" : "") << std::endl;
+
+		for (unsigned int loop = 0; loop < d_loops; ++loop) {
+			DepthBookRegistry books;
+			long long elapsed = replay(books, reader.records(), count);
+			// timings go to stderr, stdout only holds the books to diff
+			std::cerr << "loop " << loop + 1 << ": " << books.size() << " book(s)  "
+				<< std::fixed << std::setprecision(1)
+				<< (count > 0 ? (double)elapsed / count : 0.0) << " ns/record  "
+				<< std::setprecision(0)
+				<< (elapsed > 0 ? count * 1e9 / elapsed : 0.0) << " records/s" << std::endl;
+			if (d_printBooks && loop + 1 == d_loops) {
+				printBooks(books);
+			}
+		}
+		return 0;
+	}
+};
+
+/*------------------------------------------------------------------------------------
+ * Name			: main
+ * Description	: main function
+ * Arguments	: argc is number arguments
+ *              : argv are the argument values
+ * Returns		: 0 - successful, 1 - failed
+ *------------------------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+	std::cerr << "DepthJournalReplay" << std::endl;
+	DepthJournalReplay replay;
+	return replay.run(argc, argv);
+}
@@ -0,0 +1,83 @@
+/* --------------------------------------------------------------------
+ *                          DISCLAIMER OF WARRANTY
+ *
+ * THE CODE SAMPLES PROVIDED IN THIS SDK (IN SOURCE CODE AND BINARY FORM) ARE
+ * PROVIDED "AS IS," WITHOUT A WARRANTY OF ANY KIND. ALL EXPRESS OR IMPLIED
+ * CONDITIONS, REPRESENTATIONS AND WARRANTIES, INCLUDING ANY IMPLIED WARRANTY
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE OR NON-INFRINGEMENT,
+ * ARE HEREBY EXCLUDED. BLOOMBERG AND ITS LICENSORS SHALL NOT BE LIABLE FOR
+ * ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR
+ * DISTRIBUTING THE SOFTWARE OR ITS DERIVATIVES. IN NO EVENT WILL BLOOMBERG
+ * OR ITS LICENSORS BE LIABLE FOR ANY LOST REVENUE, PROFIT OR DATA, OR FOR
+ * DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL, INCIDENTAL OR PUNITIVE DAMAGES,
+ * HOWEVER CAUSED AND REGARDLESS OF THE THEORY OF LIABILITY, ARISING OUT OF
+ * THE USE OF OR INABILITY TO USE SOFTWARE, EVEN IF BLOOMBERG HAS BEEN ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGES.
+ * THE CODE SAMPLES PROVIDED WITH THE B-PIPE SDK ARE NOT INTENDED FOR
+ * PRODUCTION USE, AND IF PUT TO SUCH USE THEY MAY RESULT IN SLOWNESS OR LOSS
+ * OF DATA.
+ * ----------------------------------------------------------------- */
+
+/* --------------------------------------------------------------------
+ * File: ElementUtil.h
+ *
+ * Description: This source code reads optional sub-elements of an
+ *				Element without exceptions, through the C interface
+ *				the C++ headers wrap
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef _ELEMENTUTIL_H_
+#define  _ELEMENTUTIL_H_
+
+#include <blpapi_element.h>
+#include <blpapi_name.h>
+
+/*-------------------------------------------------
+ * Name			: tryGetElementAs
+ * Description	: Reads a sub-element that may be missing. The name
+ *				  is looked up once by handle, where hasElement()
+ *				  followed by getElementAsXXX() looks it up twice,
+ *				  and nothing throws. A null element is an error.
+ * Arguments	: element is a sequence or choice element
+ *				  name is the name of the sub-element
+ *				  result receives the value, unchanged on error.
+ *				  Any type Element::getValueAs() converts to.
+ * Returns		: 0 if the value was read, non-zero error otherwise
+ *-------------------------------------------------*/
+template <typename TYPE>
+inline int tryGetElementAs(const BloombergLP::blpapi::Element& element,
+    const BloombergLP::blpapi::Name& name, TYPE *result)
+{
+    blpapi_Element_t *field;
+    int rc = blpapi_Element_getElement(element.handle(), &field, 0, name.impl());
+    return rc != 0 ? rc : BloombergLP::blpapi::Element(field).getValueAs(result);
+}
+
+/*-------------------------------------------------
+ * Name			: tryGetElementAs
+ * Description	: Reads a string sub-element that may be missing
+ *				  without copying it
+ * Arguments	: element is a sequence or choice element
+ *				  name is the name of the sub-element
+ *				  result receives the string, valid as long as
+ *				  element, unchanged on error
+ * Returns		: 0 if the value was read, non-zero error otherwise
+ *-------------------------------------------------*/
+inline int tryGetElementAs(const BloombergLP::blpapi::Element& element,
+    const BloombergLP::blpapi::Name& name, const char **result)
+{
+    blpapi_Element_t *field;
+    int rc = blpapi_Element_getElement(element.handle(), &field, 0, name.impl());
+    return rc != 0 ? rc : blpapi_Element_getValueAsString(field, result, 0);
+}
+
+#endif
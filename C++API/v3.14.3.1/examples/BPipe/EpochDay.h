@@ -0,0 +1,82 @@
+/* --------------------------------------------------------------------
+ *                          DISCLAIMER OF WARRANTY
+ *
+ * THE CODE SAMPLES PROVIDED IN THIS SDK (IN SOURCE CODE AND BINARY FORM) ARE
+ * PROVIDED "AS IS," WITHOUT A WARRANTY OF ANY KIND. ALL EXPRESS OR IMPLIED
+ * CONDITIONS, REPRESENTATIONS AND WARRANTIES, INCLUDING ANY IMPLIED WARRANTY
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE OR NON-INFRINGEMENT,
+ * ARE HEREBY EXCLUDED. BLOOMBERG AND ITS LICENSORS SHALL NOT BE LIABLE FOR
+ * ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR
+ * DISTRIBUTING THE SOFTWARE OR ITS DERIVATIVES. IN NO EVENT WILL BLOOMBERG
+ * OR ITS LICENSORS BE LIABLE FOR ANY LOST REVENUE, PROFIT OR DATA, OR FOR
+ * DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL, INCIDENTAL OR PUNITIVE DAMAGES,
+ * HOWEVER CAUSED AND REGARDLESS OF THE THEORY OF LIABILITY, ARISING OUT OF
+ * THE USE OF OR INABILITY TO USE SOFTWARE, EVEN IF BLOOMBERG HAS BEEN ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGES.
+ * THE CODE SAMPLES PROVIDED WITH THE B-PIPE SDK ARE NOT INTENDED FOR
+ * PRODUCTION USE, AND IF PUT TO SUCH USE THEY MAY RESULT IN SLOWNESS OR LOSS
+ * OF DATA.
+ * ----------------------------------------------------------------- */
+
+/* --------------------------------------------------------------------
+ * File: EpochDay.h
+ *
+ * Description: This source code converts between calendar dates and
+ *				day numbers counted from 1970-01-01
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef _EPOCHDAY_H_
+#define  _EPOCHDAY_H_
+
+/*-------------------------------------------------
+ * Name			: epochDay
+ * Description	: Converts a proleptic Gregorian date to a day number
+ * Arguments	: year, month (1-12) and day (1-31) of the date
+ * Returns		: days since 1970-01-01, negative before
+ *-------------------------------------------------*/
+inline int epochDay(int year, int month, int day)
+{
+    //count years from March so that the leap day ends the year
+    if (month <= 2)
+    {
+        year -= 1;
+    }
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+/*-------------------------------------------------
+ * Name			: epochDate
+ * Description	: Converts a day number to a proleptic Gregorian date,
+ *				  the inverse of epochDay()
+ * Arguments	: days is the number of days since 1970-01-01
+ *				  year, month (1-12) and day (1-31) receive the date
+ * Returns		: none
+ *-------------------------------------------------*/
+inline void epochDate(int days, int *year, int *month, int *day)
+{
+    days += 719468;
+    int era = (days >= 0 ? days : days - 146096) / 146097;
+    int dayOfEra = days - era * 146097;
+    int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524
+                     - dayOfEra / 146096) / 365;
+    int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int monthOfYear = (5 * dayOfYear + 2) / 153;
+    *day = dayOfYear - (153 * monthOfYear + 2) / 5 + 1;
+    *month = monthOfYear < 10 ? monthOfYear + 3 : monthOfYear - 9;
+    *year = yearOfEra + era * 400 + (*month <= 2 ? 1 : 0);
+}
+
+#endif
@@ -0,0 +1,98 @@
+/* --------------------------------------------------------------------
+ *                          DISCLAIMER OF WARRANTY
+ *
+ * THE CODE SAMPLES PROVIDED IN THIS SDK (IN SOURCE CODE AND BINARY FORM) ARE
+ * PROVIDED "AS IS," WITHOUT A WARRANTY OF ANY KIND. ALL EXPRESS OR IMPLIED
+ * CONDITIONS, REPRESENTATIONS AND WARRANTIES, INCLUDING ANY IMPLIED WARRANTY
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE OR NON-INFRINGEMENT,
+ * ARE HEREBY EXCLUDED. BLOOMBERG AND ITS LICENSORS SHALL NOT BE LIABLE FOR
+ * ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR
+ * DISTRIBUTING THE SOFTWARE OR ITS DERIVATIVES. IN NO EVENT WILL BLOOMBERG
+ * OR ITS LICENSORS BE LIABLE FOR ANY LOST REVENUE, PROFIT OR DATA, OR FOR
+ * DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL, INCIDENTAL OR PUNITIVE DAMAGES,
+ * HOWEVER CAUSED AND REGARDLESS OF THE THEORY OF LIABILITY, ARISING OUT OF
+ * THE USE OF OR INABILITY TO USE SOFTWARE, EVEN IF BLOOMBERG HAS BEEN ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGES.
+ * THE CODE SAMPLES PROVIDED WITH THE B-PIPE SDK ARE NOT INTENDED FOR
+ * PRODUCTION USE, AND IF PUT TO SUCH USE THEY MAY RESULT IN SLOWNESS OR LOSS
+ * OF DATA.
+ * ----------------------------------------------------------------- */
+
+
+/* --------------------------------------------------------------------
+ * File: EventBatch.h
+ *
+ * Description: This source code defines drainEvents() and takeEvents(),
+ *				which load a burst of events of a Session or an
+ *				EventQueue at once, so that it costs one wakeup.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef _EVENTBATCH_H_
+#define  _EVENTBATCH_H_
+
+#include <blpapi_event.h>
+
+#include <stddef.h>
+
+/*-------------------------------------------------
+ * Name			: takeEvents
+ * Description	: Loads the events already queued,
+ *				  without blocking
+ * Arguments	: queue is a Session or an EventQueue
+ *				  events receives the events
+ *				  maxEvents is the size of events
+ * Returns		: number of events loaded
+ *-------------------------------------------------*/
+template <typename QUEUE>
+inline size_t takeEvents(QUEUE &queue, BloombergLP::blpapi::Event *events,
+	size_t maxEvents)
+{
+	size_t count = 0;
+	while (count < maxEvents && queue.tryNextEvent(&events[count]) == 0)
+	{
+		++count;
+	}
+	return count;
+}
+
+/*-------------------------------------------------
+ * Name			: drainEvents
+ * Description	: Waits for the next event with
+ *				  nextEvent(timeoutMs), then takes the
+ *				  events already queued. A synchronous
+ *				  Session or an EventQueue only.
+ * Arguments	: queue is a Session or an EventQueue
+ *				  events receives the events; slots
+ *				  past the returned count are unchanged
+ *				  maxEvents is the size of events
+ *				  timeoutMs is the longest wait, 0 for
+ *				  no limit
+ * Returns		: number of events loaded, 1 with an
+ *				  event of type TIMEOUT if none came in
+ *				  time, 0 if maxEvents is 0
+ *-------------------------------------------------*/
+template <typename QUEUE>
+inline size_t drainEvents(QUEUE &queue, BloombergLP::blpapi::Event *events,
+	size_t maxEvents, int timeoutMs = 0)
+{
+	if (maxEvents == 0)
+	{
+		return 0;
+	}
+	events[0] = queue.nextEvent(timeoutMs);
+	if (events[0].eventType() == BloombergLP::blpapi::Event::TIMEOUT)
+	{
+		return 1;
+	}
+	return 1 + takeEvents(queue, events + 1, maxEvents - 1);
+}
+#endif
@@ -0,0 +1,411 @@
+/* --------------------------------------------------------------------
+ *                          DISCLAIMER OF WARRANTY
+ *
+ * THE CODE SAMPLES PROVIDED IN THIS SDK (IN SOURCE CODE AND BINARY FORM) ARE
+ * PROVIDED "AS IS," WITHOUT A WARRANTY OF ANY KIND. ALL EXPRESS OR IMPLIED
+ * CONDITIONS, REPRESENTATIONS AND WARRANTIES, INCLUDING ANY IMPLIED WARRANTY
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE OR NON-INFRINGEMENT,
+ * ARE HEREBY EXCLUDED. BLOOMBERG AND ITS LICENSORS SHALL NOT BE LIABLE FOR
+ * ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR
+ * DISTRIBUTING THE SOFTWARE OR ITS DERIVATIVES. IN NO EVENT WILL BLOOMBERG
+ * OR ITS LICENSORS BE LIABLE FOR ANY LOST REVENUE, PROFIT OR DATA, OR FOR
+ * DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL, INCIDENTAL OR PUNITIVE DAMAGES,
+ * HOWEVER CAUSED AND REGARDLESS OF THE THEORY OF LIABILITY, ARISING OUT OF
+ * THE USE OF OR INABILITY TO USE SOFTWARE, EVEN IF BLOOMBERG HAS BEEN ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGES.
+ * THE CODE SAMPLES PROVIDED WITH THE B-PIPE SDK ARE NOT INTENDED FOR
+ * PRODUCTION USE, AND IF PUT TO SUCH USE THEY MAY RESULT IN SLOWNESS OR LOSS
+ * OF DATA.
+ * ----------------------------------------------------------------- */
+
+/* --------------------------------------------------------------------
+ * File: FieldAccessor.h
+ *
+ * Description: This source code defines the FieldAccessor class, which
+ *				reads the fields of a message by their position in the
+ *				message schema instead of by name, one at a time or
+ *				all at once into a struct or column buffers.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef _FIELDACCESSOR_H_
+#define  _FIELDACCESSOR_H_
+
+#include <blpapi_datetime.h>
+#include <blpapi_element.h>
+#include <blpapi_name.h>
+#include <blpapi_schema.h>
+#include <blpapi_types.h>
+
+#include <stddef.h>  // size_t
+#include <vector>
+
+#include "NameIndex.h"
+
+/* --------------------------------------------------------------------
+ * Class/Struct : FieldAccessor
+ * Description  : Reads typed field values of one message type. Fields
+ *				  are added once, then compile() looks up the position
+ *				  of each in the message schema. A read goes straight
+ *				  to that position through the C interface, with no
+ *				  name lookup, string conversion or Element handle
+ *				  created. The name of the element found is checked
+ *				  against the field by handle, and the field is looked
+ *				  up by Name if the message is not laid out as its
+ *				  schema, so a read is never wrong, only slower.
+ *				  extract() reads all the fields added with a type in
+ *				  one call and reports the ones written in a bit mask,
+ *				  nothing throws.
+ *				  Set up the accessor at start up; the get functions
+ *				  may then be called from any number of threads.
+ * --------------------------------------------------------------------*/
+class FieldAccessor
+{
+    public:
+        //type a field is extracted as, see addField()
+        enum FieldType
+        {
+            FIELD_NONE,         //not extracted
+            FIELD_FLOAT64,      //BloombergLP::blpapi::Float64
+            FIELD_INT64,        //BloombergLP::blpapi::Int64
+            FIELD_DATETIME      //blpapi_Datetime_t
+        };
+
+        //fields extract() fills, one bit of its result each
+        enum { MAX_EXTRACT_FIELDS = 64 };
+
+		/*-------------------------------------------------
+		 * Name			: FieldAccessor
+		 * Description	: Default constructor, no fields
+		 * Arguments	: none
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        FieldAccessor()
+        {
+        }
+
+		/*-------------------------------------------------
+		 * Name			: addField
+		 * Description	: Adds a field to read. Until compile()
+		 *				  is called the field is read by Name.
+		 * Arguments	: name is the field name
+		 * Returns		: field id to pass to the get functions,
+		 *				  numbered from 0 in the order added
+		 *-------------------------------------------------*/
+        int addField(const BloombergLP::blpapi::Name& name)
+        {
+            return addField(name, FIELD_NONE, 0);
+        }
+
+		/*-------------------------------------------------
+		 * Name			: addField
+		 * Description	: Adds a field to read, and to extract
+		 *				  as type if it is among the first
+		 *				  MAX_EXTRACT_FIELDS fields
+		 * Arguments	: name is the field name
+		 *				  type is the type extracted
+		 *				  offset is where extract() writes the
+		 *				  value in the target struct, offsetof()
+		 *				  of the member
+		 * Returns		: field id, numbered from 0 in the order
+		 *				  added, also the bit of the field in the
+		 *				  result of extract()
+		 *-------------------------------------------------*/
+        int addField(const BloombergLP::blpapi::Name& name, FieldType type, size_t offset)
+        {
+            Field field;
+            field.name_ = name;
+            field.position_ = NO_POSITION;
+            field.type_ = type;
+            field.offset_ = offset;
+            fields_.push_back(field);
+            return (int)fields_.size() - 1;
+        }
+
+		/*-------------------------------------------------
+		 * Name			: compile
+		 * Description	: Looks up the position of every field in
+		 *				  the schema of the message type
+		 * Arguments	: message is the definition of the message,
+		 *				  e.g. Service::getEventDefinition()
+		 * Returns		: true if every field is in the schema,
+		 *				  the others are still read by Name
+		 *-------------------------------------------------*/
+        bool compile(const BloombergLP::blpapi::SchemaElementDefinition& message)
+        {
+            BloombergLP::blpapi::SchemaTypeDefinition type = message.typeDefinition();
+            NameIndex positions;
+            if (type.isComplexType())
+            {
+                for (size_t i = 0; i < type.numElementDefinitions(); ++i)
+                {
+                    positions.add(type.getElementDefinition(i).name(), (int)i);
+                }
+            }
+
+            bool complete = true;
+            for (size_t i = 0; i < fields_.size(); ++i)
+            {
+                int position = positions.find(fields_[i].name_);
+                if (position == NameIndex::NOT_FOUND)
+                {
+                    fields_[i].position_ = NO_POSITION;
+                    complete = false;
+                }
+                else
+                {
+                    fields_[i].position_ = (size_t)position;
+                }
+            }
+            return complete;
+        }
+
+		/*-------------------------------------------------
+		 * Name			: numFields
+		 * Description	: Returns the number of fields added
+		 * Arguments	: none
+		 * Returns		: number of fields
+		 *-------------------------------------------------*/
+        size_t numFields() const
+        {
+            return fields_.size();
+        }
+
+		/*-------------------------------------------------
+		 * Name			: isSet
+		 * Description	: Checks whether a field has a value
+		 * Arguments	: message is the message element,
+		 *				  Message::asElement()
+		 *				  field is the id from addField()
+		 * Returns		: true if the field is present and not null
+		 *-------------------------------------------------*/
+        bool isSet(const BloombergLP::blpapi::Element& message, int field) const
+        {
+            return find(message, field) != 0;
+        }
+
+		/*-------------------------------------------------
+		 * Name			: getFloat64
+		 * Description	: Reads a field as a Float64
+		 * Arguments	: message is the message element
+		 *				  field is the id from addField()
+		 *				  value receives the value
+		 * Returns		: true if the field is set and converts
+		 *-------------------------------------------------*/
+        bool getFloat64(const BloombergLP::blpapi::Element& message, int field,
+            BloombergLP::blpapi::Float64 *value) const
+        {
+            const blpapi_Element_t *element = find(message, field);
+            return element != 0
+                && blpapi_Element_getValueAsFloat64(element, value, 0) == 0;
+        }
+
+		/*-------------------------------------------------
+		 * Name			: getInt64
+		 * Description	: Reads a field as an Int64
+		 * Arguments	: message is the message element
+		 *				  field is the id from addField()
+		 *				  value receives the value
+		 * Returns		: true if the field is set and converts
+		 *-------------------------------------------------*/
+        bool getInt64(const BloombergLP::blpapi::Element& message, int field,
+            BloombergLP::blpapi::Int64 *value) const
+        {
+            const blpapi_Element_t *element = find(message, field);
+            return element != 0
+                && blpapi_Element_getValueAsInt64(element, value, 0) == 0;
+        }
+
+		/*-------------------------------------------------
+		 * Name			: getDatetime
+		 * Description	: Reads a field as a Datetime
+		 * Arguments	: message is the message element
+		 *				  field is the id from addField()
+		 *				  value receives the value
+		 * Returns		: true if the field is set and converts
+		 *-------------------------------------------------*/
+        bool getDatetime(const BloombergLP::blpapi::Element& message, int field,
+            BloombergLP::blpapi::Datetime *value) const
+        {
+            const blpapi_Element_t *element = find(message, field);
+            return element != 0
+                && blpapi_Element_getValueAsDatetime(element, &value->rawValue(), 0) == 0;
+        }
+
+		/*-------------------------------------------------
+		 * Name			: extract
+		 * Description	: Reads every field added with a type into
+		 *				  a struct. Fields that are absent, null or
+		 *				  do not convert are left untouched.
+		 * Arguments	: message is the message element
+		 *				  target is the struct the offsets given
+		 *				  to addField() are relative to
+		 * Returns		: bit mask of the fields written, bit n
+		 *				  for field id n
+		 *-------------------------------------------------*/
+        unsigned long long extract(const BloombergLP::blpapi::Element& message, void *target) const
+        {
+            unsigned long long written = 0;
+            size_t count = fields_.size() < (size_t)MAX_EXTRACT_FIELDS ? fields_.size() : (size_t)MAX_EXTRACT_FIELDS;
+            for (size_t i = 0; i < count; ++i)
+            {
+                const Field& field = fields_[i];
+                if (field.type_ != FIELD_NONE
+                    && read(locate(message, (int)i), field.type_, static_cast<char *>(target) + field.offset_))
+                {
+                    written |= 1ULL << i;
+                }
+            }
+            return written;
+        }
+
+		/*-------------------------------------------------
+		 * Name			: extractRow
+		 * Description	: Reads every field added with a type into
+		 *				  one row of column buffers. Fields that
+		 *				  are absent, null or do not convert are
+		 *				  left untouched.
+		 * Arguments	: message is the message element
+		 *				  columns holds an array of the field type
+		 *				  for each field id, 0 for the fields
+		 *				  not wanted
+		 *				  row is the index written in each array
+		 * Returns		: bit mask of the fields written, bit n
+		 *				  for field id n
+		 *-------------------------------------------------*/
+        unsigned long long extractRow(const BloombergLP::blpapi::Element& message,
+            void *const *columns, size_t row) const
+        {
+            unsigned long long written = 0;
+            size_t count = fields_.size() < (size_t)MAX_EXTRACT_FIELDS ? fields_.size() : (size_t)MAX_EXTRACT_FIELDS;
+            for (size_t i = 0; i < count; ++i)
+            {
+                const Field& field = fields_[i];
+                if (field.type_ != FIELD_NONE && columns[i] != 0
+                    && read(locate(message, (int)i), field.type_,
+                        static_cast<char *>(columns[i]) + row * sizeOf(field.type_)))
+                {
+                    written |= 1ULL << i;
+                }
+            }
+            return written;
+        }
+
+    private:
+        //position of a field that is not in the schema
+        enum { NO_POSITION = -1 };
+
+        struct Field
+        {
+            BloombergLP::blpapi::Name name_;
+
+            //position in the schema, NO_POSITION to read by Name
+            size_t position_;
+
+            //type and struct offset extract() writes the field to
+            FieldType type_;
+            size_t offset_;
+        };
+
+		/*-------------------------------------------------
+		 * Name			: sizeOf
+		 * Description	: Returns the size of a field type
+		 * Arguments	: type is the field type
+		 * Returns		: size in bytes
+		 *-------------------------------------------------*/
+        static size_t sizeOf(FieldType type)
+        {
+            switch (type)
+            {
+                case FIELD_FLOAT64:
+                    return sizeof(BloombergLP::blpapi::Float64);
+                case FIELD_INT64:
+                    return sizeof(BloombergLP::blpapi::Int64);
+                case FIELD_DATETIME:
+                    return sizeof(blpapi_Datetime_t);
+                default:
+                    return 0;
+            }
+        }
+
+		/*-------------------------------------------------
+		 * Name			: read
+		 * Description	: Converts the value of an element. A null
+		 *				  element has no value so it fails too.
+		 * Arguments	: element is the field element, may be 0
+		 *				  type is the type to convert to
+		 *				  value receives the value
+		 * Returns		: true if value was written
+		 *-------------------------------------------------*/
+        static bool read(const blpapi_Element_t *element, FieldType type, void *value)
+        {
+            if (element == 0)
+            {
+                return false;
+            }
+            switch (type)
+            {
+                case FIELD_FLOAT64:
+                    return blpapi_Element_getValueAsFloat64(element,
+                        static_cast<blpapi_Float64_t *>(value), 0) == 0;
+                case FIELD_INT64:
+                    return blpapi_Element_getValueAsInt64(element,
+                        static_cast<blpapi_Int64_t *>(value), 0) == 0;
+                case FIELD_DATETIME:
+                    return blpapi_Element_getValueAsDatetime(element,
+                        static_cast<blpapi_Datetime_t *>(value), 0) == 0;
+                default:
+                    return false;
+            }
+        }
+
+		/*-------------------------------------------------
+		 * Name			: locate
+		 * Description	: Finds the element of a field, null or not
+		 * Arguments	: message is the message element
+		 *				  field is the id from addField()
+		 * Returns		: the element, 0 if the field is not present
+		 *-------------------------------------------------*/
+        const blpapi_Element_t *locate(const BloombergLP::blpapi::Element& message, int field) const
+        {
+            const Field& entry = fields_[field];
+            blpapi_Element_t *element = 0;
+            if (entry.position_ == (size_t)NO_POSITION
+                || blpapi_Element_getElementAt(message.handle(), &element, entry.position_) != 0
+                || blpapi_Element_name(element) != entry.name_.impl())
+            {
+                //not laid out as the schema, look the field up by Name
+                if (blpapi_Element_getElement(message.handle(), &element, 0, entry.name_.impl()) != 0)
+                {
+                    return 0;
+                }
+            }
+            return element;
+        }
+
+		/*-------------------------------------------------
+		 * Name			: find
+		 * Description	: Finds the element of a field
+		 * Arguments	: message is the message element
+		 *				  field is the id from addField()
+		 * Returns		: the element, 0 if the field is not
+		 *				  present or is null
+		 *-------------------------------------------------*/
+        const blpapi_Element_t *find(const BloombergLP::blpapi::Element& message, int field) const
+        {
+            const blpapi_Element_t *element = locate(message, field);
+            return element == 0 || blpapi_Element_isNull(element) ? 0 : element;
+        }
+
+        std::vector<Field> fields_;
+};
+
+#endif
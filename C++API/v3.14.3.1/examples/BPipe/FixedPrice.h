@@ -0,0 +1,218 @@
+/* --------------------------------------------------------------------
+ *                          DISCLAIMER OF WARRANTY
+ *
+ * THE CODE SAMPLES PROVIDED IN THIS SDK (IN SOURCE CODE AND BINARY FORM) ARE
+ * PROVIDED "AS IS," WITHOUT A WARRANTY OF ANY KIND. ALL EXPRESS OR IMPLIED
+ * CONDITIONS, REPRESENTATIONS AND WARRANTIES, INCLUDING ANY IMPLIED WARRANTY
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE OR NON-INFRINGEMENT,
+ * ARE HEREBY EXCLUDED. BLOOMBERG AND ITS LICENSORS SHALL NOT BE LIABLE FOR
+ * ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR
+ * DISTRIBUTING THE SOFTWARE OR ITS DERIVATIVES. IN NO EVENT WILL BLOOMBERG
+ * OR ITS LICENSORS BE LIABLE FOR ANY LOST REVENUE, PROFIT OR DATA, OR FOR
+ * DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL, INCIDENTAL OR PUNITIVE DAMAGES,
+ * HOWEVER CAUSED AND REGARDLESS OF THE THEORY OF LIABILITY, ARISING OUT OF
+ * THE USE OF OR INABILITY TO USE SOFTWARE, EVEN IF BLOOMBERG HAS BEEN ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGES.
+ * THE CODE SAMPLES PROVIDED WITH THE B-PIPE SDK ARE NOT INTENDED FOR
+ * PRODUCTION USE, AND IF PUT TO SUCH USE THEY MAY RESULT IN SLOWNESS OR LOSS
+ * OF DATA.
+ * ----------------------------------------------------------------- */
+
+/* --------------------------------------------------------------------
+ * File: FixedPrice.h
+ *
+ * Description: This source code defines the fixed point price held by
+ *				the market depth books
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef _FIXEDPRICE_H_
+#define  _FIXEDPRICE_H_
+
+#include <math.h>
+
+/* --------------------------------------------------------------------
+ * Type			: FixedPrice
+ * Description  : Price as a whole number of units of the instrument's
+ *				  price increment, 10^-decimals. Prices of one book
+ *				  share a PriceScale so they compare exactly.
+ * --------------------------------------------------------------------*/
+typedef long long FixedPrice;
+
+/* --------------------------------------------------------------------
+ * Class/Struct : PriceScale
+ * Description  : Converts between wire prices and FixedPrice for a
+ *				  number of decimals. Book entries hold a price in 48
+ *				  bits, fromDouble() saturates to +/-(2^47 - 1) units,
+ *				  e.g. 14 million at 7 decimals. A book starts with
+ *				  a scale and widens it with decimalsFor() when a
+ *				  price needs more decimals.
+ * --------------------------------------------------------------------*/
+class PriceScale
+{
+    public:
+		//most decimals a scale can have
+		enum { MAX_DECIMALS = 9 };
+
+		/*-------------------------------------------------
+		 * Name			: PriceScale
+		 * Description	: Constructor
+		 * Arguments	: decimals is the number of decimals of
+		 *				  the instrument's prices, at most
+		 *				  MAX_DECIMALS
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        explicit PriceScale(unsigned int decimals = 4)
+        {
+            setDecimals(decimals);
+        }
+
+		/*-------------------------------------------------
+		 * Name			: setDecimals
+		 * Description	: Changes the number of decimals
+		 * Arguments	: decimals is the number of decimals,
+		 *				  at most MAX_DECIMALS
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        void setDecimals(unsigned int decimals)
+        {
+            decimals_ = decimals > (unsigned int)MAX_DECIMALS ? (unsigned int)MAX_DECIMALS : decimals;
+            factor_ = 1.0;
+            for (unsigned int i = 0; i < decimals_; ++i)
+            {
+                factor_ *= 10.0;
+            }
+        }
+
+		/*-------------------------------------------------
+		 * Name			: decimals
+		 * Description	: Returns the number of decimals
+		 * Arguments	: none
+		 * Returns		: number of decimals
+		 *-------------------------------------------------*/
+        unsigned int decimals() const
+        {
+            return decimals_;
+        }
+
+		/*-------------------------------------------------
+		 * Name			: fromDouble
+		 * Description	: Rounds a price to the nearest unit
+		 * Arguments	: price is the price received
+		 * Returns		: price in units, saturated to the
+		 *				  range a book entry holds
+		 *-------------------------------------------------*/
+        FixedPrice fromDouble(double price) const
+        {
+            double units = price * factor_;
+            const double limit = (double)maxUnits();
+            if (units >= limit)
+            {
+                return maxUnits();
+            }
+            if (units <= -limit)
+            {
+                return -maxUnits();
+            }
+            return (FixedPrice)(units < 0 ? units - 0.5 : units + 0.5);
+        }
+
+		/*-------------------------------------------------
+		 * Name			: decimalsFor
+		 * Description	: Returns the decimals needed to hold a
+		 *				  price exactly, never fewer than this
+		 *				  scale has. Stops at MAX_DECIMALS or
+		 *				  before the price would saturate.
+		 * Arguments	: price is the price received
+		 * Returns		: number of decimals
+		 *-------------------------------------------------*/
+        unsigned int decimalsFor(double price) const
+        {
+            unsigned int decimals = decimals_;
+            double factor = factor_;
+            double units = fabs(price) * factor;
+            const double limit = (double)maxUnits();
+            while (decimals < (unsigned int)MAX_DECIMALS && units * 10.0 < limit)
+            {
+                //allow for the rounding of the wire double and of the
+                //one multiply, a few units in the last place of units.
+                //A fixed tolerance would hide real decimals of small
+                //prices, e.g. take 1.0000005 for 1.
+                double error = fabs(units - floor(units + 0.5));
+                if (error <= units * 1e-15)
+                {
+                    break;
+                }
+                //powers of ten are exact, so units is one rounding
+                //away from the price at every step
+                factor *= 10.0;
+                units = fabs(price) * factor;
+                ++decimals;
+            }
+            return decimals;
+        }
+
+		/*-------------------------------------------------
+		 * Name			: convert
+		 * Description	: Converts a price of a scale with no
+		 *				  more decimals to this scale
+		 * Arguments	: price is the price in units of from
+		 *				  from is the scale of price
+		 * Returns		: price in units, saturated to the
+		 *				  range a book entry holds
+		 *-------------------------------------------------*/
+        FixedPrice convert(FixedPrice price, const PriceScale& from) const
+        {
+            const FixedPrice limit = maxUnits() / 10;
+            for (unsigned int i = from.decimals_; i < decimals_; ++i)
+            {
+                if (price > limit)
+                {
+                    return maxUnits();
+                }
+                if (price < -limit)
+                {
+                    return -maxUnits();
+                }
+                price *= 10;
+            }
+            return price;
+        }
+
+		/*-------------------------------------------------
+		 * Name			: toDouble
+		 * Description	: Converts a price for display
+		 * Arguments	: price is the price in units
+		 * Returns		: price
+		 *-------------------------------------------------*/
+        double toDouble(FixedPrice price) const
+        {
+            return (double)price / factor_;
+        }
+
+		/*-------------------------------------------------
+		 * Name			: maxUnits
+		 * Description	: Returns the largest price magnitude a
+		 *				  book entry holds
+		 * Arguments	: none
+		 * Returns		: 2^47 - 1
+		 *-------------------------------------------------*/
+        static FixedPrice maxUnits()
+        {
+            return ((FixedPrice)1 << 47) - 1;
+        }
+
+    private:
+        unsigned int decimals_;
+        double factor_;
+};
+
+#endif
@@ -0,0 +1,227 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: HistoryColumns.cpp
+ *
+ * Description: This file contains the columnar decoder of
+ *				HistoricalDataRequest responses.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#include "HistoryColumns.h"
+#include "EpochDay.h"
+#include "ElementUtil.h"
+
+#include <blpapi_datetime.h>
+#include <blpapi_element.h>
+
+namespace {
+	const BloombergLP::blpapi::Name SECURITY_DATA("securityData");
+	const BloombergLP::blpapi::Name SECURITY_NAME("security");
+	const BloombergLP::blpapi::Name SECURITY_ERROR("securityError");
+	const BloombergLP::blpapi::Name ERROR_MESSAGE("message");
+	const BloombergLP::blpapi::Name FIELD_DATA("fieldData");
+	const BloombergLP::blpapi::Name DATE("date");
+}
+
+/*----------------------------------------------------------------
+ * Name			: HistoryColumns constructor
+ * Description	: Constructs empty columns
+ * Arguments	: fields are the fields of the request, one column
+ *				  each, in order
+ * Returns		: none
+ *---------------------------------------------------------------*/
+BloombergLP::HistoryColumns::HistoryColumns(const std::vector<std::string>& fields)
+	: fields_(fields)
+	, values_(fields.size())
+	, valid_(fields.size())
+{
+	columnIndex_.reserve(fields_.size() + 1);
+	for (size_t i = 0; i < fields_.size(); ++i)
+	{
+		columnIndex_.add(blpapi::Name(fields_[i].c_str()), static_cast<int>(i));
+	}
+	columnIndex_.add(DATE, static_cast<int>(fields_.size()));
+}
+
+/*----------------------------------------------------------------
+ * Name			: reserve
+ * Description	: Allocates all columns for rows in advance
+ * Arguments	: rows is the expected total number of rows
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::HistoryColumns::reserve(size_t rows)
+{
+	dates_.reserve(rows);
+	for (size_t i = 0; i < fields_.size(); ++i)
+	{
+		values_[i].reserve(rows);
+		valid_[i].reserve((rows + 31) / 32);
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: appendRows
+ * Description	: Grows every column by count null rows
+ * Arguments	: count is the number of rows
+ * Returns		: index of the first new row
+ *---------------------------------------------------------------*/
+size_t BloombergLP::HistoryColumns::appendRows(size_t count)
+{
+	size_t first = dates_.size();
+	size_t rows = first + count;
+	dates_.resize(rows, NO_DATE);
+	for (size_t i = 0; i < fields_.size(); ++i)
+	{
+		values_[i].resize(rows, 0.0);
+		valid_[i].resize((rows + 31) / 32, 0);
+	}
+	return first;
+}
+
+/*----------------------------------------------------------------
+ * Name			: add
+ * Description	: Appends the rows of a HistoricalDataResponse message
+ * Arguments	: msg is a PARTIAL_RESPONSE or RESPONSE message
+ * Returns		: number of rows appended
+ *---------------------------------------------------------------*/
+size_t BloombergLP::HistoryColumns::add(const blpapi::Message& msg)
+{
+	blpapi::Element securityData;
+	if (msg.asElement().getElement(&securityData, SECURITY_DATA) != 0)
+	{
+		return 0;
+	}
+
+	const char *name = "";
+	tryGetElementAs(securityData, SECURITY_NAME, &name);
+
+	blpapi::Element securityError;
+	if (securityData.getElement(&securityError, SECURITY_ERROR) == 0)
+	{
+		Security security;
+		security.name_ = name;
+		security.firstRow_ = dates_.size();
+		security.numRows_ = 0;
+		const char *error = "securityError";
+		tryGetElementAs(securityError, ERROR_MESSAGE, &error);
+		security.error_ = error;
+		securities_.push_back(security);
+		return 0;
+	}
+
+	blpapi::Element fieldData;
+	if (securityData.getElement(&fieldData, FIELD_DATA) != 0)
+	{
+		return 0;
+	}
+
+	size_t count = fieldData.numValues();
+	size_t first = appendRows(count);
+
+	//a security split over several messages keeps one row range
+	if (securities_.empty()
+		|| !securities_.back().error_.empty()
+		|| securities_.back().name_ != name)
+	{
+		Security security;
+		security.name_ = name;
+		security.firstRow_ = first;
+		security.numRows_ = 0;
+		securities_.push_back(security);
+	}
+	securities_.back().numRows_ += count;
+
+	const int dateColumn = static_cast<int>(fields_.size());
+	for (size_t j = 0; j < count; ++j)
+	{
+		blpapi::Element row;
+		if (fieldData.getValueAs(&row, j) != 0)
+		{
+			continue;
+		}
+
+		size_t r = first + j;
+		unsigned int bit = 1u << (r & 31);
+		size_t numElements = row.numElements();
+		for (size_t i = 0; i < numElements; ++i)
+		{
+			blpapi::Element element;
+			if (row.getElement(&element, i) != 0 || element.isNull())
+			{
+				continue;
+			}
+
+			int column = columnIndex_.find(element.name());
+			if (column == NameIndex::NOT_FOUND)
+			{
+				continue;
+			}
+			if (column == dateColumn)
+			{
+				blpapi::Datetime date;
+				if (element.getValueAs(&date) == 0)
+				{
+					dates_[r] = dayNumber(date.year(), date.month(), date.day());
+				}
+			}
+			else if (element.getValueAs(&values_[column][r]) == 0)
+			{
+				valid_[column][r >> 5] |= bit;
+			}
+		}
+	}
+	return count;
+}
+
+/*----------------------------------------------------------------
+ * Name			: clear
+ * Description	: Removes all rows, keeping the memory
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::HistoryColumns::clear()
+{
+	securities_.clear();
+	dates_.clear();
+	for (size_t i = 0; i < fields_.size(); ++i)
+	{
+		values_[i].clear();
+		valid_[i].clear();
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: dayNumber
+ * Description	: Converts a calendar date to a day number
+ * Arguments	: year, month (1-12) and day (1-31) of the date
+ * Returns		: days since 1970-01-01
+ *---------------------------------------------------------------*/
+int BloombergLP::HistoryColumns::dayNumber(int year, int month, int day)
+{
+	return epochDay(year, month, day);
+}
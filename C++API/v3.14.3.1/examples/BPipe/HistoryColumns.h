@@ -0,0 +1,185 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: HistoryColumns.h
+ *
+ * Description: This file contains the HistoryColumns class, which
+ *				decodes HistoricalDataRequest responses into one
+ *				contiguous column per field.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef __HistoryColumns_h__
+#define __HistoryColumns_h__
+
+#include <blpapi_message.h>
+#include <blpapi_name.h>
+
+#include <limits.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include "NameIndex.h"
+
+namespace BloombergLP
+{
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : HistoryColumns
+	 * Description  : Columns of the fieldData rows of HistoricalDataRequest
+	 *				  responses. Every row holds the date as a day number
+	 *				  and one double per requested field, with a bitmap
+	 *				  marking the fields the row carries. The rows of a
+	 *				  security are contiguous; securities are appended in
+	 *				  the order their PARTIAL_RESPONSE and RESPONSE
+	 *				  messages are added. The columns grow once per
+	 *				  message, not once per row or per value.
+	 *				  Values that do not convert to double, such as
+	 *				  strings, are left null.
+	 * --------------------------------------------------------------------*/
+	class HistoryColumns
+	{
+		public:
+			//rows of one security
+			struct Security
+			{
+				//security string of the response
+				std::string name_;
+
+				//first row and number of rows of the security
+				size_t firstRow_;
+				size_t numRows_;
+
+				//securityError message, empty if none
+				std::string error_;
+			};
+
+			/*----------------------------------------------------------------
+			 * Name			: HistoryColumns constructor
+			 * Description	: Constructs empty columns
+			 * Arguments	: fields are the fields of the request, one
+			 *				  column each, in order
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			explicit HistoryColumns(const std::vector<std::string>& fields);
+
+			/*----------------------------------------------------------------
+			 * Name			: reserve
+			 * Description	: Allocates all columns for rows in advance
+			 * Arguments	: rows is the expected total number of rows
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			void reserve(size_t rows);
+
+			/*----------------------------------------------------------------
+			 * Name			: add
+			 * Description	: Appends the rows of a HistoricalDataResponse
+			 *				  message. Rows of the same security as the
+			 *				  last message extend that security.
+			 * Arguments	: msg is a PARTIAL_RESPONSE or RESPONSE message
+			 * Returns		: number of rows appended, 0 for a message
+			 *				  without securityData or with a
+			 *				  securityError
+			 *---------------------------------------------------------------*/
+			size_t add(const blpapi::Message& msg);
+
+			/*----------------------------------------------------------------
+			 * Name			: clear
+			 * Description	: Removes all rows, keeping the memory
+			 * Arguments	: none
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			void clear();
+
+			//number of rows and of field columns
+			size_t numRows() const { return dates_.size(); }
+			size_t numFields() const { return fields_.size(); }
+
+			//securities in the order added
+			size_t numSecurities() const { return securities_.size(); }
+			const Security& security(size_t index) const { return securities_[index]; }
+
+			//field of column
+			const std::string& field(size_t column) const { return fields_[column]; }
+
+			//date of a row without a date element
+			enum { NO_DATE = INT_MIN };
+
+			//dates of all rows as day numbers, see dayNumber()
+			const int *dates() const { return dates_.empty() ? 0 : &dates_[0]; }
+
+			//values of column for all rows, 0 where null
+			const double *values(size_t column) const
+			{
+				return values_[column].empty() ? 0 : &values_[column][0];
+			}
+
+			//bitmap of column, bit row % 32 of word row / 32 is set if
+			//the row has a value
+			const unsigned int *validBits(size_t column) const
+			{
+				return valid_[column].empty() ? 0 : &valid_[column][0];
+			}
+
+			//true if row has no value for column
+			bool isNull(size_t row, size_t column) const
+			{
+				return (valid_[column][row >> 5] & (1u << (row & 31))) == 0;
+			}
+
+			/*----------------------------------------------------------------
+			 * Name			: dayNumber
+			 * Description	: Converts a calendar date to a day number
+			 * Arguments	: year, month (1-12) and day (1-31) of the date
+			 * Returns		: days since 1970-01-01
+			 *---------------------------------------------------------------*/
+			static int dayNumber(int year, int month, int day);
+
+		private:
+			/*----------------------------------------------------------------
+			 * Name			: appendRows
+			 * Description	: Grows every column by count null rows
+			 * Arguments	: count is the number of rows
+			 * Returns		: index of the first new row
+			 *---------------------------------------------------------------*/
+			size_t appendRows(size_t count);
+
+			std::vector<std::string> fields_;
+
+			//column of each field Name, numFields() for the date
+			NameIndex columnIndex_;
+
+			std::vector<Security> securities_;
+
+			std::vector<int> dates_;
+			std::vector<std::vector<double> > values_;
+			std::vector<std::vector<unsigned int> > valid_;
+	};
+}
+
+#endif
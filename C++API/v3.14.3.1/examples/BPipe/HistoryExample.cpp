@@ -30,6 +30,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "HistoryColumns.h"
+
 using namespace BloombergLP;
 using namespace blpapi;
 
@@ -82,6 +84,7 @@ class HistoryExample
 	std::vector<std::string> d_fields;
 	std::string        		 d_startDate;
 	std::string          	 d_endDate;
+	bool					 d_columns;		// decode into columns instead of printing
 
 	void printUsage()
 	{
@@ -95,6 +98,7 @@ class HistoryExample
                 << "        [-p         <tcpPort = 8194>" << std::endl
 				<< "        [-auth      <authenticationOption = LOGON (default) or NONE or APPLICATION or DIRSVC or USER_APP>]" << std::endl
                 << "        [-n         <name = applicationName or directoryService>]" << std::endl
+                << "        [-columns   decode the response into columns and print a summary]" << std::endl
                 << "Notes:" << std::endl
                 << " -Specify only LOGON to authorize 'user' using Windows login name." << std::endl
                 << " -Specify DIRSVC and name(Directory Service Property) to authorize user using directory Service." << std::endl
@@ -122,6 +126,8 @@ class HistoryExample
 				d_authOption = argv[++i];
 		  } else if (!std::strcmp(argv[i],"-n") &&  i + 1 < argc) {
                 d_name = argv[++i];
+		  } else if (!std::strcmp(argv[i],"-columns")) {
+				d_columns = true;
 		  } else if (!std::strcmp(argv[i], "-h") && i < argc) {
 				printUsage();
 				return false;
@@ -302,6 +308,7 @@ public:
     {
         d_port = 8194;
 		d_name = "";
+		d_columns = false;
         if (!parseCommandLine(argc, argv)) return;
 
         if (!startSession()) return;
@@ -343,6 +350,8 @@ public:
 			d_session->sendRequest(request, d_identity);
 		}
 
+		BloombergLP::HistoryColumns columns(d_fields);
+
         while (true)
 		{
             Event event = d_session->nextEvent();
@@ -356,6 +365,11 @@ public:
 					msg.print(std::cout);
 					continue;
 				}
+				if (d_columns && !msg.hasElement(RESPONSE_ERROR, true))
+				{
+					columns.add(msg);
+					continue;
+				}
 				if (msg.hasElement(RESPONSE_ERROR, true))
 				{
 					// response error
@@ -379,8 +393,56 @@ public:
                 break;
             }
         }
+
+		if (d_columns)
+		{
+			PrintColumns(columns);
+		}
     }
 
+	void PrintColumns(const BloombergLP::HistoryColumns& columns)
+	{
+		for (size_t i = 0; i < columns.numSecurities(); ++i)
+		{
+			const BloombergLP::HistoryColumns::Security& security = columns.security(i);
+			std::cout << security.name_ << ": ";
+			if (!security.error_.empty())
+			{
+				std::cout << security.error_ << "\n";
+				continue;
+			}
+			std::cout << security.numRows_ << " rows\n";
+			if (security.numRows_ == 0)
+			{
+				continue;
+			}
+
+			// count and average the values of each field
+			size_t end = security.firstRow_ + security.numRows_;
+			for (size_t k = 0; k < columns.numFields(); ++k)
+			{
+				const double *values = columns.values(k);
+				size_t count = 0;
+				double sum = 0;
+				for (size_t r = security.firstRow_; r < end; ++r)
+				{
+					if (!columns.isNull(r, k))
+					{
+						++count;
+						sum += values[r];
+					}
+				}
+				std::cout << "\t" << columns.field(k) << ": " << count << " values";
+				if (count > 0)
+				{
+					std::cout << ", mean " << sum / count;
+				}
+				std::cout << "\n";
+			}
+		}
+		std::cout << columns.numRows() << " rows in total" << std::endl;
+	}
+
 	bool ProcessExceptions(Message msg)
 	{
 		Element securityData = msg.getElement(SECURITY_DATA);
@@ -33,6 +33,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "RequestPlanner.h"
+
 
 using namespace BloombergLP;
 using namespace blpapi;
@@ -62,7 +64,7 @@ namespace {
 	const char *AUTH_SVC = "//blp/apiauth";
 };
 
-class IntradayBarExample {
+class IntradayBarExample : public BloombergLP::SliceHandler {
 
 	std::vector<std::string> d_hosts;		// IP Addresses of appliances
     int					    d_port;
@@ -76,6 +78,10 @@ class IntradayBarExample {
     bool                    d_gapFillInitialBar;
     std::string             d_startDateTime;
     std::string             d_endDateTime;
+    int                     d_sliceMinutes;		// 0 for a single request
+    int                     d_parallel;			// most slices in flight
+    int                     d_retries;			// resends of a failed slice
+    int                     d_maxPendingRequests;
 
 
     void printUsage()
@@ -92,6 +98,9 @@ class IntradayBarExample {
             << "     [-p     <tcpPort   = 8194>" <<  std::endl
 			<< "     [-auth  <authenticationOption = LOGON (default) or NONE or APPLICATION or DIRSVC or USER_APP>]" << std::endl
             << "     [-n     <name = applicationName or directoryService>]" << std::endl
+            << "     [-slice <minutes = 0, split the range into requests of minutes, a multiple of barInterval>]" << std::endl
+            << "     [-parallel <slices in flight = 4>]" << std::endl
+            << "     [-retries  <resends of a failed slice = 2>]" << std::endl
             << "Notes:" << std::endl
             << "1) All times are in GMT." <<  std::endl
             << "2) Only one security can be specified." <<  std::endl
@@ -123,6 +132,12 @@ class IntradayBarExample {
                 d_eventType = argv[++i];
             } else if (!std::strcmp(argv[i],"-b") &&  i + 1 < argc) {
                 d_barInterval = std::atoi(argv[++i]);
+            } else if (!std::strcmp(argv[i],"-slice") &&  i + 1 < argc) {
+                d_sliceMinutes = std::atoi(argv[++i]);
+            } else if (!std::strcmp(argv[i],"-parallel") &&  i + 1 < argc) {
+                d_parallel = std::atoi(argv[++i]);
+            } else if (!std::strcmp(argv[i],"-retries") &&  i + 1 < argc) {
+                d_retries = std::atoi(argv[++i]);
             } else if (!std::strcmp(argv[i],"-g")) {
                 d_gapFillInitialBar = true;
             } else if (!std::strcmp(argv[i],"-sd") && i + 1 < argc) {
@@ -158,11 +173,30 @@ class IntradayBarExample {
 			 printUsage();
              return false;
 		}
+		// check the slicing options
+		if (d_parallel < 1) {
+			 std::cout << "Slices in flight must be at least 1." << std::endl;
+			 printUsage();
+             return false;
+		}
+		if (d_retries < 0) {
+			 std::cout << "Retries cannot be negative." << std::endl;
+			 printUsage();
+             return false;
+		}
+
+		// slices start on a bar boundary of the whole range only if
+		// they are made of whole bars
+		if (d_sliceMinutes > 0 && (d_barInterval <= 0 || d_sliceMinutes % d_barInterval != 0)) {
+			 std::cout << "Slice minutes must be a multiple of the bar interval." << std::endl;
+			 printUsage();
+             return false;
+		}
 
         return true;
     }
 
-    void processMessage(Message &msg) {
+    void processMessage(Message &msg, const BloombergLP::RequestSlice *slice = 0) {
         Element data = msg.getElement(BAR_DATA).getElement(BAR_TICK_DATA);
         int numBars = data.numValues();
         std::cout <<"Response contains " << numBars << " bars" << std::endl;
@@ -171,6 +205,10 @@ class IntradayBarExample {
         for (int i = 0; i < numBars; ++i) {
             Element bar = data.getValueAsElement(i);
             Datetime time = bar.getElementAsDatetime(TIME);
+            if (slice && !slice->owns(BloombergLP::RequestPlanner::toSeconds(time))) {
+                // the bar at the end of the slice starts the next one
+                continue;
+            }
             double open = bar.getElementAsFloat64(OPEN);
             double high = bar.getElementAsFloat64(HIGH);
             double low = bar.getElementAsFloat64(LOW);
@@ -249,6 +287,80 @@ class IntradayBarExample {
 		}
     }
 
+    void buildRequest(const BloombergLP::RequestSlice& slice, Request& request)
+    {
+        request.set("eventType", d_eventType.c_str());
+        request.set("interval", d_barInterval);
+        // a later slice starts mid range, filling its first bar would
+        // add a bar the unsliced request does not have
+        if (d_gapFillInitialBar && slice.index_ == 0) {
+            request.set("gapFillInitialBar", d_gapFillInitialBar);
+        }
+    }
+
+    void processSlice(const BloombergLP::RequestSlice& slice)
+    {
+        std::cout << "Slice " << slice.index_ << " of " << slice.security_ << ": "
+            << BloombergLP::RequestPlanner::toDatetime(slice.start_) << " to "
+            << BloombergLP::RequestPlanner::toDatetime(slice.end_) << std::endl;
+        for (size_t i = 0; i < slice.messages_.size(); ++i) {
+            Message msg = slice.messages_[i];
+            processMessage(msg, &slice);
+        }
+    }
+
+    void processFailure(const BloombergLP::RequestSlice& slice)
+    {
+        std::cout << "Slice " << slice.index_ << " of " << slice.security_
+            << " FAILED after " << slice.attempts_ << " attempts: "
+            << slice.error_ << std::endl;
+    }
+
+    bool sendSlicedRequests(BloombergLP::RequestPlanner &planner)
+    {
+        long long start, end;
+        if (d_startDateTime.empty() || d_endDateTime.empty()) {
+            Datetime startDateTime, endDateTime;
+            if (0 != getTradingDateRange(&startDateTime, &endDateTime)) {
+                return false;
+            }
+            start = BloombergLP::RequestPlanner::toSeconds(startDateTime);
+            end = BloombergLP::RequestPlanner::toSeconds(endDateTime);
+        }
+        else if (!BloombergLP::RequestPlanner::parseTime(d_startDateTime.c_str(), &start)
+            || !BloombergLP::RequestPlanner::parseTime(d_endDateTime.c_str(), &end)) {
+            std::cout << "Invalid start or end time" << std::endl;
+            return false;
+        }
+
+        // slice i starts i whole slices, so whole bars, after start
+        size_t numSlices = planner.addJob(d_security, start, end, d_sliceMinutes * 60LL);
+        std::cout << "Sending " << numSlices << " slices, " << d_parallel
+            << " at a time" << std::endl;
+        planner.start();
+        return true;
+    }
+
+    void slicedEventLoop(BloombergLP::RequestPlanner &planner) {
+        while (!planner.done()) {
+            Event event = d_session->nextEvent();
+            if (planner.processEvent(event)) {
+                continue;
+            }
+            MessageIterator msgIter(event);
+            while (msgIter.next()) {
+                Message msg = msgIter.message();
+                if (event.eventType() == Event::SESSION_STATUS) {
+                    if (msg.messageType() == SESSION_TERMINATED) {
+                        return;
+                    }
+                }
+            }
+        }
+        std::cout << planner.numSlices() << " slices, "
+            << planner.numRetries() << " retries" << std::endl;
+    }
+
     void eventLoop() {
         bool done = false;
         while (!done) {
@@ -331,6 +443,7 @@ class IntradayBarExample {
 		if (authOptions.size() > 0) {
 			sessionOptions.setAuthenticationOptions(authOptions.c_str());
 		}
+        d_maxPendingRequests = sessionOptions.maxPendingRequests();
         d_session = new Session(sessionOptions);
 
         if (!d_session->start()) {
@@ -442,6 +555,9 @@ public:
         d_security = "IBM US Equity";
         d_eventType = "TRADE";
         d_gapFillInitialBar = false;
+        d_sliceMinutes = 0;
+        d_parallel = 4;
+        d_retries = 2;
 		d_name = "";
     }
 
@@ -460,6 +576,21 @@ public:
 			}
 		}
 
+        if (d_sliceMinutes > 0) {
+            if (d_parallel > d_maxPendingRequests) {
+                d_parallel = d_maxPendingRequests;
+            }
+            BloombergLP::RequestPlanner planner(*d_session,
+                d_session->getService(REFDATA_SVC), "IntradayBarRequest", *this,
+                strcmp(d_authOption.c_str(), "NONE") ? &d_identity : 0,
+                d_parallel, d_retries);
+            if (sendSlicedRequests(planner)) {
+                slicedEventLoop(planner);
+            }
+            d_session->stop();
+            return;
+        }
+
         sendIntradayBarRequest();
 
         // wait for events from session.
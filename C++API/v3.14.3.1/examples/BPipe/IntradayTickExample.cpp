@@ -35,6 +35,10 @@
 #include <string.h>
 #include <time.h>
 
+#include "TickDecoder.h"
+#include "ElementUtil.h"
+#include "RequestPlanner.h"
+
 using namespace BloombergLP;
 using namespace blpapi;
 
@@ -58,9 +62,41 @@ namespace {
 
 	const char *REFDATA_SVC = "//blp/refdata";
 	const char *AUTH_SVC = "//blp/apiauth";
+
+	/* Prints one line per batch of decoded ticks and the totals */
+	class TickSummary : public BloombergLP::TickBatchHandler
+	{
+		long long d_numTicks;
+		long long d_volume;
+
+	public:
+		TickSummary() : d_numTicks(0), d_volume(0)
+		{
+		}
+
+		void processTicks(const BloombergLP::TickRecord *ticks, size_t count)
+		{
+			long long volume = 0;
+			for (size_t i = 0; i < count; ++i) {
+				volume += ticks[i].size_;
+			}
+			d_numTicks += count;
+			d_volume += volume;
+
+			// times are nanoseconds since the epoch, print seconds
+			std::cout << count << " ticks from " << ticks[0].time_ / 1000000000LL
+				<< " to " << ticks[count - 1].time_ / 1000000000LL
+				<< ", volume " << volume << std::endl;
+		}
+
+		void printTotals()
+		{
+			std::cout << d_numTicks << " ticks, volume " << d_volume << std::endl;
+		}
+	};
 };
 
-class IntradayTickExample {
+class IntradayTickExample : public BloombergLP::SliceHandler {
 
 	std::vector<std::string>	d_hosts;		// IP Addresses of appliances
     int							d_port;
@@ -73,6 +109,12 @@ class IntradayTickExample {
     bool                        d_conditionCodes;
     std::string                 d_startDateTime;
     std::string                 d_endDateTime;
+    size_t                      d_batchSize;	// 0 to print every tick
+    int                         d_sliceMinutes;	// 0 for a single request
+    int                         d_parallel;		// most slices in flight
+    int                         d_retries;		// resends of a failed slice
+    int                         d_maxPendingRequests;
+    BloombergLP::TickDecoder    *d_decoder;		// decodes the slices with -batch
 
 
     void printUsage()
@@ -89,6 +131,10 @@ class IntradayTickExample {
             << "    [-p     <tcpPort   = 8194>" << std::endl
 			<< "    [-auth  <authenticationOption = LOGON (default) or NONE or APPLICATION or DIRSVC or USER_APP>]" << std::endl
             << "    [-n     <name = applicationName or directoryService>]" << std::endl
+            << "    [-batch <size = 0, print every tick; > 0 decode ticks in batches of size>]" << std::endl
+            << "    [-slice <minutes = 0, split the range into requests of minutes>]" << std::endl
+            << "    [-parallel <slices in flight = 4>]" << std::endl
+            << "    [-retries  <resends of a failed slice = 2>]" << std::endl
             << "Notes:" << std::endl
             << "1) All times are in GMT." << std::endl
             << "2) Only one security can be specified." << std::endl
@@ -113,6 +159,14 @@ class IntradayTickExample {
                 d_security = argv[++i];
             } else if (!std::strcmp(argv[i],"-e") && i + 1 < argc) {
                 d_events.push_back(argv[++i]);
+            } else if (!std::strcmp(argv[i],"-batch") && i + 1 < argc) {
+                d_batchSize = std::atoi(argv[++i]);
+            } else if (!std::strcmp(argv[i],"-slice") && i + 1 < argc) {
+                d_sliceMinutes = std::atoi(argv[++i]);
+            } else if (!std::strcmp(argv[i],"-parallel") && i + 1 < argc) {
+                d_parallel = std::atoi(argv[++i]);
+            } else if (!std::strcmp(argv[i],"-retries") && i + 1 < argc) {
+                d_retries = std::atoi(argv[++i]);
             } else if (!std::strcmp(argv[i],"-cc")) {
                 d_conditionCodes = true;
             } else if (!std::strcmp(argv[i],"-sd") && i + 1 < argc) {
@@ -152,6 +206,17 @@ class IntradayTickExample {
 			 printUsage();
              return false;
 		}
+		// check the slicing options
+		if (d_parallel < 1) {
+			 std::cout << "Slices in flight must be at least 1." << std::endl;
+			 printUsage();
+             return false;
+		}
+		if (d_retries < 0) {
+			 std::cout << "Retries cannot be negative." << std::endl;
+			 printUsage();
+             return false;
+		}
 
 		//default arguments
 		if (d_events.size() == 0) {
@@ -160,7 +225,7 @@ class IntradayTickExample {
         return true;
     }
 
-    void processMessage(Message &msg)
+    void processMessage(Message &msg, const BloombergLP::RequestSlice *slice = 0)
     {
         Element data = msg.getElement(TICK_DATA).getElement(TICK_DATA);
         int numItems = data.numValues();
@@ -171,13 +236,14 @@ class IntradayTickExample {
         for (int i = 0; i < numItems; ++i) {
             Element item = data.getValueAsElement(i);
             Datetime time = item.getElementAsDatetime(TIME);
+            if (slice && !slice->owns(BloombergLP::RequestPlanner::toSeconds(time))) {
+                continue;
+            }
             std::string timeString = item.getElementAsString(TIME);
             type = item.getElementAsString(TYPE);
             double value = item.getElementAsFloat64(VALUE);
             int size = item.getElementAsInt32(TICK_SIZE);
-            if (item.hasElement(COND_CODE)) {
-                cc = item.getElementAsString(COND_CODE);
-            }  else {
+            if (tryGetElementAs(item, COND_CODE, &cc) != 0) {
                 cc.clear();
             }
 
@@ -191,7 +257,7 @@ class IntradayTickExample {
         }
     }
 
-    void processResponseEvent(Event &event)
+    void processResponseEvent(Event &event, BloombergLP::TickDecoder *decoder)
     {
         MessageIterator msgIter(event);
         while (msgIter.next()) {
@@ -201,7 +267,11 @@ class IntradayTickExample {
                     msg.getElement(RESPONSE_ERROR));
                 continue;
             }
-            processMessage(msg);
+            if (decoder) {
+                decoder->add(msg);
+            } else {
+                processMessage(msg);
+            }
         }
     }
 
@@ -254,18 +324,120 @@ class IntradayTickExample {
 		}
     }
 
+    void buildRequest(const BloombergLP::RequestSlice&, Request& request)
+    {
+        Element eventTypes = request.getElement("eventTypes");
+        for (size_t i = 0; i < d_events.size(); ++i) {
+            eventTypes.appendValue(d_events[i].c_str());
+        }
+        if (d_conditionCodes) {
+            request.set("includeConditionCodes", true);
+        }
+    }
+
+    void processSlice(const BloombergLP::RequestSlice& slice)
+    {
+        std::cout << "Slice " << slice.index_ << " of " << slice.security_ << ": "
+            << BloombergLP::RequestPlanner::toDatetime(slice.start_) << " to "
+            << BloombergLP::RequestPlanner::toDatetime(slice.end_) << std::endl;
+        // ticks at the end of the slice start the next one
+        long long endNs = slice.last_ ? -1 : slice.end_ * 1000000000LL;
+        for (size_t i = 0; i < slice.messages_.size(); ++i) {
+            Message msg = slice.messages_[i];
+            if (d_decoder) {
+                d_decoder->add(msg, endNs);
+            } else {
+                processMessage(msg, &slice);
+            }
+        }
+    }
+
+    void processFailure(const BloombergLP::RequestSlice& slice)
+    {
+        std::cout << "Slice " << slice.index_ << " of " << slice.security_
+            << " FAILED after " << slice.attempts_ << " attempts: "
+            << slice.error_ << std::endl;
+    }
+
+    bool sendSlicedRequests(BloombergLP::RequestPlanner &planner)
+    {
+        long long start, end;
+        if (d_startDateTime.empty() || d_endDateTime.empty()) {
+            Datetime startDateTime, endDateTime;
+            if (0 != getTradingDateRange(&startDateTime, &endDateTime)) {
+                return false;
+            }
+            start = BloombergLP::RequestPlanner::toSeconds(startDateTime);
+            end = BloombergLP::RequestPlanner::toSeconds(endDateTime);
+        }
+        else if (!BloombergLP::RequestPlanner::parseTime(d_startDateTime.c_str(), &start)
+            || !BloombergLP::RequestPlanner::parseTime(d_endDateTime.c_str(), &end)) {
+            std::cout << "Invalid start or end time" << std::endl;
+            return false;
+        }
+
+        size_t numSlices = planner.addJob(d_security, start, end, d_sliceMinutes * 60LL);
+        std::cout << "Sending " << numSlices << " slices, " << d_parallel
+            << " at a time" << std::endl;
+        planner.start();
+        return true;
+    }
+
+    void slicedEventLoop(BloombergLP::RequestPlanner &planner)
+    {
+        // the slices arrive in time order, so with -batch they are
+        // decoded into one buffer as a single request would be
+        TickSummary summary;
+        BloombergLP::TickDecoder decoder(summary, d_batchSize);
+        d_decoder = d_batchSize > 0 ? &decoder : 0;
+
+        while (!planner.done()) {
+            Event event = d_session->nextEvent();
+            if (planner.processEvent(event)) {
+                continue;
+            }
+            MessageIterator msgIter(event);
+            while (msgIter.next()) {
+                Message msg = msgIter.message();
+                if (event.eventType() == Event::SESSION_STATUS) {
+                    if (msg.messageType() == SESSION_TERMINATED) {
+                        d_decoder = 0;
+                        return;
+                    }
+                }
+            }
+        }
+        if (d_decoder) {
+            d_decoder->flush();
+            summary.printTotals();
+            d_decoder = 0;
+        }
+        std::cout << planner.numSlices() << " slices, "
+            << planner.numRetries() << " retries" << std::endl;
+    }
+
     void eventLoop(Session &session)
     {
+        // with -batch the ticks of any date range are decoded into
+        // one buffer of d_batchSize records
+        TickSummary summary;
+        BloombergLP::TickDecoder decoder(summary, d_batchSize);
+        BloombergLP::TickDecoder *decoder_p = d_batchSize > 0 ? &decoder : 0;
+
         bool done = false;
         while (!done) {
             Event event = session.nextEvent();
             if (event.eventType() == Event::PARTIAL_RESPONSE) {
                 std::cout <<"Processing Partial Response" << std::endl;
-                processResponseEvent(event);
+                processResponseEvent(event, decoder_p);
             }
             else if (event.eventType() == Event::RESPONSE) {
                 std::cout <<"Processing Response" << std::endl;
-                processResponseEvent(event);
+                processResponseEvent(event, decoder_p);
+                if (decoder_p) {
+                    decoder_p->flush();
+                    summary.printTotals();
+                }
                 done = true;
             } else {
                 MessageIterator msgIter(event);
@@ -330,6 +502,7 @@ class IntradayTickExample {
 		if (authOptions.size() > 0) {
 			sessionOptions.setAuthenticationOptions(authOptions.c_str());
 		}
+        d_maxPendingRequests = sessionOptions.maxPendingRequests();
         d_session = new Session(sessionOptions);
 
         if (!d_session->start()) {
@@ -434,11 +607,15 @@ class IntradayTickExample {
 
 public:
 
-	IntradayTickExample() : d_session(0)
+	IntradayTickExample() : d_session(0), d_decoder(0)
     {
         d_port = 8194;
         d_security = "IBM US Equity";
         d_conditionCodes = false;
+        d_batchSize = 0;
+        d_sliceMinutes = 0;
+        d_parallel = 4;
+        d_retries = 2;
 		d_name = "";
     }
 
@@ -458,6 +635,21 @@ public:
 			}
 		}
 
+        if (d_sliceMinutes > 0) {
+            if (d_parallel > d_maxPendingRequests) {
+                d_parallel = d_maxPendingRequests;
+            }
+            BloombergLP::RequestPlanner planner(*d_session,
+                d_session->getService(REFDATA_SVC), "IntradayTickRequest", *this,
+                strcmp(d_authOption.c_str(), "NONE") ? &d_identity : 0,
+                d_parallel, d_retries);
+            if (sendSlicedRequests(planner)) {
+                slicedEventLoop(planner);
+            }
+            d_session->stop();
+            return;
+        }
+
         sendIntradayTickRequest(*d_session);
 
         // wait for events from session.
@@ -0,0 +1,203 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: LastValueCache.cpp
+ *
+ * Description: This file contains the last value cache of the
+ *				subscription data.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#include <blpapi_message.h>
+
+#include <new>
+
+#include "LastValueCache.h"
+
+using namespace BloombergLP;
+using namespace blpapi;
+
+/*----------------------------------------------------------------
+ * Name			: LastValueCache constructor
+ * Description	: Constructs a cache with room for maxTopics slots
+ * Arguments	: fields are the fields kept
+ *				  maxTopics is the number of topics that can be added
+ * Returns		: none
+ *---------------------------------------------------------------*/
+LastValueCache::LastValueCache(const std::vector<std::string> &fields,
+	size_t maxTopics)
+: fields_(fields)
+, slab_(0)
+, slotSize_(0)
+, maxTopics_(maxTopics)
+, scratch_(fields_.size() > 0 ? fields_.size() : 1)
+{
+	slotSize_ = sizeof(Slot) + fields_.size() * sizeof(Float64);
+	slotSize_ = (slotSize_ + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+
+	// one spare line to start the slab on a line boundary
+	buffer_.resize(maxTopics_ * slotSize_ + CACHE_LINE);
+	size_t misalign = (size_t)&buffer_[0] % CACHE_LINE;
+	slab_ = &buffer_[0] + (misalign ? CACHE_LINE - misalign : 0);
+
+	for (size_t i = 0; i < maxTopics_; ++i) {
+		Slot *s = new (slab_ + i * slotSize_) Slot;
+		s->setMask_ = 0;
+		s->updates_ = 0;
+		for (size_t j = 0; j < fields_.size(); ++j) {
+			values(s)[j] = 0;
+		}
+	}
+	topics_.reserve(maxTopics_);
+}
+
+/*----------------------------------------------------------------
+ * Name			: LastValueCache destructor
+ * Description	: Destroys the slots
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+LastValueCache::~LastValueCache()
+{
+	for (size_t i = 0; i < maxTopics_; ++i) {
+		slot((int)i)->~Slot();
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: addTopic
+ * Description	: Gives a slot to a subscription
+ * Arguments	: topic is the subscription correlation id
+ * Returns		: slot of the topic, NOT_FOUND if the slab is full
+ *---------------------------------------------------------------*/
+int LastValueCache::addTopic(const CorrelationId &topic)
+{
+	std::map<CorrelationId, int>::iterator it = index_.find(topic);
+	if (it != index_.end()) {
+		return it->second;
+	}
+	if (topics_.size() >= maxTopics_) {
+		return NOT_FOUND;
+	}
+	topics_.push_back(topic);
+	int id = (int)topics_.size() - 1;
+	index_[topic] = id;
+	return id;
+}
+
+/*----------------------------------------------------------------
+ * Name			: compile
+ * Description	: Reads the fields by their position in the schema
+ * Arguments	: message is the definition of the messages
+ * Returns		: true if every field is in the schema
+ *---------------------------------------------------------------*/
+bool LastValueCache::compile(const SchemaElementDefinition &message)
+{
+	return fields_.compile(message);
+}
+
+/*----------------------------------------------------------------
+ * Name			: publish
+ * Description	: Applies the messages of a SUBSCRIPTION_DATA event to
+ *				  the slots of their topics
+ * Arguments	: event is any event
+ * Returns		: number of messages applied
+ *---------------------------------------------------------------*/
+unsigned int LastValueCache::publish(const Event &event)
+{
+	if (event.eventType() != Event::SUBSCRIPTION_DATA || fields_.empty()) {
+		return 0;
+	}
+
+	unsigned int applied = 0;
+	MessageIterator msgIter(event);
+	while (msgIter.next()) {
+		Message msg = msgIter.message();
+		int id = find(msg.correlationId());
+		if (id == NOT_FOUND) {
+			continue;
+		}
+
+		// a recap is the full state, fields it lacks have no value
+		bool recap = msg.recapType() != Message::RecapType::e_none;
+		unsigned long long written = fields_.extract(msg.asElement(), &scratch_[0]);
+		if (written == 0 && !recap) {
+			continue;
+		}
+
+		Slot *s = slot(id);
+		Float64 *target = values(s);
+		s->lock_.writeBegin();
+		for (size_t i = 0; i < fields_.size(); ++i) {
+			if (written & (1ULL << i)) {
+				target[i] = scratch_[i];
+			} else if (recap) {
+				target[i] = 0;
+			}
+		}
+		s->setMask_ = recap ? written : s->setMask_ | written;
+		++s->updates_;
+		s->lock_.writeEnd();
+		++applied;
+	}
+	return applied;
+}
+
+/*----------------------------------------------------------------
+ * Name			: read
+ * Description	: Copies a consistent snapshot of a slot
+ * Arguments	: slot is the slot of the topic
+ *				  values receives the value of each field
+ *				  setMask receives the bits of the fields with a value
+ * Returns		: number of messages applied to the slot
+ *---------------------------------------------------------------*/
+unsigned long long LastValueCache::read(int id, Float64 *target,
+	unsigned long long *setMask) const
+{
+	Slot *s = slot(id);
+	unsigned long long updates;
+	long sequence;
+	do {
+		sequence = s->lock_.readBegin();
+		memcpy(target, values(s), fields_.size() * sizeof(Float64));
+		*setMask = s->setMask_;
+		updates = s->updates_;
+	} while (s->lock_.readRetry(sequence));
+	return updates;
+}
+
+/*----------------------------------------------------------------
+ * Name			: find
+ * Description	: Looks up the slot of a subscription
+ * Arguments	: topic is the subscription correlation id
+ * Returns		: slot of the topic, NOT_FOUND if not added
+ *---------------------------------------------------------------*/
+int LastValueCache::find(const CorrelationId &topic) const
+{
+	std::map<CorrelationId, int>::const_iterator it = index_.find(topic);
+	return it == index_.end() ? NOT_FOUND : it->second;
+}
@@ -0,0 +1,204 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: LastValueCache.h
+ *
+ * Description: This file contains the LastValueCache class, which
+ *				keeps the latest value of the fields of each
+ *				subscription in a slab that any number of threads
+ *				read without locking.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef __LastValueCache_h__
+#define __LastValueCache_h__
+
+#include <blpapi_correlationid.h>
+#include <blpapi_event.h>
+#include <blpapi_schema.h>
+#include <blpapi_types.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "NumericFields.h"
+#include "SeqLock.h"
+
+namespace BloombergLP
+{
+
+	/*----------------------------------------------------------------
+	 * Class		 : LastValueCache
+	 * Description   : Last value cache of SUBSCRIPTION_DATA. Each topic
+	 *				   added has a slot of the slab holding the last
+	 *				   value of every field, padded to whole cache lines
+	 *				   so that readers of one topic do not share a line
+	 *				   with the writer of another.
+	 *				   publish() applies the numeric fields of each
+	 *				   message to the slot of its correlation id: a
+	 *				   recap (Message::recapType() other than e_none)
+	 *				   replaces the whole state, other messages merge
+	 *				   into it. Each slot is published through its own
+	 *				   SeqLock, so read() gets a consistent copy of a
+	 *				   topic from any thread without blocking the
+	 *				   writer.
+	 *				   Topics are added before publish() or read() is
+	 *				   first called; the slab then never moves. One
+	 *				   thread publishes, any number read.
+	 *---------------------------------------------------------------*/
+	class LastValueCache
+	{
+	public:
+		//most fields, one bit of the masks each
+		enum { MAX_FIELDS = NumericFields::MAX_FIELDS };
+
+		//size the slots are padded to
+		enum { CACHE_LINE = 64 };
+
+		//slot of a topic that was not added
+		enum { NOT_FOUND = -1 };
+
+		/*----------------------------------------------------------------
+		 * Name			: LastValueCache constructor
+		 * Description	: Constructs a cache with room for maxTopics
+		 *				  empty slots
+		 * Arguments	: fields are the fields kept, the first
+		 *				  MAX_FIELDS are used; the field id is the
+		 *				  position in fields
+		 *				  maxTopics is the number of topics that can
+		 *				  be added
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		LastValueCache(const std::vector<std::string> &fields, size_t maxTopics);
+
+		~LastValueCache();
+
+		/*----------------------------------------------------------------
+		 * Name			: addTopic
+		 * Description	: Gives a slot to a subscription. Must not be
+		 *				  called once publish() or read() runs.
+		 * Arguments	: topic is the subscription correlation id
+		 * Returns		: slot of the topic, NOT_FOUND if the slab is
+		 *				  full
+		 *---------------------------------------------------------------*/
+		int addTopic(const blpapi::CorrelationId &topic);
+
+		/*----------------------------------------------------------------
+		 * Name			: compile
+		 * Description	: Reads the fields by their position in the
+		 *				  message schema, see FieldAccessor::compile().
+		 *				  Called by the publishing thread.
+		 * Arguments	: message is the definition of the messages
+		 * Returns		: true if every field is in the schema
+		 *---------------------------------------------------------------*/
+		bool compile(const blpapi::SchemaElementDefinition &message);
+
+		/*----------------------------------------------------------------
+		 * Name			: publish
+		 * Description	: Applies the messages of a SUBSCRIPTION_DATA
+		 *				  event to the slots of their topics
+		 * Arguments	: event is any event
+		 * Returns		: number of messages applied, messages of
+		 *				  topics not added are skipped
+		 *---------------------------------------------------------------*/
+		unsigned int publish(const blpapi::Event &event);
+
+		/*----------------------------------------------------------------
+		 * Name			: read
+		 * Description	: Copies a consistent snapshot of a slot, never
+		 *				  blocks the writer
+		 * Arguments	: slot is the slot of the topic
+		 *				  values receives the value of each field by
+		 *				  field id, numFields() entries
+		 *				  setMask receives the bits of the fields
+		 *				  with a value
+		 * Returns		: number of messages applied to the slot, 0 if
+		 *				  no data arrived yet
+		 *---------------------------------------------------------------*/
+		unsigned long long read(int slot, blpapi::Float64 *values,
+			unsigned long long *setMask) const;
+
+		/*----------------------------------------------------------------
+		 * Name			: find
+		 * Description	: Looks up the slot of a subscription
+		 * Arguments	: topic is the subscription correlation id
+		 * Returns		: slot of the topic, NOT_FOUND if not added
+		 *---------------------------------------------------------------*/
+		int find(const blpapi::CorrelationId &topic) const;
+
+		//correlation id of a slot
+		const blpapi::CorrelationId &topic(int slot) const { return topics_[slot]; }
+		size_t numTopics() const { return topics_.size(); }
+
+		//field name of a field id
+		const std::string &field(int id) const { return fields_.name(id); }
+		size_t numFields() const { return fields_.size(); }
+
+	private:
+		// header of a slot, the values of the fields follow it
+		struct Slot
+		{
+			SeqLock lock_;
+			unsigned long long setMask_;
+			unsigned long long updates_;
+		};
+
+		Slot *slot(int id) const
+		{
+			return reinterpret_cast<Slot*>(slab_ + id * slotSize_);
+		}
+
+		static blpapi::Float64 *values(Slot *slot)
+		{
+			return reinterpret_cast<blpapi::Float64*>(slot + 1);
+		}
+
+		NumericFields fields_;
+
+		//slots, slotSize_ bytes each, from a cache line boundary of
+		//buffer_
+		std::vector<char> buffer_;
+		char *slab_;
+		size_t slotSize_;
+		size_t maxTopics_;
+
+		//topic of each slot, and the slot of each topic
+		std::vector<blpapi::CorrelationId> topics_;
+		std::map<blpapi::CorrelationId, int> index_;
+
+		//values of the message being applied, outside the slab so
+		//that the slot is only locked for the copy
+		std::vector<blpapi::Float64> scratch_;
+
+		// Unimplemented
+		LastValueCache(const LastValueCache&);
+		LastValueCache& operator=(const LastValueCache&);
+	};
+}
+
+#endif
@@ -33,6 +33,14 @@
  * ----------------------------------------------------------------- */
 #include "LevelBook.h"
 
+#include <stdio.h>   // snprintf
+#include <string.h>  // memmove
+
+namespace {
+	//compile time check that four entries fit in a cache line
+	typedef char EntrySizeCheck[sizeof(BloombergLP::ByLevelBookEntry) == 16 ? 1 : -1];
+}
+
 /*----------------------------------------------------------------
  * Class		: ByLevelBookEntry
  * Description  : Defines constructors and fields contained in an orderbook
@@ -45,59 +53,24 @@
  * Returns		: none
  *---------------------------------------------------------------*/
 BloombergLP::ByLevelBookEntry::ByLevelBookEntry() :
-price_(0.0f), time_(""), numOrders_(0), size_(0), isValid_(false)
+time_(NO_TIME), size_(0), priceOrders_(0)
 {}
 
 /*----------------------------------------------------------------
  * Name			: ByLevelBookEntry constructor
  * Description	: Constructs a bylevel book entry instance 
- * Arguments	: price is the price of the tick
- *				  t is the tick time
+ * Arguments	: price is the price of the tick in units of the
+ *				  book's PriceScale
+ *				  t is the tick time in milliseconds since midnight
  *				  numOrders is the number of orders
  *				  size is the size of bid/ask
  * Returns		: none
  *---------------------------------------------------------------*/
-BloombergLP::ByLevelBookEntry::ByLevelBookEntry(float price, std::string t, unsigned int numOrders, unsigned int size) :
-price_(price), time_(t), numOrders_(numOrders), size_(size), isValid_(true)
+BloombergLP::ByLevelBookEntry::ByLevelBookEntry(FixedPrice price, unsigned int t, unsigned int numOrders, unsigned int size) :
+time_(t == NO_TIME ? NO_TIME - 1 : t), size_(size),
+priceOrders_(((unsigned long long)price << 16) | (numOrders > (unsigned int)MAX_ORDERS ? (unsigned int)MAX_ORDERS : numOrders))
 {}
 
-/*----------------------------------------------------------------
- * Name			: ByLevelBookEntry copy constructor
- * Description	: Copy constructor for ByLevelBookEntry
- * Arguments	: cpy is a reference to the ByLevelBookEntry to be copied
- * Returns		: none
- *---------------------------------------------------------------*/
-BloombergLP::ByLevelBookEntry::ByLevelBookEntry(const ByLevelBookEntry& cpy)
-{
-  price_ = cpy.price_;
-  time_ = cpy.time_;
-  numOrders_ = cpy.numOrders_;
-  size_ = cpy.size_;
-  isValid_ = cpy.isValid_;
-}
-
-/*----------------------------------------------------------------
- * Name			: ByLevelBookEntry assignment operator
- * Description	: Assignment operator for ByLevelBookEntry
- * Arguments	: rhs is a reference to a ByLevelBookEntry
- * Returns		: a reference to the current object
- *---------------------------------------------------------------*/
-BloombergLP::ByLevelBookEntry& BloombergLP::ByLevelBookEntry::operator= (const ByLevelBookEntry& rhs)
-{
-  if (this == &rhs)
-  {
-    return *this;
-  }
-
-  price_ = rhs.price_;
-  time_ = rhs.time_;
-  numOrders_ = rhs.numOrders_;
-  size_ = rhs.size_;
-  isValid_ = rhs.isValid_;
-
-  return *this;
-}
-
 /*----------------------------------------------------------------
  * Name			: isValid
  * Description	: Checks whether the entry is valid
@@ -107,7 +80,24 @@ BloombergLP::ByLevelBookEntry& BloombergLP::ByLevelBookEntry::operator= (const B
  *---------------------------------------------------------------*/
 bool BloombergLP::ByLevelBookEntry::isValid() const
 {
-  return isValid_;
+  return time_ != NO_TIME;
+}
+
+/*----------------------------------------------------------------
+ * Name			: formatTime
+ * Description	: Formats the tick time as HH:MM:SS.mmm
+ * Arguments	: buffer is where the formatted time is written
+ *				  bufSize is the size of buffer
+ * Returns		: buffer
+ *---------------------------------------------------------------*/
+const char *BloombergLP::ByLevelBookEntry::formatTime(char *buffer, size_t bufSize) const
+{
+  unsigned int t = time_;
+  unsigned int ms = t % 1000; t /= 1000;
+  unsigned int sec = t % 60; t /= 60;
+  unsigned int min = t % 60; t /= 60;
+  snprintf(buffer, bufSize, "%02u:%02u:%02u.%03u", t, min, sec, ms);
+  return buffer;
 }
 
 
@@ -127,8 +117,71 @@ BloombergLP::ByLevelBook::ByLevelBook()
 	: window_size(0) 
 	, valid(false)
 	, book_type("")
-	, max_num_decimals(3)
+	, count_(0)
+{
+}
+
+/*----------------------------------------------------------------
+ * Name			: setWindowSize
+ * Description	: Sets the maximum window size and sizes the level array
+ *				  to it. This is the only call that allocates memory, all
+ *				  the table commands work in place on the level array.
+ *				  The book is cleared.
+ * Arguments	: size is the window size from the init paint
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::ByLevelBook::setWindowSize(unsigned int size)
+{
+	Guard guard(lock_cache_);
+	window_size = size;
+	entries_.assign(size, ByLevelBookEntry());
+	count_ = 0;
+	publish(0);
+}
+
+/*----------------------------------------------------------------
+ * Name			: shiftDown
+ * Description	: Moves the levels from pos one position inferior,
+ *				  dropping the last level if the window is full
+ * Arguments	: pos is the first position to move
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::ByLevelBook::shiftDown(unsigned int pos)
 {
+	unsigned int last = count_ < window_size ? count_ : window_size - 1;
+	if (pos < last)
+	{
+		memmove(&entries_[pos + 1], &entries_[pos], (last - pos) * sizeof(ByLevelBookEntry));
+	}
+	if (count_ < window_size)
+	{
+		++count_;
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: eraseRange
+ * Description	: Removes the levels in [first, last) and moves the
+ *				  inferior levels up
+ * Arguments	: first is the first position to remove
+ *				  last is one past the last position to remove
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::ByLevelBook::eraseRange(unsigned int first, unsigned int last)
+{
+	if (last > count_)
+	{
+		last = count_;
+	}
+	if (first >= last)
+	{
+		return;
+	}
+	if (last < count_)
+	{
+		memmove(&entries_[first], &entries_[last], (count_ - last) * sizeof(ByLevelBookEntry));
+	}
+	count_ -= last - first;
 }
 
 /*----------------------------------------------------------------
@@ -149,19 +202,25 @@ BloombergLP::ByLevelBook::ByLevelBook()
 void BloombergLP::ByLevelBook::doAdd( unsigned int pos, const ByLevelBookEntry& entry )
 {
 	Guard guard(lock_cache_);
-	if (entries_.size() <= pos)
+	//entries >= window size are dropped
+	if (pos >= window_size)
 	{
-		entries_.resize(pos+1);
+		return;
 	}
 
-	entries_.insert(entries_.begin()+pos, entry);
-
-	//remove entries > window size
-	if(window_size < entries_.size())
+	if (count_ < pos)
 	{
-	  entries_.erase(entries_.begin() + window_size, entries_.end());
+		//pad the gap with empty levels
+		for (unsigned int i = count_; i < pos; ++i)
+		{
+			entries_[i] = ByLevelBookEntry();
+		}
+		count_ = pos;
 	}
 
+	shiftDown(pos);
+	entries_[pos] = entry;
+	publish(pos);
 }
 
 
@@ -179,7 +238,8 @@ void BloombergLP::ByLevelBook::doAdd( unsigned int pos, const ByLevelBookEntry&
 void BloombergLP::ByLevelBook::doClearAll()
 {
 	Guard guard(lock_cache_);
-	entries_.clear();
+	count_ = 0;
+	publish(0);
 }
 
 /*----------------------------------------------------------------
@@ -199,12 +259,13 @@ void BloombergLP::ByLevelBook::doClearAll()
 void BloombergLP::ByLevelBook::doDel( unsigned int pos )
 {
 	Guard guard(lock_cache_);
-	if (entries_.size() <= pos)
+	if (count_ <= pos)
 	{
 		return;
 	}
 
-	entries_.erase(entries_.begin()+pos);
+	eraseRange(pos, pos + 1);
+	publish(pos);
 }
 
 /*----------------------------------------------------------------
@@ -218,7 +279,8 @@ void BloombergLP::ByLevelBook::doDel( unsigned int pos )
 void BloombergLP::ByLevelBook::doDelAll()
 {
 	Guard guard(lock_cache_);
-	entries_.clear();
+	count_ = 0;
+	publish(0);
 }
 
 /*----------------------------------------------------------------
@@ -227,20 +289,15 @@ void BloombergLP::ByLevelBook::doDelAll()
  *				  pos + 1 is now the best order. This differs from the EXEC
  *				  command in that it delets the current order, where the 
  *				  EXEC command modifies the current order.
- * ---------------------------------------------------------------
- * deque::erase (iterator first, iterator last)
- * Iterators specifying a range within the deque] to be removed: [first,last). i.e., the range includes 
- * all the elements between first and last, including the element pointed by first but not the one pointed by last.
- * Member types iterator and const_iterator are random access iterator types that point to elements.
- * ---------------------------------------------------------------
  * Arguments	: pos is the position to be deleted
  * Returns		: none
  *---------------------------------------------------------------*/
 void BloombergLP::ByLevelBook::doDelBetter(unsigned int pos)
 {
 	Guard guard(lock_cache_);
-	// need to add 1 to pos since erase does not remove the last position
-	entries_.erase(entries_.begin(), entries_.begin() + pos + 1);
+	// need to add 1 to pos since the range does not include the last position
+	eraseRange(0, pos + 1);
+	publish(0);
 }
 
 /*----------------------------------------------------------------
@@ -252,7 +309,8 @@ void BloombergLP::ByLevelBook::doDelBetter(unsigned int pos)
 void BloombergLP::ByLevelBook::doDelSide()
 {
 	Guard guard(lock_cache_);
-	entries_.clear();
+	count_ = 0;
+	publish(0);
 }
 
 /*----------------------------------------------------------------
@@ -267,9 +325,13 @@ void BloombergLP::ByLevelBook::doDelSide()
 void BloombergLP::ByLevelBook::doExec(unsigned int pos, const ByLevelBookEntry& entry)
 {
 	Guard guard(lock_cache_);
+	if (count_ <= pos)
+	{
+		return;
+	}
 	entries_[pos] = entry;
-	entries_.erase(entries_.begin(), entries_.begin() + pos);
-
+	eraseRange(0, pos);
+	publish(0);
 }
 
 /*----------------------------------------------------------------
@@ -285,7 +347,12 @@ void BloombergLP::ByLevelBook::doExec(unsigned int pos, const ByLevelBookEntry&
 void BloombergLP::ByLevelBook::doMod( unsigned int pos, const ByLevelBookEntry& entry )
 {
 	Guard guard(lock_cache_);
+	if (count_ <= pos)
+	{
+		return;
+	}
 	entries_[pos] = entry;
+	publish(pos);
 }
 
 /*----------------------------------------------------------------
@@ -301,11 +368,17 @@ void BloombergLP::ByLevelBook::doMod( unsigned int pos, const ByLevelBookEntry&
 void BloombergLP::ByLevelBook::doReplace( unsigned int pos, const ByLevelBookEntry& entry )
 {
 	Guard guard(lock_cache_);
-	if(entries_.size() <= pos)
+	if (pos >= window_size)
+	{
+		return;
+	}
+	//pad the gap with empty levels
+	for (; count_ <= pos; ++count_)
 	{
-		entries_.resize(pos + 1);
+		entries_[count_] = ByLevelBookEntry();
 	}
 	entries_[pos] = entry;
+	publish(pos);
 }
 
 /*----------------------------------------------------------------
@@ -327,8 +400,12 @@ void BloombergLP::ByLevelBook::doReplace( unsigned int pos, const ByLevelBookEnt
 void BloombergLP::ByLevelBook::doReplaceClear( unsigned int pos )
 {
 	Guard guard(lock_cache_);
-	ByLevelBookEntry clearEntry;
-	entries_[pos] = clearEntry;
+	if (count_ <= pos)
+	{
+		return;
+	}
+	entries_[pos] = ByLevelBookEntry();
+	publish(pos);
 }
 
 
@@ -341,7 +418,7 @@ void BloombergLP::ByLevelBook::doReplaceClear( unsigned int pos )
 unsigned int BloombergLP::ByLevelBook::size() 
 {
 	Guard guard(lock_cache_);
-	return (unsigned int)entries_.size();
+	return count_;
 }
 
 /*----------------------------------------------------------------
@@ -355,7 +432,7 @@ unsigned int BloombergLP::ByLevelBook::size()
 bool BloombergLP::ByLevelBook::getEntry( unsigned int pos, ByLevelBookEntry& entry )
 {
 	Guard guard(lock_cache_);
-	if (pos < entries_.size())
+	if (pos < count_)
 	{
 		entry = entries_[pos];
 		return entry.isValid();
@@ -363,3 +440,124 @@ bool BloombergLP::ByLevelBook::getEntry( unsigned int pos, ByLevelBookEntry& ent
 		return false;
 }
 
+/*----------------------------------------------------------------
+ * Name			: setSnapshotDepth
+ * Description	: Turns on snapshot publication of the top depth levels
+ * Arguments	: depth is the number of levels published, 0 turns
+ *				  publication off
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::ByLevelBook::setSnapshotDepth(unsigned int depth)
+{
+	Guard guard(lock_cache_);
+	snapshot_.setDepth(depth);
+	publish(0);
+}
+
+/*----------------------------------------------------------------
+ * Name			: getSnapshot
+ * Description	: Copies the last published top of book without
+ *				  locking. Can be called from any thread.
+ * Arguments	: entries is where the levels should be stored
+ *				  maxEntries is the size of entries
+ *				  scale receives the scale of the level prices,
+ *				  may be 0
+ * Returns		: number of levels copied
+ *---------------------------------------------------------------*/
+unsigned int BloombergLP::ByLevelBook::getSnapshot(ByLevelBookEntry *entries, unsigned int maxEntries,
+	PriceScale *scale) const
+{
+	unsigned int decimals;
+	unsigned int count = snapshot_.read(entries, maxEntries, &decimals);
+	if (scale != 0)
+	{
+		scale->setDecimals(decimals);
+	}
+	return count;
+}
+
+/*----------------------------------------------------------------
+ * Name			: setPriceDecimals
+ * Description	: Sets the number of decimals the book starts with.
+ *				  The levels already stored are not rescaled.
+ * Arguments	: decimals is the number of decimals
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::ByLevelBook::setPriceDecimals(unsigned int decimals)
+{
+	Guard guard(lock_cache_);
+	priceScale_.setDecimals(decimals);
+	publish(0);
+}
+
+/*----------------------------------------------------------------
+ * Name			: widenPriceScale
+ * Description	: Raises the number of decimals of the book and
+ *				  rescales the levels. Stops short of decimals if
+ *				  a level would saturate.
+ * Arguments	: decimals is the number of decimals wanted
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::ByLevelBook::widenPriceScale(unsigned int decimals)
+{
+	Guard guard(lock_cache_);
+	if (decimals <= priceScale_.decimals())
+	{
+		return;
+	}
+
+	//the largest price must still fit once rescaled
+	FixedPrice largest = 0;
+	for (unsigned int i = 0; i < count_; ++i)
+	{
+		FixedPrice price = entries_[i].price() < 0 ? -entries_[i].price() : entries_[i].price();
+		if (price > largest)
+		{
+			largest = price;
+		}
+	}
+	const PriceScale from = priceScale_;
+	PriceScale to(decimals);
+	while (to.decimals() > from.decimals()
+		&& to.convert(largest, from) == PriceScale::maxUnits())
+	{
+		to.setDecimals(to.decimals() - 1);
+	}
+	if (to.decimals() == from.decimals())
+	{
+		return;
+	}
+
+	priceScale_ = to;
+	for (unsigned int i = 0; i < count_; ++i)
+	{
+		entries_[i].setPrice(priceScale_.convert(entries_[i].price(), from));
+	}
+	publish(0);
+}
+
+/*----------------------------------------------------------------
+ * Name			: priceScale
+ * Description	: Returns the scale of the prices in the book
+ * Arguments	: none
+ * Returns		: price scale
+ *---------------------------------------------------------------*/
+const PriceScale& BloombergLP::ByLevelBook::priceScale() const
+{
+	return priceScale_;
+}
+
+/*----------------------------------------------------------------
+ * Name			: publish
+ * Description	: Publishes the top of book if pos is within the
+ *				  snapshot depth. Called with lock_cache_ held.
+ * Arguments	: pos is the best position changed
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::ByLevelBook::publish(unsigned int pos)
+{
+	if (pos < snapshot_.depth())
+	{
+		snapshot_.publish(entries_.begin(), count_, priceScale_.decimals());
+	}
+}
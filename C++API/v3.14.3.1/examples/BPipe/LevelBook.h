@@ -36,13 +36,16 @@
 #define __LevelBook_h__
 
 #include <time.h>    // time_t
+#include <stddef.h>  // size_t
 
-#include <deque>
+#include <vector>
 #include <iostream>
 #include <string>
 #include <sstream>
 
 #include "SyncIO.h"
+#include "SeqLock.h"
+#include "FixedPrice.h"
 
 using namespace std;
 
@@ -51,10 +54,18 @@ namespace BloombergLP
 
 	/* --------------------------------------------------------------------
 	 * Class/Struct : ByLevelBookEntry
-	 * Description  : Defines constructors and fields contained in an orderbook
+	 * Description  : Defines constructors and fields contained in an orderbook.
+	 *				  The entry is a plain value type (no heap owned members)
+	 *				  so that the book can shift levels with memmove.
 	 * --------------------------------------------------------------------*/
   struct ByLevelBookEntry
   {
+	//time of an entry that holds no level
+	enum { NO_TIME = 0xFFFFFFFFu };
+
+	//largest number of orders an entry holds, larger counts are capped
+	enum { MAX_ORDERS = 0xFFFF };
+
 	/*----------------------------------------------------------------
 	 * Name			: ByLevelBookEntry default constructor
 	 * Description	: Constructs a bylevel book entry with 0 price, size, orders
@@ -66,46 +77,70 @@ namespace BloombergLP
 	/*----------------------------------------------------------------
 	 * Name			: ByLevelBookEntry constructor
 	 * Description	: Constructs a bylevel book entry instance 
-	 * Arguments	: price is the price of the tick
-	 *				  t is the tick time
+	 * Arguments	: price is the price of the tick in units of the
+	 *				  book's PriceScale
+	 *				  t is the tick time in milliseconds since midnight
 	 *				  numOrders is the number of orders
 	 *				  size is the size of bid/ask
 	 * Returns		: none
 	 *---------------------------------------------------------------*/
-	ByLevelBookEntry(float price, std::string t, unsigned int numOders, unsigned int size);
+	ByLevelBookEntry(FixedPrice price, unsigned int t, unsigned int numOders, unsigned int size);
+
+    bool isValid() const;
 
 	/*----------------------------------------------------------------
-	 * Name			: ByLevelBookEntry copy constructor
-	 * Description	: Copy constructor for ByLevelBookEntry
-	 * Arguments	: cpy is a reference to the ByLevelBookEntry to be copied
-	 * Returns		: none
+	 * Name			: price
+	 * Description	: Returns the price of the level
+	 * Arguments	: none
+	 * Returns		: price in units of the book's PriceScale
 	 *---------------------------------------------------------------*/
-    ByLevelBookEntry(const ByLevelBookEntry& cpy);
+	FixedPrice price() const
+	{
+		return (FixedPrice)(long long)priceOrders_ >> 16;
+	}
 
+	/*----------------------------------------------------------------
+	 * Name			: numOrders
+	 * Description	: Returns the number of orders at the level
+	 * Arguments	: none
+	 * Returns		: number of orders, at most MAX_ORDERS
+	 *---------------------------------------------------------------*/
+	unsigned int numOrders() const
+	{
+		return (unsigned int)(priceOrders_ & 0xFFFF);
+	}
 
 	/*----------------------------------------------------------------
-	 * Name			: ByLevelBookEntry assignment operator
-	 * Description	: Assignment operator for ByLevelBookEntry
-	 * Arguments	: rhs is a reference to a ByLevelBookEntry
-	 * Returns		: a reference to the current object
+	 * Name			: setPrice
+	 * Description	: Changes the price, keeping the number of orders
+	 * Arguments	: price is in units of the book's PriceScale
+	 * Returns		: none
 	 *---------------------------------------------------------------*/
-    ByLevelBookEntry& operator= (const ByLevelBookEntry& rhs);
-    bool isValid() const;
-   
-	//price of the bid/ask
-    double price_; 
+	void setPrice(FixedPrice price)
+	{
+		priceOrders_ = ((unsigned long long)price << 16) | (priceOrders_ & 0xFFFF);
+	}
 
-	//tick time
-	std::string time_;
+	/*----------------------------------------------------------------
+	 * Name			: formatTime
+	 * Description	: Formats the tick time as HH:MM:SS.mmm
+	 * Arguments	: buffer is where the formatted time is written
+	 *				  bufSize is the size of buffer
+	 * Returns		: buffer
+	 *---------------------------------------------------------------*/
+	const char *formatTime(char *buffer, size_t bufSize) const;
 
-	//number of orders
-    unsigned int numOrders_;
+	//tick time in milliseconds since midnight, NO_TIME if the
+	//entry is not valid
+	unsigned int time_;
 
 	//order size
     unsigned int size_;
 
-	//flag to indicate whether a book is valid
-    bool isValid_;
+  private:
+	//price in the high 48 bits, number of orders in the low 16,
+	//so that an entry is 16 bytes and four fit in a cache line
+	unsigned long long priceOrders_;
   };
 
 
@@ -127,12 +162,14 @@ namespace BloombergLP
 
     enum BookType {AskPrice = 0, BidPrice = 1};
 
-	//maximum window size
+	//maximum window size, use setWindowSize() to change it
 	unsigned int window_size;
 	//this is to indicate whether we have received an
 	//ack message
 	bool valid;
 	
+	//MD_BOOK_TYPE of the last init paint; not published with the
+	//snapshot, readers and the writer share a lock of the caller
 	std::string book_type;
 
 	/*----------------------------------------------------------------
@@ -267,6 +304,17 @@ namespace BloombergLP
     void doReplaceClear(unsigned int pos);
 
 	//----helper functions---
+	/*----------------------------------------------------------------
+	 * Name			: setWindowSize
+	 * Description	: Sets the maximum window size and sizes the level array
+	 *				  to it. This is the only call that allocates memory, all
+	 *				  the table commands work in place on the level array.
+	 *				  The book is cleared.
+	 * Arguments	: size is the window size from the init paint
+	 * Returns		: none
+	 *---------------------------------------------------------------*/
+	void setWindowSize(unsigned int size);
+
 	/*----------------------------------------------------------------
 	 * Name			: size
 	 * Description	: Returns the curent size of the order book
@@ -284,13 +332,100 @@ namespace BloombergLP
 	 *---------------------------------------------------------------*/
     bool getEntry(unsigned int pos, ByLevelBookEntry& entry);
 
-	//maximum number of decimal places for output
-	unsigned int max_num_decimals;
+	/*----------------------------------------------------------------
+	 * Name			: setSnapshotDepth
+	 * Description	: Turns on snapshot publication. After each change to
+	 *				  the top depth levels the book publishes them through
+	 *				  a sequence lock, so getSnapshot() never takes
+	 *				  lock_cache_ and never blocks the thread updating the
+	 *				  book. Call it before the subscription starts.
+	 * Arguments	: depth is the number of levels published, 0 turns
+	 *				  publication off
+	 * Returns		: none
+	 *---------------------------------------------------------------*/
+	void setSnapshotDepth(unsigned int depth);
+
+	/*----------------------------------------------------------------
+	 * Name			: getSnapshot
+	 * Description	: Copies the last published top of book without
+	 *				  locking. Can be called from any thread.
+	 * Arguments	: entries is where the levels should be stored
+	 *				  maxEntries is the size of entries
+	 *				  scale receives the scale of the level prices,
+	 *				  may be 0
+	 * Returns		: number of levels copied
+	 *---------------------------------------------------------------*/
+	unsigned int getSnapshot(ByLevelBookEntry *entries, unsigned int maxEntries,
+		PriceScale *scale = 0) const;
+
+	/*----------------------------------------------------------------
+	 * Name			: setPriceDecimals
+	 * Description	: Sets the number of decimals the book starts
+	 *				  with. Call it before the subscription starts,
+	 *				  the levels already stored are not rescaled.
+	 * Arguments	: decimals is the number of decimals
+	 * Returns		: none
+	 *---------------------------------------------------------------*/
+	void setPriceDecimals(unsigned int decimals);
+
+	/*----------------------------------------------------------------
+	 * Name			: widenPriceScale
+	 * Description	: Raises the number of decimals of the book and
+	 *				  rescales the levels, so a price needing more
+	 *				  decimals is held exactly. Stops short of
+	 *				  decimals if a level would saturate.
+	 * Arguments	: decimals is the number of decimals wanted
+	 * Returns		: none
+	 *---------------------------------------------------------------*/
+	void widenPriceScale(unsigned int decimals);
+
+	/*----------------------------------------------------------------
+	 * Name			: priceScale
+	 * Description	: Returns the scale of the prices in the book.
+	 *				  Only the thread updating the book may call it,
+	 *				  other threads get the scale from getSnapshot().
+	 * Arguments	: none
+	 * Returns		: price scale
+	 *---------------------------------------------------------------*/
+	const PriceScale& priceScale() const;
 
 
   protected:
-    std::deque<ByLevelBookEntry> entries_;
+	/*----------------------------------------------------------------
+	 * Name			: shiftDown
+	 * Description	: Moves the levels from pos one position inferior,
+	 *				  dropping the last level if the window is full
+	 * Arguments	: pos is the first position to move
+	 * Returns		: none
+	 *---------------------------------------------------------------*/
+	void shiftDown(unsigned int pos);
+
+	/*----------------------------------------------------------------
+	 * Name			: eraseRange
+	 * Description	: Removes the levels in [first, last) and moves the
+	 *				  inferior levels up
+	 * Arguments	: first is the first position to remove
+	 *				  last is one past the last position to remove
+	 * Returns		: none
+	 *---------------------------------------------------------------*/
+	void eraseRange(unsigned int first, unsigned int last);
+
+	/*----------------------------------------------------------------
+	 * Name			: publish
+	 * Description	: Publishes the top of book if pos is within the
+	 *				  snapshot depth. Called with lock_cache_ held.
+	 * Arguments	: pos is the best position changed
+	 * Returns		: none
+	 *---------------------------------------------------------------*/
+	void publish(unsigned int pos);
+
+	//level array, sized to window_size by setWindowSize()
+    std::vector<ByLevelBookEntry> entries_;
+	//number of levels in use
+	unsigned int count_;
+	PriceScale priceScale_;
 	SyncIO lock_cache_;
+	BookSnapshot<ByLevelBookEntry> snapshot_;
 	
   };
 }
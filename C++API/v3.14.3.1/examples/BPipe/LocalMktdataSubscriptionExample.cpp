@@ -35,6 +35,8 @@
 #include <string.h>
 #include <fstream>
 
+#include "WaitStrategy.h"
+
 using namespace BloombergLP;
 using namespace blpapi;
 
@@ -67,6 +69,9 @@ const char* AUTH_OPTION_USER_APP  = "userapp=";
 const char* AUTH_OPTION_DIR       = "dir=";
 const char* AUTH_OPTION_MANUAL    = "manual=";
 
+// most events taken from the session per wakeup
+const size_t EVENT_BATCH_SIZE = 64;
+
 std::vector<std::string> splitBy(const std::string& str, char delim)
 {
     std::string::size_type start = 0u, pos = 0u;
@@ -129,6 +134,8 @@ class LocalMktdataSubscriptionExample
     bool                     d_zfpOverLeasedLine;
     ZfpUtil::Remote          d_remote;
 
+    WaitStrategy             d_waitStrategy;
+
     void printUsage()
     {
         std::cout <<
@@ -142,6 +149,11 @@ class LocalMktdataSubscriptionExample
 "\t[-f    <field>]        field to subscribe to (default: empty)\n"
 "\t[-o    <option>]       subscription options (default: empty)\n"
 "\t[-me   <maxEvents>]    stop after this many events (default: INT_MAX)\n"
+"\t[-wait <strategy>]     how to wait for events (default: block):\n"
+"\t\tblock\n"
+"\t\tspin=<us>                poll for <us> microseconds before blocking\n"
+"\t\tpoll                     poll without blocking, keeps a core busy\n"
+"\t\tpoll=<core>              poll on the specified core\n"
 "\t[-auth <option>]       authentication option (default: user):\n"
 "\t\tnone\n"
 "\t\tuser                     as a user using OS logon information\n"
@@ -185,6 +197,13 @@ class LocalMktdataSubscriptionExample
                 d_options.push_back(argv[++i]);
             else if (!std::strcmp(argv[i],"-me") && i + 1 < argc)
                 d_maxEvents = std::atoi(argv[++i]);
+            else if (!std::strcmp(argv[i],"-wait") && i + 1 < argc) {
+                if (!d_waitStrategy.parse(argv[++i])) {
+                    std::cerr << "Invalid wait strategy: " << argv[i] << '\n';
+                    printUsage();
+                    return false;
+                }
+            }
             else if (!std::strcmp(argv[i], "-auth") && i + 1 < argc) {
                 ++ i;
                 d_manualToken = false;
@@ -493,21 +512,32 @@ public:
         }
         session.subscribe(subscriptions, subscriptionIdentity);
 
-        while (true) {
-            Event event = session.nextEvent();
-            MessageIterator msgIter(event);
-            while (msgIter.next()) {
-                Message msg = msgIter.message();
-                if (event.eventType() == Event::SUBSCRIPTION_STATUS ||
-                    event.eventType() == Event::SUBSCRIPTION_DATA) {
-
-                    const char *topic = (char *)msg.correlationId().asPointer();
-                    std::cout << topic << " - ";
+        if (!d_waitStrategy.pin()) {
+            std::cerr << "Failed to pin the event loop to its core" << std::endl;
+        }
+
+        bool done = false;
+        while (!done) {
+            // a burst of events is drained in one wakeup; the array is
+            // declared here so the events are released before the next wait
+            Event events[EVENT_BATCH_SIZE];
+            size_t numEvents = d_waitStrategy.nextEvents(session, events, EVENT_BATCH_SIZE);
+            for (size_t i = 0; i < numEvents && !done; ++i) {
+                const Event &event = events[i];
+                MessageIterator msgIter(event);
+                while (msgIter.next()) {
+                    Message msg = msgIter.message();
+                    if (event.eventType() == Event::SUBSCRIPTION_STATUS ||
+                        event.eventType() == Event::SUBSCRIPTION_DATA) {
+
+                        const char *topic = (char *)msg.correlationId().asPointer();
+                        std::cout << topic << " - ";
+                    }
+                    msg.print(std::cout) << std::endl;
+                }
+                if (event.eventType() == Event::SUBSCRIPTION_DATA) {
+                    if (++d_eventCount >= d_maxEvents) done = true;
                 }
-                msg.print(std::cout) << std::endl;
-            }
-            if (event.eventType() == Event::SUBSCRIPTION_DATA) {
-                if (++d_eventCount >= d_maxEvents) break;
             }
         }
     }
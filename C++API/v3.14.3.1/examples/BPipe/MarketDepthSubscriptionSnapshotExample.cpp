@@ -37,7 +37,15 @@
 #include <iomanip>
 #include "OrderBook.h"
 #include "LevelBook.h"
+#include "DepthBookRegistry.h"
+#include "DepthCommand.h"
+#include "DepthJournal.h"
+#include "NameTable.h"
+#include "ResubscribeScheduler.h"
 #include "SyncIO.h"
+#include "TopicDispatcher.h"
+#include "TopOfBook.h"
+#include "WaitStrategy.h"
 
 using namespace std;
 using namespace BloombergLP;
@@ -60,65 +68,11 @@ namespace {
 	const Name AUTHORIZATION_FAILURE("AuthorizationFailure");
 	const Name TOKEN("token");
 
-	const Name MKTDEPTH_EVENT_TYPE("MKTDEPTH_EVENT_TYPE");
-	const Name MKTDEPTH_EVENT_SUBTYPE("MKTDEPTH_EVENT_SUBTYPE");
-	const Name MD_GAP_DETECTED("MD_GAP_DETECTED");
-	const Name MD_TABLE_CMD_RT("MD_TABLE_CMD_RT");
-	const Name MD_BOOK_TYPE("MD_BOOK_TYPE");
-	const Name MD_MULTI_TICK_UPD_RT("MD_MULTI_TICK_UPD_RT");
-	const Name MBO_WINDOW_SIZE("MBO_WINDOW_SIZE");
-	const Name MBO_ASK_POSITION_RT("MBO_ASK_POSITION_RT");
-	const Name MBO_ASK_RT("MBO_ASK_RT");
-	const Name MBO_ASK_BROKER_RT("MBO_ASK_BROKER_RT");
-	const Name MBO_ASK_COND_CODE_RT("MBO_ASK_COND_CODE_RT");
-	const Name MBO_ASK_SIZE_RT("MBO_ASK_SIZE_RT");
-	const Name MBO_TABLE_ASK("MBO_TABLE_ASK");
-	const Name MBO_BID_POSITION_RT("MBO_BID_POSITION_RT");
-	const Name MBO_BID_RT("MBO_BID_RT");
-	const Name MBO_BID_BROKER_RT("MBO_BID_BROKER_RT");
-	const Name MBO_BID_COND_CODE_RT("MBO_BID_COND_CODE_RT");
-	const Name MBO_BID_SIZE_RT("MBO_BID_SIZE_RT");
-	const Name MBO_TABLE_BID("MBO_TABLE_BID");
-	const Name MBO_TIME_RT("MBO_TIME_RT");
-	const Name MBO_SEQNUM_RT("MBO_SEQNUM_RT");
-	const Name MBL_WINDOW_SIZE("MBL_WINDOW_SIZE");
-	const Name MBL_ASK_POSITION_RT("MBL_ASK_POSITION_RT");
-	const Name MBL_ASK_RT("MBL_ASK_RT");
-	const Name MBL_ASK_NUM_ORDERS_RT("MBL_ASK_NUM_ORDERS_RT");
-	const Name MBL_ASK_COND_CODE_RT("MBL_ASK_COND_CODE_RT");
-	const Name MBL_ASK_SIZE_RT("MBL_ASK_SIZE_RT");
-	const Name MBL_TABLE_ASK("MBL_TABLE_ASK");
-	const Name MBL_BID_POSITION_RT("MBL_BID_POSITION_RT");
-	const Name MBL_BID_RT("MBL_BID_RT");
-	const Name MBL_BID_NUM_ORDERS_RT("MBL_BID_NUM_ORDERS_RT");
-	const Name MBL_BID_COND_CODE_RT("MBL_BID_COND_CODE_RT");
-	const Name MBL_BID_SIZE_RT("MBL_BID_SIZE_RT");
-	const Name MBL_TABLE_BID("MBL_TABLE_BID");
-	const Name MBL_TIME_RT("MBL_TIME_RT");
-	const Name MBL_SEQNUM_RT("MBL_SEQNUM_RT");
 	const Name NONE("NONE");
 	
-	const Name ADD("ADD");
-	const Name DEL("DEL");
-	const Name DELALL("DELALL");
-	const Name DELBETTER("DELBETTER");
-	const Name DELSIDE("DELSIDE");
-	const Name EXEC("EXEC");
-	const Name MOD("MOD");
-	const Name REPLACE("REPLACE");
-	const Name REPLACE_BY_BROKER("REPLACE_BY_BROKER");
-	const Name MARKET_BY_LEVEL("MARKET_BY_LEVEL");
-	const Name MARKET_BY_ORDER("MARKET_BY_ORDER");
-	const Name CLEARALL("CLEARALL");
-	const Name REPLACE_CLEAR("REPLACE_CLEAR");
-	const Name REPLACE_BY_PRICE("REPLACE_BY_PRICE");
-	
 	const Name ASK("ASK");
 	const Name BID("BID");
-	const Name ASK_RETRANS("ASK_RETRANS");
-	const Name BID_RETRANS("BID_RETRANS");
-	const Name TABLE_INITPAINT("TABLE_INITPAINT");
-	const Name TABLE_UPDATE("TABLE_UPDATE");
+	const Name MARKET_DEPTH_UPDATES("MarketDepthUpdates");
 
     const char* authServiceName = "//blp/apiauth";
 	const std::string mktDepthServiceName = "//blp/mktdepthdata";
@@ -132,36 +86,129 @@ namespace {
 
 	const int bookSize = 2;
 
-	Name PRICE_FIELD[2][2] = {MBO_BID_RT, MBO_ASK_RT, 
-							  MBL_BID_RT, MBL_ASK_RT};
-	Name SIZE_FIELD[2][2] = {MBO_BID_SIZE_RT, MBO_ASK_SIZE_RT, 
-							 MBL_BID_SIZE_RT, MBL_ASK_SIZE_RT};
-	Name POSITION_FIELD[2][2] = {MBO_BID_POSITION_RT, MBO_ASK_POSITION_RT, 
-								 MBL_BID_POSITION_RT, MBL_ASK_POSITION_RT};
-	Name ORDER_FIELD[2][2] = {NONE, NONE,
-							  MBL_BID_NUM_ORDERS_RT, MBL_ASK_NUM_ORDERS_RT} ;
-	Name BROKER_FIELD[2][2] = {MBO_BID_BROKER_RT, MBO_ASK_BROKER_RT, 
-							   NONE, NONE};
-	Name TIME_FIELD[2] = {MBO_TIME_RT, MBL_TIME_RT};
+	// decimals the books start with, each book widens its scale
+	// to the decimals of its own prices
+	const unsigned int START_PRICE_DECIMALS = 0;
+
+	// MKTDEPTH_EVENT_SUBTYPE values
+	enum EventSubType {
+		SUB_BID, SUB_ASK, SUB_BID_RETRANS, SUB_ASK_RETRANS,
+		SUB_TABLE_INITPAINT, SUB_TABLE_UPDATE
+	};
+
+	// slots of the market depth fields. By order and by level fields share
+	// a slot, the slot of a per side field is its FLD_BID_ slot + side.
+	enum DepthField {
+		FLD_EVENT_TYPE, FLD_EVENT_SUBTYPE, FLD_GAP_DETECTED, FLD_MULTI_TICK,
+		FLD_TABLE_CMD, FLD_TIME, FLD_SEQNUM, FLD_WINDOW_SIZE, FLD_BOOK_TYPE,
+		FLD_BID_POSITION, FLD_ASK_POSITION, FLD_BID_PRICE, FLD_ASK_PRICE,
+		FLD_BID_SIZE, FLD_ASK_SIZE, FLD_BID_ORDERS, FLD_ASK_ORDERS,
+		FLD_BID_BROKER, FLD_ASK_BROKER, FLD_BID_TABLE, FLD_ASK_TABLE,
+		NUM_DEPTH_FIELDS
+	};
+
+	/* Market depth fields of a message or table row, by DepthField slot.
+	 * A field not sent, or sent null, is left invalid. */
+	struct DepthFields
+	{
+		Element field[NUM_DEPTH_FIELDS];
+
+		bool has(int slot) const
+		{
+			return field[slot].isValid();
+		}
+	};
+
+	/* market depth field names, by DepthField slot */
+	const NameEntry DEPTH_FIELD_NAMES[] = {
+		{ "MKTDEPTH_EVENT_TYPE", FLD_EVENT_TYPE },
+		{ "MKTDEPTH_EVENT_SUBTYPE", FLD_EVENT_SUBTYPE },
+		{ "MD_GAP_DETECTED", FLD_GAP_DETECTED },
+		{ "MD_MULTI_TICK_UPD_RT", FLD_MULTI_TICK },
+		{ "MD_TABLE_CMD_RT", FLD_TABLE_CMD },
+		{ "MD_BOOK_TYPE", FLD_BOOK_TYPE },
+		{ "MBO_TIME_RT", FLD_TIME },
+		{ "MBL_TIME_RT", FLD_TIME },
+		{ "MBO_SEQNUM_RT", FLD_SEQNUM },
+		{ "MBL_SEQNUM_RT", FLD_SEQNUM },
+		{ "MBO_WINDOW_SIZE", FLD_WINDOW_SIZE },
+		{ "MBL_WINDOW_SIZE", FLD_WINDOW_SIZE },
+		{ "MBO_BID_POSITION_RT", FLD_BID_POSITION },
+		{ "MBO_ASK_POSITION_RT", FLD_ASK_POSITION },
+		{ "MBL_BID_POSITION_RT", FLD_BID_POSITION },
+		{ "MBL_ASK_POSITION_RT", FLD_ASK_POSITION },
+		{ "MBO_BID_RT", FLD_BID_PRICE },
+		{ "MBO_ASK_RT", FLD_ASK_PRICE },
+		{ "MBL_BID_RT", FLD_BID_PRICE },
+		{ "MBL_ASK_RT", FLD_ASK_PRICE },
+		{ "MBO_BID_SIZE_RT", FLD_BID_SIZE },
+		{ "MBO_ASK_SIZE_RT", FLD_ASK_SIZE },
+		{ "MBL_BID_SIZE_RT", FLD_BID_SIZE },
+		{ "MBL_ASK_SIZE_RT", FLD_ASK_SIZE },
+		{ "MBL_BID_NUM_ORDERS_RT", FLD_BID_ORDERS },
+		{ "MBL_ASK_NUM_ORDERS_RT", FLD_ASK_ORDERS },
+		{ "MBO_BID_BROKER_RT", FLD_BID_BROKER },
+		{ "MBO_ASK_BROKER_RT", FLD_ASK_BROKER },
+		{ "MBO_TABLE_BID", FLD_BID_TABLE },
+		{ "MBO_TABLE_ASK", FLD_ASK_TABLE },
+		{ "MBL_TABLE_BID", FLD_BID_TABLE },
+		{ "MBL_TABLE_ASK", FLD_ASK_TABLE }
+	};
+
+	/* MD_TABLE_CMD_RT values, by TableCommand */
+	const NameEntry TABLE_COMMAND_NAMES[] = {
+		{ "ADD", CMD_ADD },
+		{ "CLEARALL", CMD_CLEARALL },
+		{ "DEL", CMD_DEL },
+		{ "DELALL", CMD_DELALL },
+		{ "DELBETTER", CMD_DELBETTER },
+		{ "DELSIDE", CMD_DELSIDE },
+		{ "EXEC", CMD_EXEC },
+		{ "MOD", CMD_MOD },
+		{ "REPLACE", CMD_REPLACE },
+		{ "REPLACE_BY_BROKER", CMD_REPLACE_BY_BROKER },
+		{ "REPLACE_CLEAR", CMD_REPLACE_CLEAR },
+		{ "REPLACE_BY_PRICE", CMD_REPLACE_BY_PRICE }
+	};
+
+	/* MKTDEPTH_EVENT_SUBTYPE values, by EventSubType */
+	const NameEntry EVENT_SUBTYPE_NAMES[] = {
+		{ "BID", SUB_BID },
+		{ "ASK", SUB_ASK },
+		{ "BID_RETRANS", SUB_BID_RETRANS },
+		{ "ASK_RETRANS", SUB_ASK_RETRANS },
+		{ "TABLE_INITPAINT", SUB_TABLE_INITPAINT },
+		{ "TABLE_UPDATE", SUB_TABLE_UPDATE }
+	};
+
+	/* MD_BOOK_TYPE values, by book type */
+	const NameEntry BOOK_TYPE_NAMES[] = {
+		{ "MARKET_BY_ORDER", BYORDER },
+		{ "MARKET_BY_LEVEL", BYLEVEL }
+	};
 
 	/* Protects the cache and prevents simultaneous output to stdout.  */
 	SyncIO syncio;
 }
 
 
-class SubscriptionEventHandler: public EventHandler
+class SubscriptionEventHandler: public EventHandler, public TopicMessageHandler
 {
 	Session *d_session;
+	/* processes the data of each book on one worker thread, 0 for none */
+	TopicDispatcher *d_topics;
     SubscriptionList &d_subscriptions; 
-	ByOrderBook *d_orderBooks;
-	ByLevelBook *d_levelBooks;
-	int *d_marketDepthBook;
+	DepthBookRegistry &d_books;
+	DepthJournalWriter *d_journal;
+	TopOfBookQueue *d_topQueue;
 	int d_showTicks;
-	int d_gapDetected;
-	int d_askRetran;
-	int d_bidRetran;
-	int d_resubscribed;
-	long d_sequenceNumber;
+	/* Names resolved once to the enums above */
+	NameTable d_fieldIndex;
+	NameTable d_commandIndex;
+	NameTable d_subTypeIndex;
+	NameTable d_bookTypeIndex;
+	/* resubscribes the subscriptions with a sequence gap */
+	ResubscribeScheduler d_resubscriber;
 	/* prevents simultaneous output to stdout.  */
 	SyncIO syncio;
 
@@ -191,6 +238,18 @@ class SubscriptionEventHandler: public EventHandler
 		return i;
 	}
 
+	/*------------------------------------------------------------------------------------
+	 * Name			: millisecondsOfDay
+	 * Description	: convert tick time to milliseconds since midnight
+	 * Arguments	: timeStamp is the tick time
+	 * Returns		: milliseconds since midnight
+	 *------------------------------------------------------------------------------------*/
+	unsigned int millisecondsOfDay(const Datetime &timeStamp)
+	{
+		return ((timeStamp.hours() * 60 + timeStamp.minutes()) * 60 +
+			timeStamp.seconds()) * 1000 + timeStamp.milliSeconds();
+	}
+
 	/*------------------------------------------------------------------------------------
 	 * Name			: printFragType
 	 * Description	: print fragment name
@@ -236,9 +295,9 @@ class SubscriptionEventHandler: public EventHandler
         while (msgIter.next()) {
             Message msg = msgIter.message();
 			const char* msg_type = msg.messageType().string();
-			std::string *topic = reinterpret_cast<std::string*>(msg.correlationId().asPointer());
+			DepthBook *book = d_books.find(msg.correlationId().asInteger());
 			syncio.lock();
-			std::cout << timeBuffer << ": " << topic->c_str() << " - " << msg.messageType().string() << std::endl;
+			std::cout << timeBuffer << ": " << (book ? book->topic.c_str() : "unknown topic") << " - " << msg.messageType().string() << std::endl;
             if (msg.hasElement(REASON, true)) {
                 // This can occur on SubscriptionFailure.
 				msg.print(std::cout);
@@ -262,6 +321,67 @@ class SubscriptionEventHandler: public EventHandler
         }
     }
 
+	/*------------------------------------------------------------------------------------
+	 * Name			: loadFields
+	 * Description	: finds the market depth fields of a message or table row in one
+	 *				  pass over its elements. Null fields are left out.
+	 * Arguments	: row is the message or table row element
+	 *              : fields receives the fields by DepthField slot
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	void loadFields(const Element &row, DepthFields *fields)
+	{
+		for (int i = 0; i < NUM_DEPTH_FIELDS; ++i) {
+			fields->field[i] = Element();
+		}
+		size_t numElements = row.numElements();
+		for (size_t i = 0; i < numElements; ++i) {
+			Element element = row.getElement(i);
+			int slot = d_fieldIndex.find(element.name());
+			if (slot != NameTable::NOT_FOUND && !element.isNull()) {
+				fields->field[slot] = element;
+			}
+		}
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: decodeRow
+	 * Description	: decodes the table command of a message or table row
+	 * Arguments	: fields are the fields of the row
+	 *              : side is BIDSIDE or ASKSIDE
+	 *              : row receives the decoded command
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	void decodeRow(const DepthFields &fields, int side, DepthRow *row)
+	{
+		row->command = CMD_UNKNOWN;
+		if (fields.has(FLD_TABLE_CMD)) {
+			int command = d_commandIndex.find(fields.field[FLD_TABLE_CMD].getValueAsName());
+			if (command != NameTable::NOT_FOUND) row->command = command;
+		}
+		// get position
+		row->position = -1;
+		if (fields.has(FLD_BID_POSITION + side)) {
+			row->position = fields.field[FLD_BID_POSITION + side].getValueAsInt32();
+			if (row->position > 0) --row->position;
+		}
+		// get price
+		row->price = fields.has(FLD_BID_PRICE + side) ?
+			fields.field[FLD_BID_PRICE + side].getValueAsFloat64() : 0.0;
+		// get size
+		row->size = fields.has(FLD_BID_SIZE + side) ?
+			(unsigned int)fields.field[FLD_BID_SIZE + side].getValueAsInt64() : 0;
+		// get number of orders (by level only)
+		row->numOrders = fields.has(FLD_BID_ORDERS + side) ?
+			(unsigned int)fields.field[FLD_BID_ORDERS + side].getValueAsInt64() : 0;
+		// get broker (by order only)
+		row->broker = fields.has(FLD_BID_BROKER + side) ?
+			fields.field[FLD_BID_BROKER + side].getValueAsString() : "";
+		// get time
+		row->time = fields.has(FLD_TIME) ?
+			millisecondsOfDay(fields.field[FLD_TIME].getValueAsDatetime()) : 0;
+	}
+
 	/*------------------------------------------------------------------------------------
 	 * Name			: processSubscriptionDataEvent
 	 * Description	: process market depth data events
@@ -271,447 +391,176 @@ class SubscriptionEventHandler: public EventHandler
 	 *------------------------------------------------------------------------------------*/
     bool processSubscriptionDataEvent(const Event &event, Session *session)
     {
-        char timeBuffer[64];
-        getTimeStamp(timeBuffer, sizeof(timeBuffer));
-		
         MessageIterator msgIter(event);
         while (msgIter.next()) {
             Message msg = msgIter.message();
-			const char* msg_type = msg.messageType().string();
-			if(strcmp(msg_type,"MarketDepthUpdates") == 0){
+			if (msg.messageType() == MARKET_DEPTH_UPDATES) {
 				// Market Depth data
-				if (d_showTicks > 0)
-				{
-					// output tick message
-					syncio.lock();
-					std::cout << timeBuffer << ": ";
-					printFragType(msg.fragmentType()); 
-
-					msg.print(std::cout);
-					std::cout << std::flush;
-					syncio.unlock();
-				}
-
-				// setup book type before processing data
-				if (*d_marketDepthBook == UNKNOWN)
+				DepthBook *book = d_books.find(msg.correlationId().asInteger());
+				if (book == 0)
 				{
-					Element bookType;
-					if (!msg.asElement().getElement(&bookType, MKTDEPTH_EVENT_TYPE))
-					{
-						Name value;
-						if (!bookType.getValueAs(&value, 0))
-						{
-							if (value == MARKET_BY_ORDER)
-							{
-								*d_marketDepthBook = BYORDER;
-							}
-							else if (value == MARKET_BY_LEVEL)
-							{
-								*d_marketDepthBook = BYLEVEL;
-							}
-						}
-					}
-				}
-
-				// process base on book type
-				switch (*d_marketDepthBook)
-				{
-					case BYLEVEL:
-						processByLevelMessage(msg, session);
-						break;
-					case BYORDER:
-						processByOrderMessage(msg, session);
-						break;
-					default:
-						// display unknown book type message
-						syncio.lock();
-						std::cout << timeBuffer << ": Unknown book type. Can not process message." << std::endl;
-						std::cout << timeBuffer << ": ";
-						printFragType(msg.fragmentType()); 
-
-						msg.print(std::cout);
-						std::cout << std::flush;
-						syncio.unlock();
-						break;
+					// not one of our subscriptions
+					continue;
 				}
+				// other dispatcher threads may hold messages for this book
+				Guard guard(book->lock);
+				processBookMessage(msg, book, session);
 			}
         }
         return true;
     }
 
 	/*------------------------------------------------------------------------------------
-	 * Name			: processByOrderEvent
-	 * Description	: process by order message
+	 * Name			: processBookMessage
+	 * Description	: applies a market depth message to its book
 	 * Arguments	: msg is the tick data message
+	 *              : book is the subscription's book, only used by the caller's thread
 	 *              : session is the API session
 	 * Returns		: none
 	 *------------------------------------------------------------------------------------*/
-	void processByOrderMessage(const Message &msg, Session *session)
-    {
-        int side = -1;
-		int position = -1;
-		int bidRetran = 0;
-		int askRetran = 0;
-
-		// get gap detection flag (AMD book only)
-	    if (msg.hasElement(MD_GAP_DETECTED, true) && !d_gapDetected) {
-	    	d_gapDetected = true;
-	    	syncio.lock();
-			std::cout << "Bloomberg detected a gap in data stream." << std::endl;
-			syncio.unlock();
-	    }
+	void processBookMessage(const Message &msg, DepthBook *book, Session *session)
+	{
+        char timeBuffer[64];
+		DepthFields fields;
 
-		// get event sub type
-		Name subType = msg.getElement(MKTDEPTH_EVENT_SUBTYPE).getValueAsName();
-        // get retran flags
-		bidRetran = (subType == BID_RETRANS) ? 1 : 0;
-		askRetran = (subType == ASK_RETRANS) ? 1 : 0;
-		// BID/ASK message
-		if (subType == BID || subType == ASK || 
-			bidRetran || askRetran) {
-			if(subType == BID || bidRetran) {
-				// bid side
-				side = BIDSIDE;
-			} else if (subType == ASK || askRetran) {
-				// ask side
-				side = ASKSIDE;
-			}
+		if (d_showTicks > 0)
+		{
+			// output tick message
+			getTimeStamp(timeBuffer, sizeof(timeBuffer));
+			syncio.lock();
+			std::cout << timeBuffer << ": ";
+			printFragType(msg.fragmentType()); 
 
-			// get position
-			int position = -1;
-			if (msg.hasElement(POSITION_FIELD[BYORDER][side], true)) {
-				position = msg.getElement(POSITION_FIELD[BYORDER][side]).getValueAsInt32();
-				if (position > 0) --position;
-			}
+			msg.print(std::cout);
+			std::cout << std::flush;
+			syncio.unlock();
+		}
 
-		    //  BID/ASK retran message
-		    if (askRetran || bidRetran) {
-			    // check for multi tick
-		    	if (msg.hasElement(MD_MULTI_TICK_UPD_RT, true)) {
-		    		// multi tick
-		    		if (msg.getElement(MD_MULTI_TICK_UPD_RT).getValueAsInt32() == 0 ) {
-				    	// last multi tick message, reset sequence number so next non-retran
-		    			// message sequence number will be use as new starting number
-				    	d_sequenceNumber = 0;
-		    			if (askRetran && d_askRetran) {
-		    				// end of ask retran
-		    				d_askRetran = false;
-		    		    	syncio.lock();
-							std::cout << "Ask retran completed." << std::endl;
-		    				syncio.unlock();
-		    			} else if (bidRetran && d_bidRetran) {
-		    				// end of ask retran
-		    				d_bidRetran = false;
-		    		    	syncio.lock();
-							std::cout << "Bid retran completed." << std::endl;
-		    				syncio.unlock();
-		    			}
-		    			if (!(d_askRetran || d_bidRetran)) {
-		    				// retran completed
-		    		    	syncio.lock();
-	    		    		if (d_gapDetected) {
-	    		    			// gap detected retran completed
-	    		    			d_gapDetected = false;
-								std::cout << "Gap detected retran completed." << std::endl;
-	    		    		} else {
-	    		    			// normal retran completed
-								std::cout << "Retran completed." << std::endl;
-	    		    		}
-		    				syncio.unlock();
-		    			}
-		    		} else {
-		    			if (askRetran && !d_askRetran) {
-		    				// start of ask retran
-		    				d_askRetran = true;
-		    		    	syncio.lock();
-							std::cout << "Ask retran started." << std::endl;
-		    				syncio.unlock();
-		    			} else if (bidRetran && !d_bidRetran) {
-		    				// start of ask retran
-		    				d_bidRetran = true;
-		    		    	syncio.lock();
-							std::cout << "Bid retran started." << std::endl;
-		    				syncio.unlock();
-		    			}
-		    		}
-		    	}
-		    } else if (msg.hasElement(MBO_SEQNUM_RT, true)) {
-		    	// get sequence number
-		    	long currentSequence = (long)msg.getElementAsInt64(MBO_SEQNUM_RT);
-		    	if (d_sequenceNumber == 0 || d_sequenceNumber == 1 ||
-                        (currentSequence == 1 && d_sequenceNumber > 1)) {
-		    		// use current sequence number
-		    		d_sequenceNumber = currentSequence;
-		    	} else if ((d_sequenceNumber + 1 != currentSequence) && !d_gapDetected) {
-		    		if (!d_resubscribed)
-		    		{
-				    	// previous tick sequence can not be smaller than current tick 
-				    	// sequence number - 1 and NOT in gap detected mode. 
-			    		syncio.lock();
-						std::cout << "Warning: Gap detected - previous sequence number is " << 
-		    					d_sequenceNumber << " and current tick sequence number is " <<
-								currentSequence << ")." << std::endl;
-			    		syncio.unlock();
-			    		// gap detected, re-subscribe to securities
-						session->resubscribe(d_subscriptions);
-						d_resubscribed = true;
-		    		}
-		    	} else if (d_sequenceNumber >= currentSequence) {
-		    		// previous tick sequence number can not be greater or equal
-		    		// to current sequence number
-		    		syncio.lock();
-					std::cout << "Warning: Current Sequence number (" << currentSequence <<
-	    					") is smaller or equal to previous tick sequence number (" <<
-							d_sequenceNumber << ")." << std::endl;
-		    		syncio.unlock();
-		    	} else {
-		    		// save current sequence number
-		    		d_sequenceNumber = currentSequence;
-		    	}
-		    }
+		// find all the fields used in one pass
+		loadFields(msg.asElement(), &fields);
 
-			// get command
-			Name cmd = msg.getElement(MD_TABLE_CMD_RT).getValueAsName();
-			if (cmd == CLEARALL) {
-				d_orderBooks[side].doClearAll();
-			} else if (cmd == DEL) {
-				d_orderBooks[side].doDel(position);
-			} else if (cmd == DELALL) {
-				d_orderBooks[side].doDelAll();
-			} else if (cmd == DELBETTER) {
-				d_orderBooks[side].doDelBetter(position);
-			} else if (cmd == DELSIDE) {
-				d_orderBooks[side].doDelSide();
-			} else if (cmd == REPLACE_CLEAR) {
-				d_orderBooks[side].doReplaceClear(position);
-			} else {
-				// process other data commands
-				// get price
-				double fPrice = msg.getElement(PRICE_FIELD[BYORDER][side]).getValueAsFloat64();
-				// get size
-				unsigned int nSize = 0;
-				if (msg.hasElement(SIZE_FIELD[BYORDER][side], true)) {
-					nSize = (unsigned int)msg.getElement(SIZE_FIELD[BYORDER][side]).getValueAsInt64();
-				}
-				// get broker
-				std::string sBroker = "";
-				if (msg.hasElement(BROKER_FIELD[BYORDER][side], true)) {
-					sBroker = msg.getElement(BROKER_FIELD[BYORDER][side]).getValueAsString();
+		// setup book type before processing data
+		if (book->marketDepthBook == UNKNOWN && fields.has(FLD_EVENT_TYPE))
+		{
+			Name value;
+			if (!fields.field[FLD_EVENT_TYPE].getValueAs(&value, 0))
+			{
+				int bookType = d_bookTypeIndex.find(value);
+				if (bookType != NameTable::NOT_FOUND)
+				{
+					book->marketDepthBook = bookType;
 				}
-				// get time
-				Datetime timeStamp = msg.getElement(TIME_FIELD[BYORDER]).getValueAsDatetime();
-				std::stringstream ssTime;
-				ssTime << setfill('0') << setw(2) << timeStamp.hours() << 
-					":" << setfill('0') << setw(2) << timeStamp.minutes() << 
-					":" << setfill('0') << setw(2) << timeStamp.seconds() <<
-					"." << setfill('0') << setw(3) << timeStamp.milliSeconds();
-				// create entry
-				ByOrderBookEntry entry(sBroker, (float)fPrice, ssTime.str(), 	0, nSize);
-
-				// process data command
-				if(cmd == ADD)
-					d_orderBooks[side].doAdd(position, entry);
-				else if(cmd == MOD)
-					d_orderBooks[side].doMod(position, entry);
-				else if(cmd == REPLACE)
-					d_orderBooks[side].doReplace(position, entry);
-				else if(cmd == REPLACE_BY_BROKER)
-					d_orderBooks[side].doReplaceByBroker(entry);
-				else if(cmd == EXEC)
-					d_orderBooks[side].doExec(position, entry);
 			}
-		} else {
-			if (subType == TABLE_INITPAINT) {
-				if (msg.fragmentType() == Message::FRAGMENT_START ||
-					msg.fragmentType() == Message::FRAGMENT_NONE) {
-					// init paint
-					if (msg.hasElement(MBO_WINDOW_SIZE, true) ){
-						d_orderBooks[ASKSIDE].window_size = (unsigned int) msg.getElementAsInt64(MBO_WINDOW_SIZE);
-						d_orderBooks[BIDSIDE].window_size = d_orderBooks[ASKSIDE].window_size;
-					}
-					d_orderBooks[ASKSIDE].book_type = msg.getElementAsString(MD_BOOK_TYPE);
-					d_orderBooks[BIDSIDE].book_type = d_orderBooks[ASKSIDE].book_type;
-					// clear cache
-					d_orderBooks[ASKSIDE].doClearAll();
-					d_orderBooks[BIDSIDE].doClearAll();
-				}
+		}
 
-				// ASK table
-				Element askTable;
-				if ((msg.asElement().getElement(&askTable, MBO_TABLE_ASK) == 0) && !askTable.isNull()){
-					// has ask table array
-					size_t numOfItems = askTable.numValues();
-					for (size_t index = 0; index < numOfItems; ++index) {
-						Element ask = askTable.getValueAsElement(index);
-						// get command
-						Name cmd = ask.getElement(MD_TABLE_CMD_RT).getValueAsName(); 
-						// get position
-						int position = -1;
-						if (ask.hasElement(POSITION_FIELD[BYORDER][ASKSIDE], true)) {
-							position = ask.getElement(POSITION_FIELD[BYORDER][ASKSIDE]).getValueAsInt32();
-							if (position > 0) --position;
-						}
-						// get price
-						double askPrice = ask.getElement(PRICE_FIELD[BYORDER][ASKSIDE]).getValueAsFloat64();
-						// get size
-						unsigned int askSize = 0;
-						if (ask.hasElement(SIZE_FIELD[BYORDER][ASKSIDE], true)) {
-							askSize = (unsigned int)ask.getElement(SIZE_FIELD[BYORDER][ASKSIDE]).getValueAsInt64();
-						}
-						// get broker
-						std::string askBroker = "";
-						if (ask.hasElement(BROKER_FIELD[BYORDER][ASKSIDE], true)) {
-							askBroker = ask.getElement(BROKER_FIELD[BYORDER][ASKSIDE]).getValueAsString();
-						}
-						// get time
-						Datetime timeStamp = ask.getElement(TIME_FIELD[BYORDER]).getValueAsDatetime();
-						std::stringstream askTime;
-						askTime << setfill('0') << setw(2) << timeStamp.hours() << 
-							":" << setfill('0') << setw(2) << timeStamp.minutes() << 
-							":" << setfill('0') << setw(2) << timeStamp.seconds() <<
-							"." << setfill('0') << setw(3) << timeStamp.milliSeconds();
-						// create entry
-						ByOrderBookEntry entry(askBroker, (float)askPrice, askTime.str(), 	0, askSize);
-
-						// process data command
-						if(cmd == ADD)
-							d_orderBooks[ASKSIDE].doAdd(position, entry);
-						else if(cmd == MOD)
-							d_orderBooks[ASKSIDE].doMod(position, entry);
-						else if(cmd == REPLACE)
-							d_orderBooks[ASKSIDE].doReplace(position, entry);
-						else if(cmd == REPLACE_BY_BROKER)
-							d_orderBooks[ASKSIDE].doReplaceByBroker(entry);
-						else if(cmd == EXEC)
-							d_orderBooks[ASKSIDE].doExec(position, entry);
-					}
+		// process base on book type
+		switch (book->marketDepthBook)
+		{
+			case BYLEVEL:
+				processDepthMessage(msg, fields, *book, book->levelBooks, session);
+				// publish changes of level 0 only
+				if (d_topQueue && updateTop(book->levelBooks, &book->top)) {
+					d_topQueue->publish(book->top);
 				}
-				// BID table
-				Element bidTable;
-				if ((msg.asElement().getElement(&bidTable, MBO_TABLE_BID) == 0) && !bidTable.isNull()){
-					// has bid table array
-					size_t numOfItems = bidTable.numValues();
-					for (size_t index = 0; index < numOfItems; ++index) {
-						Element bid = bidTable.getValueAsElement(index);
-						// get command
-						Name cmd = bid.getElement(MD_TABLE_CMD_RT).getValueAsName(); 
-						// get position
-						int position = -1;
-						if (bid.hasElement(POSITION_FIELD[BYORDER][BIDSIDE], true)) {
-							position = bid.getElement(POSITION_FIELD[BYORDER][BIDSIDE]).getValueAsInt32();
-							if (position > 0) --position;
-						}
-						// get price
-						double bidPrice = bid.getElement(PRICE_FIELD[BYORDER][BIDSIDE]).getValueAsFloat64();
-						// get size
-						unsigned int bidSize = 0;
-						if (bid.hasElement(SIZE_FIELD[BYORDER][BIDSIDE], true)) {
-							bidSize = (unsigned int)bid.getElement(SIZE_FIELD[BYORDER][BIDSIDE]).getValueAsInt64();
-						}
-						// get broker
-						std::string bidBroker = "";
-						if (bid.hasElement(BROKER_FIELD[BYORDER][BIDSIDE], true)) {
-							bidBroker = bid.getElement(BROKER_FIELD[BYORDER][BIDSIDE]).getValueAsString();
-						}
-						// get time
-						Datetime timeStamp = bid.getElement(TIME_FIELD[BYORDER]).getValueAsDatetime();
-						std::stringstream bidTime;
-						bidTime << setfill('0') << setw(2) << timeStamp.hours() << 
-							":" << setfill('0') << setw(2) << timeStamp.minutes() << 
-							":" << setfill('0') << setw(2) << timeStamp.seconds() <<
-							"." << setfill('0') << setw(3) << timeStamp.milliSeconds();
-						// create entry
-						ByOrderBookEntry entry(bidBroker, (float)bidPrice, bidTime.str(), 0, bidSize);
-
-						// process data command
-						if(cmd == ADD)
-							d_orderBooks[BIDSIDE].doAdd(position, entry);
-						else if(cmd == MOD)
-							d_orderBooks[BIDSIDE].doMod(position, entry);
-						else if(cmd == REPLACE)
-							d_orderBooks[BIDSIDE].doReplace(position, entry);
-						else if(cmd == REPLACE_BY_BROKER)
-							d_orderBooks[BIDSIDE].doReplaceByBroker(entry);
-						else if(cmd == EXEC)
-							d_orderBooks[BIDSIDE].doExec(position, entry);
-					}
+				break;
+			case BYORDER:
+				processDepthMessage(msg, fields, *book, book->orderBooks, session);
+				if (d_topQueue && updateTop(book->orderBooks, &book->top)) {
+					d_topQueue->publish(book->top);
 				}
-			}
+				break;
+			default:
+				// display unknown book type message
+				getTimeStamp(timeBuffer, sizeof(timeBuffer));
+				syncio.lock();
+				std::cout << timeBuffer << ": Unknown book type. Can not process message." << std::endl;
+				std::cout << timeBuffer << ": ";
+				printFragType(msg.fragmentType()); 
+
+				msg.print(std::cout);
+				std::cout << std::flush;
+				syncio.unlock();
+				break;
 		}
 	}
 
 	/*------------------------------------------------------------------------------------
-	 * Name			: processByLevelEvent
-	 * Description	: process by level message
+	 * Name			: processDepthMessage
+	 * Description	: process a by order or by level message
 	 * Arguments	: msg is the tick data message
+	 *              : fields are the fields of msg
+	 *              : book is the subscription's book, locked by the caller
+	 *              : books are the bid and ask sides of the book type received
 	 *              : session is the API session
 	 * Returns		: none
 	 *------------------------------------------------------------------------------------*/
-    void processByLevelMessage(const Message &msg, Session *session)
+	template <typename BOOK>
+	void processDepthMessage(const Message &msg, const DepthFields &fields,
+		DepthBook &book, BOOK *books, Session *session)
     {
-        int side = -1;
-		int position = -1;
-		int bidRetran = 0;
-		int askRetran = 0;
-
-	    // get gap detection flag (AMD book only)
-	    if (msg.hasElement(MD_GAP_DETECTED, true) && !d_gapDetected) {
-	    	d_gapDetected = true;
+		int side = -1;
+		int subType = NameTable::NOT_FOUND;
+		DepthRow row;
+
+		// get gap detection flag (AMD book only)
+	    if (fields.has(FLD_GAP_DETECTED) && !book.gapDetected) {
+	    	book.gapDetected = true;
 	    	syncio.lock();
 			std::cout << "Bloomberg detected a gap in data stream." << std::endl;
 			syncio.unlock();
 	    }
 
-		// get event subtype
-		Name subType = msg.getElement(MKTDEPTH_EVENT_SUBTYPE).getValueAsName();
-        // get retran flags
-		bidRetran = (subType == BID_RETRANS) ? 1 : 0;
-        askRetran = (subType == ASK_RETRANS) ? 1 : 0;
-        // BID or ASK message
-		if (subType == BID || subType == ASK ||
-			bidRetran || askRetran) {
-			// set book size
-			if(subType == BID || bidRetran) {
+		// get event sub type
+		if (fields.has(FLD_EVENT_SUBTYPE)) {
+			subType = d_subTypeIndex.find(fields.field[FLD_EVENT_SUBTYPE].getValueAsName());
+		}
+		switch (subType)
+		{
+			case SUB_BID:
+			case SUB_BID_RETRANS:
 				side = BIDSIDE;
-			} else if (subType == ASK ||askRetran) {
+				break;
+			case SUB_ASK:
+			case SUB_ASK_RETRANS:
 				side = ASKSIDE;
-			}
-
-			// get position
-			int position = -1;
-			if (msg.hasElement(POSITION_FIELD[BYLEVEL][side], true)) {
-				position = msg.getElement(POSITION_FIELD[BYLEVEL][side]).getValueAsInt32();
-				if (position > 0) --position;
-			}
+				break;
+			default:
+				break;
+		}
+        // get retran flags
+		int bidRetran = (subType == SUB_BID_RETRANS) ? 1 : 0;
+		int askRetran = (subType == SUB_ASK_RETRANS) ? 1 : 0;
 
+		// BID/ASK message
+		if (side != -1) {
 		    //  BID/ASK retran message
 		    if (askRetran || bidRetran) {
 			    // check for multi tick
-		    	if (msg.hasElement(MD_MULTI_TICK_UPD_RT, true)) {
+		    	if (fields.has(FLD_MULTI_TICK)) {
 		    		// multi tick
-		    		if (msg.getElement(MD_MULTI_TICK_UPD_RT).getValueAsInt32() == 0 ) {
+		    		if (fields.field[FLD_MULTI_TICK].getValueAsInt32() == 0 ) {
 				    	// last multi tick message, reset sequence number so next non-retran
 		    			// message sequence number will be use as new starting number
-				    	d_sequenceNumber = 0;
-		    			if (askRetran && d_askRetran) {
+				    	book.sequenceNumber = 0;
+		    			if (askRetran && book.askRetran) {
 		    				// end of ask retran
-		    				d_askRetran = false;
+		    				book.askRetran = false;
 		    		    	syncio.lock();
 							std::cout << "Ask retran completed." << std::endl;
 		    				syncio.unlock();
-		    			} else if (bidRetran && d_bidRetran) {
-		    				// end of ask retran
-		    				d_bidRetran = false;
+		    			} else if (bidRetran && book.bidRetran) {
+		    				// end of bid retran
+		    				book.bidRetran = false;
 		    		    	syncio.lock();
 							std::cout << "Bid retran completed." << std::endl;
 		    				syncio.unlock();
 		    			}
-		    			if (!(d_askRetran || d_bidRetran)) {
+		    			if (!(book.askRetran || book.bidRetran)) {
 		    				// retran completed
 		    		    	syncio.lock();
-	    		    		if (d_gapDetected) {
+	    		    		if (book.gapDetected) {
 	    		    			// gap detected retran completed
-	    		    			d_gapDetected = false;
+	    		    			book.gapDetected = false;
 								std::cout << "Gap detected retran completed." << std::endl;
 	    		    		} else {
 	    		    			// normal retran completed
@@ -720,220 +569,119 @@ class SubscriptionEventHandler: public EventHandler
 		    				syncio.unlock();
 		    			}
 		    		} else {
-		    			if (askRetran && !d_askRetran) {
+		    			if (askRetran && !book.askRetran) {
 		    				// start of ask retran
-		    				d_askRetran = true;
+		    				book.askRetran = true;
 		    		    	syncio.lock();
 							std::cout << "Ask retran started." << std::endl;
 		    				syncio.unlock();
-		    			} else if (bidRetran && !d_bidRetran) {
-		    				// start of ask retran
-		    				d_bidRetran = true;
+		    			} else if (bidRetran && !book.bidRetran) {
+		    				// start of bid retran
+		    				book.bidRetran = true;
 		    		    	syncio.lock();
 							std::cout << "Bid retran started." << std::endl;
 		    				syncio.unlock();
 		    			}
 		    		}
 		    	}
-		    } else if (msg.hasElement(MBL_SEQNUM_RT, true)) {
+		    } else if (fields.has(FLD_SEQNUM)) {
 		    	// get sequence number
-		    	long currentSequence = (long)msg.getElementAsInt64(MBL_SEQNUM_RT);
-		    	if (d_sequenceNumber == 0 || d_sequenceNumber == 1 ||
-                        (currentSequence == 1 && d_sequenceNumber > 1)) {
+		    	long currentSequence = (long)fields.field[FLD_SEQNUM].getValueAsInt64();
+		    	if (book.sequenceNumber == 0 || book.sequenceNumber == 1 ||
+                        (currentSequence == 1 && book.sequenceNumber > 1)) {
 		    		// use current sequence number
-		    		d_sequenceNumber = currentSequence;
-		    	} else if ((d_sequenceNumber + 1 != currentSequence) && !d_gapDetected) {
-		    		if (!d_resubscribed)
+		    		book.sequenceNumber = currentSequence;
+		    	} else if ((book.sequenceNumber + 1 != currentSequence) && !book.gapDetected) {
+			    	// previous tick sequence can not be smaller than current tick 
+			    	// sequence number - 1 and NOT in gap detected mode. 
+		    		// gap detected, queue the resubscribe of this subscription only,
+		    		// gaps until its recap arrives are coalesced
+		    		if (d_resubscriber.request(book.id))
 		    		{
-				    	// previous tick sequence can not be smaller than current tick 
-				    	// sequence number - 1 and NOT in gap detected mode. 
-						syncio.lock();
-						std::cout << "Warning: Gap detected - previous sequence number is " << 
-		    					d_sequenceNumber << " and current tick sequence number is " <<
+			    		syncio.lock();
+						std::cout << "Warning: Gap detected on " << book.topic << 
+								" - previous sequence number is " << 
+		    					book.sequenceNumber << " and current tick sequence number is " <<
 								currentSequence << ")." << std::endl;
 			    		syncio.unlock();
-			    		// gap detected, re-subscribe to securities
-						session->resubscribe(d_subscriptions);
-						d_resubscribed = true;
 		    		}
-		    	} else if (d_sequenceNumber >= currentSequence) {
+					book.resubscribed = true;
+		    	} else if (book.sequenceNumber >= currentSequence) {
 		    		// previous tick sequence number can not be greater or equal
 		    		// to current sequence number
 		    		syncio.lock();
-					std::cout << "Warning: Current Sequence number (" << currentSequence << 
-    						") is smaller or equal to previous tick sequence number (" <<
-							d_sequenceNumber << ")." << std::endl;
+					std::cout << "Warning: Current Sequence number (" << currentSequence <<
+	    					") is smaller or equal to previous tick sequence number (" <<
+							book.sequenceNumber << ")." << std::endl;
 		    		syncio.unlock();
 		    	} else {
 		    		// save current sequence number
-		    		d_sequenceNumber = currentSequence;
+		    		book.sequenceNumber = currentSequence;
 		    	}
 		    }
 
-			// get command
-			Name cmd = msg.getElement(MD_TABLE_CMD_RT).getValueAsName();
-			if (cmd == CLEARALL) {
-				d_levelBooks[side].doClearAll();
-			} else if (cmd == DEL) {
-				if (position != -1)
-					d_levelBooks[side].doDel(position);
-			} else if (cmd == DELALL) {
-				d_levelBooks[side].doDelAll();
-			} else if (cmd == DELBETTER) {
-				d_levelBooks[side].doDelBetter(position);
-			} else if (cmd == DELSIDE) {
-				d_levelBooks[side].doDelSide();
-			} else if (cmd == REPLACE_CLEAR) {
-				d_levelBooks[side].doReplaceClear(position);
-			} else {
-				// process other commands
-				// get price
-				double fPrice = msg.getElement(PRICE_FIELD[BYLEVEL][side]).getValueAsFloat64();
-				// get size
-				unsigned int nSize = 0;
-				if (msg.hasElement(SIZE_FIELD[BYLEVEL][side], true)) {
-					nSize = (unsigned int)msg.getElement(SIZE_FIELD[BYLEVEL][side]).getValueAsInt64();
+			// process table command
+			decodeRow(fields, side, &row);
+			if (d_journal) {
+				long long sequence = fields.has(FLD_SEQNUM) ? fields.field[FLD_SEQNUM].getValueAsInt64() : 0;
+				d_journal->writeCommand(book.id, book.marketDepthBook, side, sequence, row);
+			}
+			fitPrice(books, row);
+			applyRow(books[side], row);
+		} else if (subType == SUB_TABLE_INITPAINT) {
+			if (msg.fragmentType() == Message::FRAGMENT_START ||
+				msg.fragmentType() == Message::FRAGMENT_NONE) {
+				// init paint
+				unsigned int windowSize = 0;
+				if (fields.has(FLD_WINDOW_SIZE)) {
+					windowSize = (unsigned int)fields.field[FLD_WINDOW_SIZE].getValueAsInt64();
+					setWindow(books[ASKSIDE], windowSize);
+					setWindow(books[BIDSIDE], windowSize);
 				}
-				// get number of order
-				unsigned int nNumOrder = 0;
-				if (msg.hasElement(ORDER_FIELD[BYLEVEL][side], true)) {
-					nNumOrder = (unsigned int)msg.getElement(ORDER_FIELD[BYLEVEL][side]).getValueAsInt64();
+				if (d_journal) {
+					d_journal->writeInitPaint(book.id, book.marketDepthBook, windowSize);
 				}
-				// get time
-				Datetime timeStamp = msg.getElement(TIME_FIELD[BYLEVEL]).getValueAsDatetime();
-				std::stringstream ssTime;
-				ssTime << setfill('0') << setw(2) << timeStamp.hours() << 
-					":" << setfill('0') << setw(2) << timeStamp.minutes() << 
-					":" << setfill('0') << setw(2) << timeStamp.seconds() <<
-							"." << setfill('0') << setw(3) << timeStamp.milliSeconds();
-				// create entry
-				ByLevelBookEntry entry((float)fPrice, ssTime.str(), nNumOrder, nSize);
-
-				// process data command
-				if(cmd == ADD)
-					d_levelBooks[side].doAdd(position, entry);
-				else if(cmd == MOD)
-					d_levelBooks[side].doMod(position, entry);
-				else if(cmd == REPLACE)
-					d_levelBooks[side].doReplace(position, entry);
-				else if(cmd == EXEC)
-					d_levelBooks[side].doExec(position, entry);
-			}
-		} else {
-			if (subType == TABLE_INITPAINT) {
-				if (msg.fragmentType() == Message::FRAGMENT_START ||
-					msg.fragmentType() == Message::FRAGMENT_NONE) {
-					// init paint
-					if (msg.hasElement(MBL_WINDOW_SIZE, true)){
-						d_levelBooks[ASKSIDE].window_size = (unsigned int) msg.getElementAsInt64(MBL_WINDOW_SIZE);
-						d_levelBooks[BIDSIDE].window_size = d_levelBooks[ASKSIDE].window_size;
-					}
-					d_levelBooks[ASKSIDE].book_type = msg.getElementAsString(MD_BOOK_TYPE);
-					d_levelBooks[BIDSIDE].book_type = d_levelBooks[ASKSIDE].book_type;
-					// clear cache
-					d_levelBooks[ASKSIDE].doClearAll();
-					d_levelBooks[BIDSIDE].doClearAll();
+				if (book.resubscribed) {
+					// recap after a gap, start the sequence again
+					book.resubscribed = false;
+					book.sequenceNumber = 0;
+					d_resubscriber.recovered(book.id);
 				}
+				if (fields.has(FLD_BOOK_TYPE)) {
+					// the Show* functions read the book type under syncio
+					std::string bookType(fields.field[FLD_BOOK_TYPE].getValueAsString());
+					syncio.lock();
+					books[ASKSIDE].book_type = bookType;
+					books[BIDSIDE].book_type = bookType;
+					syncio.unlock();
+				}
+				// clear cache
+				books[ASKSIDE].doClearAll();
+				books[BIDSIDE].doClearAll();
+			}
 
-				// ASK table
-				Element askTable;
-				if ((msg.asElement().getElement(&askTable, MBL_TABLE_ASK) == 0) && !askTable.isNull()){
-					// has ask table array
-					size_t numOfItems = askTable.numValues();
-					for (size_t index = 0; index < numOfItems; ++index) {
-						Element ask = askTable.getValueAsElement(index);
-						// get command
-						Name cmd = ask.getElement(MD_TABLE_CMD_RT).getValueAsName(); 
-						// get position
-					    position = -1;
-					    if (ask.hasElement(POSITION_FIELD[BYLEVEL][ASKSIDE], true)) {
-						    position = ask.getElement(POSITION_FIELD[BYLEVEL][ASKSIDE]).getValueAsInt32();
-						    if (position > 0) --position;
-					    }
-						// get price
-						double askPrice = ask.getElement(PRICE_FIELD[BYLEVEL][ASKSIDE]).getValueAsFloat64();
-						// get size
-						unsigned int askSize = 0;
-						if (ask.hasElement(SIZE_FIELD[BYLEVEL][ASKSIDE], true)) {
-							askSize = (unsigned int)ask.getElement(SIZE_FIELD[BYLEVEL][ASKSIDE]).getValueAsInt64();
-						}
-						// get number of order
-						unsigned int askNumOrder = 0;
-						if (ask.hasElement(ORDER_FIELD[BYLEVEL][ASKSIDE], true)) {
-							askNumOrder = (unsigned int)ask.getElement(ORDER_FIELD[BYLEVEL][ASKSIDE]).getValueAsInt64();
-						}		
-						// get time
-						Datetime timeStamp = ask.getElement(TIME_FIELD[BYLEVEL]).getValueAsDatetime();
-						std::stringstream askTime;
-						askTime << setfill('0') << setw(2) << timeStamp.hours() << 
-							":" << setfill('0') << setw(2) << timeStamp.minutes() << 
-							":" << setfill('0') << setw(2) << timeStamp.seconds() <<
-							"." << setfill('0') << setw(3) << timeStamp.milliSeconds();
-						// create entry
-						ByLevelBookEntry entry((float)askPrice, askTime.str(), askNumOrder, askSize);
-
-						// process data command
-						if(cmd == ADD)
-							d_levelBooks[ASKSIDE].doAdd(position, entry);
-						else if(cmd == MOD)
-							d_levelBooks[ASKSIDE].doMod(position, entry);
-						else if(cmd == REPLACE)
-							d_levelBooks[ASKSIDE].doReplace(position, entry);
-						else if(cmd == EXEC)
-							d_levelBooks[ASKSIDE].doExec(position, entry);
-					}
+			// ASK table, then BID table
+			const int tableSides[2] = { ASKSIDE, BIDSIDE };
+			DepthFields rowFields;
+			for (int i = 0; i < 2; ++i) {
+				int tableSide = tableSides[i];
+				if (!fields.has(FLD_BID_TABLE + tableSide)) {
+					continue;
 				}
-				// BID table
-				Element bidTable;
-				if ((msg.asElement().getElement(&bidTable, MBL_TABLE_BID) == 0) && !bidTable.isNull()){
-					// has bid table array
-					size_t numOfItems = bidTable.numValues();
-					for (size_t index = 0; index < numOfItems; ++index) {
-						Element bid = bidTable.getValueAsElement(index);
-						// get command
-						Name cmd = bid.getElement(MD_TABLE_CMD_RT).getValueAsName(); 
-						// get position
-						int position = -1;
-						if (bid.hasElement(POSITION_FIELD[BYLEVEL][BIDSIDE], true)) {
-							position = bid.getElement(POSITION_FIELD[BYLEVEL][BIDSIDE]).getValueAsInt32();
-							if (position > 0) --position;
-						}
-						// get price
-						double bidPrice = bid.getElement(PRICE_FIELD[BYLEVEL][BIDSIDE]).getValueAsFloat64();
-						// get size
-						unsigned int bidSize = 0;
-						if (bid.hasElement(SIZE_FIELD[BYLEVEL][BIDSIDE], true)) {
-							bidSize = (unsigned int)bid.getElement(SIZE_FIELD[BYLEVEL][BIDSIDE]).getValueAsInt64();
-						}
-						// get number of order
-						unsigned int bidNumOrder = 0;
-						if (bid.hasElement(ORDER_FIELD[BYLEVEL][BIDSIDE], true)) {
-							bidNumOrder = (unsigned int)bid.getElement(ORDER_FIELD[BYLEVEL][BIDSIDE]).getValueAsInt64();
-						}
-						// get time
-						Datetime timeStamp = bid.getElement(TIME_FIELD[BYLEVEL]).getValueAsDatetime();
-						std::stringstream bidTime;
-						bidTime << setfill('0') << setw(2) << timeStamp.hours() << 
-							":" << setfill('0') << setw(2) << timeStamp.minutes() << 
-							":" << setfill('0') << setw(2) << timeStamp.seconds() <<
-							"." << setfill('0') << setw(3) << timeStamp.milliSeconds();
-						// create entry
-						ByLevelBookEntry entry((float)bidPrice, bidTime.str(), bidNumOrder, bidSize);
-
-						// process data command
-						if(cmd == ADD)
-							d_levelBooks[BIDSIDE].doAdd(position, entry);
-						else if(cmd == MOD)
-							d_levelBooks[BIDSIDE].doMod(position, entry);
-						else if(cmd == REPLACE)
-							d_levelBooks[BIDSIDE].doReplace(position, entry);
-						else if(cmd == EXEC)
-							d_levelBooks[BIDSIDE].doExec(position, entry);
+				const Element &table = fields.field[FLD_BID_TABLE + tableSide];
+				size_t numOfItems = table.numValues();
+				for (size_t index = 0; index < numOfItems; ++index) {
+					loadFields(table.getValueAsElement(index), &rowFields);
+					decodeRow(rowFields, tableSide, &row);
+					if (d_journal) {
+						d_journal->writeCommand(book.id, book.marketDepthBook, tableSide, 0, row);
 					}
+					fitPrice(books, row);
+					applyRow(books[tableSide], row);
 				}
 			}
 		}
-    }
+	}
 
 	/*------------------------------------------------------------------------------------
 	 * Name			: processMiscEvents
@@ -960,21 +708,30 @@ public:
 	/*------------------------------------------------------------------------------------
 	 * Name			: SubscriptionEventHandler
 	 * Description	: event handler constructor
-	 * Arguments	: none
+	 * Arguments	: books is the registry of subscription books
+	 *              : journal records the table commands applied, 0 for none
+	 *              : topQueue receives the top of book changes, 0 for none
+	 *              : showTicks is the show tick data flag
+	 *              : subscriptions is the subscription list
+	 *              : resubscribeIntervalMs is the least time between two resubscribes
+	 *              : maxResubscribeTopics is the most subscriptions resubscribed at once
 	 * Returns		: none
 	 *------------------------------------------------------------------------------------*/
-	SubscriptionEventHandler(ByOrderBook *orderBooks, 
-		ByLevelBook *levelBooks, int &book, int showTicks, 
-		SubscriptionList &subscriptions) 
-		: d_orderBooks(orderBooks), 
-		d_levelBooks(levelBooks), 
-		d_marketDepthBook(&book),
+	SubscriptionEventHandler(DepthBookRegistry &books, DepthJournalWriter *journal,
+		TopOfBookQueue *topQueue, int showTicks, SubscriptionList &subscriptions,
+		unsigned int resubscribeIntervalMs, unsigned int maxResubscribeTopics) 
+		: d_topics(0),
+		d_subscriptions(subscriptions),
+		d_books(books), 
+		d_journal(journal),
+		d_topQueue(topQueue),
 		d_showTicks(showTicks),
-		d_subscriptions(subscriptions)
+		d_fieldIndex(DEPTH_FIELD_NAMES),
+		d_commandIndex(TABLE_COMMAND_NAMES),
+		d_subTypeIndex(EVENT_SUBTYPE_NAMES),
+		d_bookTypeIndex(BOOK_TYPE_NAMES),
+		d_resubscriber(subscriptions, resubscribeIntervalMs, maxResubscribeTopics)
     {
-		d_gapDetected = 0;
-		d_resubscribed = 0;
-		d_sequenceNumber = 0;
 	}
 
 	void setSession(Session &session)
@@ -982,6 +739,19 @@ public:
 		d_session = &session;
 	}
 
+	/*------------------------------------------------------------------------------------
+	 * Name			: setTopicDispatcher
+	 * Description	: hands the data events to the workers of topics, which
+	 *				  process the messages of a book in order without locking it
+	 * Arguments	: topics is the started dispatcher, 0 to process the events
+	 *				  on the event handler thread
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	void setTopicDispatcher(TopicDispatcher *topics)
+	{
+		d_topics = topics;
+	}
+
 	/*------------------------------------------------------------------------------------
 	 * Name			: showTicks
 	 * Description	: show tick data flag
@@ -1008,7 +778,11 @@ public:
             switch (event.eventType())
             {                
             case Event::SUBSCRIPTION_DATA:
-                processSubscriptionDataEvent(event, session);
+				if (d_topics) {
+					d_topics->processEvent(event);
+				} else {
+					processSubscriptionDataEvent(event, session);
+				}
                 break;
             case Event::SUBSCRIPTION_STATUS:
                 processSubscriptionStatus(event);
@@ -1017,6 +791,14 @@ public:
                 processMiscEvents(event);
                 break;
             }
+			// send the resubscribes queued for sequence gaps when due
+			unsigned int resubscribed = d_resubscriber.flush(session);
+			if (resubscribed > 0) {
+				syncio.lock();
+				std::cout << "Resubscribed " << resubscribed << " subscription(s) after gaps, " <<
+					d_resubscriber.pending() << " waiting." << std::endl;
+				syncio.unlock();
+			}
         } catch (Exception &e) {
 			syncio.lock();
 			std::cout << "Library Exception !!! " << e.description().c_str() << std::endl;
@@ -1025,8 +807,157 @@ public:
         }
 		return flag;
 	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: processTopicMessage
+	 * Description	: process a data message on the worker of its book
+	 * Arguments	: msg is the message
+	 *              : eventType is the type of its event
+	 *              : the worker number is not used, the book is found
+	 *              : by correlation id
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	void processTopicMessage(const Message &msg, int eventType, unsigned int)
+	{
+		try {
+			if (eventType != Event::SUBSCRIPTION_DATA || msg.messageType() != MARKET_DEPTH_UPDATES) {
+				return;
+			}
+			DepthBook *book = d_books.find(msg.correlationId().asInteger());
+			if (book == 0) {
+				// not one of our subscriptions
+				return;
+			}
+			// no other thread gets the messages of this book
+			processBookMessage(msg, book, d_session);
+		} catch (Exception &e) {
+			syncio.lock();
+			std::cout << "Library Exception !!! " << e.description().c_str() << std::endl;
+			syncio.unlock();
+		}
+	}
+};
+
+/*------------------------------------------------------------------------------------
+ * Class		 : TopOfBookPrinter
+ * Description   : Prints the top of book changes of the books on its own
+ *				   thread, so console output never holds up the event
+ *				   handler threads
+ *------------------------------------------------------------------------------------*/
+class TopOfBookPrinter: public TopOfBookListener
+{
+	DepthBookRegistry &d_books;
+	TopOfBookQueue &d_queue;
+	int d_pricePrecision;
+	volatile int d_stop;
+
+public:
+	/*------------------------------------------------------------------------------------
+	 * Name			: TopOfBookPrinter
+	 * Description	: constructor
+	 * Arguments	: books is the registry the changes come from
+	 *              : queue holds the changes
+	 *              : pricePrecision is the number of decimals printed
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	TopOfBookPrinter(DepthBookRegistry &books, TopOfBookQueue &queue, int pricePrecision)
+		: d_books(books),
+		d_queue(queue),
+		d_pricePrecision(pricePrecision),
+		d_stop(0)
+	{
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: onTopOfBook
+	 * Description	: print one top of book change
+	 * Arguments	: top is the latest top of the book
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	void onTopOfBook(const TopOfBook &top)
+	{
+		DepthBook *book = d_books.find(top.bookId_);
+		syncio.lock();
+		std::cout.precision(d_pricePrecision);
+		std::cout.setf(ios::fixed, ios::floatfield);
+		std::cout << "TOP " << (book ? book->topic : std::string("?"))
+			<< "  BID " << top.size_[BIDSIDE] << " @ " << top.priceScale_.toDouble(top.price_[BIDSIDE])
+			<< " (" << top.numOrders_[BIDSIDE] << ")"
+			<< "  ASK " << top.size_[ASKSIDE] << " @ " << top.priceScale_.toDouble(top.price_[ASKSIDE])
+			<< " (" << top.numOrders_[ASKSIDE] << ")"
+			<< "  changed 0x" << std::hex << top.changeMask_ << std::dec << std::endl;
+		syncio.unlock();
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: run
+	 * Description	: deliver changes until stop() is called
+	 * Arguments	: none
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	void run()
+	{
+		while (!d_stop) {
+			d_queue.deliver(*this, 100);
+		}
+	}
+
+	/*------------------------------------------------------------------------------------
+	 * Name			: stop
+	 * Description	: make run() return
+	 * Arguments	: none
+	 * Returns		: none
+	 *------------------------------------------------------------------------------------*/
+	void stop()
+	{
+		d_stop = 1;
+		d_queue.close();
+	}
 };
 
+namespace {
+#if defined(WIN32) || defined(_WIN32)
+	typedef HANDLE ThreadHandle;
+
+	DWORD WINAPI printerThread(LPVOID arg)
+	{
+		static_cast<TopOfBookPrinter *>(arg)->run();
+		return 0;
+	}
+
+	ThreadHandle startPrinter(TopOfBookPrinter *printer)
+	{
+		return CreateThread(NULL, 0, printerThread, printer, 0, NULL);
+	}
+
+	void joinThread(ThreadHandle handle)
+	{
+		WaitForSingleObject(handle, INFINITE);
+		CloseHandle(handle);
+	}
+#else
+	typedef pthread_t ThreadHandle;
+
+	void *printerThread(void *arg)
+	{
+		static_cast<TopOfBookPrinter *>(arg)->run();
+		return 0;
+	}
+
+	ThreadHandle startPrinter(TopOfBookPrinter *printer)
+	{
+		ThreadHandle handle;
+		pthread_create(&handle, NULL, printerThread, printer);
+		return handle;
+	}
+
+	void joinThread(ThreadHandle handle)
+	{
+		pthread_join(handle, NULL);
+	}
+#endif
+}
+
 class MarketDepthSubscriptionSnapshotExample
 {
 	std::vector<std::string>	 d_hosts;			// IP Addresses of the Managed B-Pipes
@@ -1036,14 +967,24 @@ class MarketDepthSubscriptionSnapshotExample
     SessionOptions               d_sessionOptions;
     Session                     *d_session;
     SubscriptionEventHandler    *d_eventHandler;
-    std::string				     d_security;
+	EventDispatcher				*d_eventDispatcher;
+	int							 d_numDispatcherThreads;
+	TopicDispatcher				*d_topicDispatcher;
+	int							 d_numTopicWorkers;	// threads with topic affinity, 0 for none
+	WaitStrategy				 d_workerWait;		// how idle topic workers wait
+	std::vector<std::string>	 d_securities;
 	std::vector<std::string>     d_options;
     SubscriptionList             d_subscriptions; 
-	ByOrderBook				     d_orderBooks[bookSize];
-	ByLevelBook				     d_levelBooks[bookSize];
-	int							 d_marketDepthBook;
+	DepthBookRegistry			 d_books;			// books by subscription correlation id
+	std::string					 d_journalFile;
+	unsigned int				 d_resubscribeInterval;	// ms between resubscribes after gaps
+	unsigned int				 d_maxResubscribeTopics;	// subscriptions per resubscribe
+	int							 d_showTop;			// print top of book changes
+	TopOfBookQueue				 d_topQueue;		// top of book changes to print
+	DepthJournalWriter			 d_journal;			// journal of the table commands applied
 	int							 d_pricePrecision;
 	int							 d_showTicks;
+	unsigned int				 d_snapshotDepth;	// number of levels shown
 
 
 	/*------------------------------------------------------------------------------------
@@ -1106,10 +1047,27 @@ class MarketDepthSubscriptionSnapshotExample
 		syncio.unlock();
 
 		// create event handler
-		d_eventHandler = new SubscriptionEventHandler(d_orderBooks, d_levelBooks, 
-			d_marketDepthBook, d_showTicks, d_subscriptions);
+		d_eventHandler = new SubscriptionEventHandler(d_books,
+			d_journalFile.empty() ? 0 : &d_journal, d_showTop ? &d_topQueue : 0,
+			d_showTicks, d_subscriptions,
+			d_resubscribeInterval, d_maxResubscribeTopics);
+		// workers with topic affinity update different books in parallel, each book
+		// on one thread, behind the single event handler thread
+		if (d_numTopicWorkers > 0)
+		{
+			d_topicDispatcher = new TopicDispatcher(*d_eventHandler, d_numTopicWorkers);
+			d_topicDispatcher->setWaitStrategy(d_workerWait);
+			d_topicDispatcher->start();
+			d_eventHandler->setTopicDispatcher(d_topicDispatcher);
+		}
+		// several dispatcher threads update different books in parallel
+		else if (d_numDispatcherThreads > 1)
+		{
+			d_eventDispatcher = new EventDispatcher(d_numDispatcherThreads);
+			d_eventDispatcher->start();
+		}
 		// create session
-		d_session = new Session(sessionOptions, d_eventHandler);
+		d_session = new Session(sessionOptions, d_eventHandler, d_eventDispatcher);
 		// pass session to event handler
 		d_eventHandler->setSession(*d_session);
 		// start sesson
@@ -1136,11 +1094,30 @@ class MarketDepthSubscriptionSnapshotExample
 
         for (int i = 1; i < argc; ++i) {
             if (!std::strcmp(argv[i],"-s") && i + 1 < argc) {
-                d_security = argv[++i];
+                d_securities.push_back(argv[++i]);
             } else if (!std::strcmp(argv[i],"-o") && i + 1 < argc) {
                 d_options.push_back(argv[++i]);
 			} else if (!std::strcmp(argv[i],"-pr") &&  i + 1 < argc) {
                 d_pricePrecision = std::atoi(argv[++i]);
+			} else if (!std::strcmp(argv[i],"-depth") &&  i + 1 < argc) {
+                d_snapshotDepth = std::atoi(argv[++i]);
+			} else if (!std::strcmp(argv[i],"-threads") &&  i + 1 < argc) {
+                d_numDispatcherThreads = std::atoi(argv[++i]);
+			} else if (!std::strcmp(argv[i],"-workers") &&  i + 1 < argc) {
+                d_numTopicWorkers = std::atoi(argv[++i]);
+			} else if (!std::strcmp(argv[i],"-wait") &&  i + 1 < argc) {
+				if (!d_workerWait.parse(argv[++i])) {
+					printUsage();
+					return false;
+				}
+			} else if (!std::strcmp(argv[i],"-resubint") &&  i + 1 < argc) {
+                d_resubscribeInterval = std::atoi(argv[++i]);
+			} else if (!std::strcmp(argv[i],"-resubmax") &&  i + 1 < argc) {
+                d_maxResubscribeTopics = std::atoi(argv[++i]);
+			} else if (!std::strcmp(argv[i],"-journal") &&  i + 1 < argc) {
+                d_journalFile = argv[++i];
+			} else if (!std::strcmp(argv[i],"-top")) {
+				d_showTop = 1;
 			} else if (!std::strcmp(argv[i],"-st") &&  i < argc) {
 				d_showTicks = 1;
             } else if (!std::strcmp(argv[i],"-ip") && i + 1 < argc) {
@@ -1171,6 +1148,13 @@ class MarketDepthSubscriptionSnapshotExample
              return false;
 		}
 
+		if (d_snapshotDepth == 0)
+		{
+			std::cout << "Levels shown must be greater than 0." << std::endl;
+			printUsage();
+			return false;
+		}
+
 		//default arguments
 		if (d_hosts.size() == 0)
 		{
@@ -1179,8 +1163,8 @@ class MarketDepthSubscriptionSnapshotExample
             return false;
 		}
 
-        if (d_security.length() == 0) {
-            d_security = mktDepthServiceName + "/ticker/VOD LN Equity";
+        if (d_securities.size() == 0) {
+            d_securities.push_back(mktDepthServiceName + "/ticker/VOD LN Equity");
         }
 
 		if (d_options.size() == 0) {
@@ -1200,24 +1184,26 @@ class MarketDepthSubscriptionSnapshotExample
 			}
 		}
 
-		// default to unknow book type
-		d_marketDepthBook = UNKNOWN;
-
-		// add market depth service to security
-		int index = (int)d_security.find("/");
-		if (index != 0)
-		{
-			d_security = "/" + d_security;
-		}
-		index = (int)d_security.find("//");
-		if (index != 0)
-		{
-			d_security = mktDepthServiceName + d_security;
+		for (size_t k = 0; k < d_securities.size(); ++k) {
+			std::string &security = d_securities[k];
+			// add market depth service to security
+			int index = (int)security.find("/");
+			if (index != 0)
+			{
+				security = "/" + security;
+			}
+			index = (int)security.find("//");
+			if (index != 0)
+			{
+				security = mktDepthServiceName + security;
+			}
+			// add subscription to subscription list, the correlation id
+			// value is the key of the subscription book
+			tmpSecurity = security + subscriptionOptions;
+			d_books.add((long long)k, security);
+			d_subscriptions.add(tmpSecurity.c_str(), CorrelationId((long long)k));
+			std::cout << "Subscription string: " << d_subscriptions.topicStringAt(k) << std::endl;
 		}
-        // add subscription to subscription list
-		tmpSecurity = d_security + subscriptionOptions;
-        d_subscriptions.add(tmpSecurity.c_str(), CorrelationId(&d_security));
-		std::cout << "Subscription string: " << d_subscriptions.topicStringAt(0) << std::endl;
 		syncio.unlock();
 
         return true;
@@ -1326,14 +1312,26 @@ class MarketDepthSubscriptionSnapshotExample
             << "    Retrieve realtime market depth data using Bloomberg V3 API" << std::endl
 			<< std::endl
             << "      [-s    <security   = ""/ticker/VOD LN Equity"">" << std::endl
+			<< "      [-threads <dispatcher threads = 1>" << std::endl
+			<< "      [-workers <worker threads with topic affinity = 0>" << std::endl
+			<< "      [-wait <worker wait = block, spin=<microseconds>, poll or poll=<first core>>" << std::endl
 			<< "      [-o    <type=MBO, type=MBL, type=TOP or type=MMQ>" << std::endl
-			<< "      [-pr   <precision  = 4>" << std::endl
+			<< "      [-pr   <price decimals shown = 4>" << std::endl
+			<< "      [-depth <levels shown = 10>" << std::endl
 			<< "      [-st   <show ticks>" << std::endl
+			<< "      [-top  <show top of book changes>" << std::endl
+			<< "      [-journal <file to record table commands to>" << std::endl
+			<< "      [-resubint <ms between resubscribes after gaps = 1000>" << std::endl
+			<< "      [-resubmax <subscriptions per resubscribe = 16>" << std::endl
             << "      [-ip   <ipAddress  = localhost>" << std::endl
             << "      [-p    <tcpPort    = 8194>" << std::endl
 			<< "      [-auth      <authenticationOption = NONE or LOGON or APPLICATION or DIRSVC>]" << std::endl
 			<< "      [-n         <name = applicationName or directoryService>]" << std::endl
 			<< "Notes:" << std::endl
+			<< " -Specify -s several times to subscribe to several securities." << std::endl
+			<< " -Replay a journal with DepthJournalReplay." << std::endl
+			<< " -With -workers the books are updated without locks and -threads is ignored." << std::endl
+			<< " -Spinning or polling workers hand off ticks faster but keep cores busy." << std::endl
 			<< " -Specify only LOGON to authorize 'user' using Windows/unix login name." << std::endl
 			<< " -Specify DIRSVC and name(Directory Service Property) to authorize user using directory Service." << std::endl
 			<< " -Specify APPLICATION and name(Application Name) to authorize application." << std::endl;
@@ -1359,21 +1357,27 @@ class MarketDepthSubscriptionSnapshotExample
 
 	/*----------------------------------------------------------------
 	 * Name			: ShowByOrderBook
-	 * Description	: dumps the current order book to the console
-	 * Arguments	: none
+	 * Description	: dumps the current order book to the console. The
+	 *				  book is read from its published snapshot so the
+	 *				  event handler thread is never blocked.
+	 * Arguments	: depthBook is the subscription book to show
 	 * Returns		: none
 	 *---------------------------------------------------------------*/
-	void ShowByOrderBook()
+	void ShowByOrderBook(DepthBook &depthBook)
 	{
-		register unsigned int i;
+		unsigned int i;
 		unsigned int uSize, auSize[2];
+		std::vector<ByOrderBookEntry> entries[2];
+		char timeBuffer[16];
 
-	    syncio.lock();
-		ByOrderBook *book = d_orderBooks;
+		ByOrderBook *book = depthBook.orderBooks;
+		PriceScale scale[2];
 
-		// get BID/ASK size
-		auSize[BIDSIDE] = book[BIDSIDE].size();
-		auSize[ASKSIDE] = book[ASKSIDE].size();
+		// get BID/ASK snapshot with the scale of its prices
+		entries[BIDSIDE].resize(d_snapshotDepth);
+		entries[ASKSIDE].resize(d_snapshotDepth);
+		auSize[BIDSIDE] = book[BIDSIDE].getSnapshot(&entries[BIDSIDE][0], d_snapshotDepth, &scale[BIDSIDE]);
+		auSize[ASKSIDE] = book[ASKSIDE].getSnapshot(&entries[ASKSIDE][0], d_snapshotDepth, &scale[ASKSIDE]);
 		uSize = auSize[BIDSIDE] > auSize[ASKSIDE] ? auSize[BIDSIDE] : auSize[ASKSIDE];
 
 	    int offset = 0;
@@ -1382,7 +1386,9 @@ class MarketDepthSubscriptionSnapshotExample
 	    else
 		    offset = d_pricePrecision - 4;
 
+	    syncio.lock();
 		cout << "-------------------------------------------------------------------------------------------------" << endl;
+		cout << "SECURITY           : " << depthBook.topic << endl;
 		cout << "MAXIMUM WINDOW SIZE: " << book->window_size << endl
 			 << "BOOK TYPE          : " << book->book_type << endl;
 		cout << "-------------------------------------------------------------------------------------------------" << endl;
@@ -1397,25 +1403,26 @@ class MarketDepthSubscriptionSnapshotExample
 			ss.setf(ios::fixed,ios::floatfield);
 
 			// format book for bid side
-			ByOrderBookEntry entry;
-			if (book[BIDSIDE].getEntry(i, entry)) 
+			if (i < auSize[BIDSIDE] && entries[BIDSIDE][i].isValid()) 
 			{
-				ss <<  setw(7) << entry.broker_.c_str()  <<  " "
-				   << setw(8) << entry.price_  << " "
+				const ByOrderBookEntry &entry = entries[BIDSIDE][i];
+				ss <<  setw(7) << book[BIDSIDE].brokerCode(entry.brokerId())  <<  " "
+				   << setw(8) << scale[BIDSIDE].toDouble(entry.price())  << " "
 				   << setw(6) << entry.size_ <<  " "
-				   << setw(13) << entry.time_;
+				   << setw(13) << entry.formatTime(timeBuffer, sizeof(timeBuffer));
 			}
 			else
 				ss << setw(37 + offset) << "";
 
 			// format book or ask side
-			if (book[ASKSIDE].getEntry(i, entry))
+			if (i < auSize[ASKSIDE] && entries[ASKSIDE][i].isValid())
 			{
+				const ByOrderBookEntry &entry = entries[ASKSIDE][i];
 				ss << "     ---   "
-					<<  setw(7) << entry.broker_.c_str()  <<  " "
-					<< setw(8) << entry.price_  << " "
+					<<  setw(7) << book[ASKSIDE].brokerCode(entry.brokerId())  <<  " "
+					<< setw(8) << scale[ASKSIDE].toDouble(entry.price())  << " "
 					<< setw(6) << entry.size_ <<  " "
-					<< setw(13) << entry.time_;
+					<< setw(13) << entry.formatTime(timeBuffer, sizeof(timeBuffer));
 			}
 			// display row
 			cout << setw(3) << i + 1 << " " << ss.str().c_str() << endl;
@@ -1425,21 +1432,27 @@ class MarketDepthSubscriptionSnapshotExample
 
 	/*----------------------------------------------------------------
 	 * Name			: ShowByLevelBook
-	 * Description	: dumps the current order book to the console
-	 * Arguments	: none
+	 * Description	: dumps the current order book to the console. The
+	 *				  book is read from its published snapshot so the
+	 *				  event handler thread is never blocked.
+	 * Arguments	: depthBook is the subscription book to show
 	 * Returns		: none
 	 *---------------------------------------------------------------*/
-	void ShowByLevelBook()
+	void ShowByLevelBook(DepthBook &depthBook)
 	{
-		register unsigned int i;
+		unsigned int i;
 		unsigned int uSize, auSize[2];
+		std::vector<ByLevelBookEntry> entries[2];
+		char timeBuffer[16];
 
-	    syncio.lock();
-		ByLevelBook *book = d_levelBooks;
+		ByLevelBook *book = depthBook.levelBooks;
+		PriceScale scale[2];
 
-		// get BID/ASK size
-	    auSize[BIDSIDE] = book[BIDSIDE].size();
-	    auSize[ASKSIDE] = book[ASKSIDE].size();
+		// get BID/ASK snapshot with the scale of its prices
+		entries[BIDSIDE].resize(d_snapshotDepth);
+		entries[ASKSIDE].resize(d_snapshotDepth);
+		auSize[BIDSIDE] = book[BIDSIDE].getSnapshot(&entries[BIDSIDE][0], d_snapshotDepth, &scale[BIDSIDE]);
+		auSize[ASKSIDE] = book[ASKSIDE].getSnapshot(&entries[ASKSIDE][0], d_snapshotDepth, &scale[ASKSIDE]);
 	    uSize = auSize[BIDSIDE] > auSize[ASKSIDE] ? auSize[BIDSIDE] : auSize[ASKSIDE];
 	    
 		int offset = 0;
@@ -1448,7 +1461,9 @@ class MarketDepthSubscriptionSnapshotExample
 	    else
 		    offset = d_pricePrecision - 4;
 	   
+	    syncio.lock();
 		cout << "------------------------------------------------------------------------" << endl;
+	    cout << "SECURITY           : " << depthBook.topic << endl;
 	    cout << "MAXIMUM WINDOW SIZE: " << book->window_size << endl
 			 << "BOOK TYPE          : " << book->book_type << endl;
 	    cout << "------------------------------------------------------------------------" << endl;
@@ -1461,25 +1476,26 @@ class MarketDepthSubscriptionSnapshotExample
 		    ss.precision(d_pricePrecision);
 		    ss.setf(ios::fixed,ios::floatfield);
 		    // format book for bid side
-		    ByLevelBookEntry entry;
-		    if (book[BIDSIDE].getEntry(i, entry)) 
+		    if (i < auSize[BIDSIDE] && entries[BIDSIDE][i].isValid()) 
 		    {
-				ss << setw(8) << entry.price_  << " "
+				const ByLevelBookEntry &entry = entries[BIDSIDE][i];
+				ss << setw(8) << scale[BIDSIDE].toDouble(entry.price())  << " "
 				   << setw(6) << entry.size_ <<  " "
-				   << setw(6) << entry.numOrders_ << " " 
-				   << setw(13) << entry.time_;
+				   << setw(6) << entry.numOrders() << " " 
+				   << setw(13) << entry.formatTime(timeBuffer, sizeof(timeBuffer));
 			 }
 			 else
 				ss << setw(36 + offset) << "";
 
 			 // format book or ask side
-			 if (book[ASKSIDE].getEntry(i, entry))
+			 if (i < auSize[ASKSIDE] && entries[ASKSIDE][i].isValid())
 			 {
+				const ByLevelBookEntry &entry = entries[ASKSIDE][i];
 			 	ss << "   --- "
-					<< setw(8) << entry.price_  << " "
+					<< setw(8) << scale[ASKSIDE].toDouble(entry.price())  << " "
 					<< setw(6) << entry.size_ <<  " "
-					<< setw(6) << entry.numOrders_ << " " 
-					<< setw(13) << entry.time_;
+					<< setw(6) << entry.numOrders() << " " 
+					<< setw(13) << entry.formatTime(timeBuffer, sizeof(timeBuffer));
 			 }
 			 // display row
 			 cout << setw(3) << i + 1 << " " << ss.str().c_str() << endl;
@@ -1496,11 +1512,19 @@ public:
 	 * Returns		: none
 	 *------------------------------------------------------------------------------------*/
     MarketDepthSubscriptionSnapshotExample()
-    : d_session(0)
+    : d_port(8194)
+    , d_session(0)
     , d_eventHandler(0)
+	, d_eventDispatcher(0)
+	, d_numDispatcherThreads(1)
+	, d_topicDispatcher(0)
+	, d_numTopicWorkers(0)
+	, d_resubscribeInterval(1000)
+	, d_maxResubscribeTopics(16)
+	, d_showTop(0)
 	, d_pricePrecision(4)
-	, d_port(8194)
 	, d_showTicks(0)
+	, d_snapshotDepth(10)
     {
     }
 
@@ -1513,6 +1537,8 @@ public:
     ~MarketDepthSubscriptionSnapshotExample()
     {
         if (d_session) delete d_session;
+        if (d_eventDispatcher) delete d_eventDispatcher;
+        if (d_topicDispatcher) delete d_topicDispatcher;
         if (d_eventHandler) delete d_eventHandler ;
     }
 
@@ -1528,6 +1554,36 @@ public:
 		// process command line
         if (!parseCommandLine(argc, argv)) return;
         
+		// publish the top of each book so it can be shown without
+		// locking out the event handler threads. Prices are held
+		// as whole units of the last decimal the book has seen,
+		// -pr only sets the decimals printed
+		std::vector<DepthBook *> books;
+		d_books.getBooks(books);
+		for (size_t i = 0; i < books.size(); ++i) {
+			for (int side = 0; side < bookSize; ++side) {
+				books[i]->orderBooks[side].setSnapshotDepth(d_snapshotDepth);
+				books[i]->levelBooks[side].setSnapshotDepth(d_snapshotDepth);
+				books[i]->orderBooks[side].setPriceDecimals(START_PRICE_DECIMALS);
+				books[i]->levelBooks[side].setPriceDecimals(START_PRICE_DECIMALS);
+			}
+		}
+
+		// record the table commands for DepthJournalReplay
+		if (!d_journalFile.empty() && !d_journal.open(d_journalFile.c_str(), START_PRICE_DECIMALS)) {
+			syncio.lock();
+			std::cerr << "Failed to create journal " << d_journalFile << std::endl;
+			syncio.unlock();
+			return;
+		}
+
+		// print top of book changes on their own thread
+		TopOfBookPrinter topPrinter(d_books, d_topQueue, d_pricePrecision);
+		ThreadHandle topThread;
+		if (d_showTop) {
+			topThread = startPrinter(&topPrinter);
+		}
+
 		// create session 
 		createSession();
 
@@ -1564,20 +1620,22 @@ public:
 			{
 				if ((c == 'v') || (c == 'V'))
 				{
-					// view market depth book
-					switch (d_marketDepthBook)
-					{
-						case BYLEVEL:
-							ShowByLevelBook();
-							break;
-						case BYORDER:
-							ShowByOrderBook();
-							break;
-						default:
-							syncio.lock();
-							std::cout << "Unknown book type" << std::endl;
-							syncio.unlock();
-							break;
+					// view market depth books
+					for (size_t i = 0; i < books.size(); ++i) {
+						switch (books[i]->marketDepthBook)
+						{
+							case BYLEVEL:
+								ShowByLevelBook(*books[i]);
+								break;
+							case BYORDER:
+								ShowByOrderBook(*books[i]);
+								break;
+							default:
+								syncio.lock();
+								std::cout << books[i]->topic << ": Unknown book type" << std::endl;
+								syncio.unlock();
+								break;
+						}
 					}
 				}
 				else if ( (c == 't') || (c == 'T') )
@@ -1605,6 +1663,18 @@ public:
 		d_session->unsubscribe(d_subscriptions);
 		// stop session
         d_session->stop();
+		// let the workers apply the data received before the stop
+		if (d_topicDispatcher) {
+			d_topicDispatcher->stop();
+		}
+		if (d_showTop) {
+			topPrinter.stop();
+			joinThread(topThread);
+			syncio.lock();
+			std::cout << "Top of book changes conflated: " << d_topQueue.conflated()
+				<< ", dropped: " << d_topQueue.dropped() << std::endl;
+			syncio.unlock();
+		}
 		syncio.lock();
 		std::cout << "Exiting..." << std::endl;
 		syncio.unlock();
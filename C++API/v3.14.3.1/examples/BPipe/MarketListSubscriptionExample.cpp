@@ -34,6 +34,8 @@
 #include <string.h>
 #include <vector>
 
+#include "EventBatch.h"
+
 using namespace BloombergLP;
 using namespace blpapi;
 
@@ -50,6 +52,9 @@ namespace {
 	const Name TOKEN("token");
 
     const char* authServiceName = "//blp/apiauth";
+
+	// most events taken from the session per wakeup
+	const size_t EVENT_BATCH_SIZE = 64;
 }
 
 class MarketListSubscriptionExample
@@ -314,17 +319,23 @@ public:
 			d_session->subscribe(subscriptions);
 		}
 		while (true) {
-			Event event = d_session->nextEvent();
-			MessageIterator msgIter(event);
-			while (msgIter.next()) {
-				Message msg = msgIter.message();
-				printFragType(msg.fragmentType());
-				if (event.eventType() == Event::SUBSCRIPTION_STATUS ||
-					event.eventType() == Event::SUBSCRIPTION_DATA) {
-					const char *topic = (char *)msg.correlationId().asPointer();
-					std::cout << topic << " - ";
+			// a burst of list updates is drained in one wakeup; the array is
+			// declared here so the updates are released before the next wait
+			Event events[EVENT_BATCH_SIZE];
+			size_t numEvents = drainEvents(*d_session, events, EVENT_BATCH_SIZE);
+			for (size_t i = 0; i < numEvents; ++i) {
+				const Event &event = events[i];
+				MessageIterator msgIter(event);
+				while (msgIter.next()) {
+					Message msg = msgIter.message();
+					printFragType(msg.fragmentType());
+					if (event.eventType() == Event::SUBSCRIPTION_STATUS ||
+						event.eventType() == Event::SUBSCRIPTION_DATA) {
+						const char *topic = (char *)msg.correlationId().asPointer();
+						std::cout << topic << " - ";
+					}
+					msg.print(std::cout) << std::endl;
 				}
-				msg.print(std::cout) << std::endl;
 			}
 		}
 	}
@@ -74,6 +74,11 @@
 #include <string.h>
 #include <time.h>
 #include <stdio.h>
+#include <stddef.h>
+#include <iostream>
+
+#include "FieldAccessor.h"
+#include "NameIndex.h"
 
 using namespace BloombergLP;
 using namespace blpapi;
@@ -99,12 +104,38 @@ namespace {
 	Name NUMBER_OF_TICKS("NUMBER_OF_TICKS");
 	Name VOLUME("VOLUME");
 
+	Name MARKET_BAR_START("MarketBarStart");
+	Name MARKET_BAR_UPDATE("MarketBarUpdate");
+	Name MARKET_BAR_END("MarketBarEnd");
+
+	// field ids of the bar accessors, in the order the fields are added
+	enum BarField {
+		BAR_TIME, BAR_OPEN, BAR_HIGH, BAR_LOW, BAR_CLOSE,
+		BAR_NUMBER_OF_TICKS, BAR_VOLUME
+	};
+
+	// bar fields extracted from a message in one call
+	struct BarValues {
+		blpapi_Datetime_t time;
+		Float64 open;
+		Float64 high;
+		Float64 low;
+		Float64 close;
+		Int64 numberOfTicks;
+		Int64 volume;
+	};
+
 	const char *MKTBAR_SVC = "//blp/mktbar";
 	const char *AUTH_SVC = "//blp/apiauth";
 }
 
 class SubscriptionEventHandler: public EventHandler
 {
+	// bar fields of each message type, d_barFields[0] is used
+	// for the types not in d_barTypes and reads by Name
+	std::vector<FieldAccessor> d_barFields;
+	NameIndex d_barTypes;
+
     size_t getTimeStamp(char *buffer, size_t bufSize)
     {
         const char *format = "%Y/%m/%d %X";
@@ -221,55 +252,63 @@ class SubscriptionEventHandler: public EventHandler
     *****************************************************************************/
 	void CheckAspectFields(Message msg)
 	{
-		// extract data for each specific element
-		// it's anticipated that an application will require this data
-		// in the correct format.  this is retrieved to demonstrate
-		// but is not used later in the code.
-		if(msg.hasElement(TIME))
+		// extract every field in its own type in one call through
+		// the accessor of the message type, which reads the fields
+		// by their schema position. Bit n of the result is set if
+		// BarField n was written.
+		int barType = d_barTypes.find(msg.messageType());
+		const FieldAccessor &fields = d_barFields[barType == NameIndex::NOT_FOUND ? 0 : barType];
+		BarValues bar;
+		unsigned long long written = fields.extract(msg.asElement(), &bar);
+
+		if(written & (1ULL << BAR_TIME))
 		{
-			Datetime time = msg.getElementAsDatetime(TIME);
-			const char *time_str = msg.getElementAsString(TIME);
-			std::cout << "Time : " << time_str << "\n";
+			std::cout << "Time : " << Datetime(bar.time) << "\n";
 		}
-		if(msg.hasElement(OPEN))
+		if(written & (1ULL << BAR_OPEN))
 		{
-			int open = msg.getElementAsInt32(OPEN);
-			const char *open_str = msg.getElementAsString(OPEN);
-			std::cout << "Open : " << open_str << "\n";
+			std::cout << "Open : " << bar.open << "\n";
 		}
-		if(msg.hasElement(HIGH))
+		if(written & (1ULL << BAR_HIGH))
 		{
-			int high = msg.getElementAsInt32(HIGH);
-			const char *high_str = msg.getElementAsString(HIGH);
-			std::cout << "High : " << high_str << "\n";
+			std::cout << "High : " << bar.high << "\n";
 		}
-		if(msg.hasElement(LOW))
+		if(written & (1ULL << BAR_LOW))
 		{
-			int low = msg.getElementAsInt32(LOW);
-			const char *low_str = msg.getElementAsString(LOW);
-			std::cout << "Low : " << low_str << "\n";
+			std::cout << "Low : " << bar.low << "\n";
 		}
-		if(msg.hasElement(CLOSE))
+		if(written & (1ULL << BAR_CLOSE))
 		{
-			int close = msg.getElementAsInt32(CLOSE);
-			const char *close_str = msg.getElementAsString(CLOSE);
-			std::cout << "Close : " << close_str << "\n";
+			std::cout << "Close : " << bar.close << "\n";
 		}
-		if(msg.hasElement(NUMBER_OF_TICKS))
+		if(written & (1ULL << BAR_NUMBER_OF_TICKS))
 		{
-			int number_of_ticks = msg.getElementAsInt32(NUMBER_OF_TICKS);
-			const char *number_of_ticks_str = msg.getElementAsString(NUMBER_OF_TICKS);
-			std::cout << "Number of Ticks : " << number_of_ticks_str << "\n";
+			std::cout << "Number of Ticks : " << bar.numberOfTicks << "\n";
 		}
-		if(msg.hasElement(VOLUME))
+		if(written & (1ULL << BAR_VOLUME))
 		{
-			Int64 volume = msg.getElementAsInt64(VOLUME);
-			const char *volume_str = msg.getElementAsString(VOLUME);
-			std::cout << "Volume : " << volume_str << "\n";
+			std::cout << "Volume : " << bar.volume << "\n";
 		}
 		std::cout << std::endl;
 	}
 
+	/*****************************************************************************
+    Function    : addBarFields
+    Description : Adds the bar fields to an accessor in BarField order
+    Arguments   : FieldAccessor
+    Returns     : void
+    *****************************************************************************/
+	static void addBarFields(FieldAccessor &fields)
+	{
+		fields.addField(TIME, FieldAccessor::FIELD_DATETIME, offsetof(BarValues, time));
+		fields.addField(OPEN, FieldAccessor::FIELD_FLOAT64, offsetof(BarValues, open));
+		fields.addField(HIGH, FieldAccessor::FIELD_FLOAT64, offsetof(BarValues, high));
+		fields.addField(LOW, FieldAccessor::FIELD_FLOAT64, offsetof(BarValues, low));
+		fields.addField(CLOSE, FieldAccessor::FIELD_FLOAT64, offsetof(BarValues, close));
+		fields.addField(NUMBER_OF_TICKS, FieldAccessor::FIELD_INT64, offsetof(BarValues, numberOfTicks));
+		fields.addField(VOLUME, FieldAccessor::FIELD_INT64, offsetof(BarValues, volume));
+	}
+
 	/*****************************************************************************
     Function    : processMiscEvents
     Description : Processes any message returned from Bloomberg
@@ -292,9 +331,39 @@ class SubscriptionEventHandler: public EventHandler
 
 public:
     SubscriptionEventHandler()
+		: d_barFields(4)
     {
+		d_barTypes.add(MARKET_BAR_START, 1);
+		d_barTypes.add(MARKET_BAR_UPDATE, 2);
+		d_barTypes.add(MARKET_BAR_END, 3);
+		for (size_t i = 0; i < d_barFields.size(); ++i) {
+			addBarFields(d_barFields[i]);
+		}
     }
 
+	/*****************************************************************************
+	Function    : compileBarFields
+	Description : Looks up the bar fields in the schema of each bar message
+	                type so they are read by position. Call it after the
+	                service is opened and before subscribing.
+	Arguments   : Service
+	Returns     : void
+	*****************************************************************************/
+	void compileBarFields(const Service &service)
+	{
+		const Name types[] = { MARKET_BAR_START, MARKET_BAR_UPDATE, MARKET_BAR_END };
+		for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); ++i) {
+			if (!service.hasEventDefinition(types[i])) {
+				continue;
+			}
+			int barType = d_barTypes.find(types[i]);
+			if (!d_barFields[barType].compile(service.getEventDefinition(types[i]))) {
+				fprintf(stdout, "%s: some bar fields are not in the schema\n",
+					types[i].string());
+			}
+		}
+	}
+
 	/*****************************************************************************
 	Function    : processEvent
 	Description : Processes session events
@@ -379,6 +448,7 @@ class MktBarWithEventHandlerExample
             d_session->stop();
             return false;
         }
+		d_eventHandler->compileBarFields(d_session->getService(MKTBAR_SVC));
 
         return true;
     }   
@@ -0,0 +1,197 @@
+/* --------------------------------------------------------------------
+ *                          DISCLAIMER OF WARRANTY
+ *
+ * THE CODE SAMPLES PROVIDED IN THIS SDK (IN SOURCE CODE AND BINARY FORM) ARE
+ * PROVIDED "AS IS," WITHOUT A WARRANTY OF ANY KIND. ALL EXPRESS OR IMPLIED
+ * CONDITIONS, REPRESENTATIONS AND WARRANTIES, INCLUDING ANY IMPLIED WARRANTY
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE OR NON-INFRINGEMENT,
+ * ARE HEREBY EXCLUDED. BLOOMBERG AND ITS LICENSORS SHALL NOT BE LIABLE FOR
+ * ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR
+ * DISTRIBUTING THE SOFTWARE OR ITS DERIVATIVES. IN NO EVENT WILL BLOOMBERG
+ * OR ITS LICENSORS BE LIABLE FOR ANY LOST REVENUE, PROFIT OR DATA, OR FOR
+ * DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL, INCIDENTAL OR PUNITIVE DAMAGES,
+ * HOWEVER CAUSED AND REGARDLESS OF THE THEORY OF LIABILITY, ARISING OUT OF
+ * THE USE OF OR INABILITY TO USE SOFTWARE, EVEN IF BLOOMBERG HAS BEEN ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGES.
+ * THE CODE SAMPLES PROVIDED WITH THE B-PIPE SDK ARE NOT INTENDED FOR
+ * PRODUCTION USE, AND IF PUT TO SUCH USE THEY MAY RESULT IN SLOWNESS OR LOSS
+ * OF DATA.
+ * ----------------------------------------------------------------- */
+
+/* --------------------------------------------------------------------
+ * File: NameIndex.h
+ *
+ * Description: This source code defines the NameIndex class, which maps
+ *				a fixed set of Names to small integers so that message
+ *				handlers can switch on them instead of comparing Names
+ *				one after the other.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef _NAMEINDEX_H_
+#define  _NAMEINDEX_H_
+
+#include <blpapi_name.h>
+
+#include <stddef.h>  // size_t
+#include <vector>
+
+/* --------------------------------------------------------------------
+ * Class/Struct : NameIndex
+ * Description  : Open addressing table from Name to an integer value.
+ *				  Names are interned by the API so a Name is looked up
+ *				  by its handle, without touching the name string.
+ *				  Fill the table once at start up; find() may then be
+ *				  called from any number of threads.
+ * --------------------------------------------------------------------*/
+class NameIndex
+{
+    public:
+		/*-------------------------------------------------
+		 * Name			: NameIndex
+		 * Description	: Default constructor, the table is empty
+		 * Arguments	: none
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        NameIndex() : slots_(16)
+        {
+        }
+
+		/*-------------------------------------------------
+		 * Name			: add
+		 * Description	: Maps name to value, replacing any value
+		 *				  already mapped to name
+		 * Arguments	: name is the Name to map
+		 *				  value is its value, must not be NOT_FOUND
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        void add(const BloombergLP::blpapi::Name& name, int value)
+        {
+            Slot& slot = slots_[slotOf(name.impl())];
+            if (slot.handle_ == 0)
+            {
+                slot.handle_ = name.impl();
+                names_.push_back(name);
+            }
+            slot.value_ = value;
+
+            //keep the load factor under one half
+            if (names_.size() * 2 > slots_.size())
+            {
+                grow();
+            }
+        }
+
+		/*-------------------------------------------------
+		 * Name			: reserve
+		 * Description	: Sizes the table for count Names so that
+		 *				  adding them does not rehash
+		 * Arguments	: count is the number of Names
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        void reserve(size_t count)
+        {
+            while (count * 2 > slots_.size())
+            {
+                grow();
+            }
+        }
+
+		/*-------------------------------------------------
+		 * Name			: find
+		 * Description	: Looks up the value of name
+		 * Arguments	: name is the Name to look up
+		 * Returns		: value of name, NOT_FOUND if name
+		 *				  was not added
+		 *-------------------------------------------------*/
+        int find(const BloombergLP::blpapi::Name& name) const
+        {
+            if (name.impl() == 0)
+            {
+                return NOT_FOUND;
+            }
+            const Slot& slot = slots_[slotOf(name.impl())];
+            return slot.handle_ == 0 ? NOT_FOUND : slot.value_;
+        }
+
+		/*-------------------------------------------------
+		 * Name			: size
+		 * Description	: Returns the number of Names added
+		 * Arguments	: none
+		 * Returns		: number of Names
+		 *-------------------------------------------------*/
+        size_t size() const
+        {
+            return names_.size();
+        }
+
+        //value returned by find() for an unknown Name
+        enum { NOT_FOUND = -1 };
+
+    private:
+        struct Slot
+        {
+            Slot() : handle_(0), value_(NOT_FOUND)
+            {
+            }
+
+            //Name handle, 0 for an empty slot
+            blpapi_Name_t *handle_;
+            int value_;
+        };
+
+		/*-------------------------------------------------
+		 * Name			: slotOf
+		 * Description	: Finds the slot holding handle, or the
+		 *				  empty slot where it should be added
+		 * Arguments	: handle is the Name handle
+		 * Returns		: slot index
+		 *-------------------------------------------------*/
+        size_t slotOf(blpapi_Name_t *handle) const
+        {
+            //handles are aligned pointers, drop the low bits
+            size_t hash = reinterpret_cast<size_t>(handle);
+            hash = (hash >> 4) ^ (hash >> 12);
+            size_t mask = slots_.size() - 1;
+            size_t slot = hash & mask;
+            while (slots_[slot].handle_ != 0 && slots_[slot].handle_ != handle)
+            {
+                slot = (slot + 1) & mask;
+            }
+            return slot;
+        }
+
+		/*-------------------------------------------------
+		 * Name			: grow
+		 * Description	: Doubles the table and rehashes all Names
+		 * Arguments	: none
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        void grow()
+        {
+            std::vector<Slot> slots(slots_.size() * 2);
+            slots.swap(slots_);
+            for (size_t i = 0; i < slots.size(); ++i)
+            {
+                if (slots[i].handle_ != 0)
+                {
+                    slots_[slotOf(slots[i].handle_)] = slots[i];
+                }
+            }
+        }
+
+        std::vector<Slot> slots_;
+
+        //copies of the Names added, keep their handles alive
+        std::vector<BloombergLP::blpapi::Name> names_;
+};
+
+#endif
@@ -0,0 +1,203 @@
+/* --------------------------------------------------------------------
+ *                          DISCLAIMER OF WARRANTY
+ *
+ * THE CODE SAMPLES PROVIDED IN THIS SDK (IN SOURCE CODE AND BINARY FORM) ARE
+ * PROVIDED "AS IS," WITHOUT A WARRANTY OF ANY KIND. ALL EXPRESS OR IMPLIED
+ * CONDITIONS, REPRESENTATIONS AND WARRANTIES, INCLUDING ANY IMPLIED WARRANTY
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE OR NON-INFRINGEMENT,
+ * ARE HEREBY EXCLUDED. BLOOMBERG AND ITS LICENSORS SHALL NOT BE LIABLE FOR
+ * ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR
+ * DISTRIBUTING THE SOFTWARE OR ITS DERIVATIVES. IN NO EVENT WILL BLOOMBERG
+ * OR ITS LICENSORS BE LIABLE FOR ANY LOST REVENUE, PROFIT OR DATA, OR FOR
+ * DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL, INCIDENTAL OR PUNITIVE DAMAGES,
+ * HOWEVER CAUSED AND REGARDLESS OF THE THEORY OF LIABILITY, ARISING OUT OF
+ * THE USE OF OR INABILITY TO USE SOFTWARE, EVEN IF BLOOMBERG HAS BEEN ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGES.
+ * THE CODE SAMPLES PROVIDED WITH THE B-PIPE SDK ARE NOT INTENDED FOR
+ * PRODUCTION USE, AND IF PUT TO SUCH USE THEY MAY RESULT IN SLOWNESS OR LOSS
+ * OF DATA.
+ * ----------------------------------------------------------------- */
+
+/* --------------------------------------------------------------------
+ * File: NameTable.h
+ *
+ * Description: This source code defines the NameTable class, which
+ *				resolves a statically declared list of name strings to
+ *				Names in one call and maps them both ways to small
+ *				integers.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef _NAMETABLE_H_
+#define  _NAMETABLE_H_
+
+#include <blpapi_name.h>
+
+#include "NameIndex.h"
+
+#include <stddef.h>  // size_t
+#include <vector>
+
+/* --------------------------------------------------------------------
+ * Class/Struct : NameEntry
+ * Description  : One name of a name list. A const array of NameEntry is
+ *				  initialized by the compiler, it does not touch the API
+ *				  name table before main() the way a global Name does:
+ *
+ *				  const NameEntry SIDE_NAMES[] = {
+ *				      { "BID", SIDE_BID },
+ *				      { "ASK", SIDE_ASK }
+ *				  };
+ * --------------------------------------------------------------------*/
+struct NameEntry
+{
+    //name string, must outlive the NameTable resolving it
+    const char *string_;
+
+    //value of the name, a small integer not less than 0. Several
+    //names may share a value.
+    int value_;
+};
+
+/* --------------------------------------------------------------------
+ * Class/Struct : NameTable
+ * Description  : Resolves lists of NameEntry to Names and maps them to
+ *				  their values and back. The values index a vector so
+ *				  they should be dense, as enum values are.
+ *				  Fill the table once at start up; find() and name()
+ *				  may then be called from any number of threads.
+ * --------------------------------------------------------------------*/
+class NameTable
+{
+    public:
+		/*-------------------------------------------------
+		 * Name			: NameTable
+		 * Description	: Default constructor, the table is empty
+		 * Arguments	: none
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        NameTable()
+        {
+        }
+
+		/*-------------------------------------------------
+		 * Name			: NameTable
+		 * Description	: Constructor, resolves a name list
+		 * Arguments	: entries is the name list
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        template <size_t COUNT>
+        explicit NameTable(const NameEntry (&entries)[COUNT])
+        {
+            add(entries, COUNT);
+        }
+
+		/*-------------------------------------------------
+		 * Name			: add
+		 * Description	: Resolves a name list, replacing the value
+		 *				  of any name already in the table
+		 * Arguments	: entries is the name list
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        template <size_t COUNT>
+        void add(const NameEntry (&entries)[COUNT])
+        {
+            add(entries, COUNT);
+        }
+
+		/*-------------------------------------------------
+		 * Name			: add
+		 * Description	: Resolves a name list, replacing the value
+		 *				  of any name already in the table
+		 * Arguments	: entries is the first entry of the list
+		 *				  count is the number of entries
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        void add(const NameEntry *entries, size_t count)
+        {
+            int maxValue = static_cast<int>(names_.size()) - 1;
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (entries[i].value_ > maxValue)
+                {
+                    maxValue = entries[i].value_;
+                }
+            }
+            names_.resize(maxValue + 1);
+            index_.reserve(index_.size() + count);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                BloombergLP::blpapi::Name name(entries[i].string_);
+                index_.add(name, entries[i].value_);
+
+                //the first name added for a value names it
+                BloombergLP::blpapi::Name& slot = names_[entries[i].value_];
+                if (slot.impl() == 0)
+                {
+                    slot = name;
+                }
+            }
+        }
+
+		/*-------------------------------------------------
+		 * Name			: find
+		 * Description	: Looks up the value of name
+		 * Arguments	: name is the Name to look up
+		 * Returns		: value of name, NOT_FOUND if name is
+		 *				  not in the table
+		 *-------------------------------------------------*/
+        int find(const BloombergLP::blpapi::Name& name) const
+        {
+            return index_.find(name);
+        }
+
+		/*-------------------------------------------------
+		 * Name			: name
+		 * Description	: Looks up the first Name added for value
+		 * Arguments	: value is the value to look up
+		 * Returns		: Name of value, an uninitialized Name if
+		 *				  no name has value
+		 *-------------------------------------------------*/
+        const BloombergLP::blpapi::Name& name(int value) const
+        {
+            if (value < 0 || value >= static_cast<int>(names_.size()))
+            {
+                return none_;
+            }
+            return names_[value];
+        }
+
+		/*-------------------------------------------------
+		 * Name			: size
+		 * Description	: Returns the number of Names in the table
+		 * Arguments	: none
+		 * Returns		: number of Names
+		 *-------------------------------------------------*/
+        size_t size() const
+        {
+            return index_.size();
+        }
+
+        //value returned by find() for an unknown Name
+        enum { NOT_FOUND = NameIndex::NOT_FOUND };
+
+    private:
+        NameIndex index_;
+
+        //Names by value
+        std::vector<BloombergLP::blpapi::Name> names_;
+
+        //returned by name() for a value without a name
+        BloombergLP::blpapi::Name none_;
+};
+
+#endif
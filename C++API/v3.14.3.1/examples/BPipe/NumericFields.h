@@ -0,0 +1,122 @@
+/* --------------------------------------------------------------------
+ *                          DISCLAIMER OF WARRANTY
+ *
+ * THE CODE SAMPLES PROVIDED IN THIS SDK (IN SOURCE CODE AND BINARY FORM) ARE
+ * PROVIDED "AS IS," WITHOUT A WARRANTY OF ANY KIND. ALL EXPRESS OR IMPLIED
+ * CONDITIONS, REPRESENTATIONS AND WARRANTIES, INCLUDING ANY IMPLIED WARRANTY
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE OR NON-INFRINGEMENT,
+ * ARE HEREBY EXCLUDED. BLOOMBERG AND ITS LICENSORS SHALL NOT BE LIABLE FOR
+ * ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR
+ * DISTRIBUTING THE SOFTWARE OR ITS DERIVATIVES. IN NO EVENT WILL BLOOMBERG
+ * OR ITS LICENSORS BE LIABLE FOR ANY LOST REVENUE, PROFIT OR DATA, OR FOR
+ * DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL, INCIDENTAL OR PUNITIVE DAMAGES,
+ * HOWEVER CAUSED AND REGARDLESS OF THE THEORY OF LIABILITY, ARISING OUT OF
+ * THE USE OF OR INABILITY TO USE SOFTWARE, EVEN IF BLOOMBERG HAS BEEN ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGES.
+ * THE CODE SAMPLES PROVIDED WITH THE B-PIPE SDK ARE NOT INTENDED FOR
+ * PRODUCTION USE, AND IF PUT TO SUCH USE THEY MAY RESULT IN SLOWNESS OR LOSS
+ * OF DATA.
+ * ----------------------------------------------------------------- */
+
+/* --------------------------------------------------------------------
+ * File: NumericFields.h
+ *
+ * Description: This source code defines the NumericFields class, the
+ *				list of fields the subscription data stores keep as
+ *				Float64 and the FieldAccessor that extracts them.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef _NUMERICFIELDS_H_
+#define  _NUMERICFIELDS_H_
+
+#include <blpapi_element.h>
+#include <blpapi_name.h>
+#include <blpapi_schema.h>
+#include <blpapi_types.h>
+
+#include <stddef.h>  // size_t
+#include <string>
+#include <vector>
+
+#include "FieldAccessor.h"
+
+/* --------------------------------------------------------------------
+ * Class/Struct : NumericFields
+ * Description  : Fields extracted as Float64 into an array indexed by
+ *				  field id, the position of the field in the list
+ *				  given. Only the first MAX_FIELDS fields are kept, one
+ *				  bit of the extract() result each.
+ * --------------------------------------------------------------------*/
+class NumericFields
+{
+    public:
+        //most fields, one bit of the masks each
+        enum { MAX_FIELDS = FieldAccessor::MAX_EXTRACT_FIELDS };
+
+		/*-------------------------------------------------
+		 * Name			: NumericFields
+		 * Description	: Constructor
+		 * Arguments	: fields are the field names, the first
+		 *				  MAX_FIELDS are used
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        explicit NumericFields(const std::vector<std::string>& fields)
+        : names_(fields.begin(),
+            fields.size() > MAX_FIELDS ? fields.begin() + MAX_FIELDS : fields.end())
+        {
+            //extract() writes field n to values[n]
+            for (size_t i = 0; i < names_.size(); ++i)
+            {
+                accessor_.addField(BloombergLP::blpapi::Name(names_[i].c_str()),
+                    FieldAccessor::FIELD_FLOAT64, i * sizeof(BloombergLP::blpapi::Float64));
+            }
+        }
+
+		/*-------------------------------------------------
+		 * Name			: compile
+		 * Description	: Reads the fields by their position in
+		 *				  the message schema, see
+		 *				  FieldAccessor::compile()
+		 * Arguments	: message is the definition of the messages
+		 * Returns		: true if every field is in the schema
+		 *-------------------------------------------------*/
+        bool compile(const BloombergLP::blpapi::SchemaElementDefinition& message)
+        {
+            return accessor_.compile(message);
+        }
+
+		/*-------------------------------------------------
+		 * Name			: extract
+		 * Description	: Reads the fields of a message that are
+		 *				  present and convert to Float64
+		 * Arguments	: message is the message element
+		 *				  values receives the value of each field
+		 *				  by field id, size() entries
+		 * Returns		: bits of the fields written
+		 *-------------------------------------------------*/
+        unsigned long long extract(const BloombergLP::blpapi::Element& message,
+            BloombergLP::blpapi::Float64 *values) const
+        {
+            return accessor_.extract(message, values);
+        }
+
+        //field name of a field id
+        const std::string& name(int id) const { return names_[id]; }
+        size_t size() const { return names_.size(); }
+        bool empty() const { return names_.empty(); }
+
+    private:
+        std::vector<std::string> names_;
+        FieldAccessor accessor_;
+};
+
+#endif
@@ -33,6 +33,14 @@
  * ----------------------------------------------------------------- */
 #include "OrderBook.h"
 
+#include <stdio.h>   // snprintf
+#include <string.h>  // strncpy, strncmp
+
+namespace {
+	//compile time check that four entries fit in a cache line
+	typedef char EntrySizeCheck[sizeof(BloombergLP::ByOrderBookEntry) == 16 ? 1 : -1];
+}
+
 /* --------------------------------------------------------------------
  * Class/Struct : ByOrderBookEntry
  * Description  : Defines constructors and fields contained in an orderbook
@@ -45,72 +53,212 @@
  * Returns		: none
  *---------------------------------------------------------------*/
 BloombergLP::ByOrderBookEntry::ByOrderBookEntry() :
- broker_(""), price_(0.0f), time_(""), numOrders_(0), size_(0), isValid_(false)
-{}
+ time_(NO_TIME), size_(0), priceBroker_(0xFFFF)
+{
+}
 
 /*----------------------------------------------------------------
  * Name			: ByOrderBookEntry constructor
  * Description	: Constructs a byorder book entry instance 
- * Arguments	: broker is the name of the broker in string
- *				  price is the price of the tick
- *				  t is the tick time
- *				  numOrders is the number of orders
+ * Arguments	: brokerId is the broker interned by the book
+ *				  price is the price of the tick in units of the
+ *				  book's PriceScale
+ *				  t is the tick time in milliseconds since midnight
  *				  size is the size of bid/ask
  * Returns		: none
  *---------------------------------------------------------------*/
- BloombergLP::ByOrderBookEntry::ByOrderBookEntry(std::string broker, float price, std::string t, unsigned int numOders, unsigned int size) :
-broker_(broker), price_(price), time_(t), numOrders_(numOders), size_(size), isValid_(true)
-{}
+ BloombergLP::ByOrderBookEntry::ByOrderBookEntry(unsigned int brokerId, FixedPrice price, unsigned int t, unsigned int size) :
+time_(t == NO_TIME ? NO_TIME - 1 : t), size_(size),
+priceBroker_(((unsigned long long)price << 16) | (brokerId & 0xFFFF))
+{
+}
+
+/*----------------------------------------------------------------
+ * Name			: isValid
+ * Description	: Checks whether the entry is valid
+ * Arguments	: none
+ * Returns		: true if the order  book is valid
+ *				  false if the order book is not valid
+ *---------------------------------------------------------------*/
+bool BloombergLP::ByOrderBookEntry::isValid() const
+{
+  return time_ != NO_TIME;
+}
+
+/*----------------------------------------------------------------
+ * Name			: formatTime
+ * Description	: Formats the tick time as HH:MM:SS.mmm
+ * Arguments	: buffer is where the formatted time is written
+ *				  bufSize is the size of buffer
+ * Returns		: buffer
+ *---------------------------------------------------------------*/
+const char *BloombergLP::ByOrderBookEntry::formatTime(char *buffer, size_t bufSize) const
+{
+  unsigned int t = time_;
+  unsigned int ms = t % 1000; t /= 1000;
+  unsigned int sec = t % 60; t /= 60;
+  unsigned int min = t % 60; t /= 60;
+  snprintf(buffer, bufSize, "%02u:%02u:%02u.%03u", t, min, sec, ms);
+  return buffer;
+}
+
+
+/* --------------------------------------------------------------------
+ * Class/Struct : BrokerCodes
+ * Description  : Interns broker codes into small consecutive ids
+ * --------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------
+ * Name			: BrokerCodes constructor
+ * Description	: Constructs an empty table
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+BloombergLP::BrokerCodes::BrokerCodes()
+	: slots_(64, 0)
+	, count_(0)
+{
+	for (unsigned int i = 0; i < sizeof(chunks_) / sizeof(chunks_[0]); ++i)
+	{
+		chunks_[i] = 0;
+	}
+}
 
 /*----------------------------------------------------------------
- * Name			: ByOrderBookEntry copy constructor
- * Description	: Copy constructor for ByOrderBookEntry
- * Arguments	: cpy is a reference to the ByOrderBookEntry to be copied
+ * Name			: BrokerCodes destructor
+ * Description	: Frees the codes
+ * Arguments	: none
  * Returns		: none
  *---------------------------------------------------------------*/
-BloombergLP::ByOrderBookEntry::ByOrderBookEntry(const ByOrderBookEntry& cpy)
+BloombergLP::BrokerCodes::~BrokerCodes()
 {
-  broker_ = cpy.broker_;
-  price_ = cpy.price_;
-  time_ = cpy.time_;
-  numOrders_ = cpy.numOrders_;
-  size_ = cpy.size_;
-  isValid_ = cpy.isValid_;
+	for (unsigned int i = 0; i < sizeof(chunks_) / sizeof(chunks_[0]); ++i)
+	{
+		delete [] chunks_[i];
+	}
 }
 
 /*----------------------------------------------------------------
- * Name			: ByOrderBookEntry assignment operator
- * Description	: Assignment operator for ByOrderBookEntry
- * Arguments	: rhs is a reference to a ByOrderBookEntry
- * Returns		: a reference to the current object
+ * Name			: intern
+ * Description	: Returns the id of broker, adding it if it is new
+ * Arguments	: broker is the broker code
+ * Returns		: id of the broker, from 0 to size() - 1,
+ *				  NO_BROKER if broker is empty or the table
+ *				  already has MAX_CODES
  *---------------------------------------------------------------*/
-BloombergLP::ByOrderBookEntry& BloombergLP::ByOrderBookEntry::operator= (const ByOrderBookEntry& rhs)
+unsigned int BloombergLP::BrokerCodes::intern(const char *broker)
 {
-  if (this == &rhs)
-  {
-    return *this;
-  }
+	if (broker == 0 || broker[0] == '\0')
+	{
+		return NO_BROKER;
+	}
+	unsigned int slot = slotOf(broker);
+	if (slots_[slot] != 0)
+	{
+		return slots_[slot] - 1;
+	}
+	if (count_ == MAX_CODES)
+	{
+		return NO_BROKER;
+	}
 
-  broker_ = rhs.broker_;
-  price_ = rhs.price_;
-  time_ = rhs.time_;
-  numOrders_ = rhs.numOrders_;
-  size_ = rhs.size_;
-  isValid_ = rhs.isValid_;
+	unsigned int id = count_;
+	Code *&chunk = chunks_[id / CHUNK_SIZE];
+	if (chunk == 0)
+	{
+		chunk = new Code[CHUNK_SIZE];
+	}
+	Code &code = chunk[id % CHUNK_SIZE];
+	strncpy(code.code_, broker, ByOrderBookEntry::BROKER_SIZE - 1);
+	code.code_[ByOrderBookEntry::BROKER_SIZE - 1] = '\0';
+	slots_[slot] = ++count_;
 
-  return *this;
+	//keep the load factor under one half
+	if (count_ * 2 > slots_.size())
+	{
+		grow();
+	}
+	return id;
 }
 
 /*----------------------------------------------------------------
- * Name			: isValid
- * Description	: Checks whether the entry is valid
+ * Name			: find
+ * Description	: Returns the id of broker without adding it
+ * Arguments	: broker is the broker code
+ * Returns		: id of the broker, NO_BROKER if it is unknown
+ *---------------------------------------------------------------*/
+unsigned int BloombergLP::BrokerCodes::find(const char *broker) const
+{
+	if (broker == 0 || broker[0] == '\0')
+	{
+		return NO_BROKER;
+	}
+	unsigned int slot = slotOf(broker);
+	return slots_[slot] == 0 ? NO_BROKER : slots_[slot] - 1;
+}
+
+/*----------------------------------------------------------------
+ * Name			: size
+ * Description	: Returns the number of interned brokers
  * Arguments	: none
- * Returns		: true if the order  book is valid
- *				  false if the order book is not valid
+ * Returns		: number of brokers
  *---------------------------------------------------------------*/
-bool BloombergLP::ByOrderBookEntry::isValid() const
+unsigned int BloombergLP::BrokerCodes::size() const
+{
+	return count_;
+}
+
+/*----------------------------------------------------------------
+ * Name			: code
+ * Description	: Returns the code of an interned broker
+ * Arguments	: id is an id returned by intern()
+ * Returns		: broker code
+ *---------------------------------------------------------------*/
+const char *BloombergLP::BrokerCodes::code(unsigned int id) const
+{
+	return chunks_[id / CHUNK_SIZE][id % CHUNK_SIZE].code_;
+}
+
+/*----------------------------------------------------------------
+ * Name			: slotOf
+ * Description	: Finds the slot holding broker, or the empty
+ *				  slot where it should be added. Codes longer than
+ *				  BROKER_SIZE - 1 are compared on their stored prefix.
+ * Arguments	: broker is the broker code
+ * Returns		: slot index
+ *---------------------------------------------------------------*/
+unsigned int BloombergLP::BrokerCodes::slotOf(const char *broker) const
+{
+	//FNV-1a
+	unsigned int hash = 2166136261u;
+	for (unsigned int i = 0; i < ByOrderBookEntry::BROKER_SIZE - 1 && broker[i] != '\0'; ++i)
+	{
+		hash = (hash ^ (unsigned char)broker[i]) * 16777619u;
+	}
+
+	unsigned int mask = (unsigned int)slots_.size() - 1;
+	unsigned int slot = hash & mask;
+	while (slots_[slot] != 0 &&
+		strncmp(code(slots_[slot] - 1), broker, ByOrderBookEntry::BROKER_SIZE - 1) != 0)
+	{
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+/*----------------------------------------------------------------
+ * Name			: grow
+ * Description	: Doubles the hash table and rehashes all codes
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::BrokerCodes::grow()
 {
-  return isValid_;
+	slots_.assign(slots_.size() * 2, 0);
+	for (unsigned int id = 0; id < count_; ++id)
+	{
+		slots_[slotOf(code(id))] = id + 1;
+	}
 }
 
 
@@ -130,7 +278,7 @@ BloombergLP::ByOrderBook::ByOrderBook()
 	: window_size(0)
 	, valid(false)
 	, book_type("")
-	, max_num_decimals(3)
+	, staleFrom_(NO_POSITION)
 {
 }
 
@@ -153,9 +301,10 @@ BloombergLP::ByOrderBook::ByOrderBook()
 void BloombergLP::ByOrderBook::doAdd( unsigned int pos, const ByOrderBookEntry& entry )
 {
 	Guard guard(lock_cache_);
-	if (entries_.size() <= pos)
+	//pad missing positions, the new entry goes at pos
+	if (entries_.size() < pos)
 	{
-		entries_.resize(pos+1);
+		entries_.resize(pos);
 	}
 
 	entries_.insert(entries_.begin()+pos, entry);
@@ -165,6 +314,8 @@ void BloombergLP::ByOrderBook::doAdd( unsigned int pos, const ByOrderBookEntry&
 	{
 		entries_.erase(entries_.begin() + window_size, entries_.end());
 	}
+	markStale(pos);
+	publish(pos);
 }
 
 /*----------------------------------------------------------------
@@ -181,6 +332,7 @@ void BloombergLP::ByOrderBook::doClearAll()
 {
 	Guard guard(lock_cache_);
 	entries_.clear();
+	publish(0);
 }
 
 /*----------------------------------------------------------------
@@ -205,6 +357,8 @@ void BloombergLP::ByOrderBook::doDel( unsigned int pos )
 	}
 
 	entries_.erase(entries_.begin()+pos);
+	markStale(pos);
+	publish(pos);
 }
 
 /*----------------------------------------------------------------
@@ -219,6 +373,7 @@ void BloombergLP::ByOrderBook::doDelAll()
 {
 	Guard guard(lock_cache_);
 	entries_.clear();
+	publish(0);
 }
 
 /*----------------------------------------------------------------
@@ -234,6 +389,8 @@ void BloombergLP::ByOrderBook::doDelBetter(unsigned int pos)
 {
 	Guard guard(lock_cache_);
 	entries_.erase(entries_.begin(), entries_.begin() + pos);
+	markStale(0);
+	publish(0);
 }
 
 /*----------------------------------------------------------------
@@ -246,6 +403,7 @@ void BloombergLP::ByOrderBook::doDelSide()
 {
 	Guard guard(lock_cache_);
 	entries_.clear();
+	publish(0);
 }
 
 
@@ -263,6 +421,8 @@ void BloombergLP::ByOrderBook::doExec(unsigned int pos, const ByOrderBookEntry&
 	Guard guard(lock_cache_);
 	entries_[pos] = entry;
 	entries_.erase(entries_.begin(), entries_.begin() + pos);
+	markStale(0);
+	publish(0);
 }
 
 /*----------------------------------------------------------------
@@ -279,6 +439,8 @@ void BloombergLP::ByOrderBook::doMod( unsigned int pos, const ByOrderBookEntry&
 {
 	Guard guard(lock_cache_);
 	entries_[pos] = entry;
+	markStale(pos);
+	publish(pos);
 }
 
 /*----------------------------------------------------------------
@@ -299,6 +461,8 @@ void BloombergLP::ByOrderBook::doReplace( unsigned int pos, const ByOrderBookEnt
 		entries_.resize(pos + 1);
 	}
 	entries_[pos] = entry;
+	markStale(pos);
+	publish(pos);
 }
 
 /*----------------------------------------------------------------
@@ -310,37 +474,39 @@ void BloombergLP::ByOrderBook::doReplace( unsigned int pos, const ByOrderBookEnt
  *				  If that broker is not present, it should added to the cache. 
  *				  If the price and size for a broker is set to 0, 
  *				  the broker should be deleted from the cache. 
+ *				  Entries without a broker are ignored.
  * Arguments	: entry is the new book entry
  * Returns		: none
  *---------------------------------------------------------------*/
-void BloombergLP::ByOrderBook::doReplaceByBroker(ByOrderBookEntry& entry )
+void BloombergLP::ByOrderBook::doReplaceByBroker(const ByOrderBookEntry& entry )
 {
 	Guard guard(lock_cache_);
-	if(entry.price_ == 0 && entry.size_ == 0)
+	unsigned int brokerId = entry.brokerId();
+	if(brokerId == NO_BROKER)
 	{
-		doDeleteByBroker(entry.broker_);
 		return;
 	}
-
-	std::deque<ByOrderBookEntry>::iterator it;
-	for(it = entries_.begin(); it!= entries_.end(); ++it)
+	if(entry.price() == 0 && entry.size_ == 0)
 	{
-		if(it->broker_ == entry.broker_)
-		{
-			break;
-		}
+		deleteBroker(brokerId);
+		return;
 	}
-  
-	if(it == entries_.end())
+
+	unsigned int pos = findBroker(brokerId);
+
+	if(pos == NO_POSITION)
 	{
 		//add entry
+		pos = (unsigned int)entries_.size();
 		entries_.push_back(entry);
+		brokerPos_[brokerId] = pos;
 	}
 	else
 	{
-		//modify entry
-		*it = entry;
+		//modify entry, the broker keeps its position
+		entries_[pos] = entry;
 	}
+	publish(pos);
 }
 
 /*----------------------------------------------------------------
@@ -364,6 +530,8 @@ void BloombergLP::ByOrderBook::doReplaceClear( unsigned int pos )
 	Guard guard(lock_cache_);
 	ByOrderBookEntry clearEntry;
 	entries_[pos] = clearEntry;
+	markStale(pos);
+	publish(pos);
 }
 
 //----helper functions---
@@ -373,25 +541,51 @@ void BloombergLP::ByOrderBook::doReplaceClear( unsigned int pos )
  * Arguments	: broker is the broker code in string
  * Returns		: none
  *---------------------------------------------------------------*/
-void BloombergLP::ByOrderBook::doDeleteByBroker(std::string& broker)
+void BloombergLP::ByOrderBook::doDeleteByBroker(const char *broker)
 {
 	Guard guard(lock_cache_);
-	if(broker.empty())
+	if(broker[0] == '\0')
 		return;
 	
-	std::deque<ByOrderBookEntry>::iterator it;
-	for(it = entries_.begin(); it!= entries_.end(); ++it)
+	unsigned int brokerId = brokers_.find(broker);
+	if(brokerId == NO_BROKER)
+		return;
+
+	deleteBroker(brokerId);
+}
+
+/*----------------------------------------------------------------
+ * Name			: internBroker
+ * Description	: Returns the id entries of this book use for a
+ *				  broker code, adding the code if it is new
+ * Arguments	: broker is the broker code
+ * Returns		: broker id, NO_BROKER for an empty code or
+ *				  once the book is full
+ *---------------------------------------------------------------*/
+unsigned int BloombergLP::ByOrderBook::internBroker(const char *broker)
+{
+	if (broker == 0 || broker[0] == '\0')
 	{
-		if(it->broker_ == broker)
-		{
-			break;
-		}
+		return NO_BROKER;
 	}
-
-	if(it != entries_.end())
+	Guard guard(lock_cache_);
+	unsigned int brokerId = brokers_.intern(broker);
+	if (brokerPos_.size() < brokers_.size())
 	{
-		entries_.erase(it);
+		brokerPos_.resize(brokers_.size(), NO_POSITION);
 	}
+	return brokerId;
+}
+
+/*----------------------------------------------------------------
+ * Name			: brokerCode
+ * Description	: Returns the code of a broker id without locking
+ * Arguments	: brokerId is the broker of an entry of this book
+ * Returns		: broker code, empty for NO_BROKER
+ *---------------------------------------------------------------*/
+const char *BloombergLP::ByOrderBook::brokerCode(unsigned int brokerId) const
+{
+	return brokerId == NO_BROKER ? "" : brokers_.code(brokerId);
 }
 
 /*----------------------------------------------------------------
@@ -425,4 +619,235 @@ bool BloombergLP::ByOrderBook::getEntry( unsigned int pos, ByOrderBookEntry& ent
   return false;
 }
 
+/*----------------------------------------------------------------
+ * Name			: getTopLevel
+ * Description	: Returns the best price level, the run of valid
+ *				  entries from position 0 that share its price
+ * Arguments	: entry is where the best entry should be stored
+ *				  size is where the total size of the level is stored
+ *				  numOrders is where the number of orders is stored
+ * Returns		: true if the best entry is valid
+ *				  false if the book is empty or invalid at the top
+ *---------------------------------------------------------------*/
+bool BloombergLP::ByOrderBook::getTopLevel(ByOrderBookEntry& entry, unsigned int& size, unsigned int& numOrders)
+{
+	Guard guard(lock_cache_);
+	size = 0;
+	numOrders = 0;
+	if (entries_.empty() || !entries_[0].isValid())
+	{
+		return false;
+	}
+	entry = entries_[0];
+	unsigned int count = (unsigned int)entries_.size();
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		const ByOrderBookEntry& order = entries_[i];
+		if (!order.isValid() || order.price() != entry.price())
+		{
+			break;
+		}
+		size += order.size_;
+		++numOrders;
+	}
+	return true;
+}
+
+/*----------------------------------------------------------------
+ * Name			: setSnapshotDepth
+ * Description	: Turns on snapshot publication of the top depth entries
+ * Arguments	: depth is the number of entries published, 0 turns
+ *				  publication off
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::ByOrderBook::setSnapshotDepth(unsigned int depth)
+{
+	Guard guard(lock_cache_);
+	snapshot_.setDepth(depth);
+	publish(0);
+}
+
+/*----------------------------------------------------------------
+ * Name			: getSnapshot
+ * Description	: Copies the last published top of book without
+ *				  locking. Can be called from any thread.
+ * Arguments	: entries is where the entries should be stored
+ *				  maxEntries is the size of entries
+ *				  scale receives the scale of the entry prices,
+ *				  may be 0
+ * Returns		: number of entries copied
+ *---------------------------------------------------------------*/
+unsigned int BloombergLP::ByOrderBook::getSnapshot(ByOrderBookEntry *entries, unsigned int maxEntries,
+	PriceScale *scale) const
+{
+	unsigned int decimals;
+	unsigned int count = snapshot_.read(entries, maxEntries, &decimals);
+	if (scale != 0)
+	{
+		scale->setDecimals(decimals);
+	}
+	return count;
+}
+
+/*----------------------------------------------------------------
+ * Name			: setPriceDecimals
+ * Description	: Sets the number of decimals the book starts with.
+ *				  The entries already stored are not rescaled.
+ * Arguments	: decimals is the number of decimals
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::ByOrderBook::setPriceDecimals(unsigned int decimals)
+{
+	Guard guard(lock_cache_);
+	priceScale_.setDecimals(decimals);
+	publish(0);
+}
 
+/*----------------------------------------------------------------
+ * Name			: widenPriceScale
+ * Description	: Raises the number of decimals of the book and
+ *				  rescales the entries. Stops short of decimals if
+ *				  an entry would saturate.
+ * Arguments	: decimals is the number of decimals wanted
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::ByOrderBook::widenPriceScale(unsigned int decimals)
+{
+	Guard guard(lock_cache_);
+	if (decimals <= priceScale_.decimals())
+	{
+		return;
+	}
+
+	//the largest price must still fit once rescaled
+	FixedPrice largest = 0;
+	for (std::deque<ByOrderBookEntry>::iterator it = entries_.begin(); it != entries_.end(); ++it)
+	{
+		FixedPrice price = it->price() < 0 ? -it->price() : it->price();
+		if (price > largest)
+		{
+			largest = price;
+		}
+	}
+	const PriceScale from = priceScale_;
+	PriceScale to(decimals);
+	while (to.decimals() > from.decimals()
+		&& to.convert(largest, from) == PriceScale::maxUnits())
+	{
+		to.setDecimals(to.decimals() - 1);
+	}
+	if (to.decimals() == from.decimals())
+	{
+		return;
+	}
+
+	priceScale_ = to;
+	for (std::deque<ByOrderBookEntry>::iterator it = entries_.begin(); it != entries_.end(); ++it)
+	{
+		it->setPrice(priceScale_.convert(it->price(), from));
+	}
+	publish(0);
+}
+
+/*----------------------------------------------------------------
+ * Name			: priceScale
+ * Description	: Returns the scale of the prices in the book
+ * Arguments	: none
+ * Returns		: price scale
+ *---------------------------------------------------------------*/
+const PriceScale& BloombergLP::ByOrderBook::priceScale() const
+{
+	return priceScale_;
+}
+
+/*----------------------------------------------------------------
+ * Name			: publish
+ * Description	: Publishes the top of book if pos is within the
+ *				  snapshot depth. Called with lock_cache_ held.
+ * Arguments	: pos is the best position changed
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::ByOrderBook::publish(unsigned int pos)
+{
+	if (pos < snapshot_.depth())
+	{
+		snapshot_.publish(entries_.begin(), (unsigned int)entries_.size(), priceScale_.decimals());
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: deleteBroker
+ * Description	: Deletes the best entry of a broker. Called with
+ *				  lock_cache_ held.
+ * Arguments	: brokerId is the interned broker code
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::ByOrderBook::deleteBroker(unsigned int brokerId)
+{
+	unsigned int pos = findBroker(brokerId);
+	if(pos != NO_POSITION)
+	{
+		entries_.erase(entries_.begin() + pos);
+		markStale(pos);
+		publish(pos);
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: findBroker
+ * Description	: Looks up the best position of a broker, first
+ *				  bringing the index up to date if a positional
+ *				  command moved entries since the last lookup
+ * Arguments	: brokerId is the interned broker code
+ * Returns		: position, NO_POSITION if the broker is not in the book
+ *---------------------------------------------------------------*/
+unsigned int BloombergLP::ByOrderBook::findBroker(unsigned int brokerId)
+{
+	if (staleFrom_ != NO_POSITION)
+	{
+		reindex(staleFrom_);
+		staleFrom_ = NO_POSITION;
+	}
+	unsigned int pos = brokerPos_[brokerId];
+	if (pos < entries_.size() && entries_[pos].brokerId() == brokerId)
+	{
+		return pos;
+	}
+	return NO_POSITION;
+}
+
+/*----------------------------------------------------------------
+ * Name			: reindex
+ * Description	: Brings the broker index up to date after the
+ *				  entries from first onwards have moved or changed
+ * Arguments	: first is the best position changed
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::ByOrderBook::reindex(unsigned int first)
+{
+	unsigned int count = (unsigned int)entries_.size();
+
+	//forget brokers whose best position is not a valid one before first
+	for (unsigned int i = first; i < count; ++i)
+	{
+		unsigned int brokerId = entries_[i].brokerId();
+		if (brokerId != NO_BROKER)
+		{
+			unsigned int pos = brokerPos_[brokerId];
+			if (pos >= first || pos >= count || entries_[pos].brokerId() != brokerId)
+			{
+				brokerPos_[brokerId] = NO_POSITION;
+			}
+		}
+	}
+
+	//the first position seen from first onwards is the best one
+	for (unsigned int i = first; i < count; ++i)
+	{
+		unsigned int brokerId = entries_[i].brokerId();
+		if (brokerId != NO_BROKER && brokerPos_[brokerId] == NO_POSITION)
+		{
+			brokerPos_[brokerId] = i;
+		}
+	}
+}
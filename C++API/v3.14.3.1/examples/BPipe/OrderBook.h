@@ -36,12 +36,16 @@
 #define __OrderBook_h__
 
 #include <time.h>    // time_t
+#include <stddef.h>  // size_t
 
 #include <deque>
+#include <vector>
 #include <iostream>
 #include <string>
 #include <sstream>
 #include "SyncIO.h"
+#include "SeqLock.h"
+#include "FixedPrice.h"
 
 using namespace std;
 
@@ -49,12 +53,25 @@ namespace BloombergLP
 {
 
 	
+	//broker id of an entry that has not been interned
+	const unsigned int NO_BROKER = 0xFFFFFFFFu;
+
 	/* --------------------------------------------------------------------
 	 * Class/Struct : ByOrderBookEntry
-	 * Description  : Defines constructors and fields contained in an orderbook
+	 * Description  : Defines constructors and fields contained in an orderbook.
+	 *				  The entry is a plain value type (no heap owned members)
+	 *				  so that it can be published to readers with memcpy.
+	 *				  The broker is held as the id ByOrderBook::internBroker()
+	 *				  returned, ByOrderBook::brokerCode() gives the code back.
 	 * --------------------------------------------------------------------*/
 	struct ByOrderBookEntry
 	{
+		//maximum broker code length including the terminating null
+		enum { BROKER_SIZE = 16 };
+
+		//time of an entry that holds no order
+		enum { NO_TIME = 0xFFFFFFFFu };
+
 		/*----------------------------------------------------------------
 		 * Name			: ByOrderBookEntry default constructor
 		 * Description	: Constructs a byorder book entry with 0 price, size, orders
@@ -66,30 +83,14 @@ namespace BloombergLP
 		/*----------------------------------------------------------------
 		 * Name			: ByOrderBookEntry constructor
 		 * Description	: Constructs a byorder book entry instance 
-		 * Arguments	: broker is the name of the broker in string
-		 *				  price is the price of the tick
-		 *				  t is the tick time
-		 *				  numOrders is the number of orders
+		 * Arguments	: brokerId is the broker interned by the book
+		 *				  price is the price of the tick in units of the
+		 *				  book's PriceScale
+		 *				  t is the tick time in milliseconds since midnight
 		 *				  size is the size of bid/ask
 		 * Returns		: none
 		 *---------------------------------------------------------------*/
-		ByOrderBookEntry(std::string broker, float price, std::string t, unsigned int numOders, unsigned int size);
-
-		/*----------------------------------------------------------------
-		 * Name			: ByOrderBookEntry copy constructor
-		 * Description	: Copy constructor for ByOrderBookEntry
-		 * Arguments	: cpy is a reference to the ByOrderBookEntry to be copied
-		 * Returns		: none
-		 *---------------------------------------------------------------*/
-		ByOrderBookEntry(const ByOrderBookEntry& cpy);
-
-		/*----------------------------------------------------------------
-		 * Name			: ByOrderBookEntry assignment operator
-		 * Description	: Assignment operator for ByOrderBookEntry
-		 * Arguments	: rhs is a reference to a ByOrderBookEntry
-		 * Returns		: a reference to the current object
-		 *---------------------------------------------------------------*/
-		ByOrderBookEntry& operator= (const ByOrderBookEntry& rhs);
+		ByOrderBookEntry(unsigned int brokerId, FixedPrice price, unsigned int t, unsigned int size);
 
 
 		/*----------------------------------------------------------------
@@ -101,23 +102,165 @@ namespace BloombergLP
 		 *---------------------------------------------------------------*/
 		bool isValid() const;
 
-		//the broker code
-		std::string broker_;
+		/*----------------------------------------------------------------
+		 * Name			: price
+		 * Description	: Returns the price of the order
+		 * Arguments	: none
+		 * Returns		: price in units of the book's PriceScale
+		 *---------------------------------------------------------------*/
+		FixedPrice price() const
+		{
+			return (FixedPrice)(long long)priceBroker_ >> 16;
+		}
+
+		/*----------------------------------------------------------------
+		 * Name			: brokerId
+		 * Description	: Returns the interned broker of the order
+		 * Arguments	: none
+		 * Returns		: broker id, NO_BROKER if there is none
+		 *---------------------------------------------------------------*/
+		unsigned int brokerId() const
+		{
+			unsigned int id = (unsigned int)(priceBroker_ & 0xFFFF);
+			return id == 0xFFFF ? NO_BROKER : id;
+		}
 
-		//price of bid or ask
-		double  price_;
+		/*----------------------------------------------------------------
+		 * Name			: setPrice
+		 * Description	: Changes the price, keeping the broker
+		 * Arguments	: price is in units of the book's PriceScale
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		void setPrice(FixedPrice price)
+		{
+			priceBroker_ = ((unsigned long long)price << 16) | (priceBroker_ & 0xFFFF);
+		}
 
-		//tick time
-		std::string time_;
+		/*----------------------------------------------------------------
+		 * Name			: formatTime
+		 * Description	: Formats the tick time as HH:MM:SS.mmm
+		 * Arguments	: buffer is where the formatted time is written
+		 *				  bufSize is the size of buffer
+		 * Returns		: buffer
+		 *---------------------------------------------------------------*/
+		const char *formatTime(char *buffer, size_t bufSize) const;
 
-		//number of orders
-		unsigned int numOrders_;
+		//tick time in milliseconds since midnight, NO_TIME if the
+		//entry is not valid
+		unsigned int time_;
 
 		//bid or ask size
 		unsigned int size_;
 
-		//indicates whether the entry is valid or not
-		bool isValid_;
+	private:
+		//price in the high 48 bits, broker id in the low 16 with
+		//0xFFFF for NO_BROKER, so that an entry is 16 bytes
+		unsigned long long priceBroker_;
+	};
+
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : BrokerCodes
+	 * Description  : Interns broker codes into small consecutive ids using
+	 *				  an open addressing hash table, so the order book can
+	 *				  compare brokers as integers. Ids are never released.
+	 *				  Codes are stored in chunks that never move, so code()
+	 *				  can be called without the lock held by intern().
+	 * --------------------------------------------------------------------*/
+	class BrokerCodes
+	{
+	public:
+		//most brokers a table holds, the id fits in 16 bits
+		enum { MAX_CODES = 0xFFFF };
+
+		/*----------------------------------------------------------------
+		 * Name			: BrokerCodes constructor
+		 * Description	: Constructs an empty table
+		 * Arguments	: none
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		BrokerCodes();
+
+		/*----------------------------------------------------------------
+		 * Name			: BrokerCodes destructor
+		 * Description	: Frees the codes
+		 * Arguments	: none
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		~BrokerCodes();
+
+		/*----------------------------------------------------------------
+		 * Name			: intern
+		 * Description	: Returns the id of broker, adding it if it is new
+		 * Arguments	: broker is the broker code
+		 * Returns		: id of the broker, from 0 to size() - 1,
+		 *				  NO_BROKER if broker is empty or the table
+		 *				  already has MAX_CODES
+		 *---------------------------------------------------------------*/
+		unsigned int intern(const char *broker);
+
+		/*----------------------------------------------------------------
+		 * Name			: find
+		 * Description	: Returns the id of broker without adding it
+		 * Arguments	: broker is the broker code
+		 * Returns		: id of the broker, NO_BROKER if it is unknown
+		 *---------------------------------------------------------------*/
+		unsigned int find(const char *broker) const;
+
+		/*----------------------------------------------------------------
+		 * Name			: code
+		 * Description	: Returns the code of an interned broker
+		 * Arguments	: id is an id returned by intern()
+		 * Returns		: broker code
+		 *---------------------------------------------------------------*/
+		const char *code(unsigned int id) const;
+
+		/*----------------------------------------------------------------
+		 * Name			: size
+		 * Description	: Returns the number of interned brokers
+		 * Arguments	: none
+		 * Returns		: number of brokers
+		 *---------------------------------------------------------------*/
+		unsigned int size() const;
+
+	private:
+		//codes per chunk
+		enum { CHUNK_SIZE = 256 };
+
+		struct Code
+		{
+			char code_[ByOrderBookEntry::BROKER_SIZE];
+		};
+
+		// Unimplemented
+		BrokerCodes(const BrokerCodes&);
+		BrokerCodes& operator=(const BrokerCodes&);
+
+		/*----------------------------------------------------------------
+		 * Name			: slotOf
+		 * Description	: Finds the slot holding broker, or the empty
+		 *				  slot where it should be added
+		 * Arguments	: broker is the broker code
+		 * Returns		: slot index
+		 *---------------------------------------------------------------*/
+		unsigned int slotOf(const char *broker) const;
+
+		/*----------------------------------------------------------------
+		 * Name			: grow
+		 * Description	: Doubles the hash table and rehashes all codes
+		 * Arguments	: none
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		void grow();
+
+		//hash slots holding id + 1, 0 for an empty slot
+		std::vector<unsigned int> slots_;
+
+		//broker codes by id, CHUNK_SIZE to a chunk
+		Code *chunks_[(MAX_CODES + CHUNK_SIZE - 1) / CHUNK_SIZE];
+
+		//number of interned brokers
+		unsigned int count_;
 	};
 
 
@@ -146,6 +289,8 @@ namespace BloombergLP
 		//ack message
 		bool valid;
 
+		//MD_BOOK_TYPE of the last init paint; not published with the
+		//snapshot, readers and the writer share a lock of the caller
 		std::string book_type;
 
 	
@@ -271,10 +416,11 @@ namespace BloombergLP
 	 *				  If that broker is not present, it should added to the cache. 
 	 *				  If the price and size for a broker is set to 0, 
 	 *				  the broker should be deleted from the cache. 
+	 *				  Entries without a broker are ignored.
 	 * Arguments	: entry is the new book entry
 	 * Returns		: none
 	 *---------------------------------------------------------------*/
-	void doReplaceByBroker(ByOrderBookEntry& entry);
+	void doReplaceByBroker(const ByOrderBookEntry& entry);
 
 	/*----------------------------------------------------------------
 	 * Name			: doReplaceClear
@@ -301,7 +447,7 @@ namespace BloombergLP
 	 * Arguments	: broker is the broker code in string
 	 * Returns		: none
 	 *---------------------------------------------------------------*/
-	void doDeleteByBroker(std::string& broker);
+	void doDeleteByBroker(const char *broker);
 
 	/*----------------------------------------------------------------
 	 * Name			: size
@@ -321,12 +467,173 @@ namespace BloombergLP
 	 *---------------------------------------------------------------*/
 	bool getEntry(unsigned int pos, ByOrderBookEntry& entry);
 
-	//maximum number of decimal places for output
-	unsigned int max_num_decimals;
+	/*----------------------------------------------------------------
+	 * Name			: getTopLevel
+	 * Description	: Returns the best price level, the run of valid
+	 *				  entries from position 0 that share its price
+	 * Arguments	: entry is where the best entry should be stored
+	 *				  size is where the total size of the level is stored
+	 *				  numOrders is where the number of orders is stored
+	 * Returns		: true if the best entry is valid
+	 *				  false if the book is empty or invalid at the top
+	 *---------------------------------------------------------------*/
+	bool getTopLevel(ByOrderBookEntry& entry, unsigned int& size, unsigned int& numOrders);
+
+	/*----------------------------------------------------------------
+	 * Name			: setSnapshotDepth
+	 * Description	: Turns on snapshot publication. After each change to
+	 *				  the top depth entries the book publishes them through
+	 *				  a sequence lock, so getSnapshot() never takes
+	 *				  lock_cache_ and never blocks the thread updating the
+	 *				  book. Call it before the subscription starts.
+	 * Arguments	: depth is the number of entries published, 0 turns
+	 *				  publication off
+	 * Returns		: none
+	 *---------------------------------------------------------------*/
+	void setSnapshotDepth(unsigned int depth);
+
+	/*----------------------------------------------------------------
+	 * Name			: getSnapshot
+	 * Description	: Copies the last published top of book without
+	 *				  locking. Can be called from any thread.
+	 * Arguments	: entries is where the entries should be stored
+	 *				  maxEntries is the size of entries
+	 *				  scale receives the scale of the entry prices,
+	 *				  may be 0
+	 * Returns		: number of entries copied
+	 *---------------------------------------------------------------*/
+	unsigned int getSnapshot(ByOrderBookEntry *entries, unsigned int maxEntries,
+		PriceScale *scale = 0) const;
+
+	/*----------------------------------------------------------------
+	 * Name			: internBroker
+	 * Description	: Returns the id entries of this book use for a
+	 *				  broker code, adding the code if it is new
+	 * Arguments	: broker is the broker code, truncated to
+	 *				  ByOrderBookEntry::BROKER_SIZE - 1 characters
+	 * Returns		: broker id, NO_BROKER for an empty code or
+	 *				  once the book has BrokerCodes::MAX_CODES brokers
+	 *---------------------------------------------------------------*/
+	unsigned int internBroker(const char *broker);
+
+	/*----------------------------------------------------------------
+	 * Name			: brokerCode
+	 * Description	: Returns the code of a broker id without locking.
+	 *				  Can be called from any thread.
+	 * Arguments	: brokerId is the broker of an entry of this book
+	 * Returns		: broker code, empty for NO_BROKER
+	 *---------------------------------------------------------------*/
+	const char *brokerCode(unsigned int brokerId) const;
+
+	/*----------------------------------------------------------------
+	 * Name			: setPriceDecimals
+	 * Description	: Sets the number of decimals the book starts
+	 *				  with. Call it before the subscription starts,
+	 *				  the entries already stored are not rescaled.
+	 * Arguments	: decimals is the number of decimals
+	 * Returns		: none
+	 *---------------------------------------------------------------*/
+	void setPriceDecimals(unsigned int decimals);
+
+	/*----------------------------------------------------------------
+	 * Name			: widenPriceScale
+	 * Description	: Raises the number of decimals of the book and
+	 *				  rescales the entries, so a price needing more
+	 *				  decimals is held exactly. Stops short of
+	 *				  decimals if an entry would saturate.
+	 * Arguments	: decimals is the number of decimals wanted
+	 * Returns		: none
+	 *---------------------------------------------------------------*/
+	void widenPriceScale(unsigned int decimals);
+
+	/*----------------------------------------------------------------
+	 * Name			: priceScale
+	 * Description	: Returns the scale of the prices in the book.
+	 *				  Only the thread updating the book may call it,
+	 *				  other threads get the scale from getSnapshot().
+	 * Arguments	: none
+	 * Returns		: price scale
+	 *---------------------------------------------------------------*/
+	const PriceScale& priceScale() const;
 
 	protected:
+	//position of a broker that is not in the book
+	enum { NO_POSITION = 0xFFFFFFFFu };
+
+	/*----------------------------------------------------------------
+	 * Name			: deleteBroker
+	 * Description	: Deletes the best entry of a broker. Called with
+	 *				  lock_cache_ held.
+	 * Arguments	: brokerId is the interned broker code
+	 * Returns		: none
+	 *---------------------------------------------------------------*/
+	void deleteBroker(unsigned int brokerId);
+
+	/*----------------------------------------------------------------
+	 * Name			: findBroker
+	 * Description	: Looks up the best position of a broker, first
+	 *				  reindexing from staleFrom_ if entries moved since
+	 *				  the last lookup, so that books fed only positional
+	 *				  commands never pay for the index
+	 * Arguments	: brokerId is the interned broker code
+	 * Returns		: position, NO_POSITION if the broker is not in the book
+	 *---------------------------------------------------------------*/
+	unsigned int findBroker(unsigned int brokerId);
+
+	/*----------------------------------------------------------------
+	 * Name			: markStale
+	 * Description	: Records that the entries from first onwards have
+	 *				  moved or changed, the next findBroker() reindexes
+	 *				  them. Called with lock_cache_ held.
+	 * Arguments	: first is the best position changed
+	 * Returns		: none
+	 *---------------------------------------------------------------*/
+	void markStale(unsigned int first)
+	{
+		if (first < staleFrom_)
+		{
+			staleFrom_ = first;
+		}
+	}
+
+	/*----------------------------------------------------------------
+	 * Name			: reindex
+	 * Description	: Brings the broker index up to date after the
+	 *				  entries from first onwards have moved or changed.
+	 *				  Entries before first must be unchanged. The cost
+	 *				  is the number of entries after first. Called with
+	 *				  lock_cache_ held.
+	 * Arguments	: first is the best position changed
+	 * Returns		: none
+	 *---------------------------------------------------------------*/
+	void reindex(unsigned int first);
+
+	/*----------------------------------------------------------------
+	 * Name			: publish
+	 * Description	: Publishes the top of book if pos is within the
+	 *				  snapshot depth. Called with lock_cache_ held.
+	 * Arguments	: pos is the best position changed
+	 * Returns		: none
+	 *---------------------------------------------------------------*/
+	void publish(unsigned int pos);
+
 	std::deque<ByOrderBookEntry> entries_;
+
+	//interned broker codes of this book
+	BrokerCodes brokers_;
+
+	PriceScale priceScale_;
+
+	//best position of each broker by id. An entry is only
+	//trusted if entries_ holds that broker at that position.
+	std::vector<unsigned int> brokerPos_;
+
+	//first position brokerPos_ may be out of date for,
+	//NO_POSITION if it is up to date
+	unsigned int staleFrom_;
+
 	SyncIO lock_cache_;
+	BookSnapshot<ByOrderBookEntry> snapshot_;
 	};
 }
 
@@ -0,0 +1,459 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: RefDataBatcher.cpp
+ *
+ * Description: This file contains the RefDataBatcher, which sends a
+ *				large ReferenceDataRequest universe as a window of
+ *				adaptively sized requests, and the RefDataTable.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#include "RefDataBatcher.h"
+#include "AsyncRequester.h"
+#include "ElementUtil.h"
+
+#include <blpapi_correlationid.h>
+#include <blpapi_exception.h>
+#include <blpapi_name.h>
+#include <blpapi_request.h>
+
+#include <stdio.h>
+
+namespace {
+	const BloombergLP::blpapi::Name SECURITY_DATA("securityData");
+	const BloombergLP::blpapi::Name SEQUENCE_NUMBER("sequenceNumber");
+	const BloombergLP::blpapi::Name SECURITY_ERROR("securityError");
+	const BloombergLP::blpapi::Name FIELD_DATA("fieldData");
+	const BloombergLP::blpapi::Name MESSAGE("message");
+
+	const double NS_PER_MS = 1000000.0;
+}
+
+/*----------------------------------------------------------------
+ * Name			: RefDataTable constructor
+ * Description	: Constructs a table without values
+ * Arguments	: see RefDataBatcher.h
+ * Returns		: none
+ *---------------------------------------------------------------*/
+BloombergLP::RefDataTable::RefDataTable(const std::vector<std::string>& securities,
+	const std::vector<std::string>& fields)
+	: securities_(securities)
+	, fields_(fields)
+	, values_(securities.size() * fields.size())
+	, set_(securities.size() * fields.size(), NOT_SET)
+	, errors_(securities.size())
+{
+	columnIndex_.reserve(fields_.size());
+	for (size_t i = 0; i < fields_.size(); ++i)
+	{
+		columnIndex_.add(blpapi::Name(fields_[i].c_str()), static_cast<int>(i));
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: setFields
+ * Description	: Loads the fieldData of a response into a row
+ * Arguments	: see RefDataBatcher.h
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::RefDataTable::setFields(size_t row, const blpapi::Element& fieldData)
+{
+	size_t base = row * fields_.size();
+	size_t numElements = fieldData.numElements();
+	for (size_t i = 0; i < numElements; ++i)
+	{
+		blpapi::Element field = fieldData.getElement(i);
+		int column = columnIndex_.find(field.name());
+		if (column == NameIndex::NOT_FOUND)
+		{
+			continue;
+		}
+
+		std::string& value = values_[base + column];
+		if (field.isArray())
+		{
+			char text[32];
+			sprintf(text, "[%u rows]", static_cast<unsigned int>(field.numValues()));
+			value = text;
+		}
+		else
+		{
+			const char *text = 0;
+			if (blpapi_Element_getValueAsString(field.handle(), &text, 0) != 0)
+			{
+				continue;
+			}
+			value = text;
+		}
+		set_[base + column] = RECEIVED;
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: isComplete
+ * Description	: Tells if every field of a row is set
+ * Arguments	: see RefDataBatcher.h
+ * Returns		: true if no column of row is missing
+ *---------------------------------------------------------------*/
+bool BloombergLP::RefDataTable::isComplete(size_t row) const
+{
+	size_t base = row * fields_.size();
+	for (size_t i = 0; i < fields_.size(); ++i)
+	{
+		if (set_[base + i] == NOT_SET)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/*----------------------------------------------------------------
+ * Name			: RefDataBatcher constructor
+ * Description	: Constructs a batcher for the rows of table
+ * Arguments	: see RefDataBatcher.h
+ * Returns		: none
+ *---------------------------------------------------------------*/
+BloombergLP::RefDataBatcher::RefDataBatcher(blpapi::Session& session,
+	const blpapi::Service& service, RefDataTable& table,
+	const blpapi::Identity *identity, const Options& options)
+	: session_(session)
+	, service_(service)
+	, table_(table)
+	, identity_(identity)
+	, options_(options)
+	, nextRow_(0)
+	, nsPerSecurity_(0)
+	, nextId_(1)
+	, numRequests_(0)
+	, numRetries_(0)
+{
+	if (options_.minChunk_ < 1)
+	{
+		options_.minChunk_ = 1;
+	}
+	if (options_.maxChunk_ < options_.minChunk_)
+	{
+		options_.maxChunk_ = options_.minChunk_;
+	}
+	if (options_.maxInFlight_ < 1)
+	{
+		options_.maxInFlight_ = 1;
+	}
+	for (size_t i = 0; i < table_.numRows(); ++i)
+	{
+		if (!table_.isComplete(i))
+		{
+			rows_.push_back(i);
+		}
+	}
+	setChunkSize(options_.initialChunk_);
+}
+
+/*----------------------------------------------------------------
+ * Name			: start
+ * Description	: Sends the first window of requests
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::RefDataBatcher::start()
+{
+	sendNext();
+}
+
+/*----------------------------------------------------------------
+ * Name			: processEvent
+ * Description	: Merges the batcher responses into the table
+ * Arguments	: event is the event
+ * Returns		: true if event had a batcher message
+ *---------------------------------------------------------------*/
+bool BloombergLP::RefDataBatcher::processEvent(const blpapi::Event& event)
+{
+	int eventType = event.eventType();
+	if (eventType != blpapi::Event::PARTIAL_RESPONSE
+		&& eventType != blpapi::Event::RESPONSE
+		&& eventType != blpapi::Event::REQUEST_STATUS)
+	{
+		return false;
+	}
+
+	bool found = false;
+	blpapi::MessageIterator msgIter(event);
+	while (msgIter.next())
+	{
+		blpapi::Message msg = msgIter.message();
+		long long id;
+		if (!AsyncRequester::requestId(msg, CLASS_ID, &id))
+		{
+			continue;
+		}
+		found = true;
+
+		//a late message of an attempt that already failed
+		std::map<long long, Chunk>::iterator it = pending_.find(id);
+		if (it == pending_.end())
+		{
+			continue;
+		}
+		Chunk chunk = it->second;
+
+		std::string error;
+		if (AsyncRequester::requestError(msg, &error))
+		{
+			pending_.erase(it);
+			fail(chunk, error);
+		}
+		else
+		{
+			//rows of a partial response are final, a retry never
+			//follows a response of the same attempt
+			merge(chunk, msg);
+			if (eventType == blpapi::Event::RESPONSE)
+			{
+				pending_.erase(it);
+				complete(chunk);
+			}
+		}
+	}
+
+	if (found)
+	{
+		sendNext();
+	}
+	return found;
+}
+
+/*----------------------------------------------------------------
+ * Name			: sendNext
+ * Description	: Sends chunks until maxInFlight are outstanding
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::RefDataBatcher::sendNext()
+{
+	while (pending_.size() < options_.maxInFlight_)
+	{
+		Chunk chunk;
+		if (!retries_.empty())
+		{
+			chunk = retries_.front();
+			retries_.pop_front();
+		}
+		else if (nextRow_ < rows_.size())
+		{
+			chunk.first_ = nextRow_;
+			chunk.count_ = rows_.size() - nextRow_;
+			if (chunk.count_ > chunkSize_)
+			{
+				chunk.count_ = chunkSize_;
+			}
+			chunk.attempts_ = 0;
+			nextRow_ += chunk.count_;
+		}
+		else
+		{
+			break;
+		}
+		send(chunk);
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: send
+ * Description	: Sends the request of a chunk
+ * Arguments	: chunk is the chunk
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::RefDataBatcher::send(Chunk chunk)
+{
+	++chunk.attempts_;
+	long long id = nextId_++;
+	try {
+		blpapi::Request request = service_.createRequest("ReferenceDataRequest");
+		blpapi::Element securities = request.getElement("securities");
+		for (size_t i = 0; i < chunk.count_; ++i)
+		{
+			securities.appendValue(table_.security(rows_[chunk.first_ + i]).c_str());
+		}
+		blpapi::Element fields = request.getElement("fields");
+		for (size_t i = 0; i < table_.numFields(); ++i)
+		{
+			fields.appendValue(table_.field(i).c_str());
+		}
+
+		blpapi::CorrelationId cid(id, CLASS_ID);
+		chunk.sentAt_ = blpapi::HighResolutionClock::now();
+		if (identity_)
+		{
+			session_.sendRequest(request, *identity_, cid);
+		}
+		else
+		{
+			session_.sendRequest(request, cid);
+		}
+		pending_[id] = chunk;
+		++numRequests_;
+	}
+	catch (blpapi::Exception& e) {
+		fail(chunk, e.description());
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: merge
+ * Description	: Loads the securityData of a response into the table
+ * Arguments	: chunk is the chunk of the response
+ *				  msg is the response message
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::RefDataBatcher::merge(const Chunk& chunk, const blpapi::Message& msg)
+{
+	blpapi::Element securityData;
+	if (msg.asElement().getElement(&securityData, SECURITY_DATA) != 0)
+	{
+		return;
+	}
+
+	size_t numItems = securityData.numValues();
+	for (size_t i = 0; i < numItems; ++i)
+	{
+		blpapi::Element item = securityData.getValueAsElement(i);
+		//the sequence number is the position in the request
+		int sequence;
+		if (tryGetElementAs(item, SEQUENCE_NUMBER, &sequence) != 0
+			|| sequence < 0 || static_cast<size_t>(sequence) >= chunk.count_)
+		{
+			continue;
+		}
+		size_t row = rows_[chunk.first_ + sequence];
+
+		blpapi::Element element;
+		if (item.getElement(&element, SECURITY_ERROR) == 0)
+		{
+			const char *message = "securityError";
+			tryGetElementAs(element, MESSAGE, &message);
+			table_.setError(row, message);
+		}
+		else if (item.getElement(&element, FIELD_DATA) == 0)
+		{
+			table_.setFields(row, element);
+		}
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: complete
+ * Description	: Adapts the chunk size to the response time of a
+ *				  completed chunk
+ * Arguments	: chunk is the chunk
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::RefDataBatcher::complete(const Chunk& chunk)
+{
+	double ns = static_cast<double>(blpapi::TimePointUtil::nanosecondsBetween(
+		chunk.sentAt_, blpapi::HighResolutionClock::now()));
+	double sample = ns / chunk.count_;
+	nsPerSecurity_ = nsPerSecurity_ > 0
+		? 0.75 * nsPerSecurity_ + 0.25 * sample
+		: sample;
+	if (nsPerSecurity_ <= 0)
+	{
+		return;
+	}
+
+	double target = options_.targetMs_ * NS_PER_MS / nsPerSecurity_;
+	//at most double at once, the sample may be a fast outlier
+	setChunkSize(target < 2.0 * chunkSize_
+		? static_cast<size_t>(target)
+		: 2 * chunkSize_);
+}
+
+/*----------------------------------------------------------------
+ * Name			: setChunkSize
+ * Description	: Sets the size of the next new chunk within the
+ *				  minChunk, maxChunk and maxCells limits
+ * Arguments	: size is the wanted size
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::RefDataBatcher::setChunkSize(size_t size)
+{
+	if (table_.numFields() > 0 && size * table_.numFields() > options_.maxCells_)
+	{
+		size = options_.maxCells_ / table_.numFields();
+	}
+	if (size > options_.maxChunk_)
+	{
+		size = options_.maxChunk_;
+	}
+	if (size < options_.minChunk_)
+	{
+		size = options_.minChunk_;
+	}
+	chunkSize_ = size;
+}
+
+/*----------------------------------------------------------------
+ * Name			: fail
+ * Description	: Requeues a failed chunk in two halves, or records the
+ *				  error in its rows once it has no retries left
+ * Arguments	: chunk is the chunk
+ *				  error is the reason
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::RefDataBatcher::fail(const Chunk& chunk, const std::string& error)
+{
+	//smaller requests are less likely to time out or exceed the limits
+	setChunkSize(chunkSize_ / 2);
+
+	if (chunk.attempts_ > options_.maxRetries_)
+	{
+		for (size_t i = 0; i < chunk.count_; ++i)
+		{
+			table_.setError(rows_[chunk.first_ + i], error);
+		}
+		return;
+	}
+
+	//the halves keep the attempts, a failure that does not depend on
+	//the size ends after maxRetries splits
+	++numRetries_;
+	if (chunk.count_ > 1)
+	{
+		Chunk second = chunk;
+		second.first_ = chunk.first_ + chunk.count_ / 2;
+		second.count_ = chunk.count_ - chunk.count_ / 2;
+		retries_.push_front(second);
+		Chunk first = chunk;
+		first.count_ = chunk.count_ / 2;
+		retries_.push_front(first);
+	}
+	else
+	{
+		retries_.push_front(chunk);
+	}
+}
@@ -0,0 +1,354 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: RefDataBatcher.h
+ *
+ * Description: This file contains the RefDataBatcher class, which
+ *				sends a large ReferenceDataRequest universe as a window
+ *				of concurrent requests with adaptive chunk sizes, and
+ *				the RefDataTable the responses are merged into.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef __RefDataBatcher_h__
+#define __RefDataBatcher_h__
+
+#include <blpapi_element.h>
+#include <blpapi_event.h>
+#include <blpapi_highresolutionclock.h>
+#include <blpapi_identity.h>
+#include <blpapi_service.h>
+#include <blpapi_session.h>
+
+#include <stddef.h>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "NameIndex.h"
+
+namespace BloombergLP
+{
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : RefDataTable
+	 * Description  : Reference data of a universe, one row per security
+	 *				  in request order and one column per field. Values
+	 *				  are kept as strings; a bulk field holds its number
+	 *				  of rows, e.g. "[12 rows]".
+	 * --------------------------------------------------------------------*/
+	class RefDataTable
+	{
+		public:
+			/*----------------------------------------------------------------
+			 * Name			: RefDataTable constructor
+			 * Description	: Constructs a table without values
+			 * Arguments	: securities are the rows, fields the columns
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			RefDataTable(const std::vector<std::string>& securities,
+				const std::vector<std::string>& fields);
+
+			size_t numRows() const { return securities_.size(); }
+			size_t numFields() const { return fields_.size(); }
+			const std::string& security(size_t row) const { return securities_[row]; }
+			const std::string& field(size_t column) const { return fields_[column]; }
+
+			//true if row and column has a value, received or cached
+			bool isSet(size_t row, size_t column) const
+			{
+				return set_[row * fields_.size() + column] != NOT_SET;
+			}
+
+			//true if the value of row and column came from a response
+			bool isReceived(size_t row, size_t column) const
+			{
+				return set_[row * fields_.size() + column] == RECEIVED;
+			}
+
+			//value of row and column, empty if not set
+			const std::string& value(size_t row, size_t column) const
+			{
+				return values_[row * fields_.size() + column];
+			}
+
+			//securityError or request failure of row, empty if none
+			const std::string& error(size_t row) const { return errors_[row]; }
+
+			/*----------------------------------------------------------------
+			 * Name			: isComplete
+			 * Description	: Tells if every field of a row is set
+			 * Arguments	: row is the row
+			 * Returns		: true if no column of row is missing
+			 *---------------------------------------------------------------*/
+			bool isComplete(size_t row) const;
+
+			/*----------------------------------------------------------------
+			 * Name			: setCachedValue
+			 * Description	: Sets the value of a row and column from a
+			 *				  cache; isReceived() stays false
+			 * Arguments	: row is the row
+			 *				  column is the column
+			 *				  value is the value
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			void setCachedValue(size_t row, size_t column, const std::string& value)
+			{
+				values_[row * fields_.size() + column] = value;
+				set_[row * fields_.size() + column] = CACHED;
+			}
+
+			/*----------------------------------------------------------------
+			 * Name			: setFields
+			 * Description	: Loads the fieldData of a response into a row
+			 * Arguments	: row is the row
+			 *				  fieldData is the fieldData element
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			void setFields(size_t row, const blpapi::Element& fieldData);
+
+			/*----------------------------------------------------------------
+			 * Name			: setError
+			 * Description	: Records the error of a row
+			 * Arguments	: row is the row
+			 *				  error is the error
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			void setError(size_t row, const std::string& error)
+			{
+				errors_[row] = error;
+			}
+
+		private:
+			//origin of the value of a cell
+			enum { NOT_SET = 0, RECEIVED = 1, CACHED = 2 };
+
+			std::vector<std::string> securities_;
+			std::vector<std::string> fields_;
+
+			//column of each field Name
+			NameIndex columnIndex_;
+
+			//values and their origins, by row then column
+			std::vector<std::string> values_;
+			std::vector<char> set_;
+
+			std::vector<std::string> errors_;
+	};
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : RefDataBatcher
+	 * Description  : Requests the fields of the rows of a RefDataTable
+	 *				  that are not complete, e.g. not filled from a
+	 *				  RefDataCache, as consecutive chunks, keeping up to
+	 *				  maxInFlight requests outstanding. Responses are
+	 *				  routed to their chunk by correlation id and merged
+	 *				  into the table as they arrive.
+	 *				  The size of each new chunk follows the observed
+	 *				  response time per security so that a request takes
+	 *				  about targetMs, and is capped so that a response
+	 *				  holds at most maxCells securities x fields. A
+	 *				  failed chunk is split in two and requeued, and the
+	 *				  chunk size is halved; after maxRetries attempts
+	 *				  its rows get the error.
+	 *				  The application keeps its event loop and passes
+	 *				  each event to processEvent(). The batcher is used
+	 *				  by one thread at a time.
+	 * --------------------------------------------------------------------*/
+	class RefDataBatcher
+	{
+		public:
+			//classId of the correlation ids of the batcher requests
+			enum { CLASS_ID = 0x5244 };
+
+			//tuning of a batcher
+			struct Options
+			{
+				Options()
+					: initialChunk_(100)
+					, minChunk_(10)
+					, maxChunk_(2000)
+					, maxInFlight_(4)
+					, targetMs_(2000)
+					, maxCells_(200000)
+					, maxRetries_(2)
+				{
+				}
+
+				size_t initialChunk_;
+				size_t minChunk_;
+				size_t maxChunk_;
+				size_t maxInFlight_;
+				unsigned int targetMs_;
+				size_t maxCells_;
+				unsigned int maxRetries_;
+			};
+
+			/*----------------------------------------------------------------
+			 * Name			: RefDataBatcher constructor
+			 * Description	: Constructs a batcher for the rows of table
+			 *				  that are not complete
+			 * Arguments	: session sends the requests
+			 *				  service is the //blp/refdata service
+			 *				  table holds the universe and the results
+			 *				  identity is the identity of the requests,
+			 *				  0 for none
+			 *				  options is the tuning
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			RefDataBatcher(blpapi::Session& session, const blpapi::Service& service,
+				RefDataTable& table, const blpapi::Identity *identity,
+				const Options& options);
+
+			/*----------------------------------------------------------------
+			 * Name			: start
+			 * Description	: Sends the first window of requests
+			 * Arguments	: none
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			void start();
+
+			/*----------------------------------------------------------------
+			 * Name			: processEvent
+			 * Description	: Merges the batcher responses in event into
+			 *				  the table and sends more requests
+			 * Arguments	: event is any event
+			 * Returns		: true if event had a batcher message
+			 *---------------------------------------------------------------*/
+			bool processEvent(const blpapi::Event& event);
+
+			//true when every row has its response or error
+			bool done() const
+			{
+				return nextRow_ == rows_.size() && retries_.empty() && pending_.empty();
+			}
+
+			//number of rows requested
+			size_t numRequested() const { return rows_.size(); }
+
+			//size of the next new chunk
+			size_t chunkSize() const { return chunkSize_; }
+
+			//numbers of requests sent and of chunks retried
+			size_t numRequests() const { return numRequests_; }
+			size_t numRetries() const { return numRetries_; }
+
+		private:
+			//consecutive entries of rows_ of one request
+			struct Chunk
+			{
+				size_t first_;
+				size_t count_;
+				unsigned int attempts_;
+				blpapi::TimePoint sentAt_;
+			};
+
+			/*----------------------------------------------------------------
+			 * Name			: sendNext
+			 * Description	: Sends chunks until maxInFlight are
+			 *				  outstanding, retries first
+			 * Arguments	: none
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			void sendNext();
+
+			/*----------------------------------------------------------------
+			 * Name			: send
+			 * Description	: Sends the request of a chunk
+			 * Arguments	: chunk is the chunk
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			void send(Chunk chunk);
+
+			/*----------------------------------------------------------------
+			 * Name			: merge
+			 * Description	: Loads the securityData of a response into
+			 *				  the table
+			 * Arguments	: chunk is the chunk of the response
+			 *				  msg is the response message
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			void merge(const Chunk& chunk, const blpapi::Message& msg);
+
+			/*----------------------------------------------------------------
+			 * Name			: complete
+			 * Description	: Adapts the chunk size to the response time
+			 *				  of a completed chunk
+			 * Arguments	: chunk is the chunk
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			void complete(const Chunk& chunk);
+
+			/*----------------------------------------------------------------
+			 * Name			: setChunkSize
+			 * Description	: Sets the size of the next new chunk within
+			 *				  the minChunk, maxChunk and maxCells limits
+			 * Arguments	: size is the wanted size
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			void setChunkSize(size_t size);
+
+			/*----------------------------------------------------------------
+			 * Name			: fail
+			 * Description	: Requeues a failed chunk in two halves, or
+			 *				  records the error in its rows once it has
+			 *				  no retries left
+			 * Arguments	: chunk is the chunk
+			 *				  error is the reason
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			void fail(const Chunk& chunk, const std::string& error);
+
+			blpapi::Session& session_;
+			blpapi::Service service_;
+			RefDataTable& table_;
+			const blpapi::Identity *identity_;
+			Options options_;
+
+			//rows to request, and the first not yet in a chunk
+			std::vector<size_t> rows_;
+			size_t nextRow_;
+			size_t chunkSize_;
+
+			//smoothed response time of one security, 0 before the first
+			double nsPerSecurity_;
+
+			std::deque<Chunk> retries_;
+			std::map<long long, Chunk> pending_;
+			long long nextId_;
+
+			size_t numRequests_;
+			size_t numRetries_;
+
+			// Unimplemented
+			RefDataBatcher(const RefDataBatcher&);
+			RefDataBatcher& operator=(const RefDataBatcher&);
+	};
+}
+
+#endif
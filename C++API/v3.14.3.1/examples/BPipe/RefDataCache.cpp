@@ -0,0 +1,302 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: RefDataCache.cpp
+ *
+ * Description: This file contains the RefDataCache, which keeps
+ *				reference data values with a time to live per field.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#include "RefDataCache.h"
+
+#include <stdio.h>
+#include <fstream>
+#if defined(WIN32) || defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace {
+	//first line of a cache file, followed by the scope
+	const char *FILE_TAG = "RefDataCache 1";
+
+	/*----------------------------------------------------------------
+	 * Name			: escape
+	 * Description	: Appends text with its tabs, line ends and
+	 *				  backslashes escaped
+	 * Arguments	: out receives the text
+	 *				  text is the text
+	 * Returns		: none
+	 *---------------------------------------------------------------*/
+	void escape(std::string *out, const std::string& text)
+	{
+		for (size_t i = 0; i < text.size(); ++i)
+		{
+			switch (text[i])
+			{
+			case '\\': *out += "\\\\"; break;
+			case '\t': *out += "\\t"; break;
+			case '\n': *out += "\\n"; break;
+			case '\r': *out += "\\r"; break;
+			default: *out += text[i]; break;
+			}
+		}
+	}
+
+	/*----------------------------------------------------------------
+	 * Name			: unescape
+	 * Description	: Reads an escaped text up to the next tab
+	 * Arguments	: line is the line
+	 *				  pos is the position to read from, moved past
+	 *				  the tab
+	 *				  out receives the text
+	 * Returns		: false if the text is not followed by a tab and
+	 *				  last is false
+	 *---------------------------------------------------------------*/
+	bool unescape(const std::string& line, size_t *pos, std::string *out, bool last)
+	{
+		out->clear();
+		size_t i = *pos;
+		for (; i < line.size() && line[i] != '\t'; ++i)
+		{
+			if (line[i] != '\\' || i + 1 == line.size())
+			{
+				*out += line[i];
+				continue;
+			}
+			switch (line[++i])
+			{
+			case 't': *out += '\t'; break;
+			case 'n': *out += '\n'; break;
+			case 'r': *out += '\r'; break;
+			default: *out += line[i]; break;
+			}
+		}
+		if (i == line.size() ? !last : last)
+		{
+			return false;
+		}
+		*pos = i + 1;
+		return true;
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: RefDataCache constructor
+ * Description	: Constructs an empty cache
+ * Arguments	: see RefDataCache.h
+ * Returns		: none
+ *---------------------------------------------------------------*/
+BloombergLP::RefDataCache::RefDataCache(const std::string& scope, unsigned int defaultTtl)
+	: scope_(scope)
+	, defaultTtl_(defaultTtl)
+{
+}
+
+/*----------------------------------------------------------------
+ * Name			: ttl
+ * Description	: Returns the time to live of a field
+ * Arguments	: field is the field
+ * Returns		: seconds, 0 if the field is not cached
+ *---------------------------------------------------------------*/
+unsigned int BloombergLP::RefDataCache::ttl(const std::string& field) const
+{
+	std::map<std::string, unsigned int>::const_iterator it = ttls_.find(field);
+	return it != ttls_.end() ? it->second : defaultTtl_;
+}
+
+/*----------------------------------------------------------------
+ * Name			: fill
+ * Description	: Sets the cached values of a table
+ * Arguments	: see RefDataCache.h
+ * Returns		: number of values set
+ *---------------------------------------------------------------*/
+size_t BloombergLP::RefDataCache::fill(RefDataTable& table, time_t now) const
+{
+	size_t count = 0;
+	for (size_t j = 0; j < table.numFields(); ++j)
+	{
+		//a field no longer cached is requested again
+		if (ttl(table.field(j)) == 0)
+		{
+			continue;
+		}
+		for (size_t i = 0; i < table.numRows(); ++i)
+		{
+			std::map<Key, Entry>::const_iterator it =
+				entries_.find(Key(table.security(i), table.field(j)));
+			if (it != entries_.end() && it->second.expires_ > now)
+			{
+				table.setCachedValue(i, j, it->second.value_);
+				++count;
+			}
+		}
+	}
+	return count;
+}
+
+/*----------------------------------------------------------------
+ * Name			: store
+ * Description	: Caches the values a table received; values filled
+ *				  from the cache keep their expiry
+ * Arguments	: see RefDataCache.h
+ * Returns		: number of values cached
+ *---------------------------------------------------------------*/
+size_t BloombergLP::RefDataCache::store(const RefDataTable& table, time_t now)
+{
+	size_t count = 0;
+	for (size_t j = 0; j < table.numFields(); ++j)
+	{
+		unsigned int seconds = ttl(table.field(j));
+		if (seconds == 0)
+		{
+			continue;
+		}
+		for (size_t i = 0; i < table.numRows(); ++i)
+		{
+			if (!table.isReceived(i, j) || !table.error(i).empty())
+			{
+				continue;
+			}
+			Entry& entry = entries_[Key(table.security(i), table.field(j))];
+			entry.value_ = table.value(i, j);
+			entry.expires_ = now + seconds;
+			++count;
+		}
+	}
+	return count;
+}
+
+/*----------------------------------------------------------------
+ * Name			: load
+ * Description	: Adds the unexpired values of a file, expiring
+ *				  no later than the ttl of their field from now
+ * Arguments	: see RefDataCache.h
+ * Returns		: false if the file cannot be read or has another scope
+ *---------------------------------------------------------------*/
+bool BloombergLP::RefDataCache::load(const char *path, time_t now)
+{
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	std::string line;
+	if (!std::getline(file, line) || line != FILE_TAG)
+	{
+		return false;
+	}
+	std::string scope;
+	size_t pos = 0;
+	if (!std::getline(file, line) || !unescape(line, &pos, &scope, true)
+		|| scope != scope_)
+	{
+		return false;
+	}
+
+	//expires, security, field and value
+	Key key;
+	Entry entry;
+	std::string expires;
+	while (std::getline(file, line))
+	{
+		pos = 0;
+		if (!unescape(line, &pos, &expires, false)
+			|| !unescape(line, &pos, &key.first, false)
+			|| !unescape(line, &pos, &key.second, false)
+			|| !unescape(line, &pos, &entry.value_, true))
+		{
+			continue;
+		}
+		entry.expires_ = 0;
+		for (size_t i = 0; i < expires.size() && expires[i] >= '0' && expires[i] <= '9'; ++i)
+		{
+			entry.expires_ = entry.expires_ * 10 + (expires[i] - '0');
+		}
+		//a ttl shortened since the file was saved applies at once
+		unsigned int seconds = ttl(key.second);
+		if (seconds == 0)
+		{
+			continue;
+		}
+		if (entry.expires_ > now + seconds)
+		{
+			entry.expires_ = now + seconds;
+		}
+		if (entry.expires_ > now)
+		{
+			entries_[key] = entry;
+		}
+	}
+	return true;
+}
+
+/*----------------------------------------------------------------
+ * Name			: save
+ * Description	: Writes the unexpired values to a file
+ * Arguments	: see RefDataCache.h
+ * Returns		: false if the file cannot be written
+ *---------------------------------------------------------------*/
+bool BloombergLP::RefDataCache::save(const char *path, time_t now) const
+{
+	//readers of path see the old or the new file, never a part
+	std::string temp(path);
+	temp += ".tmp";
+	{
+		std::ofstream file(temp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		std::string line(FILE_TAG);
+		line += '\n';
+		escape(&line, scope_);
+		line += '\n';
+		file << line;
+
+		char expires[32];
+		for (std::map<Key, Entry>::const_iterator it = entries_.begin();
+			it != entries_.end(); ++it)
+		{
+			if (it->second.expires_ <= now)
+			{
+				continue;
+			}
+			sprintf(expires, "%.0f\t", static_cast<double>(it->second.expires_));
+			line = expires;
+			escape(&line, it->first.first);
+			line += '\t';
+			escape(&line, it->first.second);
+			line += '\t';
+			escape(&line, it->second.value_);
+			line += '\n';
+			file << line;
+		}
+		if (!file)
+		{
+			return false;
+		}
+	}
+#if defined(WIN32) || defined(_WIN32)
+	//rename does not replace a file on Windows
+	return MoveFileExA(temp.c_str(), path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	return rename(temp.c_str(), path) == 0;
+#endif
+}
@@ -0,0 +1,153 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: RefDataCache.h
+ *
+ * Description: This file contains the RefDataCache class, which keeps
+ *				reference data values with a time to live per field so
+ *				that static fields are not requested on every run.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef __RefDataCache_h__
+#define __RefDataCache_h__
+
+#include <stddef.h>
+#include <time.h>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "RefDataBatcher.h"
+
+namespace BloombergLP
+{
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : RefDataCache
+	 * Description  : Values of (security, field) pairs with the time they
+	 *				  expire. fill() sets the unexpired values in a
+	 *				  RefDataTable before it is requested, so that the
+	 *				  RefDataBatcher only requests the incomplete rows,
+	 *				  and store() keeps the values of the response.
+	 *				  The scope names what the values depend on besides
+	 *				  the security and the field, e.g. the service, the
+	 *				  operation and the overrides; a file saved with
+	 *				  another scope is not loaded.
+	 *				  A field is cached for its own ttl, or the default
+	 *				  ttl if it has none; a ttl of 0 is never cached.
+	 * --------------------------------------------------------------------*/
+	class RefDataCache
+	{
+		public:
+			/*----------------------------------------------------------------
+			 * Name			: RefDataCache constructor
+			 * Description	: Constructs an empty cache
+			 * Arguments	: scope is the scope of the values
+			 *				  defaultTtl is the seconds a field without
+			 *				  its own ttl is kept
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			RefDataCache(const std::string& scope, unsigned int defaultTtl);
+
+			/*----------------------------------------------------------------
+			 * Name			: setTtl
+			 * Description	: Sets the time to live of one field
+			 * Arguments	: field is the field
+			 *				  seconds is the time to live, 0 to not cache
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			void setTtl(const std::string& field, unsigned int seconds)
+			{
+				ttls_[field] = seconds;
+			}
+
+			/*----------------------------------------------------------------
+			 * Name			: fill
+			 * Description	: Sets the cached values of a table
+			 * Arguments	: table is the table
+			 *				  now is the current time
+			 * Returns		: number of values set
+			 *---------------------------------------------------------------*/
+			size_t fill(RefDataTable& table, time_t now) const;
+
+			/*----------------------------------------------------------------
+			 * Name			: store
+			 * Description	: Caches the values a table received, except
+			 *				  the rows with an error and fields with a ttl
+			 *				  of 0; values set by fill() keep their expiry
+			 * Arguments	: table is the table
+			 *				  now is the current time
+			 * Returns		: number of values cached
+			 *---------------------------------------------------------------*/
+			size_t store(const RefDataTable& table, time_t now);
+
+			/*----------------------------------------------------------------
+			 * Name			: load
+			 * Description	: Adds the unexpired values of a file saved
+			 *				  with the same scope. A value expires no
+			 *				  later than the ttl of its field from now,
+			 *				  so set the ttls first.
+			 * Arguments	: path is the file
+			 *				  now is the current time
+			 * Returns		: false if the file cannot be read or has
+			 *				  another scope
+			 *---------------------------------------------------------------*/
+			bool load(const char *path, time_t now);
+
+			/*----------------------------------------------------------------
+			 * Name			: save
+			 * Description	: Writes the unexpired values to a file
+			 * Arguments	: path is the file
+			 *				  now is the current time
+			 * Returns		: false if the file cannot be written
+			 *---------------------------------------------------------------*/
+			bool save(const char *path, time_t now) const;
+
+			//number of values, expired or not
+			size_t size() const { return entries_.size(); }
+
+		private:
+			typedef std::pair<std::string, std::string> Key;	// security, field
+
+			struct Entry
+			{
+				std::string value_;
+				time_t expires_;
+			};
+
+			//time to live of a field
+			unsigned int ttl(const std::string& field) const;
+
+			std::string scope_;
+			unsigned int defaultTtl_;
+			std::map<std::string, unsigned int> ttls_;
+			std::map<Key, Entry> entries_;
+	};
+}
+
+#endif
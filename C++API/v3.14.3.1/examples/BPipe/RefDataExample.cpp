@@ -28,10 +28,15 @@
 #include <blpapi_defs.h>
 
 #include <iostream>
+#include <fstream>
 #include <vector>
 #include <string>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#include "RefDataBatcher.h"
+#include "RefDataCache.h"
 
 using namespace BloombergLP;
 using namespace blpapi;
@@ -69,6 +74,11 @@ class RefDataExample
 	Session				*d_session;
     std::vector<std::string> d_securities;
     std::vector<std::string> d_fields;
+    int                     d_batch;			// 0 for a single request
+    int                     d_parallel;			// most requests in flight
+    int                     d_maxPendingRequests;
+    std::string             d_cacheFile;		// empty for no cache
+    std::vector<std::pair<std::string, unsigned int> > d_fieldTtls;	// only fields cached
 
     bool parseCommandLine(int argc, char **argv)
     {
@@ -77,6 +87,26 @@ class RefDataExample
                 d_securities.push_back(argv[++i]);
             } else if (!std::strcmp(argv[i],"-f") && i + 1 < argc) {
                 d_fields.push_back(argv[++i]);
+            } else if (!std::strcmp(argv[i],"-sf") && i + 1 < argc) {
+                if (!readSecurities(argv[++i])) {
+                    return false;
+                }
+            } else if (!std::strcmp(argv[i],"-batch") && i + 1 < argc) {
+                d_batch = std::atoi(argv[++i]);
+            } else if (!std::strcmp(argv[i],"-parallel") && i + 1 < argc) {
+                d_parallel = std::atoi(argv[++i]);
+            } else if (!std::strcmp(argv[i],"-cache") && i + 1 < argc) {
+                d_cacheFile = argv[++i];
+            } else if (!std::strcmp(argv[i],"-ttl") && i + 1 < argc) {
+                const char *ttl = argv[++i];
+                const char *seconds = std::strchr(ttl, '=');
+                if (!seconds || seconds == ttl) {
+                    std::cout << "Expected field=seconds after -ttl." << std::endl;
+                    printUsage();
+                    return false;
+                }
+                d_fieldTtls.push_back(std::make_pair(
+                    std::string(ttl, seconds), (unsigned int)std::atoi(seconds + 1)));
             } else if (!std::strcmp(argv[i],"-ip") && i + 1 < argc) {
                 d_hosts.push_back(argv[++i]);
             } else if (!std::strcmp(argv[i],"-p") &&  i + 1 < argc) {
@@ -123,6 +153,26 @@ class RefDataExample
         return true;
     }
 
+    // read one security per line
+    bool readSecurities(const char *path)
+    {
+        std::ifstream file(path);
+        if (!file) {
+            std::cout << "Cannot open " << path << std::endl;
+            return false;
+        }
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.size() > 0 && line[line.size() - 1] == '\r') {
+                line.erase(line.size() - 1);
+            }
+            if (line.size() > 0) {
+                d_securities.push_back(line);
+            }
+        }
+        return true;
+    }
+
     void printErrorInfo(const char *leadingStr, const Element &errorInfo)
     {
         std::cout << leadingStr
@@ -138,6 +188,11 @@ class RefDataExample
             << "    Retrieve reference data " << std::endl
             << "        [-s         <security   = IBM US Equity>" << std::endl
             << "        [-f         <field      = PX_LAST>" << std::endl
+            << "        [-sf        <file of securities, one per line>]" << std::endl
+            << "        [-batch     <securities of the first request = 0, single request>]" << std::endl
+            << "        [-parallel  <requests in flight = 4>]" << std::endl
+            << "        [-cache     <file of the cached fields>]" << std::endl
+            << "        [-ttl       <field=seconds the field is cached, repeatable>]" << std::endl
             << "        [-ip        <ipAddress  = localhost>" << std::endl
             << "        [-p         <tcpPort    = 8194>" << std::endl
 			<< "        [-auth      <authenticationOption = LOGON (default) or NONE or APPLICATION or DIRSVC or USER_APP>]" << std::endl
@@ -145,7 +200,10 @@ class RefDataExample
             << "Notes:" << std::endl
             << " -Specify only LOGON to authorize 'user' using Windows login name." << std::endl
             << " -Specify DIRSVC and name(Directory Service Property) to authorize user using directory Service." << std::endl
-            << " -Specify APPLICATION and name(Application Name) to authorize application." << std::endl;
+            << " -Specify APPLICATION and name(Application Name) to authorize application." << std::endl
+            << " -Specify batch to split the securities into requests sized to the response time." << std::endl
+            << " -Specify cache to request only the fields not cached by a previous run." << std::endl
+            << " -Specify ttl for each field to cache; other fields are always requested." << std::endl;
     }
 
 	bool startSession(){
@@ -163,6 +221,7 @@ class RefDataExample
         sessionOptions.setServerPort(d_port);
         sessionOptions.setAutoRestartOnDisconnection(true);
         sessionOptions.setNumStartAttempts(d_hosts.size());
+        d_maxPendingRequests = sessionOptions.maxPendingRequests();
 		authOptions = getAuthOptions();
 		if (authOptions.size() > 0) {
 			sessionOptions.setAuthenticationOptions(authOptions.c_str());
@@ -214,6 +273,34 @@ class RefDataExample
 		return authOptions;
 	}
 
+	// what the cached values depend on besides security and field,
+	// including who is authorized to see them
+	std::string getCacheScope()
+	{
+		std::string scope(REFDATA_SVC);
+		scope += " ReferenceDataRequest ";
+		if (!strcmp(d_authOption.c_str(), "NONE")) {
+			return scope + "NONE";
+		}
+		scope += d_authOption.empty() ? "LOGON" : d_authOption;
+		if (!d_name.empty()) {
+			scope += " " + d_name;
+		}
+		if (strcmp(d_authOption.c_str(), "APPLICATION")
+			&& strcmp(d_authOption.c_str(), "DIRSVC")) {
+			// OS_LOGON authorizes the login name, see getAuthOptions()
+			const char *user = getenv("USERNAME");
+			if (!user) {
+				user = getenv("USER");
+			}
+			if (user) {
+				scope += " ";
+				scope += user;
+			}
+		}
+		return scope;
+	}
+
 	bool authorize()
     {
         EventQueue tokenEventQueue;
@@ -391,11 +478,57 @@ class RefDataExample
         }
     }
 
+    void batchEventLoop(BloombergLP::RefDataBatcher &batcher)
+    {
+        while (!batcher.done()) {
+            Event event = d_session->nextEvent();
+            if (batcher.processEvent(event)) {
+                continue;
+            }
+            MessageIterator msgIter(event);
+            while (msgIter.next()) {
+                Message msg = msgIter.message();
+                if (event.eventType() == Event::SESSION_STATUS) {
+                    if (msg.messageType() == SESSION_TERMINATED ||
+                        msg.messageType() == SESSION_STARTUP_FAILURE) {
+                        return;
+                    }
+                }
+            }
+        }
+        std::cout << batcher.numRequests() << " requests, "
+            << batcher.numRetries() << " retries, last chunk size "
+            << batcher.chunkSize() << std::endl;
+    }
+
+    void printTable(const BloombergLP::RefDataTable &table)
+    {
+        std::cout << "SECURITY";
+        for (size_t j = 0; j < table.numFields(); ++j) {
+            std::cout << "\t" << table.field(j);
+        }
+        std::cout << std::endl;
+        for (size_t i = 0; i < table.numRows(); ++i) {
+            std::cout << table.security(i);
+            if (!table.error(i).empty()) {
+                std::cout << "\tFAILED: " << table.error(i) << std::endl;
+                continue;
+            }
+            for (size_t j = 0; j < table.numFields(); ++j) {
+                std::cout << "\t" << (table.isSet(i, j) ? table.value(i, j) : "-");
+            }
+            std::cout << std::endl;
+        }
+    }
+
 public:
 	RefDataExample() : d_session(0)
     {
         d_port = 8194;
 		d_name = "";
+        d_batch = 0;
+        d_parallel = 4;
+        d_maxPendingRequests = 1024;
     }
 
     ~RefDataExample()
@@ -415,6 +548,49 @@ public:
 			}
 		}
 
+        if (d_batch > 0 || !d_cacheFile.empty()) {
+            if (d_parallel > d_maxPendingRequests) {
+                d_parallel = d_maxPendingRequests;
+            }
+            BloombergLP::RefDataTable table(d_securities, d_fields);
+            BloombergLP::RefDataCache cache(getCacheScope(), 0);
+            for (size_t i = 0; i < d_fieldTtls.size(); ++i) {
+                cache.setTtl(d_fieldTtls[i].first, d_fieldTtls[i].second);
+            }
+            if (!d_cacheFile.empty()) {
+                cache.load(d_cacheFile.c_str(), time(0));
+                std::cout << cache.fill(table, time(0)) << " fields from "
+                    << d_cacheFile << std::endl;
+            }
+
+            BloombergLP::RefDataBatcher::Options options;
+            if (d_batch > 0) {
+                options.initialChunk_ = d_batch;
+            }
+            options.maxInFlight_ = d_parallel > 0 ? d_parallel : 1;
+            BloombergLP::RefDataBatcher batcher(*d_session,
+                d_session->getService(REFDATA_SVC), table,
+                strcmp(d_authOption.c_str(), "NONE") ? &d_identity : 0,
+                options);
+            std::cout << "Sending " << batcher.numRequested() << " securities, "
+                << options.maxInFlight_ << " requests in flight" << std::endl;
+            try {
+                batcher.start();
+                batchEventLoop(batcher);
+                printTable(table);
+            } catch (Exception &e) {
+                std::cerr << "Library Exception !!!" << e.description() << std::endl;
+            }
+            if (!d_cacheFile.empty() && batcher.numRequested() > 0) {
+                cache.store(table, time(0));
+                if (!cache.save(d_cacheFile.c_str(), time(0))) {
+                    std::cerr << "Failed to write " << d_cacheFile << std::endl;
+                }
+            }
+            d_session->stop();
+            return;
+        }
+
 		sendRefDataRequest(*d_session);
 
         // wait for events from session.
@@ -0,0 +1,337 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: RequestPlanner.cpp
+ *
+ * Description: This file contains the planner of sliced intraday
+ *				requests.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#include "RequestPlanner.h"
+#include "EpochDay.h"
+#include "AsyncRequester.h"
+
+#include <blpapi_correlationid.h>
+#include <blpapi_exception.h>
+
+#include <stdio.h>
+
+namespace {
+	const long long SECONDS_PER_DAY = 86400;
+}
+
+/*----------------------------------------------------------------
+ * Name			: RequestPlanner constructor
+ * Description	: Constructs a planner without jobs
+ * Arguments	: see RequestPlanner.h
+ * Returns		: none
+ *---------------------------------------------------------------*/
+BloombergLP::RequestPlanner::RequestPlanner(blpapi::Session& session,
+	const blpapi::Service& service, const char *operation, SliceHandler& handler,
+	const blpapi::Identity *identity, size_t maxInFlight, unsigned int maxRetries)
+	: session_(session)
+	, service_(service)
+	, operation_(operation)
+	, handler_(handler)
+	, identity_(identity)
+	, maxInFlight_(maxInFlight > 0 ? maxInFlight : 1)
+	, maxRetries_(maxRetries)
+	, nextId_(1)
+	, nextSlice_(0)
+	, numRetries_(0)
+{
+}
+
+/*----------------------------------------------------------------
+ * Name			: addJob
+ * Description	: Splits a job into slices and queues them. Slice
+ *				  i starts at start + i * sliceSeconds, the last
+ *				  slice ends at end.
+ * Arguments	: security is the security of the job
+ *				  start and end are the time range
+ *				  sliceSeconds is the length of a slice
+ * Returns		: number of slices queued
+ *---------------------------------------------------------------*/
+size_t BloombergLP::RequestPlanner::addJob(const std::string& security,
+	long long start, long long end, long long sliceSeconds)
+{
+	if (sliceSeconds <= 0)
+	{
+		sliceSeconds = end - start;
+	}
+
+	size_t count = 0;
+	for (long long t = start; t < end; t += sliceSeconds)
+	{
+		RequestSlice slice;
+		slice.security_ = security;
+		slice.start_ = t;
+		slice.end_ = end - t > sliceSeconds ? t + sliceSeconds : end;
+		slice.last_ = slice.end_ == end;
+		slice.index_ = slices_.size();
+		slice.attempts_ = 0;
+		slice.state_ = RequestSlice::QUEUED;
+		slices_.push_back(slice);
+		queue_.push_back(slice.index_);
+		++count;
+	}
+	return count;
+}
+
+/*----------------------------------------------------------------
+ * Name			: start
+ * Description	: Sends the first slices
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::RequestPlanner::start()
+{
+	sendNext();
+	deliver();
+}
+
+/*----------------------------------------------------------------
+ * Name			: processEvent
+ * Description	: Collects the messages of the planner requests
+ * Arguments	: event is the event
+ * Returns		: true if event had a planner message
+ *---------------------------------------------------------------*/
+bool BloombergLP::RequestPlanner::processEvent(const blpapi::Event& event)
+{
+	int eventType = event.eventType();
+	if (eventType != blpapi::Event::PARTIAL_RESPONSE
+		&& eventType != blpapi::Event::RESPONSE
+		&& eventType != blpapi::Event::REQUEST_STATUS)
+	{
+		return false;
+	}
+
+	bool found = false;
+	blpapi::MessageIterator msgIter(event);
+	while (msgIter.next())
+	{
+		blpapi::Message msg = msgIter.message();
+		long long id;
+		if (!AsyncRequester::requestId(msg, CLASS_ID, &id))
+		{
+			continue;
+		}
+		found = true;
+
+		//a late message of an attempt that already failed
+		std::map<long long, size_t>::iterator it = pending_.find(id);
+		if (it == pending_.end())
+		{
+			continue;
+		}
+		RequestSlice& slice = slices_[it->second];
+
+		std::string error;
+		if (AsyncRequester::requestError(msg, &error))
+		{
+			pending_.erase(it);
+			fail(slice, error);
+		}
+		else
+		{
+			slice.messages_.push_back(msg);
+			if (eventType == blpapi::Event::RESPONSE)
+			{
+				pending_.erase(it);
+				slice.state_ = RequestSlice::DONE;
+			}
+		}
+	}
+
+	if (found)
+	{
+		sendNext();
+		deliver();
+	}
+	return found;
+}
+
+/*----------------------------------------------------------------
+ * Name			: sendNext
+ * Description	: Sends queued slices until maxInFlight are outstanding
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::RequestPlanner::sendNext()
+{
+	while (pending_.size() < maxInFlight_ && !queue_.empty())
+	{
+		RequestSlice& slice = slices_[queue_.front()];
+		queue_.pop_front();
+
+		++slice.attempts_;
+		slice.state_ = RequestSlice::PENDING;
+		long long id = nextId_++;
+		try {
+			blpapi::Request request = service_.createRequest(operation_.c_str());
+			request.set("security", slice.security_.c_str());
+			request.set("startDateTime", toDatetime(slice.start_));
+			request.set("endDateTime", toDatetime(slice.end_));
+			handler_.buildRequest(slice, request);
+
+			blpapi::CorrelationId cid(id, CLASS_ID);
+			if (identity_)
+			{
+				session_.sendRequest(request, *identity_, cid);
+			}
+			else
+			{
+				session_.sendRequest(request, cid);
+			}
+			pending_[id] = slice.index_;
+		}
+		catch (blpapi::Exception& e) {
+			fail(slice, e.description());
+		}
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: fail
+ * Description	: Ends an attempt of a slice with an error
+ * Arguments	: slice is the slice
+ *				  error is the reason
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::RequestPlanner::fail(RequestSlice& slice, const std::string& error)
+{
+	//the partial responses of the attempt are resent with the retry
+	std::vector<blpapi::Message>().swap(slice.messages_);
+	slice.error_ = error;
+	if (slice.attempts_ <= maxRetries_)
+	{
+		slice.state_ = RequestSlice::QUEUED;
+		queue_.push_front(slice.index_);
+		++numRetries_;
+	}
+	else
+	{
+		slice.state_ = RequestSlice::FAILED;
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: deliver
+ * Description	: Hands the completed slices that follow the last
+ *				  handed slice to the handler
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::RequestPlanner::deliver()
+{
+	while (nextSlice_ < slices_.size())
+	{
+		RequestSlice& slice = slices_[nextSlice_];
+		if (slice.state_ == RequestSlice::DONE)
+		{
+			handler_.processSlice(slice);
+		}
+		else if (slice.state_ == RequestSlice::FAILED)
+		{
+			handler_.processFailure(slice);
+		}
+		else
+		{
+			break;
+		}
+		std::vector<blpapi::Message>().swap(slice.messages_);
+		++nextSlice_;
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: parseTime
+ * Description	: Parses a YYYY-MM-DDTHH:MM:SS time
+ * Arguments	: text is the time
+ *				  seconds receives it
+ * Returns		: true if text is a time
+ *---------------------------------------------------------------*/
+bool BloombergLP::RequestPlanner::parseTime(const char *text, long long *seconds)
+{
+	int year, month, day;
+	int hours = 0, minutes = 0, secs = 0;
+	int n = sscanf(text, "%d-%d-%dT%d:%d:%d", &year, &month, &day,
+		&hours, &minutes, &secs);
+	if (n != 3 && n != 6)
+	{
+		return false;
+	}
+	if (month < 1 || month > 12 || day < 1 || day > 31
+		|| hours < 0 || hours > 23 || minutes < 0 || minutes > 59
+		|| secs < 0 || secs > 59)
+	{
+		return false;
+	}
+	*seconds = epochDay(year, month, day) * SECONDS_PER_DAY
+		+ (hours * 60 + minutes) * 60 + secs;
+	return true;
+}
+
+/*----------------------------------------------------------------
+ * Name			: toSeconds
+ * Description	: Converts a GMT Datetime to seconds since 1970-01-01
+ * Arguments	: time is a Datetime with the DATE part
+ * Returns		: seconds since 1970-01-01
+ *---------------------------------------------------------------*/
+long long BloombergLP::RequestPlanner::toSeconds(const blpapi::Datetime& time)
+{
+	long long seconds = epochDay(time.year(), time.month(), time.day()) * SECONDS_PER_DAY;
+	if (time.hasParts(blpapi::DatetimeParts::TIME))
+	{
+		seconds += (time.hours() * 60 + time.minutes()) * 60 + time.seconds();
+	}
+	return seconds;
+}
+
+/*----------------------------------------------------------------
+ * Name			: toDatetime
+ * Description	: Converts seconds since 1970-01-01 to a Datetime
+ * Arguments	: seconds is the time
+ * Returns		: Datetime with the DATE and TIME parts
+ *---------------------------------------------------------------*/
+BloombergLP::blpapi::Datetime BloombergLP::RequestPlanner::toDatetime(long long seconds)
+{
+	long long days = seconds / SECONDS_PER_DAY;
+	long long secondOfDay = seconds % SECONDS_PER_DAY;
+	if (secondOfDay < 0)
+	{
+		secondOfDay += SECONDS_PER_DAY;
+		--days;
+	}
+	int year, month, day;
+	epochDate(static_cast<int>(days), &year, &month, &day);
+	return blpapi::Datetime::createDatetime(year, month, day,
+		static_cast<unsigned>(secondOfDay / 3600),
+		static_cast<unsigned>(secondOfDay / 60 % 60),
+		static_cast<unsigned>(secondOfDay % 60));
+}
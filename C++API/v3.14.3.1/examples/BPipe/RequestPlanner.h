@@ -0,0 +1,319 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: RequestPlanner.h
+ *
+ * Description: This file contains the RequestPlanner class, which
+ *				splits IntradayTickRequest and IntradayBarRequest jobs
+ *				into time slices, keeps several slices in flight and
+ *				hands their responses over in job order.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef __RequestPlanner_h__
+#define __RequestPlanner_h__
+
+#include <blpapi_datetime.h>
+#include <blpapi_event.h>
+#include <blpapi_identity.h>
+#include <blpapi_message.h>
+#include <blpapi_request.h>
+#include <blpapi_service.h>
+#include <blpapi_session.h>
+
+#include <stddef.h>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace BloombergLP
+{
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : RequestSlice
+	 * Description  : One sub-request of a job: a security over a time
+	 *				  range. Times are seconds since 1970-01-01 GMT.
+	 *				  Consecutive slices share their boundary, end_ of a
+	 *				  slice is start_ of the next, so an item at the
+	 *				  boundary comes back in both; see owns().
+	 * --------------------------------------------------------------------*/
+	struct RequestSlice
+	{
+		enum State { QUEUED, PENDING, DONE, FAILED };
+
+		std::string security_;
+		long long start_;
+		long long end_;
+
+		//true for the last slice of its job, which ends at the job end
+		bool last_;
+
+		//position of the slice in job order
+		size_t index_;
+
+		//number of times the slice was sent
+		unsigned int attempts_;
+
+		State state_;
+
+		//messages of the pending or done attempt
+		std::vector<blpapi::Message> messages_;
+
+		//error of the last failed attempt
+		std::string error_;
+
+		/*----------------------------------------------------------------
+		 * Name			: owns
+		 * Description	: Tells whether an item of the response belongs
+		 *				  to this slice. Items at end_ belong to the next
+		 *				  slice, except in the last slice of the job.
+		 * Arguments	: time is the item time, seconds since 1970-01-01
+		 *				  GMT
+		 * Returns		: true if the item should be processed
+		 *---------------------------------------------------------------*/
+		bool owns(long long time) const
+		{
+			return time < end_ || last_;
+		}
+	};
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : SliceHandler
+	 * Description  : Builds the requests of a RequestPlanner and receives
+	 *				  the slices, in job order, as they complete
+	 * --------------------------------------------------------------------*/
+	class SliceHandler
+	{
+		public:
+			virtual ~SliceHandler()
+			{
+			}
+
+			/*----------------------------------------------------------------
+			 * Name			: buildRequest
+			 * Description	: Sets the elements of a slice request other
+			 *				  than security, startDateTime and
+			 *				  endDateTime, which the planner sets
+			 * Arguments	: slice is the slice to request
+			 *				  request is the request to fill
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			virtual void buildRequest(const RequestSlice& slice, blpapi::Request& request) = 0;
+
+			/*----------------------------------------------------------------
+			 * Name			: processSlice
+			 * Description	: Called once per slice, after every slice
+			 *				  before it. The items at the end_ boundary
+			 *				  may also start the next slice, skip the
+			 *				  ones slice.owns() rejects.
+			 * Arguments	: slice is the slice, with its messages
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			virtual void processSlice(const RequestSlice& slice) = 0;
+
+			/*----------------------------------------------------------------
+			 * Name			: processFailure
+			 * Description	: Called in place of processSlice() for a
+			 *				  slice that failed every retry
+			 * Arguments	: slice is the slice, error_ is the reason
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			virtual void processFailure(const RequestSlice& slice) = 0;
+	};
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : RequestPlanner
+	 * Description  : Splits (security x time range) jobs into slices
+	 *				  and sends them, keeping at most maxInFlight
+	 *				  outstanding. A slice whose request fails is queued
+	 *				  again, ahead of the unsent slices, up to maxRetries
+	 *				  times. Completed slices are buffered until every
+	 *				  slice before them has completed, so the handler
+	 *				  sees them in job order.
+	 *				  The application keeps its event loop and passes
+	 *				  each event to processEvent(). The planner is used
+	 *				  by one thread at a time.
+	 * --------------------------------------------------------------------*/
+	class RequestPlanner
+	{
+		public:
+			//classId of the correlation ids of the planner requests
+			enum { CLASS_ID = 0x5250 };
+
+			/*----------------------------------------------------------------
+			 * Name			: RequestPlanner constructor
+			 * Description	: Constructs a planner without jobs
+			 * Arguments	: session sends the requests
+			 *				  service is the service of the requests
+			 *				  operation is the request name, e.g.
+			 *				  "IntradayTickRequest"
+			 *				  handler builds the requests and receives
+			 *				  the slices
+			 *				  identity is the identity of the requests,
+			 *				  0 for none
+			 *				  maxInFlight is the most slices outstanding,
+			 *				  at most SessionOptions::maxPendingRequests()
+			 *				  maxRetries is the most resends of a slice
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			RequestPlanner(blpapi::Session& session, const blpapi::Service& service,
+				const char *operation, SliceHandler& handler,
+				const blpapi::Identity *identity, size_t maxInFlight,
+				unsigned int maxRetries);
+
+			/*----------------------------------------------------------------
+			 * Name			: addJob
+			 * Description	: Splits a job into slices and queues them. Slice
+			 *				  i starts at start + i * sliceSeconds, the last
+			 *				  slice ends at end.
+			 * Arguments	: security is the security of the job
+			 *				  start and end are the time range, seconds
+			 *				  since 1970-01-01 GMT
+			 *				  sliceSeconds is the length of a slice
+			 * Returns		: number of slices queued
+			 *---------------------------------------------------------------*/
+			size_t addJob(const std::string& security, long long start,
+				long long end, long long sliceSeconds);
+
+			/*----------------------------------------------------------------
+			 * Name			: start
+			 * Description	: Sends the first slices
+			 * Arguments	: none
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			void start();
+
+			/*----------------------------------------------------------------
+			 * Name			: processEvent
+			 * Description	: Collects the messages of the planner
+			 *				  requests in event, hands the completed
+			 *				  slices to the handler and sends more
+			 * Arguments	: event is a PARTIAL_RESPONSE, RESPONSE or
+			 *				  REQUEST_STATUS event
+			 * Returns		: true if event had a planner message
+			 *---------------------------------------------------------------*/
+			bool processEvent(const blpapi::Event& event);
+
+			//true when every slice was handed to the handler
+			bool done() const { return nextSlice_ == slices_.size(); }
+
+			//numbers of slices, of slices outstanding and of resends
+			size_t numSlices() const { return slices_.size(); }
+			size_t numInFlight() const { return pending_.size(); }
+			size_t numRetries() const { return numRetries_; }
+
+			/*----------------------------------------------------------------
+			 * Name			: parseTime
+			 * Description	: Parses a YYYY-MM-DDTHH:MM:SS time
+			 * Arguments	: text is the time
+			 *				  seconds receives it, in seconds since
+			 *				  1970-01-01
+			 * Returns		: true if text is a time
+			 *---------------------------------------------------------------*/
+			static bool parseTime(const char *text, long long *seconds);
+
+			/*----------------------------------------------------------------
+			 * Name			: toSeconds
+			 * Description	: Converts a GMT Datetime to seconds since
+			 *				  1970-01-01
+			 * Arguments	: time is a Datetime with the DATE part,
+			 *				  unset TIME parts count as 0
+			 * Returns		: seconds since 1970-01-01
+			 *---------------------------------------------------------------*/
+			static long long toSeconds(const blpapi::Datetime& time);
+
+			/*----------------------------------------------------------------
+			 * Name			: toDatetime
+			 * Description	: Converts seconds since 1970-01-01 to a
+			 *				  Datetime
+			 * Arguments	: seconds is the time
+			 * Returns		: Datetime with the DATE and TIME parts
+			 *---------------------------------------------------------------*/
+			static blpapi::Datetime toDatetime(long long seconds);
+
+		private:
+			/*----------------------------------------------------------------
+			 * Name			: sendNext
+			 * Description	: Sends queued slices until maxInFlight are
+			 *				  outstanding
+			 * Arguments	: none
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			void sendNext();
+
+			/*----------------------------------------------------------------
+			 * Name			: fail
+			 * Description	: Ends an attempt of a slice with an error,
+			 *				  queueing the slice again if it has retries
+			 *				  left
+			 * Arguments	: slice is the slice
+			 *				  error is the reason
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			void fail(RequestSlice& slice, const std::string& error);
+
+			/*----------------------------------------------------------------
+			 * Name			: deliver
+			 * Description	: Hands the completed slices that follow the
+			 *				  last handed slice to the handler
+			 * Arguments	: none
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			void deliver();
+
+			blpapi::Session& session_;
+			blpapi::Service service_;
+			std::string operation_;
+			SliceHandler& handler_;
+			const blpapi::Identity *identity_;
+			size_t maxInFlight_;
+			unsigned int maxRetries_;
+
+			std::vector<RequestSlice> slices_;
+
+			//slices to send, retries first
+			std::deque<size_t> queue_;
+
+			//slice of each outstanding correlation id
+			std::map<long long, size_t> pending_;
+
+			//correlation id of the next request
+			long long nextId_;
+
+			//first slice not handed to the handler
+			size_t nextSlice_;
+
+			size_t numRetries_;
+
+			// Unimplemented
+			RequestPlanner(const RequestPlanner&);
+			RequestPlanner& operator=(const RequestPlanner&);
+	};
+}
+
+#endif
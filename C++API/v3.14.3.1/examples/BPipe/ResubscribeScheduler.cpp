@@ -0,0 +1,184 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: ResubscribeScheduler.cpp
+ *
+ * Description: This file contains the scheduler of the resubscribes
+ *				requested when a market depth sequence gap is detected.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#include <blpapi_highresolutionclock.h>
+
+#include <vector>
+#include "ResubscribeScheduler.h"
+
+using namespace BloombergLP;
+using namespace blpapi;
+
+/*----------------------------------------------------------------
+ * Class		 : ResubscribeScheduler
+ * Description   : Resubscribes only the subscriptions that had a
+ *				   sequence gap
+ *---------------------------------------------------------------*/
+
+/*----------------------------------------------------------------
+ * Name			: ResubscribeScheduler constructor
+ * Description	: Constructs a scheduler with nothing queued
+ * Arguments	: subscriptions holds the topic string of every
+ *				  correlation id
+ *				  intervalMs is the least time between two resubscribes
+ *				  maxTopics is the most subscriptions sent at once
+ *				  retryMs is the time after which a subscription whose
+ *				  recap has not arrived may be queued again
+ * Returns		: none
+ *---------------------------------------------------------------*/
+ResubscribeScheduler::ResubscribeScheduler(const SubscriptionList &subscriptions,
+	unsigned int intervalMs, unsigned int maxTopics, unsigned int retryMs)
+: subscriptions_(subscriptions)
+, intervalNs_((long long)intervalMs * 1000000)
+, maxTopics_(maxTopics > 0 ? maxTopics : 1)
+, retryNs_((long long)retryMs * 1000000)
+, flushed_(false)
+, coalesced_(0)
+{
+}
+
+/*----------------------------------------------------------------
+ * Name			: request
+ * Description	: Queues the resubscribe of one subscription
+ * Arguments	: id is the subscription correlation id value
+ * Returns		: true if queued, false if coalesced
+ *---------------------------------------------------------------*/
+bool ResubscribeScheduler::request(long long id)
+{
+	Guard guard(lock_);
+	std::map<long long, Entry>::iterator it = entries_.find(id);
+	if (it != entries_.end()) {
+		if (it->second.state_ == QUEUED ||
+			TimePointUtil::nanosecondsBetween(it->second.sentAt_,
+				HighResolutionClock::now()) < retryNs_) {
+			++coalesced_;
+			return false;
+		}
+		//recap overdue, send again
+		it->second.state_ = QUEUED;
+	} else {
+		Entry entry;
+		entry.state_ = QUEUED;
+		entries_.insert(std::make_pair(id, entry));
+	}
+	queue_.push_back(id);
+	return true;
+}
+
+/*----------------------------------------------------------------
+ * Name			: recovered
+ * Description	: Records that the recap of a subscription has started
+ * Arguments	: id is the subscription correlation id value
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void ResubscribeScheduler::recovered(long long id)
+{
+	Guard guard(lock_);
+	std::map<long long, Entry>::iterator it = entries_.find(id);
+	//a queued subscription is still sent, the recap may be an
+	//unrelated one that started before the gap
+	if (it != entries_.end() && it->second.state_ == SENT) {
+		entries_.erase(it);
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: flush
+ * Description	: Resubscribes the oldest queued subscriptions if the
+ *				  interval since the last resubscribe has passed
+ * Arguments	: session is the session subscribed to
+ * Returns		: number of subscriptions resubscribed
+ *---------------------------------------------------------------*/
+unsigned int ResubscribeScheduler::flush(Session *session)
+{
+	SubscriptionList list;
+	{
+		Guard guard(lock_);
+		if (queue_.empty()) return 0;
+		TimePoint now = HighResolutionClock::now();
+		if (flushed_ && TimePointUtil::nanosecondsBetween(lastFlush_, now) < intervalNs_) {
+			return 0;
+		}
+		flushed_ = true;
+		lastFlush_ = now;
+
+		std::vector<long long> ids;
+		while (!queue_.empty() && ids.size() < maxTopics_) {
+			long long id = queue_.front();
+			queue_.pop_front();
+			Entry &entry = entries_[id];
+			entry.state_ = SENT;
+			entry.sentAt_ = now;
+			ids.push_back(id);
+		}
+		for (size_t i = 0; i < subscriptions_.size(); ++i) {
+			CorrelationId cid = subscriptions_.correlationIdAt(i);
+			for (size_t j = 0; j < ids.size(); ++j) {
+				if (cid.asInteger() == ids[j]) {
+					list.add(subscriptions_.topicStringAt(i), cid);
+					break;
+				}
+			}
+		}
+	}
+	// outside the lock, other threads keep queueing gaps
+	if (list.size() > 0) {
+		session->resubscribe(list);
+	}
+	return (unsigned int)list.size();
+}
+
+/*----------------------------------------------------------------
+ * Name			: pending
+ * Description	: Returns the number of queued subscriptions
+ * Arguments	: none
+ * Returns		: number of subscriptions waiting for flush()
+ *---------------------------------------------------------------*/
+unsigned int ResubscribeScheduler::pending()
+{
+	Guard guard(lock_);
+	return (unsigned int)queue_.size();
+}
+
+/*----------------------------------------------------------------
+ * Name			: coalesced
+ * Description	: Returns the number of requests coalesced
+ * Arguments	: none
+ * Returns		: number of requests that did not queue a resubscribe
+ *---------------------------------------------------------------*/
+unsigned long long ResubscribeScheduler::coalesced()
+{
+	Guard guard(lock_);
+	return coalesced_;
+}
@@ -0,0 +1,163 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: ResubscribeScheduler.h
+ *
+ * Description: This file contains the scheduler of the resubscribes
+ *				requested when a market depth sequence gap is detected.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef __ResubscribeScheduler_h__
+#define __ResubscribeScheduler_h__
+
+#include <blpapi_session.h>
+#include <blpapi_subscriptionlist.h>
+#include <blpapi_timepoint.h>
+
+#include <deque>
+#include <map>
+
+#include "SyncIO.h"
+
+namespace BloombergLP
+{
+
+	/*----------------------------------------------------------------
+	 * Class		 : ResubscribeScheduler
+	 * Description   : Resubscribes only the subscriptions that had a
+	 *				   sequence gap. Gaps reported for a subscription
+	 *				   that is already queued, or whose recap has not
+	 *				   arrived yet, are coalesced into the pending
+	 *				   resubscribe. Queued subscriptions are sent together
+	 *				   by flush(), at most maxTopics at a time and no more
+	 *				   often than once per interval, so a network blip
+	 *				   affecting many books does not become a recap storm.
+	 *				   Any thread may call any method.
+	 *---------------------------------------------------------------*/
+	class ResubscribeScheduler
+	{
+	public:
+		/*----------------------------------------------------------------
+		 * Name			: ResubscribeScheduler constructor
+		 * Description	: Constructs a scheduler with nothing queued
+		 * Arguments	: subscriptions holds the topic string of every
+		 *				  correlation id, it must not change while the
+		 *				  scheduler is used
+		 *				  intervalMs is the least time between two
+		 *				  resubscribes
+		 *				  maxTopics is the most subscriptions sent in one
+		 *				  resubscribe
+		 *				  retryMs is the time after which a subscription
+		 *				  whose recap has not arrived may be queued again
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		ResubscribeScheduler(const blpapi::SubscriptionList &subscriptions,
+			unsigned int intervalMs = 1000, unsigned int maxTopics = 16,
+			unsigned int retryMs = 10000);
+
+		/*----------------------------------------------------------------
+		 * Name			: request
+		 * Description	: Queues the resubscribe of one subscription
+		 * Arguments	: id is the subscription correlation id value
+		 * Returns		: true if queued, false if coalesced with a
+		 *				  resubscribe already queued or sent
+		 *---------------------------------------------------------------*/
+		bool request(long long id);
+
+		/*----------------------------------------------------------------
+		 * Name			: recovered
+		 * Description	: Records that the recap of a subscription has
+		 *				  started, a later gap queues it again at once
+		 * Arguments	: id is the subscription correlation id value
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		void recovered(long long id);
+
+		/*----------------------------------------------------------------
+		 * Name			: flush
+		 * Description	: Resubscribes the oldest queued subscriptions if
+		 *				  the interval since the last resubscribe has
+		 *				  passed. Cheap when nothing is queued.
+		 * Arguments	: session is the session subscribed to
+		 * Returns		: number of subscriptions resubscribed
+		 *---------------------------------------------------------------*/
+		unsigned int flush(blpapi::Session *session);
+
+		/*----------------------------------------------------------------
+		 * Name			: pending
+		 * Description	: Returns the number of queued subscriptions
+		 * Arguments	: none
+		 * Returns		: number of subscriptions waiting for flush()
+		 *---------------------------------------------------------------*/
+		unsigned int pending();
+
+		/*----------------------------------------------------------------
+		 * Name			: coalesced
+		 * Description	: Returns the number of requests coalesced
+		 * Arguments	: none
+		 * Returns		: number of requests that did not queue a
+		 *				  resubscribe
+		 *---------------------------------------------------------------*/
+		unsigned long long coalesced();
+
+	private:
+		//state of a subscription with a gap
+		enum State { QUEUED, SENT };
+
+		struct Entry
+		{
+			int state_;
+
+			//time of the resubscribe, SENT only
+			blpapi::TimePoint sentAt_;
+		};
+
+		const blpapi::SubscriptionList &subscriptions_;
+		long long intervalNs_;
+		unsigned int maxTopics_;
+		long long retryNs_;
+
+		SyncIO lock_;
+
+		//subscriptions queued or waiting for their recap
+		std::map<long long, Entry> entries_;
+
+		//queued subscriptions, oldest first
+		std::deque<long long> queue_;
+
+		blpapi::TimePoint lastFlush_;
+		bool flushed_;
+		unsigned long long coalesced_;
+
+		// Unimplemented
+		ResubscribeScheduler(const ResubscribeScheduler&);
+		ResubscribeScheduler& operator=(const ResubscribeScheduler&);
+	};
+}
+
+#endif
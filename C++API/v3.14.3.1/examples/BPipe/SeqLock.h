@@ -0,0 +1,338 @@
+/* --------------------------------------------------------------------
+ *                          DISCLAIMER OF WARRANTY
+ *
+ * THE CODE SAMPLES PROVIDED IN THIS SDK (IN SOURCE CODE AND BINARY FORM) ARE
+ * PROVIDED "AS IS," WITHOUT A WARRANTY OF ANY KIND. ALL EXPRESS OR IMPLIED
+ * CONDITIONS, REPRESENTATIONS AND WARRANTIES, INCLUDING ANY IMPLIED WARRANTY
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE OR NON-INFRINGEMENT,
+ * ARE HEREBY EXCLUDED. BLOOMBERG AND ITS LICENSORS SHALL NOT BE LIABLE FOR
+ * ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR
+ * DISTRIBUTING THE SOFTWARE OR ITS DERIVATIVES. IN NO EVENT WILL BLOOMBERG
+ * OR ITS LICENSORS BE LIABLE FOR ANY LOST REVENUE, PROFIT OR DATA, OR FOR
+ * DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL, INCIDENTAL OR PUNITIVE DAMAGES,
+ * HOWEVER CAUSED AND REGARDLESS OF THE THEORY OF LIABILITY, ARISING OUT OF
+ * THE USE OF OR INABILITY TO USE SOFTWARE, EVEN IF BLOOMBERG HAS BEEN ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGES.
+ * THE CODE SAMPLES PROVIDED WITH THE B-PIPE SDK ARE NOT INTENDED FOR
+ * PRODUCTION USE, AND IF PUT TO SUCH USE THEY MAY RESULT IN SLOWNESS OR LOSS
+ * OF DATA.
+ * ----------------------------------------------------------------- */
+
+/* --------------------------------------------------------------------
+ * File: SeqLock.h
+ *
+ * Description: This source code defines the SeqLock class, a sequence
+ *				lock letting a single writer publish data to any number
+ *				of readers without blocking, and the BookSnapshot class
+ *				that uses it to publish the top of a market depth book.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef _SEQLOCK_H_
+#define  _SEQLOCK_H_
+
+#include <string.h>  // memcpy
+#include <vector>
+
+/* --------------------------------------------------------------------
+ * Class/Struct : SeqLock
+ * Description  : Sequence lock. The writer makes the sequence odd while
+ *				  it changes the protected data and even again when done.
+ *				  A reader remembers the sequence, copies the data and
+ *				  retries if the sequence was odd or has moved.
+ *				  Only one thread may write at a time.
+ *				  Windows uses Interlocked functions
+ *				  Unix uses the gcc __atomic builtins
+ * --------------------------------------------------------------------*/
+
+#if defined(WIN32) || defined(_WIN32)
+#include <windows.h>
+
+class SeqLock
+{
+    public:
+		/*-------------------------------------------------
+		 * Name			: SeqLock
+		 * Description	: Default constructor
+		 * Arguments	: none
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        SeqLock() : sequence_(0)
+        {
+        }
+
+		/*-------------------------------------------------
+		 * Name			: writeBegin
+		 * Description	: Marks the start of a write
+		 * Arguments	: none
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        void writeBegin(void)
+        {
+            InterlockedIncrement(&sequence_);     // full barrier
+        }
+
+		/*-------------------------------------------------
+		 * Name			: writeEnd
+		 * Description	: Marks the end of a write
+		 * Arguments	: none
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        void writeEnd(void)
+        {
+            InterlockedIncrement(&sequence_);     // full barrier
+        }
+
+		/*-------------------------------------------------
+		 * Name			: readBegin
+		 * Description	: Waits for any write in progress and
+		 *				  returns the sequence to validate with
+		 * Arguments	: none
+		 * Returns		: sequence at the start of the read
+		 *-------------------------------------------------*/
+        long readBegin(void) const
+        {
+            long sequence;
+            while ((sequence = sequence_) & 1)
+            {
+                YieldProcessor();
+            }
+            MemoryBarrier();
+            return sequence;
+        }
+
+		/*-------------------------------------------------
+		 * Name			: readRetry
+		 * Description	: Checks whether the data read since
+		 *				  readBegin may be inconsistent
+		 * Arguments	: sequence is the value from readBegin
+		 * Returns		: true if the read must be retried
+		 *-------------------------------------------------*/
+        bool readRetry(long sequence) const
+        {
+            MemoryBarrier();
+            return sequence_ != sequence;
+        }
+
+    protected:
+        volatile LONG sequence_;
+
+    private:
+        // Unimplemented
+        SeqLock(const SeqLock&);
+        SeqLock& operator=(const SeqLock&);
+};
+#else
+#include <sched.h>                                // sched_yield
+
+class SeqLock
+{
+    public:
+		/*-------------------------------------------------
+		 * Name			: SeqLock
+		 * Description	: Default constructor
+		 * Arguments	: none
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        SeqLock() : sequence_(0)
+        {
+        }
+
+		/*-------------------------------------------------
+		 * Name			: writeBegin
+		 * Description	: Marks the start of a write
+		 * Arguments	: none
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        void writeBegin(void)
+        {
+            __atomic_store_n(&sequence_, sequence_ + 1, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_RELEASE);
+        }
+
+		/*-------------------------------------------------
+		 * Name			: writeEnd
+		 * Description	: Marks the end of a write
+		 * Arguments	: none
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        void writeEnd(void)
+        {
+            __atomic_store_n(&sequence_, sequence_ + 1, __ATOMIC_RELEASE);
+        }
+
+		/*-------------------------------------------------
+		 * Name			: readBegin
+		 * Description	: Waits for any write in progress and
+		 *				  returns the sequence to validate with
+		 * Arguments	: none
+		 * Returns		: sequence at the start of the read
+		 *-------------------------------------------------*/
+        long readBegin(void) const
+        {
+            long sequence;
+            while ((sequence = __atomic_load_n(&sequence_, __ATOMIC_ACQUIRE)) & 1)
+            {
+                sched_yield();
+            }
+            return sequence;
+        }
+
+		/*-------------------------------------------------
+		 * Name			: readRetry
+		 * Description	: Checks whether the data read since
+		 *				  readBegin may be inconsistent
+		 * Arguments	: sequence is the value from readBegin
+		 * Returns		: true if the read must be retried
+		 *-------------------------------------------------*/
+        bool readRetry(long sequence) const
+        {
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            return __atomic_load_n(&sequence_, __ATOMIC_RELAXED) != sequence;
+        }
+
+    protected:
+        long sequence_;
+
+    private:
+        // Unimplemented
+        SeqLock(const SeqLock&);
+        SeqLock& operator=(const SeqLock&);
+};
+#endif
+
+
+/* --------------------------------------------------------------------
+ * Class/Struct : BookSnapshot
+ * Description  : Top of book published through a SeqLock. The book
+ *				  thread calls publish() after a change to the top
+ *				  levels, any other thread calls read() to get a
+ *				  consistent copy without locking the book. The
+ *				  decimals of the prices are published with the
+ *				  levels since a book may widen its price scale.
+ *				  ENTRY must be copyable with memcpy.
+ * --------------------------------------------------------------------*/
+template <typename ENTRY>
+class BookSnapshot
+{
+public:
+	/*-------------------------------------------------
+	 * Name			: BookSnapshot
+	 * Description	: Default constructor. Depth is 0 which
+	 *				  disables publication.
+	 * Arguments	: none
+	 * Returns		: none
+	 *-------------------------------------------------*/
+	BookSnapshot() : depth_(0), count_(0), decimals_(0)
+	{
+	}
+
+	/*-------------------------------------------------
+	 * Name			: setDepth
+	 * Description	: Sets the number of levels published. Must
+	 *				  be called before any reader or writer runs.
+	 * Arguments	: depth is the number of levels
+	 * Returns		: none
+	 *-------------------------------------------------*/
+	void setDepth(unsigned int depth)
+	{
+		depth_ = depth;
+		count_ = 0;
+		entries_.assign(depth, ENTRY());
+	}
+
+	/*-------------------------------------------------
+	 * Name			: depth
+	 * Description	: Returns the number of levels published
+	 * Arguments	: none
+	 * Returns		: depth, 0 if publication is disabled
+	 *-------------------------------------------------*/
+	unsigned int depth() const
+	{
+		return depth_;
+	}
+
+	/*-------------------------------------------------
+	 * Name			: publish
+	 * Description	: Copies the top levels of the book. Called
+	 *				  by the book writer only.
+	 * Arguments	: first is an iterator to the best level
+	 *				  count is the number of levels in the book
+	 *				  decimals is the number of decimals of
+	 *				  the level prices
+	 * Returns		: none
+	 *-------------------------------------------------*/
+	template <typename ITERATOR>
+	void publish(ITERATOR first, unsigned int count, unsigned int decimals)
+	{
+		if (count > depth_)
+		{
+			count = depth_;
+		}
+		lock_.writeBegin();
+		for (unsigned int i = 0; i < count; ++i, ++first)
+		{
+			entries_[i] = *first;
+		}
+		count_ = count;
+		decimals_ = decimals;
+		lock_.writeEnd();
+	}
+
+	/*-------------------------------------------------
+	 * Name			: read
+	 * Description	: Copies a consistent snapshot of the top
+	 *				  levels, never blocks the writer
+	 * Arguments	: entries is where the levels are stored
+	 *				  maxEntries is the size of entries
+	 *				  decimals receives the decimals of the
+	 *				  level prices, may be 0
+	 * Returns		: number of levels copied
+	 *-------------------------------------------------*/
+	unsigned int read(ENTRY *entries, unsigned int maxEntries,
+		unsigned int *decimals = 0) const
+	{
+		unsigned int count;
+		unsigned int published;
+		long sequence;
+		do
+		{
+			sequence = lock_.readBegin();
+			count = count_;
+			published = decimals_;
+			if (count > maxEntries)
+			{
+				count = maxEntries;
+			}
+			if (count > 0)
+			{
+				memcpy(entries, &entries_[0], count * sizeof(ENTRY));
+			}
+		} while (lock_.readRetry(sequence));
+		if (decimals != 0)
+		{
+			*decimals = published;
+		}
+		return count;
+	}
+
+private:
+	SeqLock lock_;
+	unsigned int depth_;
+	unsigned int count_;
+	unsigned int decimals_;
+	std::vector<ENTRY> entries_;
+
+	// Unimplemented
+	BookSnapshot(const BookSnapshot&);
+	BookSnapshot& operator=(const BookSnapshot&);
+};
+#endif
@@ -33,6 +33,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "AsyncRequester.h"
+
 using namespace std;
 using namespace BloombergLP;
 using namespace blpapi;
@@ -52,10 +54,20 @@ namespace {
 
 class MyEventHandler :public EventHandler {
     // Process events using callback
+    AsyncRequester *d_requester;	// completes the asynchronous requests
 
     public: 
+    MyEventHandler() : d_requester(0) {}
+
+    void setRequester(AsyncRequester *requester) {
+        d_requester = requester;
+    }
+
     bool processEvent(const Event &event, Session *session) {
         try {
+            if (d_requester && d_requester->processEvent(event)) {
+                return true;
+            }
             if (event.eventType() == Event::SUBSCRIPTION_DATA) {
                 MessageIterator msgIter(event);
                 while (msgIter.next()) {
@@ -88,6 +100,10 @@ class SimpleBlockingRequestExample {
 	std::string			d_name;	        // DirectoryService/ApplicationName
     Identity			d_identity;
 	Session				*d_session;
+	MyEventHandler		*d_handler;
+	AsyncRequester		*d_requester;
+	bool				d_async;		// one request per security, completed by callback
+	std::vector<std::string> d_securities;
 
     void printUsage()
     {
@@ -97,6 +113,8 @@ class SimpleBlockingRequestExample {
             << "        [-p         <tcpPort   = 8194>" << std::endl
 			<< "        [-auth      <authenticationOption = LOGON (default) or NONE or APPLICATION or DIRSVC or USER_APP>]" << std::endl
 			<< "        [-n         <name = applicationName or directoryService>]" << std::endl
+			<< "        [-async     send the requests without blocking]" << std::endl
+			<< "        [-s         <security   = IBM US Equity>, with -async]" << std::endl
 			<< "Notes:" << std::endl
 			<< " -Specify only LOGON to authorize 'user' using Windows login name." << std::endl
 			<< " -Specify DIRSVC and name(Directory Service Property) to authorize user using directory Service." << std::endl
@@ -114,6 +132,10 @@ class SimpleBlockingRequestExample {
 				d_authOption = argv[++i];
 			} else if (!std::strcmp(argv[i],"-n") &&  i + 1 < argc) {
                 d_name = argv[++i];
+			} else if (!std::strcmp(argv[i],"-async")) {
+                d_async = true;
+			} else if (!std::strcmp(argv[i],"-s") &&  i + 1 < argc) {
+                d_securities.push_back(argv[++i]);
             } else {
                 printUsage();
                 return false;
@@ -140,20 +162,72 @@ class SimpleBlockingRequestExample {
              return false;
 		}
 
+		if (d_securities.size() == 0) {
+			d_securities.push_back("IBM US Equity");
+		}
+
 		return true;
     }
 
+    // send one request per security and wait for all of them, the
+    // event dispatcher thread completes the requests in any order
+    void sendAsyncRequests()
+    {
+		Service refDataService = d_session->getService(REFDATA_SVC);
+		std::vector<ResponseFuture *> futures;
+		for (size_t i = 0; i < d_securities.size(); ++i) {
+			Request request = refDataService.createRequest("ReferenceDataRequest");
+			request.append("securities", d_securities[i].c_str());
+			request.append("fields", "DS002");
+			futures.push_back(new ResponseFuture());
+			try {
+				d_requester->sendRequest(request, *futures.back());
+			} catch (Exception &e) {
+				// the request was not sent, the ones before it still
+				// complete into their futures
+				std::cerr << d_securities[i] << ": not sent, "
+					<< e.description() << std::endl;
+				delete futures.back();
+				futures.pop_back();
+				break;
+			}
+		}
+		std::cout << "Sent " << futures.size() << " requests" << std::endl;
+
+		for (size_t i = 0; i < futures.size(); ++i) {
+			if (!futures[i]->wait(30000)) {
+				// the future must outlive its request
+				std::cout << d_securities[i] << ": no response" << std::endl;
+				continue;
+			}
+			if (futures[i]->failed()) {
+				std::cout << d_securities[i] << ": FAILED "
+					<< futures[i]->error() << std::endl;
+			} else {
+				for (size_t j = 0; j < futures[i]->messages().size(); ++j) {
+					futures[i]->messages()[j].print(std::cout);
+				}
+			}
+			delete futures[i];
+		}
+    }
+
 public:
     SimpleBlockingRequestExample(): d_session(0)
 		, d_cid((int)1)
 		, d_port(8194)
 		, d_name("") 
+		, d_handler(0)
+		, d_requester(0)
+		, d_async(false)
 	{
     }
 
 	~SimpleBlockingRequestExample()
 	{
+		// stops the dispatcher thread before the requester goes
 		if (d_session) delete d_session;
+		if (d_requester) delete d_requester;
 	}
 
 	// construct authentication option string
@@ -264,7 +338,15 @@ public:
 			sessionOptions.setAuthenticationOptions(authOptions.c_str());
 		}
 
-		d_session = new Session(sessionOptions, new MyEventHandler());
+		d_handler = new MyEventHandler();
+		d_session = new Session(sessionOptions, d_handler);
+		if (d_async) {
+			// the dispatcher thread reads the requester of the handler,
+			// so it is set before the session starts
+			d_requester = new AsyncRequester(*d_session,
+				authOptions.size() > 0 ? &d_identity : 0);
+			d_handler->setRequester(d_requester);
+		}
         if (!d_session->start()) {
             std::cerr << "Failed to start session." << std::endl;
             return;
@@ -295,6 +377,11 @@ public:
 			d_session->subscribe(subscriptions);
 		}
 
+		if (d_async) {
+			sendAsyncRequests();
+			return;
+		}
+
 		Service refDataService = d_session->getService(REFDATA_SVC);
         Request request = refDataService.createRequest("ReferenceDataRequest");
         request.append("securities", "IBM US Equity");
@@ -29,9 +29,12 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 #include <stdlib.h>
 #include <string.h>
 
+#include "TopicConflator.h"
+
 using namespace BloombergLP;
 using namespace blpapi;
 
@@ -44,6 +47,31 @@ namespace {
 
 	const char *MKTDATA_SVC = "//blp/mktdata";
 	const char *AUTH_SVC = "//blp/apiauth";
+
+	// prints the fields that changed in a conflated update
+	class ConflatedPrinter : public ConflatedTopicListener
+	{
+		const TopicConflator &d_conflator;
+
+	public:
+		ConflatedPrinter(const TopicConflator &conflator)
+			: d_conflator(conflator)
+		{
+		}
+
+		void onTopic(const ConflatedTopic &topic)
+		{
+			std::cout << (char *)topic.topic_.asPointer() << " - "
+				<< topic.updates_ << " updates";
+			for (size_t i = 0; i < d_conflator.numFields(); ++i) {
+				if (topic.changeMask_ & (1ULL << i)) {
+					std::cout << " " << d_conflator.field((int)i)
+						<< "=" << topic.values_[i];
+				}
+			}
+			std::cout << std::endl;
+		}
+	};
 }
 
 class SimpleSubscriptionIntervalExample
@@ -56,6 +84,7 @@ class SimpleSubscriptionIntervalExample
 	Session				*d_session;
     int                 d_maxEvents;
     int                 d_eventCount;
+    int                 d_conflateMs;	// client side interval, -1 for the server side one
 
     void printUsage()
     {
@@ -66,6 +95,7 @@ class SimpleSubscriptionIntervalExample
 			<< "        [-auth      <authenticationOption = LOGON (default) or NONE or APPLICATION or DIRSVC or USER_APP>]" << std::endl
             << "        [-n         <name = applicationName or directoryService>]" << std::endl
             << "        [-me        <maxEvents  = MAX_INT>" << std::endl
+            << "        [-conflate  <milliseconds between updates of a topic, client side>]" << std::endl
             << "Notes:" << std::endl
             << " -Specify only LOGON to authorize 'user' using Windows login name." << std::endl
             << " -Specify DIRSVC and name(Directory Service Property) to authorize user using directory Service." << std::endl
@@ -86,6 +116,8 @@ class SimpleSubscriptionIntervalExample
 				d_name = argv[++i];
             else if (!std::strcmp(argv[i],"-me") && i + 1 < argc)
                 d_maxEvents = std::atoi(argv[++i]);
+            else if (!std::strcmp(argv[i],"-conflate") && i + 1 < argc)
+                d_conflateMs = std::atoi(argv[++i]);
             else { 
                 printUsage();
                 return false;
@@ -234,6 +266,35 @@ public:
 	{
 	}
 
+    // merge the ticks of each topic, print at most one update per
+    // topic per interval
+    void conflatedEventLoop()
+    {
+        std::vector<std::string> fields;
+        fields.push_back("LAST_PRICE");
+        fields.push_back("BID");
+        fields.push_back("ASK");
+        fields.push_back("BID_YIELD");
+        fields.push_back("ASK_YIELD");
+        TopicConflator conflator(fields, d_conflateMs);
+        ConflatedPrinter printer(conflator);
+
+        while (true) {
+            Event event = d_session->nextEvent(d_conflateMs > 0 ? d_conflateMs : 100);
+            if (event.eventType() == Event::SUBSCRIPTION_DATA) {
+                conflator.publish(event);
+                if (++d_eventCount >= d_maxEvents) break;
+            } else if (event.eventType() != Event::TIMEOUT) {
+                MessageIterator msgIter(event);
+                while (msgIter.next()) {
+                    msgIter.message().print(std::cout) << std::endl;
+                }
+            }
+            conflator.deliver(printer, 0);
+        }
+        std::cout << conflator.conflated() << " updates conflated" << std::endl;
+    }
+
 	~SimpleSubscriptionIntervalExample()
 	{
 		if (d_session) delete d_session;
@@ -244,6 +305,7 @@ public:
         d_port = 8194;
         d_maxEvents = INT_MAX;
         d_eventCount = 0;
+        d_conflateMs = -1;
 		d_name = "";
 
         if (!parseCommandLine(argc, argv)) return;
@@ -263,16 +325,18 @@ public:
 
         const char *security1 = "IBM US Equity";
         const char *security2 = "/cusip/912828GM6@BGN";
+        // with client side conflation the server sends every tick
+        const char *options = d_conflateMs < 0 ? "interval=1.0" : "";
         SubscriptionList subscriptions;
         subscriptions.add(
                 security1,
                 "LAST_PRICE,BID,ASK",
-                "interval=1.0",
+                options,
                 CorrelationId((char *)security1));
         subscriptions.add(
                 security2,
                 "LAST_PRICE,BID,ASK,BID_YIELD,ASK_YIELD",
-                "interval=1.0",
+                options,
                 CorrelationId((char *)security2));
 		std::cout << "Sending subscriptions" <<  std::endl;
 		if (!strcmp(d_authOption.c_str(), "NONE")) {
@@ -288,6 +352,11 @@ public:
 	        d_session->subscribe(subscriptions, d_identity);
 		}
 
+        if (d_conflateMs >= 0) {
+            conflatedEventLoop();
+            return;
+        }
+
         while (true) {
             Event event = d_session->nextEvent();
             MessageIterator msgIter(event);
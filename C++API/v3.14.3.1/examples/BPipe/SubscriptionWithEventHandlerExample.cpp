@@ -36,6 +36,8 @@
 #include <iostream>
 #include <fstream>
 
+#include "LastValueCache.h"
+
 using namespace std;
 using namespace BloombergLP;
 using namespace blpapi;
@@ -63,6 +65,8 @@ namespace {
 
 class SubscriptionEventHandler: public EventHandler
 {
+    LastValueCache *d_cache;    // keeps the data instead of printing it, may be 0
+
     size_t getTimeStamp(char *buffer, size_t bufSize)
     {
         const char *format = "%Y/%m/%d %X";
@@ -139,6 +143,11 @@ class SubscriptionEventHandler: public EventHandler
 
     bool processSubscriptionDataEvent(const Event &event)
     {
+        if (d_cache) {
+            d_cache->publish(event);
+            return true;
+        }
+
         char timeBuffer[64];
         getTimeStamp(timeBuffer, sizeof(timeBuffer));
 
@@ -214,7 +223,8 @@ class SubscriptionEventHandler: public EventHandler
     }
 
 public:
-	SubscriptionEventHandler()
+	SubscriptionEventHandler(LastValueCache *cache = 0)
+    : d_cache(cache)
     {
     }
 
@@ -257,6 +267,8 @@ class SubscriptionWithEventHandlerExample
     std::vector<std::string>     d_options; 
     SubscriptionList             d_subscriptions; 
 	string						 d_service;
+	bool						 d_lastValues;	// keep a last value cache
+	LastValueCache				*d_cache;
 
     bool createSession() { 
 		cout << "Connecting to port " << d_port << " on server: "; 
@@ -277,7 +289,7 @@ class SubscriptionWithEventHandlerExample
 		if (authOptions.size() > 0) {
 			d_sessionOptions.setAuthenticationOptions(authOptions.c_str());
 		}
-		d_eventHandler = new SubscriptionEventHandler();
+		d_eventHandler = new SubscriptionEventHandler(d_cache);
         d_session = new Session(d_sessionOptions, d_eventHandler);
 
         if (!d_session->start()) {
@@ -409,6 +421,8 @@ class SubscriptionWithEventHandlerExample
 				secFileName = argv[++i];
 			} else if (!std::strcmp(argv[i],"-fFile") && i + 1 < argc) {
 				fldFileName = argv[++i];
+			} else if (!std::strcmp(argv[i],"-lvc")) {
+				d_lastValues = true;
 			} else {
 				printUsage();
 				return false;
@@ -463,6 +477,14 @@ class SubscriptionWithEventHandlerExample
                                 CorrelationId(&d_securities[i]));
         }
 
+		if (d_lastValues) {
+			// the slots are given before the session delivers data
+			d_cache = new LastValueCache(d_fields, d_securities.size());
+			for (size_t i = 0; i < d_securities.size(); ++i) {
+				d_cache->addTopic(CorrelationId(&d_securities[i]));
+			}
+		}
+
         return true;
     }
 
@@ -524,6 +546,7 @@ class SubscriptionWithEventHandlerExample
 			"        [-fFile <field list file>\n"
 			"        [-auth  <authenticationOption = LOGON (default) or NONE or APPLICATION or DIRSVC or USER_APP>]\n"
 			"        [-n     <name = applicationName or directoryService>]\n"
+			"        [-lvc   keep the last values and print them on ENTER]\n"
             "Notes:\n"
             " -Specify only LOGON to authorize 'user' using Windows login name.\n"
             " -Specify DIRSVC and name(Directory Service Property) to authorize user using directory Service.\n"
@@ -536,6 +559,8 @@ public:
     SubscriptionWithEventHandlerExample()
     : d_session(0)
     , d_eventHandler(0)
+    , d_lastValues(false)
+    , d_cache(0)
     {
 		d_service = "";
 		d_port = 8194;
@@ -546,8 +571,32 @@ public:
     {
         if (d_session) delete d_session;
         if (d_eventHandler) delete d_eventHandler ;
+        if (d_cache) delete d_cache;
     }
 
+	// reads the cache from this thread while the dispatcher thread
+	// updates it
+	void printLastValues()
+	{
+		std::vector<Float64> values(d_cache->numFields());
+		for (size_t i = 0; i < d_cache->numTopics(); ++i) {
+			unsigned long long setMask;
+			unsigned long long updates = d_cache->read((int)i, &values[0], &setMask);
+			std::string *topic = reinterpret_cast<std::string*>(
+				d_cache->topic((int)i).asPointer());
+			fprintf(stdout, "%s: %llu updates\n", topic->c_str(), updates);
+			for (size_t j = 0; j < d_cache->numFields(); ++j) {
+				if (setMask & (1ULL << j)) {
+					fprintf(stdout, "        %s = %g\n",
+						d_cache->field((int)j).c_str(), values[j]);
+				} else {
+					fprintf(stdout, "        %s is not set\n",
+						d_cache->field((int)j).c_str());
+				}
+			}
+		}
+	}
+
     void run(int argc, char **argv)
     {
         if (!parseCommandLine(argc, argv)) return;
@@ -564,9 +613,17 @@ public:
 			d_session->subscribe(d_subscriptions);
 		}
 
-        // wait for enter key to exit application
-        fprintf(stdout, "Press ENTER to quit\n\n");
-        getchar();
+        if (d_cache) {
+            std::string line;
+            fprintf(stdout, "Press ENTER to print the last values, q and ENTER to quit\n\n");
+            while (std::getline(std::cin, line) && line != "q") {
+                printLastValues();
+            }
+        } else {
+            // wait for enter key to exit application
+            fprintf(stdout, "Press ENTER to quit\n\n");
+            getchar();
+        }
 
         d_session->stop();
         fprintf(stdout, "Exiting...\n");
@@ -104,6 +104,7 @@ class SyncIO
 #else
 #include <unistd.h>                               // sleep
 #include <pthread.h>                              // should be present on a unix systems supported
+#include <time.h>                                 // clock_gettime
 
 class SyncIO
 {
@@ -201,4 +202,107 @@ private:
 	SyncIO& mutex_;
 
 };
+
+
+/* --------------------------------------------------------------------
+ * Class/Struct : SyncCondition
+ * Description  : SyncIO that a thread holding it can wait on until
+ *				  another thread signals it
+ *				  Windows uses CONDITION_VARIABLE
+ *				  Unix uses pthread_cond_t
+ * --------------------------------------------------------------------*/
+class SyncCondition : public SyncIO
+{
+    public:
+		/*-------------------------------------------------
+		 * Name			: SyncCondition
+		 * Description	: Default constructor
+		 * Arguments	: none
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        SyncCondition()
+        {
+#if defined(WIN32) || defined(_WIN32)
+            InitializeConditionVariable(&m_cv);
+#else
+            pthread_cond_init(&cond_, 0);
+#endif
+        }
+
+		/*-------------------------------------------------
+		 * Name			: ~SyncCondition
+		 * Description	: Destructor
+		 * Arguments	: none
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        ~SyncCondition() throw()
+        {
+#if !defined(WIN32) && !defined(_WIN32)
+            pthread_cond_destroy(&cond_);
+#endif
+        }
+
+		/*-------------------------------------------------
+		 * Name			: wait
+		 * Description	: Releases the lock, held once by the
+		 *				  caller, until signalled or timed out and
+		 *				  takes it again. May return early, callers
+		 *				  check their condition again.
+		 * Arguments	: timeoutMs is the longest wait
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        void wait(unsigned int timeoutMs)
+        {
+#if defined(WIN32) || defined(_WIN32)
+            SleepConditionVariableCS(&m_cv, &m_cs, timeoutMs);
+#else
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_sec += timeoutMs / 1000;
+            until.tv_nsec += (long)(timeoutMs % 1000) * 1000000;
+            if (until.tv_nsec >= 1000000000) {
+                ++until.tv_sec;
+                until.tv_nsec -= 1000000000;
+            }
+            pthread_cond_timedwait(&cond_, &mutex_, &until);
+#endif
+        }
+
+		/*-------------------------------------------------
+		 * Name			: signal
+		 * Description	: Wakes one waiting thread
+		 * Arguments	: none
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        void signal(void)
+        {
+#if defined(WIN32) || defined(_WIN32)
+            WakeConditionVariable(&m_cv);
+#else
+            pthread_cond_signal(&cond_);
+#endif
+        }
+
+		/*-------------------------------------------------
+		 * Name			: broadcast
+		 * Description	: Wakes all waiting threads
+		 * Arguments	: none
+		 * Returns		: none
+		 *-------------------------------------------------*/
+        void broadcast(void)
+        {
+#if defined(WIN32) || defined(_WIN32)
+            WakeAllConditionVariable(&m_cv);
+#else
+            pthread_cond_broadcast(&cond_);
+#endif
+        }
+
+    private:
+#if defined(WIN32) || defined(_WIN32)
+        CONDITION_VARIABLE m_cv;
+#else
+        pthread_cond_t cond_;
+#endif
+};
 #endif
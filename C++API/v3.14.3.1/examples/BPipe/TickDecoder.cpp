@@ -0,0 +1,313 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: TickDecoder.cpp
+ *
+ * Description: This file contains the streaming decoder of
+ *				IntradayTickRequest responses.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#include "TickDecoder.h"
+#include "EpochDay.h"
+
+#include <blpapi_datetime.h>
+#include <blpapi_element.h>
+
+namespace {
+	const BloombergLP::blpapi::Name TICK_DATA("tickData");
+
+	// fields of a tickData item
+	enum TickField { FLD_TIME, FLD_TYPE, FLD_VALUE, FLD_SIZE, FLD_COND_CODE };
+
+	const NameEntry TICK_FIELD_NAMES[] = {
+		{ "time", FLD_TIME },
+		{ "type", FLD_TYPE },
+		{ "value", FLD_VALUE },
+		{ "size", FLD_SIZE },
+		{ "conditionCodes", FLD_COND_CODE }
+	};
+
+	// event types, by TickType
+	const NameEntry TICK_TYPE_NAMES[] = {
+		{ "OTHER", BloombergLP::TICK_OTHER },
+		{ "TRADE", BloombergLP::TICK_TRADE },
+		{ "BID", BloombergLP::TICK_BID },
+		{ "ASK", BloombergLP::TICK_ASK },
+		{ "BID_BEST", BloombergLP::TICK_BID_BEST },
+		{ "ASK_BEST", BloombergLP::TICK_ASK_BEST },
+		{ "MID_PRICE", BloombergLP::TICK_MID_PRICE },
+		{ "AT_TRADE", BloombergLP::TICK_AT_TRADE },
+		{ "BEST_BID", BloombergLP::TICK_BEST_BID },
+		{ "BEST_ASK", BloombergLP::TICK_BEST_ASK },
+		{ "SETTLE", BloombergLP::TICK_SETTLE }
+	};
+
+	typedef char TypeNamesCheck[
+		sizeof(TICK_TYPE_NAMES) / sizeof(TICK_TYPE_NAMES[0]) == BloombergLP::NUM_TICK_TYPES ? 1 : -1];
+	typedef char TickRecordSizeCheck[sizeof(BloombergLP::TickRecord) == 24 ? 1 : -1];
+
+	const long long NANOS_PER_SECOND = 1000000000LL;
+
+	/*----------------------------------------------------------------
+	 * Name			: epochNanos
+	 * Description	: Converts a tick time to nanoseconds since the epoch
+	 * Arguments	: time is the tick time, UTC unless it has an offset
+	 * Returns		: nanoseconds since 1970-01-01 UTC
+	 *---------------------------------------------------------------*/
+	long long epochNanos(const BloombergLP::blpapi::Datetime& time)
+	{
+		using BloombergLP::blpapi::DatetimeParts;
+
+		long long seconds = 0;
+		if (time.hasParts(DatetimeParts::DATE))
+		{
+			seconds = epochDay(time.year(), time.month(), time.day()) * 86400LL;
+		}
+		if (time.hasParts(DatetimeParts::TIME))
+		{
+			seconds += (time.hours() * 60 + time.minutes()) * 60 + time.seconds();
+		}
+		if (time.hasParts(DatetimeParts::OFFSET))
+		{
+			seconds -= time.offset() * 60LL;
+		}
+		long long nanos = seconds * NANOS_PER_SECOND;
+		if (time.hasParts(DatetimeParts::FRACSECONDS))
+		{
+			nanos += time.nanoseconds();
+		}
+		return nanos;
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: TickDecoder constructor
+ * Description	: Constructs a decoder with an empty batch
+ * Arguments	: handler receives the batches
+ *				  batchSize is the number of records of a batch
+ * Returns		: none
+ *---------------------------------------------------------------*/
+BloombergLP::TickDecoder::TickDecoder(TickBatchHandler& handler, size_t batchSize)
+	: handler_(handler)
+	, batch_(batchSize > 0 ? batchSize : 1)
+	, count_(0)
+	, fields_(TICK_FIELD_NAMES)
+	, types_(TICK_TYPE_NAMES)
+	, conditionCodes_(1)
+	, lastCodesId_(0)
+{
+}
+
+/*----------------------------------------------------------------
+ * Name			: add
+ * Description	: Decodes the ticks of a response message
+ * Arguments	: msg is a PARTIAL_RESPONSE or RESPONSE message
+ *				  endNs skips the ticks at or after it, negative
+ *				  for none
+ * Returns		: number of ticks decoded
+ *---------------------------------------------------------------*/
+size_t BloombergLP::TickDecoder::add(const blpapi::Message& msg, long long endNs)
+{
+	//the ticks are in tickData.tickData
+	blpapi::Element response;
+	blpapi::Element tickData;
+	if (msg.asElement().getElement(&response, TICK_DATA) != 0
+		|| response.getElement(&tickData, TICK_DATA) != 0)
+	{
+		return 0;
+	}
+
+	size_t numItems = tickData.numValues();
+	size_t numTicks = 0;
+	for (size_t i = 0; i < numItems; ++i)
+	{
+		blpapi::Element item;
+		if (tickData.getValueAs(&item, i) != 0)
+		{
+			continue;
+		}
+
+		TickRecord& tick = batch_[count_];
+		tick.time_ = 0;
+		tick.value_ = 0;
+		tick.size_ = 0;
+		tick.type_ = TICK_OTHER;
+		tick.conditionCodes_ = 0;
+
+		size_t numElements = item.numElements();
+		for (size_t j = 0; j < numElements; ++j)
+		{
+			blpapi::Element element;
+			if (item.getElement(&element, j) != 0 || element.isNull())
+			{
+				continue;
+			}
+
+			switch (fields_.find(element.name()))
+			{
+				case FLD_TIME:
+				{
+					blpapi::Datetime time;
+					if (element.getValueAs(&time) == 0)
+					{
+						tick.time_ = epochNanos(time);
+					}
+					break;
+				}
+				case FLD_TYPE:
+				{
+					blpapi::Name type;
+					const char *typeString;
+					if (element.getValueAs(&type) != 0
+						&& blpapi_Element_getValueAsString(element.handle(), &typeString, 0) == 0)
+					{
+						//a string type, look it up without adding it
+						type = blpapi::Name::findName(typeString);
+					}
+					int value = types_.find(type);
+					if (value != NameTable::NOT_FOUND)
+					{
+						tick.type_ = static_cast<unsigned short>(value);
+					}
+					break;
+				}
+				case FLD_VALUE:
+					element.getValueAs(&tick.value_);
+					break;
+				case FLD_SIZE:
+					element.getValueAs(&tick.size_);
+					break;
+				case FLD_COND_CODE:
+				{
+					const char *codes;
+					if (blpapi_Element_getValueAsString(element.handle(), &codes, 0) == 0)
+					{
+						tick.conditionCodes_ = internConditionCodes(codes);
+					}
+					break;
+				}
+				default:
+					break;
+			}
+		}
+
+		if (endNs >= 0 && tick.time_ >= endNs)
+		{
+			continue;
+		}
+		++numTicks;
+		if (++count_ == batch_.size())
+		{
+			flush();
+		}
+	}
+	return numTicks;
+}
+
+/*----------------------------------------------------------------
+ * Name			: flush
+ * Description	: Hands the ticks of a partly filled batch to the handler
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void BloombergLP::TickDecoder::flush()
+{
+	if (count_ > 0)
+	{
+		size_t count = count_;
+		count_ = 0;
+		handler_.processTicks(&batch_[0], count);
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: conditionCodes
+ * Description	: Looks up the condition codes of an id
+ * Arguments	: id is TickRecord::conditionCodes_
+ * Returns		: condition codes string, empty for 0
+ *---------------------------------------------------------------*/
+const std::string& BloombergLP::TickDecoder::conditionCodes(unsigned short id) const
+{
+	return id < conditionCodes_.size() ? conditionCodes_[id] : conditionCodes_[0];
+}
+
+/*----------------------------------------------------------------
+ * Name			: typeName
+ * Description	: Returns the event type string of a TickType
+ * Arguments	: type is TickRecord::type_
+ * Returns		: type string
+ *---------------------------------------------------------------*/
+const char *BloombergLP::TickDecoder::typeName(int type)
+{
+	if (type < 0 || type >= NUM_TICK_TYPES)
+	{
+		type = TICK_OTHER;
+	}
+	return TICK_TYPE_NAMES[type].string_;
+}
+
+/*----------------------------------------------------------------
+ * Name			: internConditionCodes
+ * Description	: Returns the id of a condition codes string
+ * Arguments	: codes is the condition codes string
+ * Returns		: id of codes
+ *---------------------------------------------------------------*/
+unsigned short BloombergLP::TickDecoder::internConditionCodes(const char *codes)
+{
+	if (*codes == '\0')
+	{
+		return 0;
+	}
+	if (lastCodesId_ != 0 && lastCodes_ == codes)
+	{
+		return lastCodesId_;
+	}
+
+	lastCodes_ = codes;
+	std::map<std::string, unsigned short>::const_iterator it = conditionIds_.find(lastCodes_);
+	if (it != conditionIds_.end())
+	{
+		lastCodesId_ = it->second;
+	}
+	else if (conditionCodes_.size() < MAX_CONDITION_CODES)
+	{
+		lastCodesId_ = static_cast<unsigned short>(conditionCodes_.size());
+		conditionCodes_.push_back(lastCodes_);
+		conditionIds_[lastCodes_] = lastCodesId_;
+	}
+	else
+	{
+		//table full, every new string shares the last id
+		lastCodesId_ = MAX_CONDITION_CODES;
+		if (conditionCodes_.size() == MAX_CONDITION_CODES)
+		{
+			conditionCodes_.push_back("?");
+		}
+	}
+	return lastCodesId_;
+}
@@ -0,0 +1,203 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: TickDecoder.h
+ *
+ * Description: This file contains the TickDecoder class, which decodes
+ *				IntradayTickRequest responses into fixed size batches
+ *				of packed tick records.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef __TickDecoder_h__
+#define __TickDecoder_h__
+
+#include <blpapi_message.h>
+
+#include <stddef.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "NameTable.h"
+
+namespace BloombergLP
+{
+
+	//type of a tick, TICK_OTHER for a type not listed
+	enum TickType {
+		TICK_OTHER, TICK_TRADE, TICK_BID, TICK_ASK, TICK_BID_BEST,
+		TICK_ASK_BEST, TICK_MID_PRICE, TICK_AT_TRADE, TICK_BEST_BID,
+		TICK_BEST_ASK, TICK_SETTLE, NUM_TICK_TYPES
+	};
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : TickRecord
+	 * Description  : One tickData item of an IntradayTickResponse,
+	 *				  24 bytes.
+	 * --------------------------------------------------------------------*/
+	struct TickRecord
+	{
+		//tick time, nanoseconds since 1970-01-01 UTC
+		long long time_;
+
+		double value_;
+		int size_;
+
+		//TickType of the tick
+		unsigned short type_;
+
+		//id of the condition codes, see TickDecoder::conditionCodes().
+		//0 for none.
+		unsigned short conditionCodes_;
+	};
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : TickBatchHandler
+	 * Description  : Receives the batches of a TickDecoder
+	 * --------------------------------------------------------------------*/
+	class TickBatchHandler
+	{
+		public:
+			virtual ~TickBatchHandler()
+			{
+			}
+
+			/*----------------------------------------------------------------
+			 * Name			: processTicks
+			 * Description	: Called with each batch of ticks, in time
+			 *				  order of the response. The records are
+			 *				  overwritten by the next batch.
+			 * Arguments	: ticks is the first record of the batch
+			 *				  count is the number of records
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			virtual void processTicks(const TickRecord *ticks, size_t count) = 0;
+	};
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : TickDecoder
+	 * Description  : Decodes the tickData of IntradayTickResponse messages
+	 *				  into one buffer of batchSize records, handing the
+	 *				  buffer to the handler each time it fills. Memory
+	 *				  does not grow with the number of ticks, only with
+	 *				  the number of distinct condition codes, at most
+	 *				  MAX_CONDITION_CODES.
+	 *				  A decoder is used by one thread at a time.
+	 * --------------------------------------------------------------------*/
+	class TickDecoder
+	{
+		public:
+			enum {
+				DEFAULT_BATCH_SIZE = 4096,
+
+				//condition codes id given to every condition code
+				//string after the first MAX_CONDITION_CODES - 1
+				MAX_CONDITION_CODES = 0xFFFF
+			};
+
+			/*----------------------------------------------------------------
+			 * Name			: TickDecoder constructor
+			 * Description	: Constructs a decoder with an empty batch
+			 * Arguments	: handler receives the batches
+			 *				  batchSize is the number of records of a batch
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			explicit TickDecoder(TickBatchHandler& handler,
+				size_t batchSize = DEFAULT_BATCH_SIZE);
+
+			/*----------------------------------------------------------------
+			 * Name			: add
+			 * Description	: Decodes the ticks of a response message,
+			 *				  handing each full batch to the handler
+			 * Arguments	: msg is a PARTIAL_RESPONSE or RESPONSE message
+			 *				  endNs skips the ticks at or after it,
+			 *				  nanoseconds since 1970-01-01 UTC, negative
+			 *				  to keep every tick
+			 * Returns		: number of ticks decoded
+			 *---------------------------------------------------------------*/
+			size_t add(const blpapi::Message& msg, long long endNs = -1);
+
+			/*----------------------------------------------------------------
+			 * Name			: flush
+			 * Description	: Hands the ticks of a partly filled batch to
+			 *				  the handler. Call it after the RESPONSE.
+			 * Arguments	: none
+			 * Returns		: none
+			 *---------------------------------------------------------------*/
+			void flush();
+
+			/*----------------------------------------------------------------
+			 * Name			: conditionCodes
+			 * Description	: Looks up the condition codes of an id
+			 * Arguments	: id is TickRecord::conditionCodes_
+			 * Returns		: condition codes string, empty for 0
+			 *---------------------------------------------------------------*/
+			const std::string& conditionCodes(unsigned short id) const;
+
+			/*----------------------------------------------------------------
+			 * Name			: typeName
+			 * Description	: Returns the event type string of a TickType
+			 * Arguments	: type is TickRecord::type_
+			 * Returns		: type string, "OTHER" for TICK_OTHER
+			 *---------------------------------------------------------------*/
+			static const char *typeName(int type);
+
+		private:
+			/*----------------------------------------------------------------
+			 * Name			: internConditionCodes
+			 * Description	: Returns the id of a condition codes string
+			 * Arguments	: codes is the condition codes string
+			 * Returns		: id of codes
+			 *---------------------------------------------------------------*/
+			unsigned short internConditionCodes(const char *codes);
+
+			TickBatchHandler& handler_;
+
+			//records of the batch, count_ of them are set
+			std::vector<TickRecord> batch_;
+			size_t count_;
+
+			//tickData item fields and tick types by Name
+			NameTable fields_;
+			NameTable types_;
+
+			//condition codes strings by id and ids by string
+			std::vector<std::string> conditionCodes_;
+			std::map<std::string, unsigned short> conditionIds_;
+
+			//last condition codes interned, ticks repeat them
+			std::string lastCodes_;
+			unsigned short lastCodesId_;
+
+			// Unimplemented
+			TickDecoder(const TickDecoder&);
+			TickDecoder& operator=(const TickDecoder&);
+	};
+}
+
+#endif
@@ -0,0 +1,300 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: TopOfBook.cpp
+ *
+ * Description: This file contains the top of book change detection of
+ *				the market depth books and the conflating queue that
+ *				delivers the changes to a consumer thread.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#include "TopOfBook.h"
+
+using namespace BloombergLP;
+
+namespace {
+	/*----------------------------------------------------------------
+	 * Name			: updateSide
+	 * Description	: Updates one side of the top of book
+	 * Arguments	: top is the last top of book
+	 *				  side is 0 for bid, 1 for ask
+	 *				  valid is false for an empty side
+	 *				  price, size, numOrders are level 0 of the side
+	 * Returns		: Change bits of the fields that changed
+	 *---------------------------------------------------------------*/
+	unsigned int updateSide(TopOfBook *top, int side, bool valid,
+		FixedPrice price, unsigned int size, unsigned int numOrders)
+	{
+		if (!valid) {
+			price = 0;
+			size = 0;
+			numOrders = 0;
+		}
+		//bid bits shifted to the ask bits for the ask side
+		unsigned int shift = side == 0 ? 0 : 3;
+		unsigned int mask = 0;
+		if (top->price_[side] != price) {
+			top->price_[side] = price;
+			mask |= TopOfBook::BID_PRICE << shift;
+		}
+		if (top->size_[side] != size) {
+			top->size_[side] = size;
+			mask |= TopOfBook::BID_SIZE << shift;
+		}
+		if (top->numOrders_[side] != numOrders) {
+			top->numOrders_[side] = numOrders;
+			mask |= TopOfBook::BID_ORDERS << shift;
+		}
+		return mask;
+	}
+
+	/*----------------------------------------------------------------
+	 * Name			: rescaleTop
+	 * Description	: Converts the last top of book to the scale of
+	 *				  the book once the book has widened it, so an
+	 *				  unchanged price does not compare as a change
+	 * Arguments	: top is the last top of book
+	 *				  scale is the scale of the book
+	 * Returns		: none
+	 *---------------------------------------------------------------*/
+	void rescaleTop(TopOfBook *top, const PriceScale &scale)
+	{
+		if (top->priceScale_.decimals() < scale.decimals()) {
+			for (int side = 0; side < 2; ++side) {
+				top->price_[side] = scale.convert(top->price_[side], top->priceScale_);
+			}
+		}
+		top->priceScale_ = scale;
+	}
+
+	/*----------------------------------------------------------------
+	 * Name			: finishUpdate
+	 * Description	: Records the changes of an update
+	 * Arguments	: top is the updated top of book
+	 *				  mask is the Change bits of the update
+	 * Returns		: mask
+	 *---------------------------------------------------------------*/
+	unsigned int finishUpdate(TopOfBook *top, unsigned int mask)
+	{
+		if (mask != 0) {
+			top->changeMask_ = mask;
+			++top->changes_;
+		}
+		return mask;
+	}
+}
+
+/* --------------------------------------------------------------------
+ * Class/Struct : TopOfBook
+ * Description  : Best bid and ask of one book
+ * --------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------
+ * Name			: TopOfBook constructor
+ * Description	: Constructs an empty top of book
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+TopOfBook::TopOfBook()
+: bookId_(0)
+, changeMask_(0)
+, changes_(0)
+{
+	for (int side = 0; side < 2; ++side) {
+		price_[side] = 0;
+		size_[side] = 0;
+		numOrders_[side] = 0;
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: updateTop
+ * Description	: Compares the best price level of both sides of a by
+ *				  order book with the last top of book and updates it.
+ *				  The size and order count are those of all the orders
+ *				  at the best price.
+ * Arguments	: books are the bid and ask sides
+ *				  top is the last top of book, updated
+ * Returns		: Change bits of the fields that changed
+ *---------------------------------------------------------------*/
+unsigned int BloombergLP::updateTop(ByOrderBook *books, TopOfBook *top)
+{
+	unsigned int mask = 0;
+	ByOrderBookEntry entry;
+	unsigned int size;
+	unsigned int numOrders;
+	rescaleTop(top, books[0].priceScale());
+	for (int side = 0; side < 2; ++side) {
+		bool valid = books[side].getTopLevel(entry, size, numOrders);
+		mask |= updateSide(top, side, valid, entry.price(), size, numOrders);
+	}
+	return finishUpdate(top, mask);
+}
+
+/*----------------------------------------------------------------
+ * Name			: updateTop
+ * Description	: Compares level 0 of both sides of a by level book
+ *				  with the last top of book and updates it
+ * Arguments	: books are the bid and ask sides
+ *				  top is the last top of book, updated
+ * Returns		: Change bits of the fields that changed
+ *---------------------------------------------------------------*/
+unsigned int BloombergLP::updateTop(ByLevelBook *books, TopOfBook *top)
+{
+	unsigned int mask = 0;
+	ByLevelBookEntry entry;
+	rescaleTop(top, books[0].priceScale());
+	for (int side = 0; side < 2; ++side) {
+		bool valid = books[side].getEntry(0, entry);
+		mask |= updateSide(top, side, valid, entry.price(), entry.size_, entry.numOrders());
+	}
+	return finishUpdate(top, mask);
+}
+
+
+/*----------------------------------------------------------------
+ * Class		 : TopOfBookQueue
+ * Description   : Bounded conflating queue of top of book changes
+ *---------------------------------------------------------------*/
+
+/*----------------------------------------------------------------
+ * Name			: TopOfBookQueue constructor
+ * Description	: Constructs an empty queue
+ * Arguments	: capacity is the most changes queued
+ * Returns		: none
+ *---------------------------------------------------------------*/
+TopOfBookQueue::TopOfBookQueue(unsigned int capacity)
+: slots_(capacity > 0 ? capacity : 1)
+, head_(0)
+, tail_(0)
+, closed_(false)
+, conflated_(0)
+, dropped_(0)
+{
+}
+
+/*----------------------------------------------------------------
+ * Name			: publish
+ * Description	: Queues a change, conflating it with the queued change
+ *				  of the same book
+ * Arguments	: top is the new top of book
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void TopOfBookQueue::publish(const TopOfBook &top)
+{
+	Guard guard(lock_);
+	std::map<long long, unsigned long long>::iterator it = queued_.find(top.bookId_);
+	if (it != queued_.end()) {
+		// keep the place of the queued change, add up the changes
+		TopOfBook &slot = slots_[it->second % slots_.size()];
+		unsigned int mask = slot.changeMask_ | top.changeMask_;
+		slot = top;
+		slot.changeMask_ = mask;
+		++conflated_;
+		return;
+	}
+	if (tail_ - head_ == slots_.size()) {
+		// full, drop the oldest change
+		queued_.erase(slots_[head_ % slots_.size()].bookId_);
+		++head_;
+		++dropped_;
+	}
+	slots_[tail_ % slots_.size()] = top;
+	queued_.insert(std::make_pair(top.bookId_, tail_));
+	++tail_;
+	lock_.signal();
+}
+
+/*----------------------------------------------------------------
+ * Name			: deliver
+ * Description	: Waits for changes and passes each queued change to
+ *				  listener
+ * Arguments	: listener receives the changes
+ *				  timeoutMs is the longest wait for a change
+ * Returns		: number of changes delivered
+ *---------------------------------------------------------------*/
+unsigned int TopOfBookQueue::deliver(TopOfBookListener &listener, unsigned int timeoutMs)
+{
+	unsigned int delivered = 0;
+	lock_.lock();
+	if (head_ == tail_ && !closed_) {
+		lock_.wait(timeoutMs);
+	}
+	while (head_ != tail_ && !closed_) {
+		TopOfBook top = slots_[head_ % slots_.size()];
+		queued_.erase(top.bookId_);
+		++head_;
+		// publishers carry on while the listener runs
+		lock_.unlock();
+		listener.onTopOfBook(top);
+		++delivered;
+		lock_.lock();
+	}
+	lock_.unlock();
+	return delivered;
+}
+
+/*----------------------------------------------------------------
+ * Name			: close
+ * Description	: Wakes the consumer, deliver() returns at once from
+ *				  then on
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void TopOfBookQueue::close()
+{
+	Guard guard(lock_);
+	closed_ = true;
+	lock_.broadcast();
+}
+
+/*----------------------------------------------------------------
+ * Name			: conflated
+ * Description	: Returns the number of changes merged into a queued
+ *				  change
+ * Arguments	: none
+ * Returns		: number of changes conflated
+ *---------------------------------------------------------------*/
+unsigned long long TopOfBookQueue::conflated()
+{
+	Guard guard(lock_);
+	return conflated_;
+}
+
+/*----------------------------------------------------------------
+ * Name			: dropped
+ * Description	: Returns the number of changes dropped because the
+ *				  queue was full
+ * Arguments	: none
+ * Returns		: number of changes dropped
+ *---------------------------------------------------------------*/
+unsigned long long TopOfBookQueue::dropped()
+{
+	Guard guard(lock_);
+	return dropped_;
+}
@@ -0,0 +1,214 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: TopOfBook.h
+ *
+ * Description: This file contains the top of book change detection of
+ *				the market depth books and the conflating queue that
+ *				delivers the changes to a consumer thread.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef __TopOfBook_h__
+#define __TopOfBook_h__
+
+#include <map>
+#include <vector>
+
+#include "OrderBook.h"
+#include "LevelBook.h"
+#include "SyncIO.h"
+
+namespace BloombergLP
+{
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : TopOfBook
+	 * Description  : Best bid and ask of one book. An empty side has
+	 *				  price, size and order count 0.
+	 * --------------------------------------------------------------------*/
+	struct TopOfBook
+	{
+		//changeMask_ bits
+		enum Change {
+			BID_PRICE = 0x01, BID_SIZE = 0x02, BID_ORDERS = 0x04,
+			ASK_PRICE = 0x08, ASK_SIZE = 0x10, ASK_ORDERS = 0x20
+		};
+
+		/*----------------------------------------------------------------
+		 * Name			: TopOfBook constructor
+		 * Description	: Constructs an empty top of book
+		 * Arguments	: none
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		TopOfBook();
+
+		//subscription correlation id value
+		long long bookId_;
+
+		//level 0 of each side, indexed 0 bid 1 ask. For by order
+		//books that is all the orders at the best price.
+		FixedPrice price_[2];
+		unsigned int size_[2];
+		unsigned int numOrders_[2];
+
+		//scale of price_, the one of the book
+		PriceScale priceScale_;
+
+		//Change bits of the fields that changed. A delivered
+		//event holds the changes of every update conflated into it.
+		unsigned int changeMask_;
+
+		//number of changes detected on the book, a delivered event
+		//skipping numbers had updates conflated into it
+		unsigned long long changes_;
+	};
+
+	/*----------------------------------------------------------------
+	 * Name			: updateTop
+	 * Description	: Compares level 0 of both sides of a book with the
+	 *				  last top of book and updates it
+	 * Arguments	: books are the bid and ask sides
+	 *				  top is the last top of book, updated
+	 * Returns		: Change bits of the fields that changed, 0 if level 0
+	 *				  of both sides is unchanged
+	 *---------------------------------------------------------------*/
+	unsigned int updateTop(ByOrderBook *books, TopOfBook *top);
+	unsigned int updateTop(ByLevelBook *books, TopOfBook *top);
+
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : TopOfBookListener
+	 * Description  : Receives top of book changes from a TopOfBookQueue
+	 * --------------------------------------------------------------------*/
+	class TopOfBookListener
+	{
+	public:
+		virtual ~TopOfBookListener() {}
+
+		/*----------------------------------------------------------------
+		 * Name			: onTopOfBook
+		 * Description	: Called for each top of book change delivered
+		 * Arguments	: top is the latest top of the book
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		virtual void onTopOfBook(const TopOfBook &top) = 0;
+	};
+
+
+	/*----------------------------------------------------------------
+	 * Class		 : TopOfBookQueue
+	 * Description   : Bounded queue of top of book changes, at most one
+	 *				   per book. A change for a book already queued
+	 *				   replaces the queued one, keeping its place and
+	 *				   adding its change bits. When the queue is full the
+	 *				   oldest change is dropped, so publish() never waits
+	 *				   on a slow consumer. Any thread may publish, one
+	 *				   consumer thread delivers.
+	 *---------------------------------------------------------------*/
+	class TopOfBookQueue
+	{
+	public:
+		/*----------------------------------------------------------------
+		 * Name			: TopOfBookQueue constructor
+		 * Description	: Constructs an empty queue
+		 * Arguments	: capacity is the most changes queued
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		explicit TopOfBookQueue(unsigned int capacity = 1024);
+
+		/*----------------------------------------------------------------
+		 * Name			: publish
+		 * Description	: Queues a change, conflating it with the queued
+		 *				  change of the same book
+		 * Arguments	: top is the new top of book
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		void publish(const TopOfBook &top);
+
+		/*----------------------------------------------------------------
+		 * Name			: deliver
+		 * Description	: Waits for changes and passes each queued change
+		 *				  to listener, without holding the queue lock
+		 * Arguments	: listener receives the changes
+		 *				  timeoutMs is the longest wait for a change
+		 * Returns		: number of changes delivered, 0 on time out or
+		 *				  after close()
+		 *---------------------------------------------------------------*/
+		unsigned int deliver(TopOfBookListener &listener, unsigned int timeoutMs);
+
+		/*----------------------------------------------------------------
+		 * Name			: close
+		 * Description	: Wakes the consumer, deliver() returns at once
+		 *				  from then on
+		 * Arguments	: none
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		void close();
+
+		/*----------------------------------------------------------------
+		 * Name			: conflated
+		 * Description	: Returns the number of changes merged into a
+		 *				  queued change
+		 * Arguments	: none
+		 * Returns		: number of changes conflated
+		 *---------------------------------------------------------------*/
+		unsigned long long conflated();
+
+		/*----------------------------------------------------------------
+		 * Name			: dropped
+		 * Description	: Returns the number of changes dropped because
+		 *				  the queue was full
+		 * Arguments	: none
+		 * Returns		: number of changes dropped
+		 *---------------------------------------------------------------*/
+		unsigned long long dropped();
+
+	private:
+		SyncCondition lock_;
+
+		//ring of queued changes, position n is in slots_[n % capacity]
+		std::vector<TopOfBook> slots_;
+
+		//positions of the oldest change and of the next one queued
+		unsigned long long head_;
+		unsigned long long tail_;
+
+		//position of the queued change of each book
+		std::map<long long, unsigned long long> queued_;
+
+		bool closed_;
+		unsigned long long conflated_;
+		unsigned long long dropped_;
+
+		// Unimplemented
+		TopOfBookQueue(const TopOfBookQueue&);
+		TopOfBookQueue& operator=(const TopOfBookQueue&);
+	};
+}
+
+#endif
@@ -0,0 +1,214 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: TopicConflator.cpp
+ *
+ * Description: This file contains the client side conflation of the
+ *				subscription data into a last value record per
+ *				subscription.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#include <blpapi_highresolutionclock.h>
+#include <blpapi_message.h>
+
+#include "TopicConflator.h"
+
+using namespace BloombergLP;
+using namespace blpapi;
+
+/*----------------------------------------------------------------
+ * Name			: TopicConflator constructor
+ * Description	: Constructs a conflator without records
+ * Arguments	: fields are the fields kept
+ *				  intervalMs is the least time between two deliveries
+ * Returns		: none
+ *---------------------------------------------------------------*/
+TopicConflator::TopicConflator(const std::vector<std::string> &fields,
+	unsigned int intervalMs)
+: fields_(fields)
+, intervalNs_((long long)intervalMs * 1000000)
+, delivered_(false)
+, closed_(false)
+, conflated_(0)
+{
+}
+
+/*----------------------------------------------------------------
+ * Name			: compile
+ * Description	: Reads the fields by their position in the schema
+ * Arguments	: message is the definition of the messages
+ * Returns		: true if every field is in the schema
+ *---------------------------------------------------------------*/
+bool TopicConflator::compile(const SchemaElementDefinition &message)
+{
+	Guard guard(lock_);
+	return fields_.compile(message);
+}
+
+/*----------------------------------------------------------------
+ * Name			: publish
+ * Description	: Merges the messages of a SUBSCRIPTION_DATA event into
+ *				  their records
+ * Arguments	: event is any event
+ * Returns		: number of messages merged
+ *---------------------------------------------------------------*/
+unsigned int TopicConflator::publish(const Event &event)
+{
+	if (event.eventType() != Event::SUBSCRIPTION_DATA || fields_.empty()) {
+		return 0;
+	}
+
+	unsigned int merged = 0;
+	bool signal = false;
+	Guard guard(lock_);
+	MessageIterator msgIter(event);
+	while (msgIter.next()) {
+		Message msg = msgIter.message();
+		CorrelationId cid = msg.correlationId();
+
+		std::map<CorrelationId, size_t>::iterator it = index_.find(cid);
+		if (it == index_.end()) {
+			Entry entry;
+			entry.record_.topic_ = cid;
+			entry.record_.values_.resize(fields_.size());
+			entry.record_.setMask_ = 0;
+			entry.record_.changeMask_ = 0;
+			entry.record_.updates_ = 0;
+			entry.queued_ = false;
+			entries_.push_back(entry);
+			it = index_.insert(std::make_pair(cid, entries_.size() - 1)).first;
+		}
+		Entry &entry = entries_[it->second];
+
+		// fields not in the message keep their last value
+		unsigned long long written = fields_.extract(msg.asElement(),
+			&entry.record_.values_[0]);
+		if (written == 0) {
+			continue;
+		}
+		entry.record_.setMask_ |= written;
+		entry.record_.changeMask_ |= written;
+		++entry.record_.updates_;
+		++merged;
+		if (entry.queued_) {
+			++conflated_;
+		} else {
+			entry.queued_ = true;
+			ready_.push_back(it->second);
+			signal = true;
+		}
+	}
+	if (signal) {
+		lock_.signal();
+	}
+	return merged;
+}
+
+/*----------------------------------------------------------------
+ * Name			: deliver
+ * Description	: Waits for changed records and passes each to listener
+ * Arguments	: listener receives the records
+ *				  timeoutMs is the longest wait
+ * Returns		: number of records delivered
+ *---------------------------------------------------------------*/
+unsigned int TopicConflator::deliver(ConflatedTopicListener &listener, unsigned int timeoutMs)
+{
+	TimePoint start = HighResolutionClock::now();
+	std::vector<ConflatedTopic> records;
+	{
+		Guard guard(lock_);
+		while (!closed_) {
+			TimePoint now = HighResolutionClock::now();
+			long long waitNs = (long long)timeoutMs * 1000000
+				- TimePointUtil::nanosecondsBetween(start, now);
+			if (!ready_.empty()) {
+				long long sinceNs = delivered_
+					? TimePointUtil::nanosecondsBetween(lastDelivery_, now) : intervalNs_;
+				if (sinceNs >= intervalNs_) {
+					break;
+				}
+				// records wait for the end of the interval
+				if (intervalNs_ - sinceNs < waitNs) {
+					waitNs = intervalNs_ - sinceNs;
+				}
+			}
+			if (waitNs <= 0) {
+				return 0;
+			}
+			lock_.wait((unsigned int)((waitNs + 999999) / 1000000));
+		}
+		if (closed_) {
+			return 0;
+		}
+
+		records.reserve(ready_.size());
+		for (size_t i = 0; i < ready_.size(); ++i) {
+			Entry &entry = entries_[ready_[i]];
+			records.push_back(entry.record_);
+			entry.record_.changeMask_ = 0;
+			entry.record_.updates_ = 0;
+			entry.queued_ = false;
+		}
+		ready_.clear();
+		lastDelivery_ = HighResolutionClock::now();
+		delivered_ = true;
+	}
+
+	// publishers carry on while the listener runs
+	for (size_t i = 0; i < records.size(); ++i) {
+		listener.onTopic(records[i]);
+	}
+	return (unsigned int)records.size();
+}
+
+/*----------------------------------------------------------------
+ * Name			: close
+ * Description	: Wakes the consumer, deliver() returns at once from
+ *				  then on
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void TopicConflator::close()
+{
+	Guard guard(lock_);
+	closed_ = true;
+	lock_.broadcast();
+}
+
+/*----------------------------------------------------------------
+ * Name			: conflated
+ * Description	: Returns the number of messages merged into a record
+ *				  that was already waiting for delivery
+ * Arguments	: none
+ * Returns		: number of messages conflated
+ *---------------------------------------------------------------*/
+unsigned long long TopicConflator::conflated()
+{
+	Guard guard(lock_);
+	return conflated_;
+}
@@ -0,0 +1,215 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: TopicConflator.h
+ *
+ * Description: This file contains the TopicConflator class, which
+ *				merges the field updates of each subscription into a
+ *				last value record and delivers at most one record per
+ *				subscription per interval.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef __TopicConflator_h__
+#define __TopicConflator_h__
+
+#include <blpapi_correlationid.h>
+#include <blpapi_event.h>
+#include <blpapi_schema.h>
+#include <blpapi_timepoint.h>
+#include <blpapi_types.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "NumericFields.h"
+#include "SyncIO.h"
+
+namespace BloombergLP
+{
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : ConflatedTopic
+	 * Description  : Last values of the fields of one subscription. A
+	 *				  delivered record holds every update merged since
+	 *				  the previous delivery.
+	 * --------------------------------------------------------------------*/
+	struct ConflatedTopic
+	{
+		//subscription correlation id
+		blpapi::CorrelationId topic_;
+
+		//last value of each field, by field id, valid if its bit is
+		//in setMask_
+		std::vector<blpapi::Float64> values_;
+		unsigned long long setMask_;
+
+		//bits of the fields updated since the previous delivery
+		unsigned long long changeMask_;
+
+		//number of messages merged since the previous delivery
+		unsigned int updates_;
+	};
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : ConflatedTopicListener
+	 * Description  : Receives conflated records from a TopicConflator
+	 * --------------------------------------------------------------------*/
+	class ConflatedTopicListener
+	{
+	public:
+		virtual ~ConflatedTopicListener() {}
+
+		/*----------------------------------------------------------------
+		 * Name			: onTopic
+		 * Description	: Called for each record delivered
+		 * Arguments	: topic is the last values of the subscription
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		virtual void onTopic(const ConflatedTopic &topic) = 0;
+	};
+
+	/*----------------------------------------------------------------
+	 * Class		 : TopicConflator
+	 * Description   : Client side conflation of SUBSCRIPTION_DATA.
+	 *				   publish() merges the numeric fields of each
+	 *				   message into the record of its correlation id,
+	 *				   and deliver() passes every record that changed
+	 *				   to the listener, at most once per interval, so
+	 *				   the consumer sees the latest values of thousands
+	 *				   of subscriptions without processing every tick.
+	 *				   An interval of 0 delivers whenever the consumer
+	 *				   calls deliver(). Fields that are absent or do
+	 *				   not convert to Float64 keep their last value.
+	 *				   Any thread may publish, one consumer thread
+	 *				   delivers.
+	 *---------------------------------------------------------------*/
+	class TopicConflator
+	{
+	public:
+		//most fields, one bit of the masks each
+		enum { MAX_FIELDS = NumericFields::MAX_FIELDS };
+
+		/*----------------------------------------------------------------
+		 * Name			: TopicConflator constructor
+		 * Description	: Constructs a conflator without records
+		 * Arguments	: fields are the fields kept, the first
+		 *				  MAX_FIELDS are used; the field id is the
+		 *				  position in fields
+		 *				  intervalMs is the least time between two
+		 *				  deliveries
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		TopicConflator(const std::vector<std::string> &fields, unsigned int intervalMs);
+
+		/*----------------------------------------------------------------
+		 * Name			: compile
+		 * Description	: Reads the fields by their position in the
+		 *				  message schema, see FieldAccessor::compile()
+		 * Arguments	: message is the definition of the messages
+		 * Returns		: true if every field is in the schema
+		 *---------------------------------------------------------------*/
+		bool compile(const blpapi::SchemaElementDefinition &message);
+
+		/*----------------------------------------------------------------
+		 * Name			: publish
+		 * Description	: Merges the messages of a SUBSCRIPTION_DATA
+		 *				  event into their records
+		 * Arguments	: event is any event
+		 * Returns		: number of messages merged
+		 *---------------------------------------------------------------*/
+		unsigned int publish(const blpapi::Event &event);
+
+		/*----------------------------------------------------------------
+		 * Name			: deliver
+		 * Description	: Waits until records changed and the interval
+		 *				  since the last delivery passed, then passes
+		 *				  each changed record to listener without
+		 *				  holding the lock
+		 * Arguments	: listener receives the records
+		 *				  timeoutMs is the longest wait
+		 * Returns		: number of records delivered, 0 on time out or
+		 *				  after close()
+		 *---------------------------------------------------------------*/
+		unsigned int deliver(ConflatedTopicListener &listener, unsigned int timeoutMs);
+
+		/*----------------------------------------------------------------
+		 * Name			: close
+		 * Description	: Wakes the consumer, deliver() returns at once
+		 *				  from then on
+		 * Arguments	: none
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		void close();
+
+		/*----------------------------------------------------------------
+		 * Name			: conflated
+		 * Description	: Returns the number of messages merged into a
+		 *				  record that was already waiting for delivery
+		 * Arguments	: none
+		 * Returns		: number of messages conflated
+		 *---------------------------------------------------------------*/
+		unsigned long long conflated();
+
+		//field name of a field id
+		const std::string &field(int id) const { return fields_.name(id); }
+		size_t numFields() const { return fields_.size(); }
+
+	private:
+		struct Entry
+		{
+			ConflatedTopic record_;
+
+			//true while the record is in ready_
+			bool queued_;
+		};
+
+		NumericFields fields_;
+		long long intervalNs_;
+
+		SyncCondition lock_;
+
+		//records, and the record of each correlation id
+		std::vector<Entry> entries_;
+		std::map<blpapi::CorrelationId, size_t> index_;
+
+		//records changed since the last delivery, in order of change
+		std::vector<size_t> ready_;
+
+		blpapi::TimePoint lastDelivery_;
+		bool delivered_;
+		bool closed_;
+		unsigned long long conflated_;
+
+		// Unimplemented
+		TopicConflator(const TopicConflator&);
+		TopicConflator& operator=(const TopicConflator&);
+	};
+}
+
+#endif
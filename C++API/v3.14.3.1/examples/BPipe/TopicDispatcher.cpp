@@ -0,0 +1,261 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: TopicDispatcher.cpp
+ *
+ * Description: This file contains the dispatch of the subscription
+ *				messages to worker threads by topic.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#include "TopicDispatcher.h"
+
+using namespace BloombergLP;
+using namespace blpapi;
+
+namespace {
+	// longest sleep of an idle worker between two checks for stop()
+	const unsigned int IDLE_WAIT_MS = 1000;
+}
+
+/*----------------------------------------------------------------
+ * Name			: TopicDispatcher constructor
+ * Description	: Constructs a dispatcher with stopped workers
+ * Arguments	: handler processes the messages
+ *				  numWorkers is the number of worker threads
+ * Returns		: none
+ *---------------------------------------------------------------*/
+TopicDispatcher::TopicDispatcher(TopicMessageHandler &handler, unsigned int numWorkers)
+: handler_(handler)
+, batches_(numWorkers > 0 ? numWorkers : 1)
+{
+	for (size_t i = 0; i < batches_.size(); ++i) {
+		Worker *worker = new Worker;
+		worker->owner_ = this;
+		worker->id_ = (unsigned int)i;
+		worker->stopping_ = false;
+		worker->posted_ = 0;
+		worker->started_ = false;
+		workers_.push_back(worker);
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: TopicDispatcher destructor
+ * Description	: Stops the workers
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+TopicDispatcher::~TopicDispatcher()
+{
+	stop();
+	for (size_t i = 0; i < workers_.size(); ++i) {
+		delete workers_[i];
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: start
+ * Description	: Starts the worker threads
+ * Arguments	: none
+ * Returns		: true if every worker started
+ *---------------------------------------------------------------*/
+bool TopicDispatcher::start()
+{
+	bool started = true;
+	for (size_t i = 0; i < workers_.size(); ++i) {
+		Worker &worker = *workers_[i];
+		if (worker.started_) {
+			continue;
+		}
+		worker.stopping_ = false;
+#if defined(WIN32) || defined(_WIN32)
+		worker.thread_ = CreateThread(NULL, 0, workerThread, &worker, 0, NULL);
+		worker.started_ = worker.thread_ != NULL;
+#else
+		worker.started_ = pthread_create(&worker.thread_, NULL, workerThread, &worker) == 0;
+#endif
+		started = started && worker.started_;
+	}
+	return started;
+}
+
+/*----------------------------------------------------------------
+ * Name			: stop
+ * Description	: Lets the workers drain their queues and waits for them
+ * Arguments	: none
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void TopicDispatcher::stop()
+{
+	for (size_t i = 0; i < workers_.size(); ++i) {
+		Worker &worker = *workers_[i];
+		Guard guard(worker.lock_);
+		worker.stopping_ = true;
+		worker.post();
+		worker.lock_.broadcast();
+	}
+	for (size_t i = 0; i < workers_.size(); ++i) {
+		Worker &worker = *workers_[i];
+		if (!worker.started_) {
+			continue;
+		}
+#if defined(WIN32) || defined(_WIN32)
+		WaitForSingleObject(worker.thread_, INFINITE);
+		CloseHandle(worker.thread_);
+#else
+		pthread_join(worker.thread_, NULL);
+#endif
+		worker.started_ = false;
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: processEvent
+ * Description	: Queues each message of a subscription event on the
+ *				  worker of its topic
+ * Arguments	: event is any event
+ * Returns		: true if event was a subscription event
+ *---------------------------------------------------------------*/
+bool TopicDispatcher::processEvent(const Event &event)
+{
+	int eventType = event.eventType();
+	if (eventType != Event::SUBSCRIPTION_DATA && eventType != Event::SUBSCRIPTION_STATUS) {
+		return false;
+	}
+
+	// the queued copies keep the messages alive after the event
+	MessageIterator msgIter(event);
+	while (msgIter.next()) {
+		Message msg = msgIter.message();
+		batches_[worker(msg.correlationId())].push_back(QueuedMessage(msg, eventType));
+	}
+
+	for (size_t i = 0; i < batches_.size(); ++i) {
+		std::vector<QueuedMessage> &batch = batches_[i];
+		if (batch.empty()) {
+			continue;
+		}
+		Worker &worker = *workers_[i];
+		{
+			Guard guard(worker.lock_);
+			bool idle = worker.queue_.empty();
+			worker.queue_.insert(worker.queue_.end(), batch.begin(), batch.end());
+			worker.post();
+			if (idle) {
+				worker.lock_.signal();
+			}
+		}
+		batch.clear();
+	}
+	return true;
+}
+
+/*----------------------------------------------------------------
+ * Name			: worker
+ * Description	: Returns the worker of a topic
+ * Arguments	: topic is the subscription correlation id
+ * Returns		: worker number
+ *---------------------------------------------------------------*/
+unsigned int TopicDispatcher::worker(const CorrelationId &topic) const
+{
+	unsigned long long key = 0;
+	switch (topic.valueType()) {
+	case CorrelationId::INT_VALUE:
+	case CorrelationId::AUTOGEN_VALUE:
+		key = (unsigned long long)topic.asInteger();
+		break;
+	case CorrelationId::POINTER_VALUE:
+		key = (unsigned long long)(size_t)topic.asPointer();
+		break;
+	default:
+		break;
+	}
+	key += (unsigned long long)topic.classId() << 48;
+
+	// Fibonacci hashing, the high bits mix all the bits of the key so
+	// that sequential ids and aligned pointers spread evenly
+	key *= 0x9E3779B97F4A7C15ULL;
+	return (unsigned int)((key >> 32) % workers_.size());
+}
+
+/*----------------------------------------------------------------
+ * Name			: run
+ * Description	: Processes the messages queued on a worker until stop()
+ * Arguments	: worker is the worker
+ * Returns		: none
+ *---------------------------------------------------------------*/
+void TopicDispatcher::run(Worker &worker)
+{
+	waitStrategy_.pin(worker.id_);
+
+	std::vector<QueuedMessage> batch;
+	// posted_ when the worker last took its queue
+	long seen = 0;
+	for (;;) {
+		// a message arriving while the worker spins costs no wakeup
+		waitStrategy_.spin(WorkReady(worker, seen));
+		{
+			Guard guard(worker.lock_);
+			while (worker.queue_.empty() && !worker.stopping_) {
+				worker.lock_.wait(IDLE_WAIT_MS);
+			}
+			if (worker.queue_.empty()) {
+				return;
+			}
+			// the queue gets the capacity of the previous batch back
+			batch.swap(worker.queue_);
+			// once stopping, seen keeps a value from before stop() so
+			// the next spin ends at once
+			if (!worker.stopping_) {
+				seen = worker.posted();
+			}
+		}
+
+		for (size_t i = 0; i < batch.size(); ++i) {
+			handler_.processTopicMessage(batch[i].message_, batch[i].eventType_, worker.id_);
+		}
+		batch.clear();
+	}
+}
+
+/*----------------------------------------------------------------
+ * Name			: workerThread
+ * Description	: Entry point of a worker thread
+ * Arguments	: arg is the Worker
+ * Returns		: 0
+ *---------------------------------------------------------------*/
+#if defined(WIN32) || defined(_WIN32)
+DWORD WINAPI TopicDispatcher::workerThread(LPVOID arg)
+#else
+void *TopicDispatcher::workerThread(void *arg)
+#endif
+{
+	Worker *worker = static_cast<Worker *>(arg);
+	worker->owner_->run(*worker);
+	return 0;
+}
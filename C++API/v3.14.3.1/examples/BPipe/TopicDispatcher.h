@@ -0,0 +1,243 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:  The above copyright notice and this
+ * permission notice shall be included in all copies or substantial portions of
+ * the Software.  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO
+ * EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* --------------------------------------------------------------------
+ * File: TopicDispatcher.h
+ *
+ * Description: This file contains the TopicDispatcher class, which
+ *				hands the messages of each subscription to the same
+ *				worker thread so that they are processed in order
+ *				without locking.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef __TopicDispatcher_h__
+#define __TopicDispatcher_h__
+
+#include <blpapi_correlationid.h>
+#include <blpapi_event.h>
+#include <blpapi_message.h>
+
+#include <vector>
+
+#include "SyncIO.h"
+#include "WaitStrategy.h"
+
+namespace BloombergLP
+{
+
+	/* --------------------------------------------------------------------
+	 * Class/Struct : TopicMessageHandler
+	 * Description  : Processes the messages a TopicDispatcher hands to
+	 *				  its workers
+	 * --------------------------------------------------------------------*/
+	class TopicMessageHandler
+	{
+	public:
+		virtual ~TopicMessageHandler() {}
+
+		/*----------------------------------------------------------------
+		 * Name			: processTopicMessage
+		 * Description	: Called on the worker of the message topic, in
+		 *				  the order the session delivered the messages
+		 *				  of that topic. Must not throw.
+		 * Arguments	: message is the message
+		 *				  eventType is the type of its event
+		 *				  worker is the worker number
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		virtual void processTopicMessage(const blpapi::Message &message,
+			int eventType, unsigned int worker) = 0;
+	};
+
+	/*----------------------------------------------------------------
+	 * Class		 : TopicDispatcher
+	 * Description   : Dispatcher with topic affinity. processEvent()
+	 *				   hashes the correlation id of each message of a
+	 *				   SUBSCRIPTION_DATA or SUBSCRIPTION_STATUS event
+	 *				   to one of numWorkers threads and queues the
+	 *				   message there. A topic always maps to the same
+	 *				   worker, so its messages are processed in order
+	 *				   and the state of a topic is only touched by one
+	 *				   thread, while the topics are spread across the
+	 *				   cores.
+	 *				   Unlike an EventDispatcher with several threads,
+	 *				   which hands whole events to any thread, the
+	 *				   session must deliver events on one thread (no
+	 *				   EventDispatcher, or one of one thread) for the
+	 *				   order to hold.
+	 *---------------------------------------------------------------*/
+	class TopicDispatcher
+	{
+	public:
+		/*----------------------------------------------------------------
+		 * Name			: TopicDispatcher constructor
+		 * Description	: Constructs a dispatcher, the workers run once
+		 *				  start() is called
+		 * Arguments	: handler processes the messages
+		 *				  numWorkers is the number of worker threads
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		TopicDispatcher(TopicMessageHandler &handler, unsigned int numWorkers);
+
+		/*----------------------------------------------------------------
+		 * Name			: TopicDispatcher destructor
+		 * Description	: Stops the workers
+		 * Arguments	: none
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		~TopicDispatcher();
+
+		/*----------------------------------------------------------------
+		 * Name			: start
+		 * Description	: Starts the worker threads
+		 * Arguments	: none
+		 * Returns		: true if every worker started
+		 *---------------------------------------------------------------*/
+		bool start();
+
+		/*----------------------------------------------------------------
+		 * Name			: setWaitStrategy
+		 * Description	: Sets how an idle worker waits for messages.
+		 *				  Called before start(); a busy polling
+		 *				  strategy with a core pins worker n to the
+		 *				  core + n.
+		 * Arguments	: strategy is the wait strategy, blocking by
+		 *				  default
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		void setWaitStrategy(const WaitStrategy &strategy) { waitStrategy_ = strategy; }
+
+		/*----------------------------------------------------------------
+		 * Name			: stop
+		 * Description	: Lets the workers process the messages queued
+		 *				  and waits for them to end
+		 * Arguments	: none
+		 * Returns		: none
+		 *---------------------------------------------------------------*/
+		void stop();
+
+		/*----------------------------------------------------------------
+		 * Name			: processEvent
+		 * Description	: Queues each message of a subscription event
+		 *				  on the worker of its topic
+		 * Arguments	: event is any event
+		 * Returns		: true if event was a subscription event
+		 *---------------------------------------------------------------*/
+		bool processEvent(const blpapi::Event &event);
+
+		/*----------------------------------------------------------------
+		 * Name			: worker
+		 * Description	: Returns the worker of a topic
+		 * Arguments	: topic is the subscription correlation id
+		 * Returns		: worker number, less than numWorkers()
+		 *---------------------------------------------------------------*/
+		unsigned int worker(const blpapi::CorrelationId &topic) const;
+
+		unsigned int numWorkers() const { return (unsigned int)workers_.size(); }
+
+	private:
+		struct QueuedMessage
+		{
+			blpapi::Message message_;
+			int eventType_;
+
+			QueuedMessage(const blpapi::Message &message, int eventType)
+			: message_(message)
+			, eventType_(eventType)
+			{
+			}
+		};
+
+		struct Worker
+		{
+			TopicDispatcher *owner_;
+			unsigned int id_;
+
+			SyncCondition lock_;
+			std::vector<QueuedMessage> queue_;
+			bool stopping_;
+
+			// bumped under lock_ when messages are queued or stop() is
+			// called, read without it by a spinning worker
+#if defined(WIN32) || defined(_WIN32)
+			volatile LONG posted_;
+
+			void post() { InterlockedIncrement(&posted_); }
+			long posted() const { return posted_; }
+#else
+			long posted_;
+
+			void post() { __atomic_store_n(&posted_, posted_ + 1, __ATOMIC_RELEASE); }
+			long posted() const { return __atomic_load_n(&posted_, __ATOMIC_ACQUIRE); }
+#endif
+
+			bool started_;
+#if defined(WIN32) || defined(_WIN32)
+			HANDLE thread_;
+#else
+			pthread_t thread_;
+#endif
+		};
+
+		// true once a worker may have messages or must stop, checked
+		// without the lock so that spinning does not slow the producer
+		struct WorkReady
+		{
+			const Worker &worker_;
+			long seen_;
+
+			WorkReady(const Worker &worker, long seen) : worker_(worker), seen_(seen) {}
+
+			bool operator()() const
+			{
+				return worker_.posted() != seen_;
+			}
+		};
+
+		void run(Worker &worker);
+
+#if defined(WIN32) || defined(_WIN32)
+		static DWORD WINAPI workerThread(LPVOID arg);
+#else
+		static void *workerThread(void *arg);
+#endif
+
+		TopicMessageHandler &handler_;
+		std::vector<Worker *> workers_;
+		WaitStrategy waitStrategy_;
+
+		//messages of the event being dispatched, by worker, so that
+		//each worker is locked once per event
+		std::vector<std::vector<QueuedMessage> > batches_;
+
+		// Unimplemented
+		TopicDispatcher(const TopicDispatcher&);
+		TopicDispatcher& operator=(const TopicDispatcher&);
+	};
+}
+
+#endif
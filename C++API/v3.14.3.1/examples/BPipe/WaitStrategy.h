@@ -0,0 +1,327 @@
+/* --------------------------------------------------------------------
+ *                          DISCLAIMER OF WARRANTY
+ *
+ * THE CODE SAMPLES PROVIDED IN THIS SDK (IN SOURCE CODE AND BINARY FORM) ARE
+ * PROVIDED "AS IS," WITHOUT A WARRANTY OF ANY KIND. ALL EXPRESS OR IMPLIED
+ * CONDITIONS, REPRESENTATIONS AND WARRANTIES, INCLUDING ANY IMPLIED WARRANTY
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE OR NON-INFRINGEMENT,
+ * ARE HEREBY EXCLUDED. BLOOMBERG AND ITS LICENSORS SHALL NOT BE LIABLE FOR
+ * ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING OR
+ * DISTRIBUTING THE SOFTWARE OR ITS DERIVATIVES. IN NO EVENT WILL BLOOMBERG
+ * OR ITS LICENSORS BE LIABLE FOR ANY LOST REVENUE, PROFIT OR DATA, OR FOR
+ * DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL, INCIDENTAL OR PUNITIVE DAMAGES,
+ * HOWEVER CAUSED AND REGARDLESS OF THE THEORY OF LIABILITY, ARISING OUT OF
+ * THE USE OF OR INABILITY TO USE SOFTWARE, EVEN IF BLOOMBERG HAS BEEN ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGES.
+ * THE CODE SAMPLES PROVIDED WITH THE B-PIPE SDK ARE NOT INTENDED FOR
+ * PRODUCTION USE, AND IF PUT TO SUCH USE THEY MAY RESULT IN SLOWNESS OR LOSS
+ * OF DATA.
+ * ----------------------------------------------------------------- */
+
+/* --------------------------------------------------------------------
+ * File: WaitStrategy.h
+ *
+ * Description: This source code defines the WaitStrategy class, which
+ *				chooses how a consumer thread waits for its next event:
+ *				parked in the API, spinning for a while first, or
+ *				busy polling.
+ *
+ * Version	  : XX.XX.XX
+ *
+ *   NOTICE:
+ *   Copyright (C) Bloomberg L.P., 2007
+ *   All Rights Reserved.
+ *   Property of Bloomberg L.P. (BLP)
+ *   This software is made available solely pursuant to the
+ *   terms of a BLP license agreement which governs its use.
+ * ----------------------------------------------------------------- */
+
+#ifndef _WAITSTRATEGY_H_
+#define  _WAITSTRATEGY_H_
+
+#include <blpapi_event.h>
+#include <blpapi_highresolutionclock.h>
+#include <blpapi_timepoint.h>
+
+#include "EventBatch.h"
+
+#include <stdlib.h>  // strtoul
+#include <string.h>
+
+#if defined(WIN32) || defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/* --------------------------------------------------------------------
+ * Class/Struct : WaitStrategy
+ * Description  : How a thread waits for work. A blocking wait parks the
+ *				  thread at once and pays a wakeup for every event.
+ *				  Spin then park polls without blocking for a number of
+ *				  microseconds first, so an event arriving soon is
+ *				  taken without a wakeup. Busy poll never parks and
+ *				  keeps a core busy, best pinned to a core of its own.
+ *				  nextEvent() and nextEvents() wait on a Session or an
+ *				  EventQueue, spin() on any condition of the caller.
+ * --------------------------------------------------------------------*/
+class WaitStrategy
+{
+public:
+	enum Type {
+		BLOCKING,		// park at once
+		SPIN_THEN_PARK,	// poll for spinMicros, then park
+		BUSY_POLL		// poll until the event or the timeout
+	};
+
+	/*-------------------------------------------------
+	 * Name			: WaitStrategy
+	 * Description	: Default constructor, blocking
+	 * Arguments	: none
+	 * Returns		: none
+	 *-------------------------------------------------*/
+	WaitStrategy() : type_(BLOCKING), spinMicros_(0), core_(-1)
+	{
+	}
+
+	/*-------------------------------------------------
+	 * Name			: WaitStrategy
+	 * Description	: Constructor
+	 * Arguments	: type is the way to wait
+	 *				  spinMicros is the time polled before
+	 *				  parking, for SPIN_THEN_PARK
+	 *				  core is the first core pin() uses, -1
+	 *				  not to pin
+	 * Returns		: none
+	 *-------------------------------------------------*/
+	WaitStrategy(Type type, unsigned int spinMicros, int core = -1)
+		: type_(type), spinMicros_(spinMicros), core_(core)
+	{
+	}
+
+	/*-------------------------------------------------
+	 * Name			: parse
+	 * Description	: Reads a strategy: "block", "spin=<us>",
+	 *				  "poll", or "poll=<core>" to busy poll
+	 *				  on cores from <core>
+	 * Arguments	: text is the strategy
+	 * Returns		: true if text is a strategy, otherwise
+	 *				  the strategy is unchanged
+	 *-------------------------------------------------*/
+	bool parse(const char *text)
+	{
+		char *end;
+		if (!strcmp(text, "block"))
+		{
+			*this = WaitStrategy();
+		}
+		else if (!strncmp(text, "spin=", 5) && text[5] != '\0')
+		{
+			unsigned long micros = strtoul(text + 5, &end, 10);
+			if (*end != '\0')
+			{
+				return false;
+			}
+			*this = WaitStrategy(SPIN_THEN_PARK, (unsigned int)micros);
+		}
+		else if (!strcmp(text, "poll"))
+		{
+			*this = WaitStrategy(BUSY_POLL, 0);
+		}
+		else if (!strncmp(text, "poll=", 5) && text[5] != '\0')
+		{
+			unsigned long core = strtoul(text + 5, &end, 10);
+			if (*end != '\0')
+			{
+				return false;
+			}
+			*this = WaitStrategy(BUSY_POLL, 0, (int)core);
+		}
+		else
+		{
+			return false;
+		}
+		return true;
+	}
+
+	Type type() const { return type_; }
+	unsigned int spinMicros() const { return spinMicros_; }
+
+	/*-------------------------------------------------
+	 * Name			: pin
+	 * Description	: Pins the calling thread to core
+	 *				  core + offset, if a core was given.
+	 *				  Unix other than Linux cannot pin.
+	 * Arguments	: offset is added to the first core,
+	 *				  e.g. the number of a worker
+	 * Returns		: false if the thread could not be
+	 *				  pinned
+	 *-------------------------------------------------*/
+	bool pin(unsigned int offset = 0) const
+	{
+		if (core_ < 0)
+		{
+			return true;
+		}
+		unsigned int core = (unsigned int)core_ + offset;
+#if defined(WIN32) || defined(_WIN32)
+		return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core) != 0;
+#elif defined(__linux__)
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(core, &cpus);
+		return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+		return false;
+#endif
+	}
+
+	/*-------------------------------------------------
+	 * Name			: nextEvent
+	 * Description	: Waits for the next event of queue as
+	 *				  the strategy says. A blocking wait is
+	 *				  queue.nextEvent(timeoutMs).
+	 * Arguments	: queue is a Session or an EventQueue
+	 *				  timeoutMs is the longest wait, 0 for
+	 *				  no limit
+	 * Returns		: the event, of type TIMEOUT if none
+	 *				  came in time
+	 *-------------------------------------------------*/
+	template <typename QUEUE>
+	BloombergLP::blpapi::Event nextEvent(QUEUE &queue, int timeoutMs = 0) const
+	{
+		BloombergLP::blpapi::Event event;
+		int remainingMs = timeoutMs;
+		if (type_ != BLOCKING && poll(queue, &event, timeoutMs, &remainingMs))
+		{
+			return event;
+		}
+		return queue.nextEvent(remainingMs);
+	}
+
+	/*-------------------------------------------------
+	 * Name			: nextEvents
+	 * Description	: Waits for the next event of queue as
+	 *				  the strategy says, then takes the
+	 *				  events already queued, see
+	 *				  drainEvents()
+	 * Arguments	: queue is a Session or an EventQueue
+	 *				  events receives the events
+	 *				  maxEvents is the size of events
+	 *				  timeoutMs is the longest wait, 0 for
+	 *				  no limit
+	 * Returns		: number of events loaded
+	 *-------------------------------------------------*/
+	template <typename QUEUE>
+	size_t nextEvents(QUEUE &queue, BloombergLP::blpapi::Event *events,
+		size_t maxEvents, int timeoutMs = 0) const
+	{
+		int remainingMs = timeoutMs;
+		if (type_ != BLOCKING && maxEvents > 0
+			&& poll(queue, &events[0], timeoutMs, &remainingMs))
+		{
+			return 1 + takeEvents(queue, events + 1, maxEvents - 1);
+		}
+		return drainEvents(queue, events, maxEvents, remainingMs);
+	}
+
+	/*-------------------------------------------------
+	 * Name			: spin
+	 * Description	: Polls a condition for the spin time,
+	 *				  or until it holds when busy polling.
+	 *				  The caller parks if it still does not
+	 *				  hold.
+	 * Arguments	: ready is called with no arguments and
+	 *				  returns true once the wait is over
+	 * Returns		: true if ready returned true
+	 *-------------------------------------------------*/
+	template <typename PREDICATE>
+	bool spin(const PREDICATE &ready) const
+	{
+		if (type_ == BLOCKING)
+		{
+			return false;
+		}
+		BloombergLP::blpapi::TimePoint start = BloombergLP::blpapi::HighResolutionClock::now();
+		long long limitNs = (long long)spinMicros_ * 1000;
+		while (!ready())
+		{
+			if (type_ == SPIN_THEN_PARK && elapsedNs(start) >= limitNs)
+			{
+				return false;
+			}
+			relax();
+		}
+		return true;
+	}
+
+private:
+	/*-------------------------------------------------
+	 * Name			: poll
+	 * Description	: Polls queue with tryNextEvent() for
+	 *				  the spin time, or the timeout when
+	 *				  busy polling
+	 * Arguments	: queue is a Session or an EventQueue
+	 *				  event receives the event
+	 *				  timeoutMs is the longest wait, 0 for
+	 *				  no limit
+	 *				  remainingMs receives the timeout left
+	 *				  for nextEvent(), 0 for no limit
+	 * Returns		: true if an event was loaded
+	 *-------------------------------------------------*/
+	template <typename QUEUE>
+	bool poll(QUEUE &queue, BloombergLP::blpapi::Event *event, int timeoutMs,
+		int *remainingMs) const
+	{
+		long long timeoutNs = (long long)timeoutMs * 1000000;
+		long long limitNs = type_ == BUSY_POLL ? -1 : (long long)spinMicros_ * 1000;
+		if (timeoutMs > 0 && (limitNs < 0 || timeoutNs < limitNs))
+		{
+			limitNs = timeoutNs;
+		}
+
+		BloombergLP::blpapi::TimePoint start = BloombergLP::blpapi::HighResolutionClock::now();
+		for (;;)
+		{
+			if (queue.tryNextEvent(event) == 0)
+			{
+				return true;
+			}
+			long long elapsed = elapsedNs(start);
+			if (limitNs >= 0 && elapsed >= limitNs)
+			{
+				if (timeoutMs > 0)
+				{
+					// a timeout that ran out still waits 1 ms
+					// for nextEvent() to return TIMEOUT
+					long long leftMs = (timeoutNs - elapsed) / 1000000;
+					*remainingMs = leftMs > 0 ? (int)leftMs : 1;
+				}
+				return false;
+			}
+			relax();
+		}
+	}
+
+	static long long elapsedNs(const BloombergLP::blpapi::TimePoint &start)
+	{
+		return BloombergLP::blpapi::TimePointUtil::nanosecondsBetween(start,
+			BloombergLP::blpapi::HighResolutionClock::now());
+	}
+
+	// lets the other hyperthread of the core run while spinning
+	static void relax()
+	{
+#if defined(WIN32) || defined(_WIN32)
+		YieldProcessor();
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+		__builtin_ia32_pause();
+#endif
+	}
+
+	Type type_;
+	unsigned int spinMicros_;
+	int core_;
+};
+#endif